@@ -0,0 +1,118 @@
+// Cooks the models and shapes of an asset directory into CookedMesh files
+// for the demos to load instead of parsing text at startup. Assets whose
+// content and settings have not changed since the last run are skipped,
+// the rest are cooked in parallel. Prints the time of every asset and
+// writes manifest.txt into the output directory.
+//
+// AssetCooker assetDirectory outputDirectory [-threads N] [-force] [-positionbits N] [-nooptimize] [-nocompress]
+//
+// -threads 0 cooks on the calling thread. -force cooks everything again.
+// -positionbits quantizes the positions coarser than the 16 bits the format
+// stores and -nooptimize keeps the source's triangle and vertex order.
+// -nocompress stores the buffers as they are instead of with MeshCodec.
+
+#include "Cooker.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+namespace
+{
+	const char* ResultName(CookResult result)
+	{
+		switch (result)
+		{
+		case CookResult::Cooked:
+			return "cooked";
+		case CookResult::UpToDate:
+			return "up to date";
+		default:
+			return "failed";
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<const char*> directories;
+	uint32_t threads = std::max(1u, std::thread::hardware_concurrency());
+	bool force = false;
+	CookSettings settings = { 16, true, true };
+	bool usage = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "-threads") == 0 && hasValue)
+		{
+			threads = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-force") == 0)
+		{
+			force = true;
+		}
+		else if (strcmp(argv[i], "-positionbits") == 0 && hasValue)
+		{
+			int bits = atoi(argv[++i]);
+			usage = usage || bits < 1 || bits > 16;
+			settings.PositionBits = static_cast<uint32_t>(bits);
+		}
+		else if (strcmp(argv[i], "-nooptimize") == 0)
+		{
+			settings.OptimizeVertexCache = false;
+		}
+		else if (strcmp(argv[i], "-nocompress") == 0)
+		{
+			settings.Compress = false;
+		}
+		else if (argv[i][0] != '-')
+		{
+			directories.push_back(argv[i]);
+		}
+		else
+		{
+			usage = true;
+		}
+	}
+
+	if (usage || directories.size() != 2)
+	{
+		fprintf(stderr, "Usage: %s assetDirectory outputDirectory [-threads N] [-force] [-positionbits N] [-nooptimize] [-nocompress]\n", argv[0]);
+		return 1;
+	}
+
+	std::unique_ptr<JobSystem> jobs(threads > 0 ? new JobSystem(threads) : nullptr);
+	AssetCooker cooker(directories[0], directories[1], settings);
+	CookStats stats = cooker.Run(jobs.get(), force);
+
+	const std::vector<CookedAsset>& assets = cooker.Manifest();
+	printf("%-10s %9s %9s %9s %10s %10s %12s  %s\n", "", "ms", "vertices", "triangles", "source KB", "cooked KB", "ACMR", "asset");
+	for (size_t i = 0; i < assets.size(); i++)
+	{
+		const CookedAsset& asset = assets[i];
+		CookResult result = cooker.Results()[i];
+		if (result == CookResult::Failed)
+		{
+			printf("%-10s %9.2f %9s %9s %10s %10s %12s  %s: %s\n", ResultName(result), cooker.Milliseconds()[i], "", "", "", "", ""
+				, asset.Source.c_str(), cooker.Errors()[i].c_str());
+			continue;
+		}
+		printf("%-10s %9.2f %9u %9u %10.1f %10.1f %5.2f->%5.2f  %s\n"
+			, ResultName(result)
+			, cooker.Milliseconds()[i]
+			, asset.Vertices
+			, asset.Triangles
+			, asset.SourceBytes / 1024.0
+			, asset.CookedBytes / 1024.0
+			, asset.MissRatioBefore
+			, asset.MissRatioAfter
+			, asset.Source.c_str());
+	}
+	printf("%s\n", CookSummary(stats).c_str());
+	return stats.Failed > 0 ? 1 : 0;
+}
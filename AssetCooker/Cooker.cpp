@@ -0,0 +1,495 @@
+#include "Cooker.h"
+#include "CookedMesh.h"
+#include "Hash.h"
+#include "JobSystem.h"
+#include "MeshGenerator.h"
+#include "VertexCacheOptimizer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+
+namespace
+{
+	// Bump when the cooking changes what it writes, everything is cooked again
+	const uint32_t cookFormatVersion = 3;
+
+	struct SourceMesh
+	{
+		std::vector<Float3> Positions;
+		std::vector<Float3> Normals;
+		std::vector<Float2> TexCoords;		// Empty for the book's models
+		std::vector<uint32_t> Indices;
+	};
+
+	double MillisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	bool ReadFile(const std::string& fileName, std::string& text)
+	{
+		std::ifstream file(fileName.c_str(), std::ios::binary);
+		if (!file)
+		{
+			return false;
+		}
+		text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		return true;
+	}
+
+	bool IsModel(const std::filesystem::path& path)
+	{
+		char start[32] = {};
+		FILE* file = fopen(path.string().c_str(), "rb");
+		if (file == nullptr)
+		{
+			return false;
+		}
+		size_t read = fread(start, 1, sizeof(start) - 1, file);
+		fclose(file);
+		start[read] = '\0';
+		return strstr(start, "VertexCount:") != nullptr;
+	}
+
+	// The book's format parsed in place, a stream takes several times longer
+	bool ParseModel(const std::string& text, SourceMesh& mesh, std::string& error)
+	{
+		const char* at = strstr(text.c_str(), "VertexCount:");
+		char* end = nullptr;
+		uint32_t vertexCount = at != nullptr ? static_cast<uint32_t>(strtoul(at + 12, &end, 10)) : 0;
+		at = end != nullptr ? strstr(end, "TriangleCount:") : nullptr;
+		uint32_t triangleCount = at != nullptr ? static_cast<uint32_t>(strtoul(at + 14, &end, 10)) : 0;
+
+		// Every number takes two characters at least, larger counts can not be right
+		if (vertexCount == 0 || triangleCount == 0 || vertexCount > text.size() / 12 || triangleCount > text.size() / 6)
+		{
+			error = "no vertex and triangle counts";
+			return false;
+		}
+
+		at = strchr(end, '{');
+		if (at != nullptr)
+		{
+			at++;
+		}
+		mesh.Positions.resize(vertexCount);
+		mesh.Normals.resize(vertexCount);
+		for (uint32_t i = 0; at != nullptr && i < vertexCount; i++)
+		{
+			float values[6];
+			for (uint32_t j = 0; at != nullptr && j < 6; j++)
+			{
+				values[j] = strtof(at, &end);
+				at = end != at ? end : nullptr;
+			}
+			if (at != nullptr)
+			{
+				mesh.Positions[i] = Float3(values[0], values[1], values[2]);
+				mesh.Normals[i] = Float3(values[3], values[4], values[5]);
+			}
+		}
+
+		at = at != nullptr ? strchr(at, '{') : nullptr;
+		if (at != nullptr)
+		{
+			at++;
+		}
+		mesh.Indices.resize(triangleCount * 3);
+		for (uint32_t i = 0; at != nullptr && i < triangleCount * 3; i++)
+		{
+			unsigned long index = strtoul(at, &end, 10);
+			at = end != at && index < vertexCount ? end : nullptr;
+			mesh.Indices[i] = static_cast<uint32_t>(index);
+		}
+
+		if (at == nullptr)
+		{
+			error = "truncated or an index out of range";
+			return false;
+		}
+		return true;
+	}
+
+	// The first line that is not a comment
+	bool ParseShape(const std::string& text, SourceMesh& mesh, std::string& error)
+	{
+		std::istringstream lines(text);
+		std::string line;
+		while (std::getline(lines, line) && (line.empty() || line[0] == '#'))
+		{
+		}
+
+		const uint32_t maxDivisions = 4096;
+		MeshGenerator::MeshData data;
+		float a = 0.0f;
+		float b = 0.0f;
+		float c = 0.0f;
+		uint32_t m = 0;
+		uint32_t n = 0;
+		if (sscanf(line.c_str(), "sphere %f %u %u", &a, &m, &n) == 3 && m >= 3 && n >= 2 && m <= maxDivisions && n <= maxDivisions)
+		{
+			MeshGenerator::CreateSphere(a, m, n, data);
+		}
+		else if (sscanf(line.c_str(), "box %f %f %f", &a, &b, &c) == 3)
+		{
+			MeshGenerator::CreateBox(a, b, c, data);
+		}
+		else if (sscanf(line.c_str(), "cylinder %f %f %f %u %u", &a, &b, &c, &m, &n) == 5 && m >= 3 && n >= 1 && m <= maxDivisions && n <= maxDivisions)
+		{
+			MeshGenerator::CreateCylinder(a, b, c, m, n, data);
+		}
+		else if (sscanf(line.c_str(), "grid %f %f %u %u", &a, &b, &m, &n) == 4 && m >= 2 && n >= 2 && m <= maxDivisions && n <= maxDivisions)
+		{
+			MeshGenerator::CreateGrid(a, b, m, n, data);
+		}
+		else
+		{
+			error = "unknown shape '" + line + "'";
+			return false;
+		}
+
+		size_t vertexCount = data.Vertices.size();
+		mesh.Positions.resize(vertexCount);
+		mesh.Normals.resize(vertexCount);
+		mesh.TexCoords.resize(vertexCount);
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			mesh.Positions[i] = data.Vertices[i].Position;
+			mesh.Normals[i] = data.Vertices[i].Normal;
+			mesh.TexCoords[i] = data.Vertices[i].TexC;
+		}
+		mesh.Indices.swap(data.Indices);
+		return true;
+	}
+
+	template<typename T>
+	void Reorder(std::vector<T>& values, const std::vector<uint32_t>& remap, uint32_t usedCount)
+	{
+		if (values.empty())
+		{
+			return;
+		}
+		std::vector<T> reordered(usedCount);
+		for (size_t i = 0; i < remap.size(); i++)
+		{
+			if (remap[i] != ~0u)
+			{
+				reordered[remap[i]] = values[i];
+			}
+		}
+		values.swap(reordered);
+	}
+
+	bool Cook(const std::string& text, bool isShape, const CookSettings& settings, const std::string& outputPath,
+		CookedAsset& asset, std::string& error)
+	{
+		SourceMesh source;
+		if (!(isShape ? ParseShape(text, source, error) : ParseModel(text, source, error)))
+		{
+			return false;
+		}
+
+		uint32_t vertexCount = static_cast<uint32_t>(source.Positions.size());
+		uint32_t indexCount = static_cast<uint32_t>(source.Indices.size());
+		asset.MissRatioBefore = AverageCacheMissRatio(source.Indices.data(), indexCount, vertexCount);
+		if (settings.OptimizeVertexCache)
+		{
+			OptimizeVertexCache(source.Indices.data(), indexCount, vertexCount);
+
+			std::vector<uint32_t> remap;
+			vertexCount = OptimizeVertexFetch(source.Indices.data(), indexCount, vertexCount, remap);
+			Reorder(source.Positions, remap, vertexCount);
+			Reorder(source.Normals, remap, vertexCount);
+			Reorder(source.TexCoords, remap, vertexCount);
+		}
+		asset.MissRatioAfter = AverageCacheMissRatio(source.Indices.data(), indexCount, vertexCount);
+		asset.Vertices = vertexCount;
+		asset.Triangles = indexCount / 3;
+
+		CookedMesh cooked;
+		QuantizeMesh(source.Positions, source.Normals, source.TexCoords, source.Indices, settings.PositionBits, cooked);
+		cooked.Header.SourceHash = asset.SourceHash;
+		cooked.Header.SettingsHash = asset.SettingsHash;
+		if (settings.Compress)
+		{
+			cooked.Header.Flags |= CookedMeshCompressed;
+		}
+
+		std::error_code directoryError;
+		std::filesystem::create_directories(std::filesystem::path(outputPath).parent_path(), directoryError);
+		asset.CookedBytes = WriteCookedMesh(outputPath, cooked);
+		if (asset.CookedBytes == 0)
+		{
+			error = "could not write " + outputPath;
+			return false;
+		}
+		return true;
+	}
+
+	bool IsUpToDate(const CookedAsset& asset, const CookedAsset* previous, const std::string& outputPath)
+	{
+		if (previous == nullptr || previous->SourceHash != asset.SourceHash || previous->SettingsHash != asset.SettingsHash
+			|| previous->Output != asset.Output)
+		{
+			return false;
+		}
+
+		// The manifest may be older than the output, or the output replaced by hand
+		CookedMeshHeader header;
+		return ReadCookedMeshHeader(outputPath, header) && header.SourceHash == asset.SourceHash && header.SettingsHash == asset.SettingsHash;
+	}
+
+	std::vector<std::string> SplitTabs(const std::string& line)
+	{
+		std::vector<std::string> fields;
+		size_t start = 0;
+		for (size_t tab = line.find('\t'); tab != std::string::npos; tab = line.find('\t', start))
+		{
+			fields.push_back(line.substr(start, tab - start));
+			start = tab + 1;
+		}
+		fields.push_back(line.substr(start));
+		return fields;
+	}
+}
+
+AssetCooker::AssetCooker(const std::string& assetDirectory, const std::string& outputDirectory, const CookSettings& settings)
+	: mAssetDirectory(assetDirectory)
+	, mOutputDirectory(outputDirectory)
+	, mSettings(settings)
+	, mSettingsHash(CookSettingsHash(settings))
+{
+}
+
+std::string AssetCooker::ManifestPath() const
+{
+	return (std::filesystem::path(mOutputDirectory) / "manifest.txt").string();
+}
+
+CookStats AssetCooker::Run(JobSystem* jobs, bool force)
+{
+	auto start = std::chrono::steady_clock::now();
+	CookStats stats = {};
+
+	std::vector<CookedAsset> previousAssets;
+	ReadManifest(ManifestPath(), previousAssets);
+	std::map<std::string, const CookedAsset*> previous;
+	for (size_t i = 0; i < previousAssets.size(); i++)
+	{
+		previous[previousAssets[i].Source] = &previousAssets[i];
+	}
+
+	// Sorted, so the manifest only changes where the assets did
+	std::vector<std::string> sources;
+	std::error_code error;
+	for (std::filesystem::recursive_directory_iterator it(mAssetDirectory, error), end; !error && it != end; it.increment(error))
+	{
+		std::string extension = it->path().extension().string();
+		if (!it->is_regular_file(error) || !(extension == ".shape" || (extension == ".txt" && IsModel(it->path()))))
+		{
+			continue;
+		}
+		sources.push_back(std::filesystem::relative(it->path(), mAssetDirectory).generic_string());
+	}
+	std::sort(sources.begin(), sources.end());
+
+	uint32_t count = static_cast<uint32_t>(sources.size());
+	mManifest.assign(count, CookedAsset());
+	mResults.assign(count, CookResult::Failed);
+	mMilliseconds.assign(count, 0.0);
+	mErrors.assign(count, std::string());
+
+	auto cookRange = [&](uint32_t first, uint32_t end)
+	{
+		for (uint32_t i = first; i < end; i++)
+		{
+			auto assetStart = std::chrono::steady_clock::now();
+			CookedAsset& asset = mManifest[i];
+			asset.Source = sources[i];
+			asset.Output = std::filesystem::path(sources[i]).replace_extension(".cmesh").generic_string();
+			asset.SettingsHash = mSettingsHash;
+			std::string sourcePath = (std::filesystem::path(mAssetDirectory) / asset.Source).string();
+			std::string outputPath = (std::filesystem::path(mOutputDirectory) / asset.Output).string();
+
+			std::string text;
+			if (!ReadFile(sourcePath, text))
+			{
+				mErrors[i] = "could not read " + sourcePath;
+				mMilliseconds[i] = MillisecondsSince(assetStart);
+				continue;
+			}
+			asset.SourceHash = Fnv1a(text.data(), text.size());
+			asset.SourceBytes = text.size();
+
+			auto found = previous.find(asset.Source);
+			if (!force && IsUpToDate(asset, found != previous.end() ? found->second : nullptr, outputPath))
+			{
+				asset = *found->second;
+				mResults[i] = CookResult::UpToDate;
+				mMilliseconds[i] = MillisecondsSince(assetStart);
+				continue;
+			}
+
+			bool isShape = std::filesystem::path(asset.Source).extension() == ".shape";
+			bool cooked = Cook(text, isShape, mSettings, outputPath, asset, mErrors[i]);
+			mResults[i] = cooked ? CookResult::Cooked : CookResult::Failed;
+			mMilliseconds[i] = MillisecondsSince(assetStart);
+			asset.CookMs = mMilliseconds[i];
+		}
+	};
+
+	// One asset per batch, they differ too much in size for more
+	if (jobs != nullptr)
+	{
+		jobs->ParallelFor(count, 1, cookRange);
+	}
+	else
+	{
+		cookRange(0, count);
+	}
+
+	// Outputs of sources that were removed or renamed
+	std::vector<CookedAsset> written;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		stats.Cooked += mResults[i] == CookResult::Cooked ? 1 : 0;
+		stats.UpToDate += mResults[i] == CookResult::UpToDate ? 1 : 0;
+		stats.Failed += mResults[i] == CookResult::Failed ? 1 : 0;
+		previous.erase(mManifest[i].Source);
+		if (mResults[i] != CookResult::Failed)
+		{
+			written.push_back(mManifest[i]);
+		}
+	}
+	for (auto it = previous.begin(); it != previous.end(); ++it)
+	{
+		bool stillCooked = false;
+		for (uint32_t i = 0; i < count && !stillCooked; i++)
+		{
+			stillCooked = mManifest[i].Output == it->second->Output;
+		}
+		if (!stillCooked && std::filesystem::remove(std::filesystem::path(mOutputDirectory) / it->second->Output, error))
+		{
+			stats.Removed++;
+		}
+	}
+
+	// Failed assets are left out, so the next run tries them again
+	std::filesystem::create_directories(mOutputDirectory, error);
+	if (!WriteManifest(ManifestPath(), mSettings, written))
+	{
+		stats.Failed++;
+	}
+	stats.TotalMs = MillisecondsSince(start);
+	return stats;
+}
+
+uint64_t CookSettingsHash(const CookSettings& settings)
+{
+	uint64_t hash = HashValue(cookFormatVersion);
+	hash = HashValue(settings.PositionBits, hash);
+	hash = HashValue(settings.OptimizeVertexCache ? 1u : 0u, hash);
+	return HashValue(settings.Compress ? 1u : 0u, hash);
+}
+
+bool ReadManifest(const std::string& fileName, std::vector<CookedAsset>& assets)
+{
+	std::ifstream file(fileName.c_str());
+	if (!file)
+	{
+		return false;
+	}
+
+	assets.clear();
+	std::string line;
+	while (std::getline(file, line))
+	{
+		std::vector<std::string> fields = SplitTabs(line);
+		if (line.empty() || line[0] == '#' || fields.size() != 11)
+		{
+			continue;
+		}
+		CookedAsset asset;
+		asset.Source = fields[0];
+		asset.Output = fields[1];
+		asset.SourceHash = strtoull(fields[2].c_str(), nullptr, 16);
+		asset.SettingsHash = strtoull(fields[3].c_str(), nullptr, 16);
+		asset.Vertices = static_cast<uint32_t>(strtoul(fields[4].c_str(), nullptr, 10));
+		asset.Triangles = static_cast<uint32_t>(strtoul(fields[5].c_str(), nullptr, 10));
+		asset.SourceBytes = strtoull(fields[6].c_str(), nullptr, 10);
+		asset.CookedBytes = strtoull(fields[7].c_str(), nullptr, 10);
+		asset.MissRatioBefore = strtof(fields[8].c_str(), nullptr);
+		asset.MissRatioAfter = strtof(fields[9].c_str(), nullptr);
+		asset.CookMs = strtod(fields[10].c_str(), nullptr);
+		assets.push_back(asset);
+	}
+	return true;
+}
+
+bool WriteManifest(const std::string& fileName, const CookSettings& settings, const std::vector<CookedAsset>& assets)
+{
+	// Renamed over the old one like the meshes, an interrupted run keeps the last manifest
+	std::string temporary = fileName + ".tmp";
+	FILE* file = fopen(temporary.c_str(), "w");
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	fprintf(file, "# AssetCooker manifest, format %u, position bits %u, vertex cache %s, %s, settings %016llx\n"
+		, cookFormatVersion
+		, settings.PositionBits
+		, settings.OptimizeVertexCache ? "optimized" : "as is"
+		, settings.Compress ? "compressed" : "uncompressed"
+		, static_cast<unsigned long long>(CookSettingsHash(settings)));
+	fprintf(file, "# source\toutput\tsource hash\tsettings hash\tvertices\ttriangles\tsource bytes\tcooked bytes\tACMR before\tACMR after\tcook ms\n");
+	for (size_t i = 0; i < assets.size(); i++)
+	{
+		const CookedAsset& asset = assets[i];
+		fprintf(file, "%s\t%s\t%016llx\t%016llx\t%u\t%u\t%llu\t%llu\t%.3f\t%.3f\t%.2f\n"
+			, asset.Source.c_str()
+			, asset.Output.c_str()
+			, static_cast<unsigned long long>(asset.SourceHash)
+			, static_cast<unsigned long long>(asset.SettingsHash)
+			, asset.Vertices
+			, asset.Triangles
+			, static_cast<unsigned long long>(asset.SourceBytes)
+			, static_cast<unsigned long long>(asset.CookedBytes)
+			, asset.MissRatioBefore
+			, asset.MissRatioAfter
+			, asset.CookMs);
+	}
+	bool written = fclose(file) == 0;
+
+	std::error_code error;
+	if (written)
+	{
+		std::filesystem::rename(temporary, fileName, error);
+		written = !error;
+	}
+	if (!written)
+	{
+		std::filesystem::remove(temporary, error);
+	}
+	return written;
+}
+
+std::string CookSummary(const CookStats& stats)
+{
+	char summary[160];
+	snprintf(summary, sizeof(summary), "Assets: %u cooked, %u up to date, %u failed, %u removed in %.1f ms"
+		, stats.Cooked
+		, stats.UpToDate
+		, stats.Failed
+		, stats.Removed
+		, stats.TotalMs);
+	return summary;
+}
@@ -0,0 +1,101 @@
+#ifndef COOKER_H
+#define COOKER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class JobSystem;
+
+// Cooked into every mesh's SettingsHash, so changing one cooks everything again
+struct CookSettings
+{
+	uint32_t PositionBits;		// 1 to 16
+	bool OptimizeVertexCache;
+	bool Compress;				// Store the buffers with MeshCodec
+};
+
+// One line of the manifest
+struct CookedAsset
+{
+	std::string Source;			// Relative to the asset directory
+	std::string Output;			// Relative to the output directory
+	uint64_t SourceHash;
+	uint64_t SettingsHash;
+	uint32_t Vertices;
+	uint32_t Triangles;
+	uint64_t SourceBytes;
+	uint64_t CookedBytes;
+	float MissRatioBefore;		// AverageCacheMissRatio of the source order
+	float MissRatioAfter;
+	double CookMs;				// Of the run that cooked it
+};
+
+enum class CookResult
+{
+	Cooked,
+	UpToDate,
+	Failed
+};
+
+struct CookStats
+{
+	uint32_t Cooked;
+	uint32_t UpToDate;
+	uint32_t Failed;
+	uint32_t Removed;			// Outputs of sources that are gone
+	double TotalMs;
+};
+
+// Cooks the meshes under 'assetDirectory' into 'outputDirectory':
+//   *.txt    the book's model format, "VertexCount: N" first
+//   *.shape  a MeshGenerator call, "sphere 0.5 20 20", "box 1 1 1",
+//            "cylinder 0.5 0.3 3 20 20" or "grid 20 30 60 40"
+// into a .cmesh of the same relative name. Each asset is one job on 'jobs',
+// or they run on the calling thread without it.
+//
+// An asset is skipped when manifest.txt in the output directory lists it
+// with the same content hash and settings and its .cmesh carries the same
+// ones. With 'force' everything is cooked. The manifest is rewritten after
+// every run, the outputs of sources that are gone are deleted.
+class AssetCooker
+{
+public:
+	AssetCooker(const std::string& assetDirectory, const std::string& outputDirectory, const CookSettings& settings);
+
+	CookStats Run(JobSystem* jobs, bool force = false);
+
+	// Of the last Run, sorted by source name
+	const std::vector<CookedAsset>& Manifest() const { return mManifest; }
+	const std::vector<CookResult>& Results() const { return mResults; }
+	// Hashing and checking for the skipped assets, cooking for the others
+	const std::vector<double>& Milliseconds() const { return mMilliseconds; }
+	const std::vector<std::string>& Errors() const { return mErrors; }
+
+	std::string ManifestPath() const;
+
+private:
+	AssetCooker(const AssetCooker&);
+	AssetCooker& operator=(const AssetCooker&);
+
+	std::string mAssetDirectory;
+	std::string mOutputDirectory;
+	CookSettings mSettings;
+	uint64_t mSettingsHash;
+
+	std::vector<CookedAsset> mManifest;
+	std::vector<CookResult> mResults;
+	std::vector<double> mMilliseconds;
+	std::vector<std::string> mErrors;
+};
+
+// Includes the format version of CookedMesh
+uint64_t CookSettingsHash(const CookSettings& settings);
+
+bool ReadManifest(const std::string& fileName, std::vector<CookedAsset>& assets);
+bool WriteManifest(const std::string& fileName, const CookSettings& settings, const std::vector<CookedAsset>& assets);
+
+// "Assets: 1 cooked, 3 up to date, 0 failed, 0 removed in 12.3 ms"
+std::string CookSummary(const CookStats& stats);
+
+#endif // COOKER_H
@@ -1,124 +1,93 @@
 
-#include "d3dApp.h"
-#include <dxgi.h>
-#include <iostream>
-
-class InitDirect3DApp : public D3DApp
-{
-public:
-	InitDirect3DApp(HINSTANCE hInstance);
-	~InitDirect3DApp();
+#include "SceneApp.h"
+#include "InitScene.h"
+#include "DxgiDisplayModes.h"
+#include "Log.h"
 
-	virtual bool Init();
-	virtual void UpdateScene(float delta);
-	virtual void DrawScene(void);
-	virtual void OnResize(void);
-};
+#include <cstdio>
+#include <dxgi.h>
 
-int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance, PSTR cmdLine, int showCmd)
+namespace
 {
-	// Memory check
-#if defined(DEBUG) | defined(_DEBUG)
-	_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
-#endif
-
-	InitDirect3DApp theApp(hInstance);
+	const char* const displayModeCache = "displaymodes.txt";
 
-	if (!theApp.Init())
+	// Logs every adapter, output and display mode and the mode that fits the
+	// window. Runs before the first frame, so it is part of the startup trace.
+	void LogDisplayModes(SceneApp& theApp)
 	{
-		return 0;
-	}
+		STARTUP_PHASE("EnumerateDisplayModes");
 
-	ID3D11Device *device = theApp.GetDevice();
+		ID3D11Device *device = theApp.GetDevice();
 
+		IDXGIDevice* dxgiDevice = 0;
+		HR(device->QueryInterface(__uuidof(IDXGIDevice), (void**)&dxgiDevice));
 
-	IDXGIDevice* dxgiDevice = 0;
-	HR(device->QueryInterface(__uuidof(IDXGIDevice), (void**)&dxgiDevice));
+		IDXGIAdapter* dxgiAdapter = 0;
+		HR(dxgiDevice->GetParent(__uuidof(IDXGIAdapter), (void**)&dxgiAdapter));
 
-	IDXGIAdapter* dxgiAdapter = 0;
-	HR(dxgiDevice->GetParent(__uuidof(IDXGIAdapter), (void**)&dxgiAdapter));
+		IDXGIFactory* dxgiFactory = 0;
+		HR(dxgiAdapter->GetParent(__uuidof(IDXGIFactory), (void**)&dxgiFactory));
 
-	IDXGIFactory* dxgiFactory = 0;
-	HR(dxgiAdapter->GetParent(__uuidof(IDXGIFactory), (void**)&dxgiFactory));
+		// Do not react to ALT + ENTER
+		dxgiFactory->MakeWindowAssociation(theApp.MainWnd(), DXGI_MWA_NO_WINDOW_CHANGES);
 
-	// Do not react to ALT + ENTER
-	dxgiFactory->MakeWindowAssociation(theApp.MainWnd(), DXGI_MWA_NO_WINDOW_CHANGES);
+		DisplayModeTable table;
+		bool cached = EnumerateDisplayModes(dxgiFactory, DXGI_FORMAT_R8G8B8A8_UNORM, displayModeCache, table);
+		LogMessage(std::string("Display modes ") + (cached ? "from " : "enumerated, saved to ") + displayModeCache + "\n");
 
-	// Get amount of adapters
-	UINT adapterIndex = 0;
+		RECT client;
+		GetClientRect(theApp.MainWnd(), &client);
+		uint32_t width = static_cast<uint32_t>(client.right - client.left);
+		uint32_t height = static_cast<uint32_t>(client.bottom - client.top);
 
-	IDXGIAdapter* adapter;
-	DXGI_ADAPTER_DESC adapterDesc;
-
-	OutputDebugString("Enumerating Display adapters ...\n");
-	for (adapterIndex = 0; dxgiFactory->EnumAdapters(adapterIndex, &adapter) != DXGI_ERROR_NOT_FOUND; adapterIndex++)
-	{
-		adapter->GetDesc(&adapterDesc);
-		OutputDebugStringW(adapterDesc.Description);
-		OutputDebugString("\n");
-
-		OutputDebugString("Enumerating outputs for adapter:\n");
-		UINT outputIndex = 0;
-		IDXGIOutput* output;
-		DXGI_OUTPUT_DESC outputDesc;
-		for (outputIndex = 0; adapter->EnumOutputs(outputIndex, &output) != DXGI_ERROR_NOT_FOUND; outputIndex++)
+		for (size_t i = 0; i < table.Adapters().size(); i++)
 		{
-			output->GetDesc(&outputDesc);
-			OutputDebugStringW(outputDesc.DeviceName);
-			OutputDebugString("\n");
-			UINT numModes;
-			output->GetDisplayModeList(DXGI_FORMAT_R8G8B8A8_UNORM, 0, &numModes, NULL);
-			DXGI_MODE_DESC *modes = new DXGI_MODE_DESC[numModes];
-			output->GetDisplayModeList(DXGI_FORMAT_R8G8B8A8_UNORM, 0, &numModes, modes);
-			for (UINT i = 0; i < numModes; i++)
+			const DisplayAdapterInfo& adapter = table.Adapters()[i];
+			LogMessage(adapter.Description + "\n");
+			for (uint32_t j = 0; j < adapter.OutputCount; j++)
 			{
-				std::stringstream debug;
-				debug << "Mode " << i << ": Rate "<< modes[i].RefreshRate.Numerator << "/" << modes[i].RefreshRate.Denominator << " " << modes[i].Width << "x" << modes[i].Height << std::endl;
-				OutputDebugString(debug.str().c_str());
+				uint32_t output = adapter.FirstOutput + j;
+				const DisplayOutputInfo& info = table.Outputs()[output];
+				LogMessage("  " + info.Name + "\n");
+
+				const DisplayMode* modes = table.Modes(output);
+				for (uint32_t k = 0; k < info.ModeCount; k++)
+				{
+					char line[96];
+					snprintf(line, sizeof(line), "    Mode %u: %s\n", k, FormatDisplayMode(modes[k]).c_str());
+					LogMessage(line);
+				}
+
+				const DisplayMode* best = table.FindBestMode(output, width, height, 60.0);
+				if (best != nullptr)
+				{
+					LogMessage("    Best for the window at 60 Hz: " + FormatDisplayMode(*best) + "\n");
+				}
 			}
 		}
-	}
-
-	ReleaseCOM(dxgiDevice);
-	ReleaseCOM(dxgiAdapter);
-	ReleaseCOM(dxgiFactory);
-
 
-    return theApp.Run();
-}
-
-InitDirect3DApp::InitDirect3DApp(HINSTANCE hInstance) : D3DApp(hInstance)
-{
-    // nop
+		ReleaseCOM(dxgiDevice);
+		ReleaseCOM(dxgiAdapter);
+		ReleaseCOM(dxgiFactory);
+	}
 }
 
-InitDirect3DApp::~InitDirect3DApp()
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance, PSTR cmdLine, int showCmd)
 {
+	// Memory check
+#if defined(DEBUG) | defined(_DEBUG)
+	_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
+#endif
 
-}
+	InitScene scene;
+	SceneApp theApp(hInstance, scene);
 
-bool InitDirect3DApp::Init()
-{
-    if(D3DApp::Init() == false)
-    {
-        return false;
-    }
-    return true;
-}
-
-void InitDirect3DApp::UpdateScene(float delta) {}
-void InitDirect3DApp::DrawScene(void) 
-{
-	assert(md3dImmediateContext);
-	assert(mSwapChain);
+	if (!theApp.Init())
+	{
+		return 0;
+	}
 
-	// Clear back buffer
-	md3dImmediateContext->ClearRenderTargetView(mRenderTargetView, reinterpret_cast<const float*>(&Colors::Blue));
-	md3dImmediateContext->ClearDepthStencilView(mDepthStencilView, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
+	LogDisplayModes(theApp);
 
-	HR(mSwapChain->Present(0, 0));
+    return theApp.Run();
 }
-void InitDirect3DApp::OnResize(void) 
-{
-	D3DApp::OnResize();
-}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#include "InitScene.h"
+
+InitScene::InitScene()
+	: mCaption("D3D11 Application")
+{
+}
+
+bool InitScene::Init(IRenderDevice& device)
+{
+	mStateCache.reset(new StateCachedContext(device.ImmediateContext()));
+	return true;
+}
+
+void InitScene::Shutdown()
+{
+	mStateCache.reset();
+}
+
+void InitScene::OnResize(int, int) {}
+void InitScene::UpdateScene(float, float) {}
+
+void InitScene::DrawScene()
+{
+	// Clear back buffer to blue
+	mStateCache->ClearRenderTarget(Float4(0.0f, 0.0f, 1.0f, 1.0f));
+	mStateCache->ClearDepthStencil(1.0f, 0);
+}
@@ -0,0 +1,30 @@
+#ifndef INITSCENE_H
+#define INITSCENE_H
+
+#include "DemoScene.h"
+#include "StateCache.h"
+
+#include <memory>
+#include <string>
+
+// Chapter 4: only clears the back buffer
+class InitScene : public DemoScene
+{
+public:
+	InitScene();
+
+	bool Init(IRenderDevice& device);
+	void Shutdown();
+
+	void OnResize(int width, int height);
+	void UpdateScene(float dt, float totalTime);
+	void DrawScene();
+
+	const std::string& Caption() const { return mCaption; }
+
+private:
+	std::unique_ptr<StateCachedContext> mStateCache;
+	std::string mCaption;
+};
+
+#endif // INITSCENE_H
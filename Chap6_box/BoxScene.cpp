@@ -0,0 +1,390 @@
+#include "BoxScene.h"
+#include "StaticGeometry.h"
+#include "VertexFormat.h"
+#include "ColorPacking.h"
+#include "StartupTrace.h"
+
+#include <cstdio>
+
+// Vertices are authored interleaved and split into streams at load time
+struct CombinedVertex
+{
+	Float3	Position;
+	Float4	Color;
+};
+
+template<> struct VertexFormat<CombinedVertex>
+{
+	static constexpr std::array<VertexElement, 2> Elements =
+	{{
+		VERTEX_ELEMENT(CombinedVertex, Position, "POSITION"),
+		VERTEX_ELEMENT(CombinedVertex, Color, "COLOR")
+	}};
+};
+
+// Same vertex with the color stored as R8G8B8A8_UNORM
+struct PackedCombinedVertex
+{
+	Float3		Position;
+	ColorRGBA8	Color;
+};
+
+template<> struct VertexFormat<PackedCombinedVertex>
+{
+	static constexpr std::array<VertexElement, 2> Elements =
+	{{
+		VERTEX_ELEMENT(PackedCombinedVertex, Position, "POSITION"),
+		VERTEX_ELEMENT(PackedCombinedVertex, Color, "COLOR")
+	}};
+};
+
+static_assert(VertexFormatIsTight<CombinedVertex>(), "CombinedVertex has padding");
+static_assert(VertexFormatIsTight<PackedCombinedVertex>(), "PackedCombinedVertex has padding");
+static_assert(VertexStride<CombinedVertex>() == 28, "CombinedVertex stride");
+static_assert(VertexFormat<CombinedVertex>::Elements[1].Offset == 12, "Color follows position");
+
+//
+// Geometry baked at compile time
+//
+
+static constexpr StaticGeometry::StaticMesh<8, 36> cubeMesh = StaticGeometry::MakeCornerBox(2.0f, 2.0f, 2.0f);
+
+static constexpr std::array<Float4, 8> cubeColors =
+{{
+	Float4(1.0f, 1.0f, 1.0f, 1.0f),
+	Float4(0.0f, 1.0f, 1.0f, 1.0f),
+	Float4(1.0f, 0.0f, 1.0f, 1.0f),
+	Float4(1.0f, 1.0f, 0.0f, 1.0f),
+	Float4(0.0f, 0.0f, 1.0f, 1.0f),
+	Float4(1.0f, 0.0f, 0.0f, 1.0f),
+	Float4(0.0f, 1.0f, 0.0f, 1.0f),
+	Float4(0.0f, 0.0f, 0.0f, 1.0f)
+}};
+
+static constexpr std::array<CombinedVertex, 8> cubeVertices = StaticGeometry::MakeColorVertices<CombinedVertex>(cubeMesh, cubeColors);
+
+// Left hand
+static constexpr StaticGeometry::StaticMesh<5, 18> pyramidMesh = StaticGeometry::MakePyramid(2.0f, 2.0f);
+
+static constexpr std::array<Float4, 5> pyramidColors =
+{{
+	Float4(0.0f, 1.0f, 0.2f, 1.0f),
+	Float4(0.0f, 1.0f, 0.2f, 1.0f),
+	Float4(0.0f, 1.0f, 0.2f, 1.0f),
+	Float4(0.0f, 1.0f, 0.2f, 1.0f),
+	Float4(1.0f, 0.4f, 0.0f, 1.0f)
+}};
+
+static constexpr std::array<CombinedVertex, 5> pyramidVertices = StaticGeometry::MakeColorVertices<CombinedVertex>(pyramidMesh, pyramidColors);
+
+static_assert(pyramidVertices[4].Position.y == 2.0f && pyramidVertices[4].Color.y == 0.4f, "Pyramid apex");
+
+BoxScene::BoxScene(StreamLayout streamLayout, bool packedColors)
+	: mDevice(nullptr)
+	, mStreamLayout(streamLayout)
+	, mPackedColors(packedColors)
+	, mFX(nullptr)
+	, mfxWorldViewProj(nullptr)
+	, mfxTime(nullptr)
+	, mTimeConstants(nullptr)
+	, mWorldViewProjConstants(nullptr)
+	, mInputLayout(nullptr)
+	, mTheta(1.5f * MathPi)
+	, mPhi(0.25f * MathPi)
+	, mRadius(5.0f)
+	, mTotalTime(0.0f)
+	, mPreviousTheta(mTheta)
+	, mPreviousPhi(mPhi)
+	, mPreviousTime(0.0f)
+	, mDrawTime(0.0f)
+	, mLastMouseX(0)
+	, mLastMouseY(0)
+	, mCaption("Box Demo")
+{
+	mWorld = MatrixIdentity();
+	mPyramidWorld = MatrixIdentity();
+	mView = MatrixIdentity();
+	mProj = MatrixIdentity();
+
+	mCube.IndexBuffer = nullptr;
+	mCube.IndexAmount = 0;
+	mPyramid.IndexBuffer = nullptr;
+	mPyramid.IndexAmount = 0;
+}
+
+bool BoxScene::Init(IRenderDevice& device)
+{
+	mDevice = &device;
+	mStateCache.reset(new StateCachedContext(device.ImmediateContext()));
+	mConstantUploader.reset(new ContextConstantUploader(*mStateCache));
+
+	BuildGeometryBuffers();
+	BuildFX();
+	if (mFX == nullptr)
+	{
+		return false;
+	}
+	BuildVertexLayout();
+
+	return true;
+}
+
+void BoxScene::Shutdown()
+{
+	ReleaseMeshBuffers(mCube);
+	ReleaseMeshBuffers(mPyramid);
+	mDevice->ReleaseInputLayout(mInputLayout);
+	mDevice->ReleaseEffect(mFX);
+	mInputLayout = nullptr;
+	mFX = nullptr;
+}
+
+void BoxScene::OnResize(int width, int height)
+{
+	// Update projection matrix
+	mProj = MatrixPerspectiveFovLH(0.25f * MathPi, static_cast<float>(width) / height, 1.0f, 1000.0f);
+}
+
+void BoxScene::UpdateScene(float dt, float totalTime)
+{
+	mPreviousTheta = mTheta;
+	mPreviousPhi = mPhi;
+	mPreviousTime = mTotalTime;
+
+	mTotalTime = totalTime;
+
+	mTheta += 0.2f * dt;
+	mPhi += 0.2f * dt;
+
+	// Convert sphere coordinates to Cartesian
+	// float x = mRadius * sinf(mPhi) * cosf(mTheta);
+	// float y = mRadius * sinf(mPhi) * sinf(mTheta);
+	// float z = mRadius * cosf(mPhi);
+
+	// Camera position
+	float x = 0.0f;// mRadius * sinf(mTheta);
+	float y = 1.0f;
+	float z = mRadius;
+
+	// View matrix points to origo
+	Float3 pos(x, y, z);
+	Float3 target(0.0f, 1.0f, 0.0f);
+	Float3 up(0.0f, 1.0f, 0.0f);
+
+	mView = MatrixLookAtLH(pos, target, up);
+
+	// Drawn as of this step unless the caller interpolates
+	Interpolate(1.0f);
+}
+
+void BoxScene::Interpolate(float alpha)
+{
+	float theta = mPreviousTheta + alpha * (mTheta - mPreviousTheta);
+	float phi = mPreviousPhi + alpha * (mPhi - mPreviousPhi);
+	mDrawTime = mPreviousTime + alpha * (mTotalTime - mPreviousTime);
+
+	// Rotate object
+	mPyramidWorld = MatrixRotationRollPitchYaw(sinf(phi), cosf(theta), cosf(phi) + sinf(theta));
+}
+
+BoxScene::SimulationState BoxScene::State() const
+{
+	SimulationState state = { mTheta, mPhi, mTotalTime };
+	return state;
+}
+
+void BoxScene::DrawScene()
+{
+	// LightSteelBlue
+	mStateCache->ClearRenderTarget(Float4(0.690196097f, 0.768627524f, 0.870588303f, 1.0f));
+	mStateCache->ClearDepthStencil(1.0f, 0);
+
+	mStateCache->BeginFrame();
+	mStateCache->SetInputLayout(mInputLayout);
+	mStateCache->SetPrimitiveTopology(PrimitiveTopology::TriangleList);
+
+	mConstants.BeginFrame();
+	mTimeConstants->Set(mDrawTime);
+	mConstants.Commit(mTimeConstants, *mConstantUploader);
+
+	//DrawCube();
+	DrawPyramid();
+
+	// Constant traffic and state calls next to the frame stats in the caption
+	const StateCacheStats& state = mStateCache->CurrentFrame();
+	if (mConstants.CurrentFrame().TotalBytesUploaded() != mConstants.LastFrame().TotalBytesUploaded()
+		|| state.TotalIssued() != mStateCache->LastFrame().TotalIssued())
+	{
+		// Formatted in place, the caption keeps its capacity so this does not allocate
+		char constants[160];
+		char calls[256];
+		char caption[448];
+		FormatConstantUploadSummary(mConstants.CurrentFrame(), constants, sizeof(constants));
+		FormatStateCacheSummary(state, calls, sizeof(calls));
+		snprintf(caption, sizeof(caption), "Box Demo  %s  %s", constants, calls);
+		mCaption.assign(caption);
+	}
+}
+
+void BoxScene::DrawCube()
+{
+	DrawMesh(mCube, mWorld);
+}
+
+void BoxScene::DrawPyramid()
+{
+	DrawMesh(mPyramid, mPyramidWorld);
+}
+
+void BoxScene::DrawMesh(MeshBuffers& mesh, const Float4x4& worldMatrix)
+{
+	// Slot n gets stream n
+	for (size_t i = 0; i < mesh.VertexBuffers.size(); i++)
+	{
+		mStateCache->SetVertexBuffer(static_cast<uint32_t>(i), mesh.VertexBuffers[i], mesh.Strides[i], 0);
+	}
+	mStateCache->SetIndexBuffer(mesh.IndexBuffer, IndexFormat::UInt32, 0);
+
+	UpdateConstantBuffer(worldMatrix);
+	ApplyTechnique(mesh.IndexAmount);
+}
+
+void BoxScene::UpdateConstantBuffer(const Float4x4& worldMatrix)
+{
+	// Constant buffer
+	Float4x4 worldViewProj = MatrixMultiply(MatrixMultiply(worldMatrix, mView), mProj);
+
+	// Uploaded only if it differs from what the effect already holds
+	mWorldViewProjConstants->Set(worldViewProj);
+	mConstants.Commit(mWorldViewProjConstants, *mConstantUploader);
+}
+
+void BoxScene::ApplyTechnique(uint32_t indicesAmount)
+{
+	for (size_t pass = 0; pass < mPasses.size(); pass++)
+	{
+		mStateCache->ApplyPass(mPasses[pass]);
+
+		mStateCache->DrawIndexed(indicesAmount, 0, 0);
+	}
+}
+
+void BoxScene::OnMouseDown(uint32_t, int x, int y)
+{
+	mLastMouseX = x;
+	mLastMouseY = y;
+}
+
+void BoxScene::OnMouseMove(uint32_t buttons, int x, int y)
+{
+	// If state has left button
+	if ((buttons & MouseButtonLeft) != 0)
+	{
+		float dx = DegreesToRadians(0.25f * static_cast<float>(x - mLastMouseX));
+		float dy = DegreesToRadians(0.25f * static_cast<float>(y - mLastMouseY));
+
+		float oldPhi = mPhi;
+		mTheta += dx;
+		mPhi += dy;
+
+		// Restrict vertical
+		mPhi = Clamp(mPhi, 0.1f, MathPi - 0.1f);
+
+		// The previous step turns too so the interpolation does not undo the drag
+		mPreviousTheta += dx;
+		mPreviousPhi += mPhi - oldPhi;
+	}
+	else if ((buttons & MouseButtonRight) != 0)
+	{
+		float dx = 0.005f * static_cast<float>(x - mLastMouseX);
+		float dy = 0.005f * static_cast<float>(y - mLastMouseY);
+
+
+		mRadius += dx - dy;
+		mRadius = Clamp(mRadius, 3.0f, 15.0f);
+	}
+
+	mLastMouseX = x;
+	mLastMouseY = y;
+}
+
+void BoxScene::BuildGeometryBuffers()
+{
+	STARTUP_PHASE("BuildGeometryBuffers");
+
+	mCubeStreams = BuildStreams(cubeVertices);
+	BuildMeshBuffers(mCubeStreams, cubeMesh.Indices.data(), static_cast<uint32_t>(cubeMesh.Indices.size()), mCube);
+
+	mPyramidStreams = BuildStreams(pyramidVertices);
+	BuildMeshBuffers(mPyramidStreams, pyramidMesh.Indices.data(), static_cast<uint32_t>(pyramidMesh.Indices.size()), mPyramid);
+
+	// Both meshes are stored, DrawScene only draws the pyramid
+	size_t vertexAmount = cubeVertices.size() + pyramidVertices.size();
+	LogVertexColorReport("Box", vertexAmount, VertexStride<CombinedVertex>(), VertexStride<PackedCombinedVertex>(), pyramidVertices.size());
+}
+
+template<size_t N>
+VertexStreamSet BoxScene::BuildStreams(const std::array<CombinedVertex, N>& vertices)
+{
+	if (mPackedColors)
+	{
+		std::vector<PackedCombinedVertex> packed = PackVertexColors<PackedCombinedVertex>(std::vector<CombinedVertex>(vertices.begin(), vertices.end()));
+		return BuildVertexStreams(packed.data(), static_cast<uint32_t>(packed.size()), mStreamLayout);
+	}
+	return BuildVertexStreams(vertices.data(), static_cast<uint32_t>(vertices.size()), mStreamLayout);
+}
+
+void BoxScene::BuildMeshBuffers(const VertexStreamSet& streams, const uint32_t* indices, uint32_t indexAmount, MeshBuffers& mesh)
+{
+	for (size_t i = 0; i < streams.Streams.size(); i++)
+	{
+		const VertexStream& stream = streams.Streams[i];
+		mesh.VertexBuffers.push_back(CreateImmutableBuffer(*mDevice, BufferBinding::Vertex, stream.Data.data(), static_cast<uint32_t>(stream.Data.size()), "Box"));
+		mesh.Strides.push_back(stream.Stride);
+	}
+
+	mesh.IndexBuffer = CreateImmutableBuffer(*mDevice, BufferBinding::Index, indices, sizeof(uint32_t) * indexAmount, "Box");
+	mesh.IndexAmount = indexAmount;
+}
+
+void BoxScene::ReleaseMeshBuffers(MeshBuffers& mesh)
+{
+	for (size_t i = 0; i < mesh.VertexBuffers.size(); i++)
+	{
+		mDevice->ReleaseBuffer(mesh.VertexBuffers[i]);
+	}
+	mesh.VertexBuffers.clear();
+	mesh.Strides.clear();
+	mDevice->ReleaseBuffer(mesh.IndexBuffer);
+	mesh.IndexBuffer = nullptr;
+}
+
+void BoxScene::BuildFX()
+{
+	STARTUP_PHASE("BuildFX");
+
+	mFX = mDevice->CreateEffect("FX/color.fx");
+	if (mFX == nullptr)
+	{
+		return;
+	}
+
+	uint32_t passCount = mDevice->PassCount(mFX, "ColorTech");
+	for (uint32_t pass = 0; pass < passCount; pass++)
+	{
+		mPasses.push_back(mDevice->FindPass(mFX, "ColorTech", pass));
+	}
+	mfxWorldViewProj = mDevice->FindConstant(mFX, "gWorldViewProj");
+	mfxTime = mDevice->FindConstant(mFX, "gTime");
+
+	mTimeConstants = mConstants.AddBlock(mfxTime, sizeof(float), UpdateFrequency::PerFrame);
+	mWorldViewProjConstants = mConstants.AddBlock(mfxWorldViewProj, sizeof(Float4x4), UpdateFrequency::PerObject);
+}
+
+void BoxScene::BuildVertexLayout()
+{
+	STARTUP_PHASE("BuildVertexLayout");
+
+	// Cube and pyramid use the same layout so either stream set describes it
+	mInputLayout = mDevice->CreateInputLayout(mCubeStreams.Elements, mPasses[0]);
+}
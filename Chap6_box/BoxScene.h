@@ -0,0 +1,118 @@
+#ifndef BOXSCENE_H
+#define BOXSCENE_H
+
+#include "DemoScene.h"
+#include "ConstantData.h"
+#include "StateCache.h"
+#include "VertexStreams.h"
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct CombinedVertex;
+
+class BoxScene : public DemoScene
+{
+public:
+	// Vertex colors are packed to RGBA8 unless 'packedColors' is false
+	explicit BoxScene(StreamLayout streamLayout, bool packedColors = true);
+
+	bool Init(IRenderDevice& device);
+	void Shutdown();
+
+	void OnResize(int width, int height);
+	void UpdateScene(float dt, float totalTime);
+	void Interpolate(float alpha);
+	void DrawScene();
+
+	const std::string& Caption() const { return mCaption; }
+
+	void OnMouseDown(uint32_t buttons, int x, int y);
+	void OnMouseMove(uint32_t buttons, int x, int y);
+
+	// What UpdateScene advances, the same after the same steps whatever the frame rate
+	struct SimulationState
+	{
+		float Theta;
+		float Phi;
+		float TotalTime;
+	};
+
+	SimulationState State() const;
+
+private:
+	// One vertex buffer per stream of the mesh, the stream index is the input slot
+	struct MeshBuffers
+	{
+		std::vector<RenderBuffer*> VertexBuffers;
+		std::vector<uint32_t> Strides;
+		RenderBuffer* IndexBuffer;
+		uint32_t IndexAmount;
+	};
+
+	void DrawCube();
+	void DrawPyramid();
+	void DrawMesh(MeshBuffers& mesh, const Float4x4& worldMatrix);
+	void UpdateConstantBuffer(const Float4x4& worldMatrix);
+	void ApplyTechnique(uint32_t indicesAmount);
+
+	void BuildGeometryBuffers();
+	template<size_t N> VertexStreamSet BuildStreams(const std::array<CombinedVertex, N>& vertices);
+	void BuildMeshBuffers(const VertexStreamSet& streams, const uint32_t* indices, uint32_t indexAmount, MeshBuffers& mesh);
+	void ReleaseMeshBuffers(MeshBuffers& mesh);
+	void BuildFX();
+	void BuildVertexLayout();
+
+	IRenderDevice* mDevice;
+
+	StreamLayout mStreamLayout;
+	bool mPackedColors;
+	VertexStreamSet mCubeStreams;
+	VertexStreamSet mPyramidStreams;
+
+	MeshBuffers mCube;
+	MeshBuffers mPyramid;
+
+	RenderEffect* mFX;
+	std::vector<RenderPass*> mPasses;
+	RenderConstant* mfxWorldViewProj;
+	RenderConstant* mfxTime;
+
+	// gTime changes once per frame, gWorldViewProj for every object
+	ConstantUpdater mConstants;
+	ConstantBlock* mTimeConstants;
+	ConstantBlock* mWorldViewProjConstants;
+
+	// Draw calls go through the state cache so rebinding the same state is dropped
+	std::unique_ptr<StateCachedContext> mStateCache;
+	std::unique_ptr<ContextConstantUploader> mConstantUploader;
+
+	RenderInputLayout* mInputLayout;
+
+	Float4x4 mPyramidWorld;
+
+	Float4x4 mWorld;
+
+	Float4x4 mView;
+	Float4x4 mProj;
+
+	float mTheta;
+	float mPhi;
+	float mRadius;
+	float mTotalTime;
+
+	// Before the last UpdateScene, the frame is drawn in between
+	float mPreviousTheta;
+	float mPreviousPhi;
+	float mPreviousTime;
+	float mDrawTime;
+
+	int mLastMouseX;
+	int mLastMouseY;
+
+	std::string mCaption;
+};
+
+#endif // BOXSCENE_H
@@ -0,0 +1,420 @@
+#include "HillsScene.h"
+#include "MeshGenerator.h"
+#include "VertexFormat.h"
+#include "ColorPacking.h"
+#include "StartupTrace.h"
+#include "JobSystem.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+// Local to this file, other scenes have their own Vertex
+namespace
+{
+	struct Vertex
+	{
+		Float3	Position;
+		Float4	Color;
+	};
+
+	// Same vertex with the color stored as R8G8B8A8_UNORM
+	struct PackedVertex
+	{
+		Float3	Position;
+		ColorRGBA8	Color;
+	};
+}
+
+template<> struct VertexFormat<Vertex>
+{
+	static constexpr std::array<VertexElement, 2> Elements =
+	{{
+		VERTEX_ELEMENT(Vertex, Position, "POSITION"),
+		VERTEX_ELEMENT(Vertex, Color, "COLOR")
+	}};
+};
+
+template<> struct VertexFormat<PackedVertex>
+{
+	static constexpr std::array<VertexElement, 2> Elements =
+	{{
+		VERTEX_ELEMENT(PackedVertex, Position, "POSITION"),
+		VERTEX_ELEMENT(PackedVertex, Color, "COLOR")
+	}};
+};
+
+static_assert(VertexFormatIsTight<Vertex>(), "Vertex has padding");
+static_assert(VertexFormatIsTight<PackedVertex>(), "PackedVertex has padding");
+
+HillsScene::HillsScene(JobSystem* jobs, bool waves, bool packedColors)
+	: mDevice(nullptr)
+	, mJobs(jobs)
+	, mWaves(waves)
+	, mPackedColors(packedColors)
+	, mTime(0.0f)
+	, mUploadFence(nullptr)
+	, mHillVB(nullptr)
+	, mVertexStride(0)
+	, mHillIB(nullptr)
+	, geometryIndexBufferSize(0)
+	, mFX(nullptr)
+	, mfxWorldViewProj(nullptr)
+	, mWorldViewProjConstants(nullptr)
+	, mInputLayout(nullptr)
+	, mCameraHeight(0.0f)
+	, mCameraDistance(10.0f)
+	, mCameraAngleAroundY(0.0f)
+	, mLastMouseX(0)
+	, mLastMouseY(0)
+	, mCaption(waves ? "Hills Waves Demo" : "Hills Demo")
+{
+	mWorld = MatrixIdentity();
+	mView = MatrixIdentity();
+	mProj = MatrixIdentity();
+}
+
+bool HillsScene::Init(IRenderDevice& device)
+{
+	mDevice = &device;
+	mStateCache.reset(new StateCachedContext(device.ImmediateContext()));
+	mConstantUploader.reset(new ContextConstantUploader(*mStateCache));
+
+	BuildGeometryBuffers();
+	BuildFX();
+	if (mFX == nullptr)
+	{
+		return false;
+	}
+	BuildVertexLayout();
+
+	return true;
+}
+
+void HillsScene::Shutdown()
+{
+	mUpload.reset();
+	mDevice->ReleaseFrameFence(mUploadFence);
+	mUploadFence = nullptr;
+	mDevice->ReleaseBuffer(mHillVB);
+	mDevice->ReleaseBuffer(mHillIB);
+	mDevice->ReleaseInputLayout(mInputLayout);
+	mDevice->ReleaseEffect(mFX);
+	mHillVB = nullptr;
+	mHillIB = nullptr;
+	mInputLayout = nullptr;
+	mFX = nullptr;
+}
+
+void HillsScene::OnResize(int width, int height)
+{
+	// Update projection matrix
+	mProj = MatrixPerspectiveFovLH(0.25f * MathPi, static_cast<float>(width) / height, 1.0f, 1000.0f);
+}
+
+void HillsScene::UpdateScene(float, float totalTime)
+{
+	mTime = totalTime;
+	Float3 up(0.0f, 1.0f, 0.0f);
+
+	float y = mCameraHeight;
+	float z = mCameraDistance;
+
+
+	// View matrix points to origo
+	Float4 pos(0.0f, y, z, 1.0f);
+
+	// Rotate this pos around Y axis by cameraAngleAroundY
+	Float4 rotatedPos = Transform(pos, MatrixRotationY(mCameraAngleAroundY));
+
+	Float3 target(0.0f, 0.0f, 0.0f);
+
+
+	mView = MatrixLookAtLH(Float3(rotatedPos.x, rotatedPos.y, rotatedPos.z), target, up);
+}
+
+void HillsScene::DrawScene()
+{
+	// Blue
+	mStateCache->ClearRenderTarget(Float4(0.0f, 0.0f, 1.0f, 1.0f));
+	mStateCache->ClearDepthStencil(1.0f, 0);
+
+	// Bound every frame, the cache only issues what changed
+	mStateCache->BeginFrame();
+	mStateCache->SetInputLayout(mInputLayout);
+	mStateCache->SetPrimitiveTopology(PrimitiveTopology::TriangleList);
+	if (mUpload)
+	{
+		UploadAllocation vertices = mUpload->Allocate(mVertexStride * static_cast<uint32_t>(mGridPositions.size()), mVertexStride);
+		if (vertices.Data != nullptr)
+		{
+			WriteWaveVertices(vertices.Data);
+		}
+		mUpload->Unmap();
+		mStateCache->SetVertexBuffer(0, vertices.Buffer, mVertexStride, vertices.Offset);
+	}
+	else
+	{
+		mStateCache->SetVertexBuffer(0, mHillVB, mVertexStride, 0);
+	}
+	mStateCache->SetIndexBuffer(mHillIB, IndexFormat::UInt32, 0);
+
+	// Constant buffer
+	Float4x4 worldViewProj = MatrixMultiply(MatrixMultiply(mWorld, mView), mProj);
+
+	mConstants.BeginFrame();
+	mWorldViewProjConstants->Set(worldViewProj);
+	mConstants.Commit(*mConstantUploader);
+
+	for (size_t pass = 0; pass < mPasses.size(); pass++)
+	{
+		mStateCache->ApplyPass(mPasses[pass]);
+
+		mStateCache->DrawIndexed(geometryIndexBufferSize, 0, 0);
+	}
+
+	if (mUpload)
+	{
+		mUpload->EndFrame();
+	}
+
+	// Constant traffic and state calls next to the frame stats in the caption
+	const StateCacheStats& state = mStateCache->CurrentFrame();
+	if (mConstants.CurrentFrame().TotalBytesUploaded() != mConstants.LastFrame().TotalBytesUploaded()
+		|| state.TotalIssued() != mStateCache->LastFrame().TotalIssued()
+		|| mUpload)
+	{
+		// Formatted in place, the caption keeps its capacity so this does not allocate
+		char constants[160];
+		char calls[256];
+		char caption[512];
+		FormatConstantUploadSummary(mConstants.CurrentFrame(), constants, sizeof(constants));
+		FormatStateCacheSummary(state, calls, sizeof(calls));
+		if (mUpload)
+		{
+			const UploadRingStats& upload = mUpload->Stats();
+			snprintf(caption, sizeof(caption), "Hills Waves Demo  %s  %s  Streamed: %.1f KB/frame, %u stalls", constants, calls, upload.FrameBytes / 1024.0, upload.Stalls);
+		}
+		else
+		{
+			snprintf(caption, sizeof(caption), "Hills Demo  %s  %s", constants, calls);
+		}
+		mCaption.assign(caption);
+	}
+}
+
+void HillsScene::OnMouseDown(uint32_t, int x, int y)
+{
+	mLastMouseX = x;
+	mLastMouseY = y;
+}
+
+void HillsScene::OnMouseMove(uint32_t buttons, int x, int y)
+{
+	// If state has left button
+	if ((buttons & MouseButtonLeft) != 0)
+	{
+		float changeSpeed = 0.05f;
+		float dy = changeSpeed * static_cast<float>(y - mLastMouseY);
+
+
+		mCameraHeight += dy;
+
+		// Restrict vertical
+		mCameraHeight = Clamp(mCameraHeight, -100.0f, 100.0f);
+
+		// Rotate around
+		float dx = changeSpeed * static_cast<float>(x - mLastMouseX);
+
+		float radianChange = DegreesToRadians(dx);
+		mCameraAngleAroundY += radianChange;
+
+	}
+	else if ((buttons & MouseButtonRight) != 0)
+	{
+		float changeSpeed = 0.05f;
+		float dy = changeSpeed * static_cast<float>(y - mLastMouseY);
+
+
+		mCameraDistance +=  dy;
+		mCameraDistance = Clamp(mCameraDistance, -200.0f, 200.0f);
+	}
+
+	mLastMouseX = x;
+	mLastMouseY = y;
+}
+
+float HillsScene::getHeightOnGrid(float x, float z)
+{
+	return 0.3f * (z*sinf(0.1f * x) + x * cosf(0.1f * z));
+}
+
+Float4 HillsScene::colorByHeight(float height)
+{
+	static const float beachLevel = -10.0f;
+	static const float lightGrassLevel = 5.0f;
+	static const float darkGrassLevel = 12.0f;
+	static const float hillLevel = 20.0f;
+
+	static const Float4 sandColor(1.0f, 0.96f, 0.62f, 1.0f);
+	static const Float4 lightGrassColor(0.48f, 0.77f, 0.46f, 1.0f);
+	static const Float4 darkGrassColor(0.1f, 0.48f, 0.619f, 1.0f);
+	static const Float4 hillColor(0.45f, 0.39f, 0.34f, 1.0f);
+	static const Float4 snowColor(1.0f, 0.96f, 1.0f, 1.0f);
+
+	if (height < beachLevel)
+	{
+		return sandColor;
+	}
+	else if (height < lightGrassLevel)
+	{
+		return lightGrassColor;
+	}
+	else if (height < darkGrassLevel)
+	{
+		return darkGrassColor;
+	}
+	else if (height < hillLevel)
+	{
+		return hillColor;
+	}
+	else
+	{
+		return snowColor;
+	}
+
+	return sandColor;
+}
+
+void HillsScene::BuildGeometryBuffers()
+{
+	STARTUP_PHASE("BuildGeometryBuffers");
+
+	MeshGenerator::MeshData grid;
+
+	float gridWidth = 100.0f;
+	float gridDepth = 100.0f;
+	uint32_t verticesForWidth = 50;
+	uint32_t verticesForDepth = 50;
+
+	MeshGenerator::CreateGrid(gridWidth, gridDepth, verticesForWidth, verticesForDepth, grid);
+
+	uint32_t mGridIndexCount = static_cast<uint32_t>(grid.Indices.size());
+	geometryIndexBufferSize = mGridIndexCount;
+
+
+
+	// Extract from mesh to our own vertex format discarding normals and tangents
+	std::vector<Vertex> gridVertices(grid.Vertices.size());
+	auto buildVertices = [&](uint32_t first, uint32_t end)
+	{
+		for (uint32_t i = first; i < end; i++)
+		{
+			Float3 pos = grid.Vertices[i].Position;
+			pos.y = getHeightOnGrid(pos.x, pos.z);
+			gridVertices[i].Position = pos;
+
+			gridVertices[i].Color = colorByHeight(pos.y);
+		}
+	};
+
+	uint32_t vertexCount = static_cast<uint32_t>(grid.Vertices.size());
+	if (mJobs != nullptr)
+	{
+		mJobs->ParallelFor(vertexCount, 512, buildVertices);
+	}
+	else
+	{
+		buildVertices(0, vertexCount);
+	}
+
+	std::vector<PackedVertex> packedVertices;
+	const void* vertexData = nullptr;
+	if (mPackedColors)
+	{
+		packedVertices = PackVertexColors<PackedVertex>(gridVertices);
+		mVertexStride = VertexStride<PackedVertex>();
+		vertexData = &packedVertices[0];
+	}
+	else
+	{
+		mVertexStride = VertexStride<Vertex>();
+		vertexData = &gridVertices[0];
+	}
+
+	LogVertexColorReport("Hills", gridVertices.size(), VertexStride<Vertex>(), VertexStride<PackedVertex>(), gridVertices.size());
+
+	mHillIB = CreateImmutableBuffer(*mDevice, BufferBinding::Index, &grid.Indices[0], sizeof(uint32_t) * mGridIndexCount, "Hills");
+	if (!mWaves)
+	{
+		mHillVB = CreateImmutableBuffer(*mDevice, BufferBinding::Vertex, vertexData, mVertexStride * static_cast<uint32_t>(gridVertices.size()), "Hills");
+		return;
+	}
+
+	mGridPositions.resize(grid.Vertices.size());
+	for (size_t i = 0; i < grid.Vertices.size(); i++)
+	{
+		mGridPositions[i] = grid.Vertices[i].Position;
+	}
+
+	// Room for the frames in flight and one more, so writing never waits on the GPU
+	uint32_t frameBytes = mVertexStride * static_cast<uint32_t>(mGridPositions.size());
+	mUploadFence = mDevice->CreateFrameFence();
+	mUpload.reset(new UploadRing(*mDevice, *mUploadFence, BufferBinding::Vertex, 4 * frameBytes + mVertexStride, 3, "Hills"));
+}
+
+void HillsScene::WriteWaveVertices(uint8_t* target)
+{
+	// Written in order and never read back, the memory may be write combined
+	for (size_t i = 0; i < mGridPositions.size(); i++)
+	{
+		Float3 pos = mGridPositions[i];
+		float wave = 0.75f + 0.25f * sinf(mTime + 0.05f * (pos.x + pos.z));
+		pos.y = wave * getHeightOnGrid(pos.x, pos.z);
+		Float4 color = colorByHeight(pos.y);
+		if (mPackedColors)
+		{
+			PackedVertex vertex = { pos, PackColor(color) };
+			memcpy(target + i * sizeof(vertex), &vertex, sizeof(vertex));
+		}
+		else
+		{
+			Vertex vertex = { pos, color };
+			memcpy(target + i * sizeof(vertex), &vertex, sizeof(vertex));
+		}
+	}
+}
+
+void HillsScene::BuildFX()
+{
+	STARTUP_PHASE("BuildFX");
+
+	mFX = mDevice->CreateEffect("FX/color.fx");
+	if (mFX == nullptr)
+	{
+		return;
+	}
+
+	uint32_t passCount = mDevice->PassCount(mFX, "ColorTech");
+	for (uint32_t pass = 0; pass < passCount; pass++)
+	{
+		mPasses.push_back(mDevice->FindPass(mFX, "ColorTech", pass));
+	}
+	mfxWorldViewProj = mDevice->FindConstant(mFX, "gWorldViewProj");
+
+	mWorldViewProjConstants = mConstants.AddBlock(mfxWorldViewProj, sizeof(Float4x4), UpdateFrequency::PerView);
+}
+
+void HillsScene::BuildVertexLayout()
+{
+	STARTUP_PHASE("BuildVertexLayout");
+
+	if (mPackedColors)
+	{
+		mInputLayout = mDevice->CreateInputLayout(InterleavedElements<PackedVertex>(), mPasses[0]);
+	}
+	else
+	{
+		mInputLayout = mDevice->CreateInputLayout(InterleavedElements<Vertex>(), mPasses[0]);
+	}
+}
@@ -0,0 +1,91 @@
+#ifndef HILLSSCENE_H
+#define HILLSSCENE_H
+
+#include "DemoScene.h"
+#include "ConstantData.h"
+#include "StateCache.h"
+#include "UploadRing.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class JobSystem;
+
+// With 'waves' the terrain rises and falls over time. Its vertices are then
+// rewritten every frame into an UploadRing instead of an immutable buffer.
+class HillsScene : public DemoScene
+{
+public:
+	// The terrain is generated on 'jobs' when there is one. Vertex colors are
+	// packed to RGBA8 unless 'packedColors' is false.
+	explicit HillsScene(JobSystem* jobs = nullptr, bool waves = false, bool packedColors = true);
+
+	bool Init(IRenderDevice& device);
+	void Shutdown();
+
+	void OnResize(int width, int height);
+	void UpdateScene(float dt, float totalTime);
+	void DrawScene();
+
+	const std::string& Caption() const { return mCaption; }
+
+	void OnMouseDown(uint32_t buttons, int x, int y);
+	void OnMouseMove(uint32_t buttons, int x, int y);
+
+	// Null without waves
+	const UploadRing* Upload() const { return mUpload.get(); }
+
+private:
+
+	float getHeightOnGrid(float x, float z);
+	Float4 colorByHeight(float height);
+
+	void BuildGeometryBuffers();
+	void BuildFX();
+	void BuildVertexLayout();
+	void WriteWaveVertices(uint8_t* target);
+
+	IRenderDevice* mDevice;
+	JobSystem* mJobs;
+	bool mWaves;
+	bool mPackedColors;
+	float mTime;
+	std::vector<Float3> mGridPositions;		// Flat, the waves set the heights
+	IFrameFence* mUploadFence;
+	std::unique_ptr<UploadRing> mUpload;
+
+	RenderBuffer* mHillVB;
+	uint32_t mVertexStride;
+	RenderBuffer* mHillIB;
+	uint32_t geometryIndexBufferSize;
+
+	RenderEffect* mFX;
+	std::vector<RenderPass*> mPasses;
+	RenderConstant* mfxWorldViewProj;
+
+	// Only the camera changes gWorldViewProj, it is skipped while the view is still
+	ConstantUpdater mConstants;
+	ConstantBlock* mWorldViewProjConstants;
+
+	// Draw calls go through the state cache so rebinding the same state is dropped
+	std::unique_ptr<StateCachedContext> mStateCache;
+	std::unique_ptr<ContextConstantUploader> mConstantUploader;
+
+	RenderInputLayout* mInputLayout;
+
+	Float4x4 mWorld;
+	Float4x4 mView;
+	Float4x4 mProj;
+
+	float mCameraHeight;
+	float mCameraDistance;
+	float mCameraAngleAroundY;
+
+	int mLastMouseX;
+	int mLastMouseY;
+
+	std::string mCaption;
+};
+
+#endif // HILLSSCENE_H
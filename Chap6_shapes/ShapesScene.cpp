@@ -0,0 +1,477 @@
+#include "ShapesScene.h"
+#include "VertexFormat.h"
+#include "ColorPacking.h"
+#include "FrameProfiler.h"
+#include "StartupTrace.h"
+
+#include <algorithm>
+#include <cstdio>
+
+struct ShapesVertex
+{
+	Float3	Position;
+	Float4	Color;
+};
+
+template<> struct VertexFormat<ShapesVertex>
+{
+	static constexpr std::array<VertexElement, 2> Elements =
+	{{
+		VERTEX_ELEMENT(ShapesVertex, Position, "POSITION"),
+		VERTEX_ELEMENT(ShapesVertex, Color, "COLOR")
+	}};
+};
+
+// Same vertex with the color stored as R8G8B8A8_UNORM
+struct PackedShapesVertex
+{
+	Float3	Position;
+	ColorRGBA8	Color;
+};
+
+template<> struct VertexFormat<PackedShapesVertex>
+{
+	static constexpr std::array<VertexElement, 2> Elements =
+	{{
+		VERTEX_ELEMENT(PackedShapesVertex, Position, "POSITION"),
+		VERTEX_ELEMENT(PackedShapesVertex, Color, "COLOR")
+	}};
+};
+
+static_assert(VertexFormatIsTight<ShapesVertex>(), "ShapesVertex has padding");
+static_assert(VertexFormatIsTight<PackedShapesVertex>(), "PackedShapesVertex has padding");
+
+// Size of the occlusion depth buffer
+static const uint32_t occlusionWidth = 256;
+static const uint32_t occlusionHeight = 128;
+
+static OccluderMesh ToOccluderMesh(const MeshGenerator::MeshData& mesh)
+{
+	OccluderMesh occluder;
+	occluder.Positions.resize(mesh.Vertices.size());
+	for (size_t i = 0; i < mesh.Vertices.size(); i++)
+	{
+		occluder.Positions[i] = mesh.Vertices[i].Position;
+	}
+	occluder.Indices = mesh.Indices;
+	return occluder;
+}
+
+// Draw submission is recorded in parallel, one partition per group of objects:
+// 0: grid and box, 1: cylinders, 2: spheres
+static const uint32_t drawPartitionCount = 3;
+
+// Grid, box, 10 cylinders and 10 spheres
+static const uint32_t maxDrawPackets = 22;
+
+// Packets and culling results with room to spare, two frames in flight
+static const size_t frameArenaBytes = 4096;
+static const uint32_t framesInFlight = 2;
+
+ShapesScene::ShapesScene(JobSystem* jobs, bool packedColors)
+	: mDevice(nullptr)
+	, mPackedColors(packedColors)
+	, mShapesVB(nullptr)
+	, mVertexStride(0)
+	, mShapesIB(nullptr)
+	, geometryIndexBufferSize(0)
+	, mFX(nullptr)
+	, mfxWorldViewProj(nullptr)
+	, mInputLayout(nullptr)
+	, mRecorder(drawPartitionCount, jobs)
+	, mOcclusion(occlusionWidth, occlusionHeight)
+	, mTestedCount(0)
+	, mOccludedCount(0)
+	, mFrameArena(frameArenaBytes, framesInFlight)
+	, mCameraHeight(0.0f)
+	, mCameraDistance(10.0f)
+	, mCameraAngleAroundY(0.0f)
+	, mLastMouseX(0)
+	, mLastMouseY(0)
+	, mCaption("Shapes Demo")
+{
+	mWorld = MatrixIdentity();
+	mView = MatrixIdentity();
+	mProj = MatrixIdentity();
+	mViewProj = MatrixIdentity();
+
+	// Create scene matrices
+
+	mGridWorld = MatrixIdentity();
+
+	Float4x4 boxScale = MatrixScaling(2.0f, 1.0f, 2.0f);
+	Float4x4 boxOffset = MatrixTranslation(0.f, 0.5f, 0.0f);
+	mBoxWorld = MatrixMultiply(boxScale, boxOffset);
+
+	for (int i = 0; i < 5; i++)
+	{
+		mCylinderWorldArray[i * 2 + 0] = MatrixTranslation(-5.0f, 1.5f, -10.0f + i * 5.0f);
+		mCylinderWorldArray[i * 2 + 1] = MatrixTranslation(+5.0f, 1.5f, -10.0f + i * 5.0f);
+
+		mSphereWorldArray[i * 2 + 0] = MatrixTranslation(-5.0f, 3.5f, -10.0f + i * 5.0f);
+		mSphereWorldArray[i * 2 + 1] = MatrixTranslation(+5.0f, 3.5f, -10.0f + i * 5.0f);
+	}
+
+	for (uint32_t i = 0; i <= drawPartitionCount; i++)
+	{
+		mPartitionStart[i] = 0;
+	}
+}
+
+bool ShapesScene::Init(IRenderDevice& device)
+{
+	mDevice = &device;
+	mStateCache.reset(new StateCachedContext(device.ImmediateContext()));
+
+	BuildGeometryBuffers();
+	BuildFX();
+	if (mFX == nullptr)
+	{
+		return false;
+	}
+	BuildVertexLayout();
+
+	return true;
+}
+
+void ShapesScene::Shutdown()
+{
+	mDevice->ReleaseBuffer(mShapesVB);
+	mDevice->ReleaseBuffer(mShapesIB);
+	mDevice->ReleaseInputLayout(mInputLayout);
+	mDevice->ReleaseEffect(mFX);
+	mShapesVB = nullptr;
+	mShapesIB = nullptr;
+	mInputLayout = nullptr;
+	mFX = nullptr;
+}
+
+void ShapesScene::OnResize(int width, int height)
+{
+	// Update projection matrix
+	mProj = MatrixPerspectiveFovLH(0.25f * MathPi, static_cast<float>(width) / height, 1.0f, 1000.0f);
+}
+
+void ShapesScene::UpdateScene(float, float)
+{
+	Float3 up(0.0f, 1.0f, 0.0f);
+
+	float y = mCameraHeight;
+	float z = mCameraDistance;
+
+
+	// View matrix points to origo
+	Float4 pos(0.0f, y, z, 1.0f);
+
+	// Rotate this pos around Y axis by cameraAngleAroundY
+	Float4 rotatedPos = Transform(pos, MatrixRotationY(mCameraAngleAroundY));
+
+	Float3 target(0.0f, 0.0f, 0.0f);
+
+
+	mView = MatrixLookAtLH(Float3(rotatedPos.x, rotatedPos.y, rotatedPos.z), target, up);
+}
+
+void ShapesScene::DrawScene()
+{
+	// Blue
+	mStateCache->ClearRenderTarget(Float4(0.0f, 0.0f, 1.0f, 1.0f));
+	mStateCache->ClearDepthStencil(1.0f, 0);
+
+	mViewProj = MatrixMultiply(mView, mProj);
+
+	mFrameArena.BeginFrame();
+
+	uint32_t occludedBefore = mOccludedCount;
+	BuildDrawPackets(CullOccludedShapes());
+
+	// Record on worker threads, replay here in partition order
+	mRecorder.Record([this](uint32_t partition, CommandBuffer& commands)
+	{
+		RecordPartition(partition, commands);
+	});
+
+	mStateCache->BeginFrame();
+	mRecorder.Replay(*mStateCache);
+
+	const StateCacheStats& state = mStateCache->CurrentFrame();
+	if (state.TotalIssued() != mStateCache->LastFrame().TotalIssued() || mOccludedCount != occludedBefore)
+	{
+		// Formatted in place, the caption keeps its capacity so this does not allocate
+		char calls[256];
+		char caption[320];
+		FormatStateCacheSummary(state, calls, sizeof(calls));
+		snprintf(caption, sizeof(caption), "Shapes Demo  Culled: %u of %u  %s", mOccludedCount, mTestedCount, calls);
+		mCaption.assign(caption);
+	}
+}
+
+FrameSpan<bool> ShapesScene::CullOccludedShapes()
+{
+	PROFILE_SCOPE("CullOccludedShapes");
+
+	mOcclusion.BeginFrame(mViewProj);
+	mOcclusion.AddOccluder(mBoxOccluder, mBoxWorld);
+	for (int i = 0; i < 10; i++)
+	{
+		mOcclusion.AddOccluder(mCylinderOccluder, mCylinderWorldArray[i]);
+	}
+	mOcclusion.BuildHierarchy();
+
+	// A cylinder may hide the ones behind it, its own depth never hides itself
+	FrameSpan<bool> visible = mFrameArena.AllocateArray<bool>(20);
+	mTestedCount = visible.Size();
+	mOccludedCount = 0;
+	for (uint32_t i = 0; i < 10; i++)
+	{
+		visible[i] = mOcclusion.IsVisible(mCylinderBounds, mCylinderWorldArray[i]);
+		visible[10 + i] = mOcclusion.IsVisible(mSphereBounds, mSphereWorldArray[i]);
+		mOccludedCount += (visible[i] ? 0 : 1) + (visible[10 + i] ? 0 : 1);
+	}
+	return visible;
+}
+
+void ShapesScene::BuildDrawPackets(const FrameSpan<bool>& visible)
+{
+	mPackets = mFrameArena.AllocateArray<DrawPacket>(maxDrawPackets);
+	uint32_t count = 0;
+
+	// Grid and box
+	mPartitionStart[0] = count;
+	mPackets[count++] = MakePacket(mGridWorld, mGridIndexCount, mGridIndexOffset, mGridVertexOffset);
+	mPackets[count++] = MakePacket(mBoxWorld, mBoxIndexCount, mBoxIndexOffset, mBoxVertexOffset);
+
+	// Cylinders
+	mPartitionStart[1] = count;
+	for (uint32_t i = 0; i < 10; i++)
+	{
+		if (visible[i])
+		{
+			mPackets[count++] = MakePacket(mCylinderWorldArray[i], mCylinderIndexCount, mCylinderIndexOffset, mCylinderVertexOffset);
+		}
+	}
+
+	// Spheres
+	mPartitionStart[2] = count;
+	for (uint32_t i = 0; i < 10; i++)
+	{
+		if (visible[10 + i])
+		{
+			mPackets[count++] = MakePacket(mSphereWorldArray[i], mSphereIndexCount, mSphereIndexOffset, mSphereVertexOffset);
+		}
+	}
+	mPartitionStart[3] = count;
+}
+
+ShapesScene::DrawPacket ShapesScene::MakePacket(const Float4x4& world, uint32_t indexCount, uint32_t indexOffset, uint32_t vertexOffset) const
+{
+	DrawPacket packet;
+	packet.WorldViewProj = MatrixMultiply(world, mViewProj);
+	packet.IndexCount = indexCount;
+	packet.IndexOffset = indexOffset;
+	packet.VertexOffset = vertexOffset;
+	return packet;
+}
+
+void ShapesScene::RecordPartition(uint32_t partition, CommandBuffer& commands)
+{
+	PROFILE_SCOPE("RecordPartition");
+
+	// Partitions do not rely on each other for bound state
+	commands.SetInputLayout(mInputLayout);
+	commands.SetPrimitiveTopology(PrimitiveTopology::TriangleList);
+	commands.SetVertexBuffer(0, mShapesVB, mVertexStride, 0);
+	commands.SetIndexBuffer(mShapesIB, IndexFormat::UInt32, 0);
+
+	for (uint32_t i = mPartitionStart[partition]; i < mPartitionStart[partition + 1]; i++)
+	{
+		RecordDraw(commands, mPackets[i]);
+	}
+}
+
+void ShapesScene::RecordDraw(CommandBuffer& commands, const DrawPacket& packet)
+{
+	for (size_t pass = 0; pass < mPasses.size(); pass++)
+	{
+		commands.SetConstants(mfxWorldViewProj, &packet.WorldViewProj, sizeof(packet.WorldViewProj));
+		commands.ApplyPass(mPasses[pass]);
+		commands.DrawIndexed(packet.IndexCount, packet.IndexOffset, packet.VertexOffset);
+	}
+}
+
+void ShapesScene::OnMouseDown(uint32_t, int x, int y)
+{
+	mLastMouseX = x;
+	mLastMouseY = y;
+}
+
+void ShapesScene::OnMouseMove(uint32_t buttons, int x, int y)
+{
+	// If state has left button
+	if ((buttons & MouseButtonLeft) != 0)
+	{
+		float changeSpeed = 0.05f;
+		float dy = changeSpeed * static_cast<float>(y - mLastMouseY);
+
+
+		mCameraHeight += dy;
+
+		// Restrict vertical
+		mCameraHeight = Clamp(mCameraHeight, -100.0f, 100.0f);
+
+		// Rotate around
+		float dx = changeSpeed * static_cast<float>(x - mLastMouseX);
+
+		float radianChange = DegreesToRadians(dx);
+		mCameraAngleAroundY += radianChange;
+
+	}
+	else if ((buttons & MouseButtonRight) != 0)
+	{
+		float changeSpeed = 0.05f;
+		float dy = changeSpeed * static_cast<float>(y - mLastMouseY);
+
+
+		mCameraDistance += dy;
+		mCameraDistance = Clamp(mCameraDistance, -200.0f, 200.0f);
+	}
+
+	mLastMouseX = x;
+	mLastMouseY = y;
+}
+
+uint32_t ShapesScene::packIntoBuffer(std::vector<ShapesVertex> &target, std::vector<StaticGeometry::MeshVertex> &source, uint32_t startIndex, Float4 color)
+{
+	for (size_t i = 0; i < source.size(); i++, startIndex++)
+	{
+		target[startIndex].Position = source[i].Position;
+		target[startIndex].Color = color;
+	}
+
+	return startIndex;
+}
+
+void ShapesScene::BuildGeometryBuffers()
+{
+	STARTUP_PHASE("BuildGeometryBuffers");
+
+	MeshGenerator::MeshData grid;
+	MeshGenerator::MeshData box;
+	MeshGenerator::MeshData cylinder;
+	MeshGenerator::MeshData sphere;
+
+	float gridWidth = 100.0f;
+	float gridDepth = 100.0f;
+	uint32_t verticesForWidth = 50;
+	uint32_t verticesForDepth = 50;
+
+	MeshGenerator::CreateGrid(gridWidth, gridDepth, verticesForWidth, verticesForDepth, grid);
+	MeshGenerator::CreateBox(1.0f, 1.0f, 1.0f, box);
+	MeshGenerator::CreateCylinder(0.5f, 0.3f, 3.0f, 20, 20, cylinder);
+	MeshGenerator::CreateSphere(0.5f, 20, 20, sphere);
+
+	// The occluders are inscribed in the drawn shapes so they never hide too much
+	MeshGenerator::MeshData cylinderOccluder;
+	MeshGenerator::CreateCylinder(0.5f, 0.3f, 3.0f, 8, 1, cylinderOccluder);
+	mBoxOccluder = ToOccluderMesh(box);
+	mCylinderOccluder = ToOccluderMesh(cylinderOccluder);
+	mCylinderBounds = ComputeBounds(ToOccluderMesh(cylinder).Positions);
+	mSphereBounds = ComputeBounds(ToOccluderMesh(sphere).Positions);
+
+	mBoxVertexOffset = 0;
+	mGridVertexOffset = mBoxVertexOffset + static_cast<uint32_t>(box.Vertices.size());
+	mCylinderVertexOffset = mGridVertexOffset + static_cast<uint32_t>(grid.Vertices.size());
+	mSphereVertexOffset = mCylinderVertexOffset + static_cast<uint32_t>(cylinder.Vertices.size());
+
+	mBoxIndexCount = static_cast<uint32_t>(box.Indices.size());
+	mGridIndexCount = static_cast<uint32_t>(grid.Indices.size());
+	mCylinderIndexCount = static_cast<uint32_t>(cylinder.Indices.size());
+	mSphereIndexCount = static_cast<uint32_t>(sphere.Indices.size());
+
+	mBoxIndexOffset = 0;
+	mGridIndexOffset = mBoxIndexOffset + mBoxIndexCount;
+	mCylinderIndexOffset = mGridIndexOffset + mGridIndexCount;
+	mSphereIndexOffset = mCylinderIndexOffset + mCylinderIndexCount;
+
+	uint32_t totalVertexCount = mSphereVertexOffset + static_cast<uint32_t>(sphere.Vertices.size());
+	uint32_t totalIndexCount = mSphereIndexOffset + mSphereIndexCount;
+
+	std::vector<ShapesVertex> vertices(totalVertexCount);
+
+	Float4 black(0.0f, 0.0f, 0.0f, 1.0f);
+	Float4 red(1.0f, 0.6f, 0.6f, 1.0f);
+	Float4 darkRed(0.6f, 0.2f, 0.2f, 1.0f);
+	Float4 white(0.8f, 0.8f, 0.8f, 1.0f);
+
+
+	uint32_t bi = 0; // Buffer index
+	bi = packIntoBuffer(vertices, box.Vertices, bi, red);
+	bi = packIntoBuffer(vertices, grid.Vertices, bi, black);
+	bi = packIntoBuffer(vertices, cylinder.Vertices, bi, darkRed);
+	bi = packIntoBuffer(vertices, sphere.Vertices, bi, white);
+
+
+
+	std::vector<PackedShapesVertex> packedVertices;
+	const void* vertexData = nullptr;
+	if (mPackedColors)
+	{
+		packedVertices = PackVertexColors<PackedShapesVertex>(vertices);
+		mVertexStride = VertexStride<PackedShapesVertex>();
+		vertexData = &packedVertices[0];
+	}
+	else
+	{
+		mVertexStride = VertexStride<ShapesVertex>();
+		vertexData = &vertices[0];
+	}
+
+	// Every frame draws the grid and box once and ten of the cylinders and spheres
+	uint64_t verticesPerFrame = box.Vertices.size() + grid.Vertices.size() + 10 * (cylinder.Vertices.size() + sphere.Vertices.size());
+	LogVertexColorReport("Shapes", totalVertexCount, VertexStride<ShapesVertex>(), VertexStride<PackedShapesVertex>(), verticesPerFrame);
+
+	mShapesVB = CreateImmutableBuffer(*mDevice, BufferBinding::Vertex, vertexData, mVertexStride * totalVertexCount, "Shapes");
+
+	std::vector<uint32_t> indices;
+	indices.reserve(totalIndexCount);
+	indices.insert(indices.end(), box.Indices.begin(), box.Indices.end());
+	indices.insert(indices.end(), grid.Indices.begin(), grid.Indices.end());
+	indices.insert(indices.end(), cylinder.Indices.begin(), cylinder.Indices.end());
+	indices.insert(indices.end(), sphere.Indices.begin(), sphere.Indices.end());
+
+
+
+	mShapesIB = CreateImmutableBuffer(*mDevice, BufferBinding::Index, &indices[0], sizeof(uint32_t) * totalIndexCount, "Shapes");
+}
+
+void ShapesScene::BuildFX()
+{
+	STARTUP_PHASE("BuildFX");
+
+	mFX = mDevice->CreateEffect("FX/color.fx");
+	if (mFX == nullptr)
+	{
+		return;
+	}
+
+	uint32_t passCount = mDevice->PassCount(mFX, "ColorTech");
+	for (uint32_t pass = 0; pass < passCount; pass++)
+	{
+		mPasses.push_back(mDevice->FindPass(mFX, "ColorTech", pass));
+	}
+	mfxWorldViewProj = mDevice->FindConstant(mFX, "gWorldViewProj");
+}
+
+void ShapesScene::BuildVertexLayout()
+{
+	STARTUP_PHASE("BuildVertexLayout");
+
+	if (mPackedColors)
+	{
+		mInputLayout = mDevice->CreateInputLayout(InterleavedElements<PackedShapesVertex>(), mPasses[0]);
+	}
+	else
+	{
+		mInputLayout = mDevice->CreateInputLayout(InterleavedElements<ShapesVertex>(), mPasses[0]);
+	}
+}
@@ -0,0 +1,135 @@
+#ifndef SHAPESSCENE_H
+#define SHAPESSCENE_H
+
+#include "DemoScene.h"
+#include "CommandBuffer.h"
+#include "StateCache.h"
+#include "MeshGenerator.h"
+#include "OcclusionCuller.h"
+#include "FrameArena.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+struct ShapesVertex;
+class JobSystem;
+
+class ShapesScene : public DemoScene
+{
+public:
+	// Draw commands are recorded on the threads of 'jobs' when given. Vertex
+	// colors are packed to RGBA8 unless 'packedColors' is false.
+	explicit ShapesScene(JobSystem* jobs = nullptr, bool packedColors = true);
+
+	bool Init(IRenderDevice& device);
+	void Shutdown();
+
+	void OnResize(int width, int height);
+	void UpdateScene(float dt, float totalTime);
+	void DrawScene();
+
+	const std::string& Caption() const { return mCaption; }
+
+	void OnMouseDown(uint32_t buttons, int x, int y);
+	void OnMouseMove(uint32_t buttons, int x, int y);
+
+private:
+
+	void BuildGeometryBuffers();
+	void BuildFX();
+	void BuildVertexLayout();
+
+	// One draw of the frame with its constants, in the frame arena
+	struct DrawPacket
+	{
+		Float4x4 WorldViewProj;
+		uint32_t IndexCount;
+		uint32_t IndexOffset;
+		uint32_t VertexOffset;
+	};
+
+	// Tests the cylinders and spheres against the box and the cylinders,
+	// true for the visible ones, cylinders first
+	FrameSpan<bool> CullOccludedShapes();
+	// The visible shapes in partition order into mPackets
+	void BuildDrawPackets(const FrameSpan<bool>& visible);
+	DrawPacket MakePacket(const Float4x4& world, uint32_t indexCount, uint32_t indexOffset, uint32_t vertexOffset) const;
+
+	void RecordPartition(uint32_t partition, CommandBuffer& commands);
+	void RecordDraw(CommandBuffer& commands, const DrawPacket& packet);
+
+	uint32_t packIntoBuffer(std::vector<ShapesVertex> &target, std::vector<StaticGeometry::MeshVertex> &source, uint32_t startIndex, Float4 color);
+
+	IRenderDevice* mDevice;
+	bool mPackedColors;
+
+	RenderBuffer* mShapesVB;
+	uint32_t mVertexStride;
+	RenderBuffer* mShapesIB;
+	uint32_t geometryIndexBufferSize;
+
+	RenderEffect* mFX;
+	RenderConstant* mfxWorldViewProj;
+
+	RenderInputLayout* mInputLayout;
+
+	std::vector<RenderPass*> mPasses;
+	ParallelCommandRecorder mRecorder;
+
+	// Every partition binds its own input state, the cache drops the repeats on replay
+	std::unique_ptr<StateCachedContext> mStateCache;
+
+	Float4x4 mWorld;
+	Float4x4 mView;
+	Float4x4 mProj;
+	Float4x4 mViewProj;
+
+	// Matrices of shapes
+	Float4x4 mSphereWorldArray[10];
+	Float4x4 mCylinderWorldArray[10];
+	Float4x4 mBoxWorld;
+	Float4x4 mGridWorld;
+
+	// Vertex offsets and counts 
+	// Everything is stored in the same buffer
+	uint32_t mBoxVertexOffset;
+	uint32_t mCylinderVertexOffset;
+	uint32_t mGridVertexOffset;
+	uint32_t mSphereVertexOffset;
+
+	uint32_t mBoxIndexCount;
+	uint32_t mCylinderIndexCount;
+	uint32_t mGridIndexCount;
+	uint32_t mSphereIndexCount;
+
+	uint32_t mBoxIndexOffset;
+	uint32_t mCylinderIndexOffset;
+	uint32_t mGridIndexOffset;
+	uint32_t mSphereIndexOffset;
+
+	// Low poly stand-ins for the box and cylinders and the bounds of the tested shapes
+	OcclusionCuller mOcclusion;
+	OccluderMesh mBoxOccluder;
+	OccluderMesh mCylinderOccluder;
+	Bounds mCylinderBounds;
+	Bounds mSphereBounds;
+	uint32_t mTestedCount;
+	uint32_t mOccludedCount;
+
+	// Culling results and draw packets live for one frame
+	FrameArena mFrameArena;
+	FrameSpan<DrawPacket> mPackets;
+	uint32_t mPartitionStart[4];	// First packet of each partition and the end
+
+	float mCameraHeight;
+	float mCameraDistance;
+	float mCameraAngleAroundY;
+
+	int mLastMouseX;
+	int mLastMouseY;
+
+	std::string mCaption;
+};
+
+#endif // SHAPESSCENE_H
@@ -0,0 +1,410 @@
+#include "SkullScene.h"
+#include "CookedMesh.h"
+#include "VertexFormat.h"
+#include "Log.h"
+#include "StartupTrace.h"
+
+// For reading model data from file
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+struct SkullVertex
+{
+	Float3	Position;
+	Float3	Normal;
+};
+
+template<> struct VertexFormat<SkullVertex>
+{
+	static constexpr std::array<VertexElement, 2> Elements =
+	{{
+		VERTEX_ELEMENT(SkullVertex, Position, "POSITION"),
+		VERTEX_ELEMENT(SkullVertex, Normal, "NORMAL")
+	}};
+};
+
+static_assert(VertexFormatIsTight<SkullVertex>(), "SkullVertex has padding");
+
+namespace
+{
+	// The book's text format
+	bool ReadTextModel(const std::string& fileName, std::vector<SkullVertex>& skullVertices, std::vector<uint32_t>& skullIndices)
+	{
+		// Load vertices from file
+		std::ifstream modelFile(fileName);
+		if (!modelFile)
+		{
+			LogMessage("Could not open file " + fileName + "\n");
+			return false;
+		}
+		modelFile.seekg(0, std::ios::end);
+		CountFileBytesRead(static_cast<uint64_t>(modelFile.tellg()));
+		modelFile.seekg(0, std::ios::beg);
+
+		// Read vertex amount
+		std::string headerString;
+		uint32_t vertexAmount = 0;
+		uint32_t triangleCount = 0;
+		modelFile >> headerString;
+		if (headerString.find("VertexCount:") != std::string::npos)
+		{
+			// Next is the amount
+			modelFile >> vertexAmount;
+		}
+
+		// else etc...
+		modelFile >> headerString;
+		if (headerString.find("TriangleCount:") != std::string::npos)
+		{
+			modelFile >> triangleCount;
+		}
+
+		modelFile >> headerString;
+		if (headerString.find("VertexList") != std::string::npos)
+		{
+			// ok
+		}
+
+		// Read vertices
+
+		do {
+			modelFile >> headerString;
+		} while (modelFile && headerString.find("{") == std::string::npos);
+
+
+		skullVertices.resize(vertexAmount);
+		float x, y, z;
+		float nx, ny, nz;
+
+		for (uint32_t i = 0; i < vertexAmount; i++)
+		{
+			modelFile >> x >> y >> z >> nx >> ny >> nz;
+			skullVertices[i] = { Float3(x, y, z), Float3(nx, ny, nz) };
+		}
+
+		do {
+			modelFile >> headerString;
+		} while (modelFile && headerString.find("}") == std::string::npos);
+
+
+		// Read triangles
+
+		modelFile >> headerString;
+		if (headerString.find("TriangleList") != std::string::npos)
+		{
+
+		}
+
+		do {
+			modelFile >> headerString;
+		} while (modelFile && headerString.find("{") == std::string::npos);
+
+		uint32_t indexAmount = triangleCount * 3;
+		skullIndices.resize(indexAmount);
+		for (uint32_t i = 0; i < indexAmount; i++)
+		{
+			modelFile >> skullIndices[i];
+		}
+
+		do {
+			modelFile >> headerString;
+		} while (modelFile && headerString.find("}") == std::string::npos);
+
+		modelFile.close();
+
+		if (vertexAmount == 0 || indexAmount == 0)
+		{
+			LogMessage("No geometry in " + fileName + "\n");
+			return false;
+		}
+		return true;
+	}
+
+	// What AssetCooker makes of it, dequantized into the book's vertex
+	bool ReadCookedModel(const std::string& fileName, std::vector<SkullVertex>& skullVertices, std::vector<uint32_t>& skullIndices)
+	{
+		CookedMesh mesh;
+		if (!ReadCookedMesh(fileName, mesh) || mesh.Indices.empty())
+		{
+			LogMessage("Could not read cooked model " + fileName + "\n");
+			return false;
+		}
+		CountFileBytesRead(sizeof(mesh.Header) + mesh.Header.VertexDataBytes + mesh.Header.IndexDataBytes);
+
+		skullVertices.resize(mesh.Vertices.size());
+		for (size_t i = 0; i < mesh.Vertices.size(); i++)
+		{
+			skullVertices[i] = { DecodePosition(mesh.Header, mesh.Vertices[i]), DecodeNormal(mesh.Vertices[i]) };
+		}
+		skullIndices.swap(mesh.Indices);
+		return true;
+	}
+}
+
+SkullScene::SkullScene(const char* modelFile)
+	: mDevice(nullptr)
+	, mModelFile(modelFile)
+	, mSkullVB()
+	, mSkullIB()
+	, mSkullIndexAmount(0)
+	, mFX()
+	, mfxWorldViewProj(nullptr)
+	, mWorldViewProjConstants(nullptr)
+	, mInputLayout()
+	, mTheta(1.5f * MathPi)
+	, mPhi(0.25f * MathPi)
+	, mRadius(20.0f)
+	, mLastMouseX(0)
+	, mLastMouseY(0)
+	, mClientWidth(0)
+	, mClientHeight(0)
+	, mPickedTriangle(~0u)
+	, mPickedDistance(0.0f)
+	, mPickChanged(false)
+	, mCaption("Skull Demo")
+{
+	mWorld = MatrixIdentity();
+	mView = MatrixIdentity();
+	mProj = MatrixIdentity();
+}
+
+bool SkullScene::Init(IRenderDevice& device)
+{
+	mDevice = &device;
+	mResources.reset(new RenderResources(device));
+	mStateCache.reset(new StateCachedContext(device.ImmediateContext()));
+	mConstantUploader.reset(new ContextConstantUploader(*mStateCache));
+
+	if (!BuildGeometryBuffers())
+	{
+		return false;
+	}
+	BuildFX();
+	if (mResources->Effect(mFX) == nullptr)
+	{
+		return false;
+	}
+	BuildVertexLayout();
+
+	return true;
+}
+
+void SkullScene::Shutdown()
+{
+	mResources->Destroy(mSkullVB);
+	mResources->Destroy(mSkullIB);
+	mResources->Destroy(mInputLayout);
+	mResources->Destroy(mFX);
+	mSkullVB = BufferHandle();
+	mSkullIB = BufferHandle();
+	mInputLayout = InputLayoutHandle();
+	mFX = EffectHandle();
+
+	// Called with the GPU idle
+	mResources->Flush();
+	mResources->ReportLeaks();
+}
+
+bool SkullScene::ReloadModel()
+{
+	return BuildGeometryBuffers();
+}
+
+void SkullScene::OnResize(int width, int height)
+{
+	mClientWidth = width;
+	mClientHeight = height;
+
+	// Update projection matrix
+	mProj = MatrixPerspectiveFovLH(0.25f * MathPi, static_cast<float>(width) / height, 1.0f, 1000.0f);
+}
+
+void SkullScene::UpdateScene(float, float)
+{
+	// Convert sphere coordinates to Cartesian
+	float x = mRadius * sinf(mPhi) * cosf(mTheta);
+	float y = mRadius * sinf(mPhi) * sinf(mTheta);
+	float z = mRadius * cosf(mPhi);
+
+	// View matrix points to origo
+	Float3 pos(x, y, z);
+	Float3 target(0.0f, 3.0f, 0.0f);
+	Float3 up(0.0f, 1.0f, 0.0f);
+
+	mView = MatrixLookAtLH(pos, target, up);
+}
+
+void SkullScene::DrawScene()
+{
+	// Black
+	mStateCache->ClearRenderTarget(Float4(0.0f, 0.0f, 0.0f, 1.0f));
+	mStateCache->ClearDepthStencil(1.0f, 0);
+
+	// Bound every frame, the cache only issues what changed
+	mStateCache->BeginFrame();
+	mStateCache->SetInputLayout(mResources->InputLayout(mInputLayout));
+	mStateCache->SetPrimitiveTopology(PrimitiveTopology::TriangleList);
+	mStateCache->SetVertexBuffer(0, mResources->Buffer(mSkullVB), VertexStride<SkullVertex>(), 0);
+	mStateCache->SetIndexBuffer(mResources->Buffer(mSkullIB), IndexFormat::UInt32, 0);
+
+	// Constant buffer
+	Float4x4 worldViewProj = MatrixMultiply(MatrixMultiply(mWorld, mView), mProj);
+
+	mConstants.BeginFrame();
+	mWorldViewProjConstants->Set(worldViewProj);
+	mConstants.Commit(*mConstantUploader);
+
+	for (size_t pass = 0; pass < mPasses.size(); pass++)
+	{
+		mStateCache->ApplyPass(mPasses[pass]);
+		mStateCache->DrawIndexed(mSkullIndexAmount, 0, 0);
+	}
+
+	// Constant traffic and state calls next to the frame stats in the caption
+	const StateCacheStats& state = mStateCache->CurrentFrame();
+	if (mConstants.CurrentFrame().TotalBytesUploaded() != mConstants.LastFrame().TotalBytesUploaded()
+		|| state.TotalIssued() != mStateCache->LastFrame().TotalIssued() || mPickChanged)
+	{
+		// Formatted in place, the caption keeps its capacity so this does not allocate
+		char constants[160];
+		char calls[256];
+		char picked[64];
+		char caption[512];
+		FormatConstantUploadSummary(mConstants.CurrentFrame(), constants, sizeof(constants));
+		FormatStateCacheSummary(state, calls, sizeof(calls));
+		if (mPickedTriangle != ~0u)
+		{
+			snprintf(picked, sizeof(picked), "Triangle %u at %.2f", mPickedTriangle, mPickedDistance);
+		}
+		else
+		{
+			snprintf(picked, sizeof(picked), "No triangle");
+		}
+		snprintf(caption, sizeof(caption), "Skull Demo  %s  %s  %s", picked, constants, calls);
+		mCaption.assign(caption);
+		mPickChanged = false;
+	}
+
+	// Releases what a reload replaced once no frame in flight draws it
+	mResources->EndFrame();
+}
+
+void SkullScene::OnMouseDown(uint32_t, int x, int y)
+{
+	mLastMouseX = x;
+	mLastMouseY = y;
+}
+
+void SkullScene::OnMouseMove(uint32_t buttons, int x, int y)
+{
+	// If state has left button
+	if ((buttons & MouseButtonLeft) != 0)
+	{
+		float dx = DegreesToRadians(0.25f * static_cast<float>(x - mLastMouseX));
+		float dy = DegreesToRadians(0.25f * static_cast<float>(y - mLastMouseY));
+
+		mTheta += dx;
+		mPhi += dy;
+
+		// Restrict vertical
+		mPhi = Clamp(mPhi, 0.1f, MathPi - 0.1f);
+	}
+	else if ((buttons & MouseButtonRight) != 0)
+	{
+		float dx = 0.005f * static_cast<float>(x - mLastMouseX);
+		float dy = 0.005f * static_cast<float>(y - mLastMouseY);
+
+
+		mRadius += dx - dy;
+		mRadius = Clamp(mRadius, 3.0f, 15.0f);
+	}
+
+	mLastMouseX = x;
+	mLastMouseY = y;
+
+	Pick(x, y);
+}
+
+void SkullScene::Pick(int x, int y)
+{
+	if (mClientWidth <= 0 || mClientHeight <= 0)
+	{
+		return;
+	}
+
+	// The skull's world matrix is the identity, so the ray is in model space
+	Float4x4 viewProj = MatrixMultiply(MatrixMultiply(mWorld, mView), mProj);
+	Ray ray = ScreenPointToRay(static_cast<float>(x), static_cast<float>(y), static_cast<float>(mClientWidth), static_cast<float>(mClientHeight), viewProj);
+	RayHit hit;
+	uint32_t picked = mBvh.Intersect(ray, hit) ? hit.Triangle : ~0u;
+	float distance = picked != ~0u ? hit.Distance : 0.0f;
+	if (picked != mPickedTriangle || distance != mPickedDistance)
+	{
+		mPickedTriangle = picked;
+		mPickedDistance = distance;
+		mPickChanged = true;
+	}
+}
+
+bool SkullScene::BuildGeometryBuffers()
+{
+	STARTUP_PHASE("BuildGeometryBuffers");
+
+	std::vector<SkullVertex> skullVertices;
+	std::vector<uint32_t> skullIndices;
+	bool cooked = mModelFile.size() > 6 && mModelFile.compare(mModelFile.size() - 6, 6, ".cmesh") == 0;
+	if (!(cooked ? ReadCookedModel(mModelFile, skullVertices, skullIndices) : ReadTextModel(mModelFile, skullVertices, skullIndices)))
+	{
+		return false;
+	}
+	uint32_t vertexAmount = static_cast<uint32_t>(skullVertices.size());
+	uint32_t indexAmount = static_cast<uint32_t>(skullIndices.size());
+
+	{
+		STARTUP_PHASE("BuildBvh");
+		mBvh.Build(&skullVertices[0].Position, VertexStride<SkullVertex>(), vertexAmount, skullIndices.data(), indexAmount);
+		mPickedTriangle = ~0u;
+		mPickChanged = true;
+	}
+
+	// A reload replaces the buffers, the old ones stay alive for the frames in flight
+	BufferDesc vertexDesc = { BufferBinding::Vertex, BufferUsage::Immutable, VertexStride<SkullVertex>() * vertexAmount, "Skull" };
+	BufferDesc indexDesc = { BufferBinding::Index, BufferUsage::Immutable, static_cast<uint32_t>(sizeof(uint32_t)) * indexAmount, "Skull" };
+	mResources->Destroy(mSkullVB);
+	mResources->Destroy(mSkullIB);
+	mSkullVB = mResources->CreateBuffer(vertexDesc, skullVertices.data());
+	mSkullIB = mResources->CreateBuffer(indexDesc, skullIndices.data());
+	mSkullIndexAmount = indexAmount;
+
+	return true;
+}
+
+void SkullScene::BuildFX()
+{
+	STARTUP_PHASE("BuildFX");
+
+	mFX = mResources->CreateEffect("FX/normal.fx");
+	RenderEffect* effect = mResources->Effect(mFX);
+	if (effect == nullptr)
+	{
+		return;
+	}
+
+	uint32_t passCount = mDevice->PassCount(effect, "NormalTech");
+	for (uint32_t pass = 0; pass < passCount; pass++)
+	{
+		mPasses.push_back(mDevice->FindPass(effect, "NormalTech", pass));
+	}
+	mfxWorldViewProj = mDevice->FindConstant(effect, "gWorldViewProj");
+
+	mWorldViewProjConstants = mConstants.AddBlock(mfxWorldViewProj, sizeof(Float4x4), UpdateFrequency::PerView);
+}
+
+void SkullScene::BuildVertexLayout()
+{
+	STARTUP_PHASE("BuildVertexLayout");
+
+	mInputLayout = mResources->CreateInputLayout(InterleavedElements<SkullVertex>(), mPasses[0], "SkullVertex");
+}
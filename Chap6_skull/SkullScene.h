@@ -0,0 +1,96 @@
+#ifndef SKULLSCENE_H
+#define SKULLSCENE_H
+
+#include "DemoScene.h"
+#include "ConstantData.h"
+#include "StateCache.h"
+#include "RenderResources.h"
+#include "MeshBvh.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// The skull's GPU objects are held by handle in a RenderResources, so the
+// model can be reloaded while the scene runs: the old buffers are released
+// once the frames that drew them are done.
+//
+// A MeshBvh over the skull's triangles finds the one under the mouse
+// cursor on every move, the caption shows it.
+class SkullScene : public DemoScene
+{
+public:
+	// 'modelFile' is the book's skull.txt text format, or a .cmesh that
+	// AssetCooker made of it
+	SkullScene(const char* modelFile = "Models/skull.txt");
+
+	bool Init(IRenderDevice& device);
+	void Shutdown();
+
+	void OnResize(int width, int height);
+	void UpdateScene(float dt, float totalTime);
+	void DrawScene();
+
+	const std::string& Caption() const { return mCaption; }
+
+	void OnMouseDown(uint32_t buttons, int x, int y);
+	void OnMouseMove(uint32_t buttons, int x, int y);
+
+	// Reads the model file again, keeps the current model if that fails
+	bool ReloadModel();
+	const RenderResources* Resources() const { return mResources.get(); }
+	const MeshBvh& Bvh() const { return mBvh; }
+	// ~0 if the cursor is not over the skull
+	uint32_t PickedTriangle() const { return mPickedTriangle; }
+
+private:
+	bool BuildGeometryBuffers();
+	void BuildFX();
+	void BuildVertexLayout();
+	void Pick(int x, int y);
+
+	IRenderDevice* mDevice;
+	std::unique_ptr<RenderResources> mResources;
+	std::string mModelFile;
+
+	BufferHandle mSkullVB;
+	BufferHandle mSkullIB;
+
+	uint32_t mSkullIndexAmount;
+	MeshBvh mBvh;
+
+	EffectHandle mFX;
+	std::vector<RenderPass*> mPasses;
+	RenderConstant* mfxWorldViewProj;
+
+	// Only the camera changes gWorldViewProj, it is skipped while the view is still
+	ConstantUpdater mConstants;
+	ConstantBlock* mWorldViewProjConstants;
+
+	// Draw calls go through the state cache so rebinding the same state is dropped
+	std::unique_ptr<StateCachedContext> mStateCache;
+	std::unique_ptr<ContextConstantUploader> mConstantUploader;
+
+	InputLayoutHandle mInputLayout;
+
+	Float4x4 mWorld;
+	Float4x4 mView;
+	Float4x4 mProj;
+
+	float mTheta;
+	float mPhi;
+	float mRadius;
+
+	int mLastMouseX;
+	int mLastMouseY;
+
+	int mClientWidth;
+	int mClientHeight;
+	uint32_t mPickedTriangle;
+	float mPickedDistance;
+	bool mPickChanged;
+
+	std::string mCaption;
+};
+
+#endif // SKULLSCENE_H
@@ -0,0 +1,34 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <cstdint>
+
+// Counts heap allocations. Linking AllocationCounter.cpp replaces the global
+// operator new and delete with versions that count every call and the bytes
+// asked for on every thread, which costs two atomic adds per allocation.
+uint64_t AllocationCount();
+uint64_t AllocatedBytes();
+
+// Allocations made since the scope was created, on any thread:
+//
+//	AllocationScope frame;
+//	scene.DrawScene();
+//	if (frame.Allocations() != 0) ...
+class AllocationScope
+{
+public:
+	AllocationScope()
+		: mStart(AllocationCount())
+		, mStartBytes(AllocatedBytes())
+	{
+	}
+
+	uint64_t Allocations() const { return AllocationCount() - mStart; }
+	uint64_t Bytes() const { return AllocatedBytes() - mStartBytes; }
+
+private:
+	uint64_t mStart;
+	uint64_t mStartBytes;
+};
+
+#endif // ALLOCATIONCOUNTER_H
@@ -0,0 +1,144 @@
+#include "ColorPacking.h"
+#include "Log.h"
+
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <set>
+#include <sstream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define COLORPACKING_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define COLORPACKING_NEON
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+	uint8_t PackChannel(float value)
+	{
+		// Written so that NaN fails both tests and ends up as 0
+		float clamped = value > 0.0f ? (value < 1.0f ? value : 1.0f) : 0.0f;
+		// nearbyint rounds to nearest even like the SIMD conversions
+		return static_cast<uint8_t>(std::nearbyint(clamped * 255.0f));
+	}
+
+	void PackScalar(const uint8_t* source, size_t sourceStride, uint8_t* target, size_t targetStride, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			Float4 color;
+			memcpy(&color, source + i * sourceStride, sizeof(color));
+			ColorRGBA8 packed = PackColor(color);
+			memcpy(target + i * targetStride, &packed, sizeof(packed));
+		}
+	}
+}
+
+ColorRGBA8 PackColor(const Float4& color)
+{
+	ColorRGBA8 packed;
+	packed.r = PackChannel(color.x);
+	packed.g = PackChannel(color.y);
+	packed.b = PackChannel(color.z);
+	packed.a = PackChannel(color.w);
+	return packed;
+}
+
+Float4 UnpackColor(ColorRGBA8 color)
+{
+	const float scale = 1.0f / 255.0f;
+	return Float4(color.r * scale, color.g * scale, color.b * scale, color.a * scale);
+}
+
+void PackColors(const void* source, size_t sourceStride, void* target, size_t targetStride, size_t count)
+{
+	const uint8_t* src = static_cast<const uint8_t*>(source);
+	uint8_t* dst = static_cast<uint8_t*>(target);
+	size_t i = 0;
+
+#if defined(COLORPACKING_SSE2)
+	// Four colors per iteration. max/min return the second operand for NaN,
+	// so NaN clamps to 0. cvtps rounds to nearest even in the default mode.
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 scale = _mm_set1_ps(255.0f);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i c[4];
+		for (int k = 0; k < 4; k++)
+		{
+			__m128 color = _mm_loadu_ps(reinterpret_cast<const float*>(src + (i + k) * sourceStride));
+			color = _mm_min_ps(_mm_max_ps(color, zero), one);
+			c[k] = _mm_cvtps_epi32(_mm_mul_ps(color, scale));
+		}
+		__m128i bytes = _mm_packus_epi16(_mm_packs_epi32(c[0], c[1]), _mm_packs_epi32(c[2], c[3]));
+
+		if (targetStride == sizeof(ColorRGBA8))
+		{
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * targetStride), bytes);
+		}
+		else
+		{
+			uint32_t packed[4];
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(packed), bytes);
+			for (int k = 0; k < 4; k++)
+			{
+				memcpy(dst + (i + k) * targetStride, &packed[k], sizeof(uint32_t));
+			}
+		}
+	}
+#elif defined(COLORPACKING_NEON)
+	const float32x4_t zero = vdupq_n_f32(0.0f);
+	const float32x4_t one = vdupq_n_f32(1.0f);
+	for (; i + 2 <= count; i += 2)
+	{
+		uint32x4_t c[2];
+		for (int k = 0; k < 2; k++)
+		{
+			float32x4_t color = vld1q_f32(reinterpret_cast<const float*>(src + (i + k) * sourceStride));
+			// vmaxnm/vminnm would keep NaN away from the compare, vmax propagates it.
+			// Replace NaN explicitly: NaN != NaN.
+			color = vbslq_f32(vceqq_f32(color, color), color, zero);
+			color = vminq_f32(vmaxq_f32(color, zero), one);
+			c[k] = vcvtnq_u32_f32(vmulq_n_f32(color, 255.0f));
+		}
+		uint16x8_t shorts = vcombine_u16(vmovn_u32(c[0]), vmovn_u32(c[1]));
+		uint8x8_t bytes = vmovn_u16(shorts);
+
+		uint32_t packed[2];
+		vst1_u8(reinterpret_cast<uint8_t*>(packed), bytes);
+		memcpy(dst + i * targetStride, &packed[0], sizeof(uint32_t));
+		memcpy(dst + (i + 1) * targetStride, &packed[1], sizeof(uint32_t));
+	}
+#endif
+
+	PackScalar(src + i * sourceStride, sourceStride, dst + i * targetStride, targetStride, count - i);
+}
+
+std::string VertexColorReport(const char* name, size_t vertexCount, uint32_t floatStride, uint32_t packedStride, uint64_t verticesPerFrame)
+{
+	uint64_t floatBytes = static_cast<uint64_t>(vertexCount) * floatStride;
+	uint64_t packedBytes = static_cast<uint64_t>(vertexCount) * packedStride;
+	double saved = floatBytes > 0 ? 100.0 * (floatBytes - packedBytes) / floatBytes : 0.0;
+
+	std::stringstream report;
+	report << name << " vertex colors: "
+		<< "float " << floatStride << " B/vertex, " << floatBytes << " B total, " << verticesPerFrame * floatStride << " B fetched/frame; "
+		<< "RGBA8 " << packedStride << " B/vertex, " << packedBytes << " B total, " << verticesPerFrame * packedStride << " B fetched/frame; "
+		<< saved << "% smaller" << std::endl;
+	return report.str();
+}
+
+void LogVertexColorReport(const char* name, size_t vertexCount, uint32_t floatStride, uint32_t packedStride, uint64_t verticesPerFrame)
+{
+	static std::mutex mutex;
+	static std::set<std::string> reported;
+	std::lock_guard<std::mutex> lock(mutex);
+	if (reported.insert(name).second)
+	{
+		LogMessage(VertexColorReport(name, vertexCount, floatStride, packedStride, verticesPerFrame));
+	}
+}
@@ -0,0 +1,61 @@
+#ifndef COLORPACKING_H
+#define COLORPACKING_H
+
+#include "MathTypes.h"
+#include "VertexFormat.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Color stored as DXGI_FORMAT_R8G8B8A8_UNORM, red in the lowest byte
+struct ColorRGBA8
+{
+	uint8_t r;
+	uint8_t g;
+	uint8_t b;
+	uint8_t a;
+};
+
+template<> struct VertexAttributeTraits<ColorRGBA8> { static constexpr VertexAttributeFormat Format = VertexAttributeFormat::UNorm8x4; };
+
+// Float to UNORM conversion as the GPU does it: clamp to [0, 1] (NaN becomes 0),
+// scale by 255 and round to nearest even
+ColorRGBA8 PackColor(const Float4& color);
+Float4 UnpackColor(ColorRGBA8 color);
+
+// Converts 'count' colors. Source and target may be members of larger vertex
+// structs, the strides are the distances between consecutive colors in bytes.
+// Uses SSE2 or NEON when available, results are identical to PackColor.
+void PackColors(const void* source, size_t sourceStride, void* target, size_t targetStride, size_t count);
+
+inline void PackColors(const Float4* source, ColorRGBA8* target, size_t count)
+{
+	PackColors(source, sizeof(Float4), target, sizeof(ColorRGBA8), count);
+}
+
+// Copies the Position and packs the Color of every vertex
+template<typename PackedVertexType, typename VertexType>
+std::vector<PackedVertexType> PackVertexColors(const std::vector<VertexType>& vertices)
+{
+	std::vector<PackedVertexType> packed(vertices.size());
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		packed[i].Position = vertices[i].Position;
+	}
+	if (!vertices.empty())
+	{
+		PackColors(&vertices[0].Color, sizeof(VertexType), &packed[0].Color, sizeof(PackedVertexType), vertices.size());
+	}
+	return packed;
+}
+
+// Memory and vertex fetch cost of a mesh with float and with packed colors.
+// verticesPerFrame is the number of vertices the app fetches every frame.
+std::string VertexColorReport(const char* name, size_t vertexCount, uint32_t floatStride, uint32_t packedStride, uint64_t verticesPerFrame);
+// Logs the report the first time it is made for 'name', scenes that are
+// built again, as Headless does, do not repeat it
+void LogVertexColorReport(const char* name, size_t vertexCount, uint32_t floatStride, uint32_t packedStride, uint64_t verticesPerFrame);
+
+#endif // COLORPACKING_H
@@ -0,0 +1,296 @@
+#include "CommandBuffer.h"
+#include "JobSystem.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace
+{
+	struct InputLayoutPayload
+	{
+		RenderInputLayout* Layout;
+	};
+
+	struct TopologyPayload
+	{
+		PrimitiveTopology Topology;
+	};
+
+	struct VertexBufferPayload
+	{
+		RenderBuffer* Buffer;
+		uint32_t Slot;
+		uint32_t Stride;
+		uint32_t Offset;
+	};
+
+	struct IndexBufferPayload
+	{
+		RenderBuffer* Buffer;
+		IndexFormat Format;
+		uint32_t Offset;
+	};
+
+	// Followed by Size bytes of data
+	struct ConstantsPayload
+	{
+		RenderConstant* Constant;
+		uint32_t Size;
+	};
+
+	struct PassPayload
+	{
+		RenderPass* Pass;
+	};
+
+	struct DrawIndexedPayload
+	{
+		uint32_t IndexCount;
+		uint32_t StartIndex;
+		int32_t BaseVertex;
+	};
+
+	const size_t commandAlignment = 8;
+
+	size_t AlignCommand(size_t size)
+	{
+		return (size + commandAlignment - 1) & ~(commandAlignment - 1);
+	}
+}
+
+//
+// CommandBuffer
+//
+
+CommandBuffer::CommandBuffer()
+	: mSize(0)
+	, mCommandCount(0)
+{
+}
+
+void CommandBuffer::Reserve(size_t bytes)
+{
+	if (bytes > mData.size())
+	{
+		mData.resize(bytes);
+	}
+}
+
+void CommandBuffer::Grow(size_t bytes)
+{
+	if (bytes > mData.size())
+	{
+		// Grow geometrically so that a steady state frame never allocates
+		// and appending many buffers stays linear
+		size_t newCapacity = mData.size() * 2;
+		if (newCapacity < bytes)
+		{
+			newCapacity = bytes;
+		}
+		if (newCapacity < 4096)
+		{
+			newCapacity = 4096;
+		}
+		mData.resize(newCapacity);
+	}
+}
+
+void CommandBuffer::Reset()
+{
+	mSize = 0;
+	mCommandCount = 0;
+}
+
+void* CommandBuffer::Push(CommandType type, size_t payloadSize)
+{
+	size_t commandSize = AlignCommand(sizeof(CommandHeader) + payloadSize);
+	Grow(mSize + commandSize);
+
+	CommandHeader header;
+	header.Type = static_cast<uint16_t>(type);
+	header.Padding = 0;
+	header.Size = static_cast<uint32_t>(commandSize);
+
+	uint8_t* command = &mData[mSize];
+	memcpy(command, &header, sizeof(header));
+	mSize += commandSize;
+	mCommandCount++;
+	return command + sizeof(CommandHeader);
+}
+
+void CommandBuffer::SetInputLayout(RenderInputLayout* layout)
+{
+	InputLayoutPayload payload = { layout };
+	memcpy(Push(CommandSetInputLayout, sizeof(payload)), &payload, sizeof(payload));
+}
+
+void CommandBuffer::SetPrimitiveTopology(PrimitiveTopology topology)
+{
+	TopologyPayload payload = { topology };
+	memcpy(Push(CommandSetPrimitiveTopology, sizeof(payload)), &payload, sizeof(payload));
+}
+
+void CommandBuffer::SetVertexBuffer(uint32_t slot, RenderBuffer* buffer, uint32_t stride, uint32_t offset)
+{
+	VertexBufferPayload payload = { buffer, slot, stride, offset };
+	memcpy(Push(CommandSetVertexBuffer, sizeof(payload)), &payload, sizeof(payload));
+}
+
+void CommandBuffer::SetIndexBuffer(RenderBuffer* buffer, IndexFormat format, uint32_t offset)
+{
+	IndexBufferPayload payload = { buffer, format, offset };
+	memcpy(Push(CommandSetIndexBuffer, sizeof(payload)), &payload, sizeof(payload));
+}
+
+void CommandBuffer::SetConstants(RenderConstant* constant, const void* data, uint32_t size)
+{
+	ConstantsPayload payload = { constant, size };
+	uint8_t* target = static_cast<uint8_t*>(Push(CommandSetConstants, sizeof(payload) + size));
+	memcpy(target, &payload, sizeof(payload));
+	memcpy(target + sizeof(payload), data, size);
+}
+
+void CommandBuffer::ApplyPass(RenderPass* pass)
+{
+	PassPayload payload = { pass };
+	memcpy(Push(CommandApplyPass, sizeof(payload)), &payload, sizeof(payload));
+}
+
+void CommandBuffer::DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex)
+{
+	DrawIndexedPayload payload = { indexCount, startIndex, baseVertex };
+	memcpy(Push(CommandDrawIndexed, sizeof(payload)), &payload, sizeof(payload));
+}
+
+void CommandBuffer::Append(const CommandBuffer& other)
+{
+	if (other.mSize == 0)
+	{
+		return;
+	}
+	Grow(mSize + other.mSize);
+	memcpy(&mData[mSize], &other.mData[0], other.mSize);
+	mSize += other.mSize;
+	mCommandCount += other.mCommandCount;
+}
+
+void CommandBuffer::Replay(IDeviceContext& context) const
+{
+	size_t position = 0;
+	while (position < mSize)
+	{
+		CommandHeader header;
+		memcpy(&header, &mData[position], sizeof(header));
+		const uint8_t* payload = &mData[position + sizeof(CommandHeader)];
+
+		switch (header.Type)
+		{
+		case CommandSetInputLayout:
+		{
+			InputLayoutPayload p;
+			memcpy(&p, payload, sizeof(p));
+			context.SetInputLayout(p.Layout);
+			break;
+		}
+		case CommandSetPrimitiveTopology:
+		{
+			TopologyPayload p;
+			memcpy(&p, payload, sizeof(p));
+			context.SetPrimitiveTopology(p.Topology);
+			break;
+		}
+		case CommandSetVertexBuffer:
+		{
+			VertexBufferPayload p;
+			memcpy(&p, payload, sizeof(p));
+			context.SetVertexBuffer(p.Slot, p.Buffer, p.Stride, p.Offset);
+			break;
+		}
+		case CommandSetIndexBuffer:
+		{
+			IndexBufferPayload p;
+			memcpy(&p, payload, sizeof(p));
+			context.SetIndexBuffer(p.Buffer, p.Format, p.Offset);
+			break;
+		}
+		case CommandSetConstants:
+		{
+			ConstantsPayload p;
+			memcpy(&p, payload, sizeof(p));
+			context.SetConstants(p.Constant, payload + sizeof(p), p.Size);
+			break;
+		}
+		case CommandApplyPass:
+		{
+			PassPayload p;
+			memcpy(&p, payload, sizeof(p));
+			context.ApplyPass(p.Pass);
+			break;
+		}
+		case CommandDrawIndexed:
+		{
+			DrawIndexedPayload p;
+			memcpy(&p, payload, sizeof(p));
+			context.DrawIndexed(p.IndexCount, p.StartIndex, p.BaseVertex);
+			break;
+		}
+		default:
+			assert(false && "Unknown command in command buffer");
+			return;
+		}
+
+		position += header.Size;
+	}
+}
+
+//
+// ParallelCommandRecorder
+//
+
+ParallelCommandRecorder::ParallelCommandRecorder(uint32_t partitionCount, JobSystem* jobs)
+	: mPartitions(partitionCount)
+	, mJobs(jobs)
+{
+}
+
+void ParallelCommandRecorder::Record(const RecordFunction& record)
+{
+	// Threads take whole partitions, each partition has its own buffer
+	auto recordPartitions = [this, &record](uint32_t first, uint32_t end)
+	{
+		for (uint32_t partition = first; partition < end; partition++)
+		{
+			mPartitions[partition].Reset();
+			record(partition, mPartitions[partition]);
+		}
+	};
+	if (mJobs != nullptr)
+	{
+		mJobs->ParallelFor(PartitionCount(), 1, recordPartitions);
+	}
+	else
+	{
+		recordPartitions(0, PartitionCount());
+	}
+}
+
+uint32_t ParallelCommandRecorder::ThreadCount() const
+{
+	return mJobs != nullptr ? mJobs->ThreadCount() : 1;
+}
+
+void ParallelCommandRecorder::Replay(IDeviceContext& context) const
+{
+	for (size_t i = 0; i < mPartitions.size(); i++)
+	{
+		mPartitions[i].Replay(context);
+	}
+}
+
+void ParallelCommandRecorder::Concatenate(CommandBuffer& target) const
+{
+	for (size_t i = 0; i < mPartitions.size(); i++)
+	{
+		target.Append(mPartitions[i]);
+	}
+}
@@ -0,0 +1,98 @@
+#ifndef COMMANDBUFFER_H
+#define COMMANDBUFFER_H
+
+#include "DeviceContext.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+class JobSystem;
+
+// Commands encoded into one linear byte stream. Each command is a small
+// header followed by its payload, padded to 8 bytes. Recording only
+// allocates when the stream outgrows its capacity, Reset keeps the memory.
+// A buffer is filled by one thread at a time.
+class CommandBuffer
+{
+public:
+	CommandBuffer();
+
+	void Reserve(size_t bytes);
+	void Reset();
+
+	void SetInputLayout(RenderInputLayout* layout);
+	void SetPrimitiveTopology(PrimitiveTopology topology);
+	void SetVertexBuffer(uint32_t slot, RenderBuffer* buffer, uint32_t stride, uint32_t offset);
+	void SetIndexBuffer(RenderBuffer* buffer, IndexFormat format, uint32_t offset);
+	// Copies 'size' bytes of constant data into the stream
+	void SetConstants(RenderConstant* constant, const void* data, uint32_t size);
+	void ApplyPass(RenderPass* pass);
+	void DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex);
+
+	// Appends the commands of another buffer after the commands of this one
+	void Append(const CommandBuffer& other);
+
+	void Replay(IDeviceContext& context) const;
+
+	size_t SizeInBytes() const { return mSize; }
+	uint32_t CommandCount() const { return mCommandCount; }
+
+private:
+	enum CommandType : uint16_t
+	{
+		CommandSetInputLayout,
+		CommandSetPrimitiveTopology,
+		CommandSetVertexBuffer,
+		CommandSetIndexBuffer,
+		CommandSetConstants,
+		CommandApplyPass,
+		CommandDrawIndexed
+	};
+
+	struct CommandHeader
+	{
+		uint16_t Type;
+		uint16_t Padding;
+		uint32_t Size;	// Header and payload in bytes
+	};
+
+	void* Push(CommandType type, size_t payloadSize);
+	// Makes room for 'bytes' in total, at least doubling the capacity
+	void Grow(size_t bytes);
+
+	std::vector<uint8_t> mData;
+	size_t mSize;
+	uint32_t mCommandCount;
+};
+
+// Records a frame into several command buffers in parallel, one per scene
+// partition, and replays them in partition order so the result does not
+// depend on which thread finished first.
+class ParallelCommandRecorder
+{
+public:
+	typedef std::function<void(uint32_t partition, CommandBuffer& commands)> RecordFunction;
+
+	// Records on the threads of 'jobs', or on the calling thread when it is null
+	ParallelCommandRecorder(uint32_t partitionCount, JobSystem* jobs);
+
+	// Calls record once for every partition and returns when all are done
+	void Record(const RecordFunction& record);
+
+	void Replay(IDeviceContext& context) const;
+
+	// Concatenates the partitions into 'target' in partition order
+	void Concatenate(CommandBuffer& target) const;
+
+	uint32_t PartitionCount() const { return static_cast<uint32_t>(mPartitions.size()); }
+	uint32_t ThreadCount() const;
+	const CommandBuffer& Partition(uint32_t partition) const { return mPartitions[partition]; }
+
+private:
+	std::vector<CommandBuffer> mPartitions;
+	JobSystem* mJobs;
+};
+
+#endif // COMMANDBUFFER_H
@@ -0,0 +1,129 @@
+#include "ConstantData.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+const char* UpdateFrequencyName(UpdateFrequency frequency)
+{
+	switch (frequency)
+	{
+	case UpdateFrequency::PerFrame: return "PerFrame";
+	case UpdateFrequency::PerView: return "PerView";
+	case UpdateFrequency::PerObject: return "PerObject";
+	default: return "Unknown";
+	}
+}
+
+//
+// RecordingConstantUploader
+//
+
+void RecordingConstantUploader::Upload(RenderConstant* constant, const void*, uint32_t size)
+{
+	Records.push_back({ constant, size });
+}
+
+//
+// ConstantBlock
+//
+
+ConstantBlock::ConstantBlock(RenderConstant* constant, uint32_t size, UpdateFrequency frequency)
+	: mConstant(constant)
+	, mFrequency(frequency)
+	, mShadow(size, 0)
+	, mDirty(true)
+{
+}
+
+void ConstantBlock::Set(const void* data)
+{
+	if (memcmp(mShadow.data(), data, mShadow.size()) != 0)
+	{
+		memcpy(mShadow.data(), data, mShadow.size());
+		mDirty = true;
+	}
+}
+
+void ConstantBlock::SetChecked(const void* data, uint32_t size)
+{
+	assert(size == mShadow.size() && "Constant data size does not match the block");
+	Set(data);
+}
+
+//
+// ConstantUploadStats
+//
+
+uint64_t ConstantUploadStats::TotalBytesUploaded() const
+{
+	uint64_t total = 0;
+	for (int i = 0; i < static_cast<int>(UpdateFrequency::Count); i++)
+	{
+		total += BytesUploaded[i];
+	}
+	return total;
+}
+
+std::string ConstantUploadSummary(const ConstantUploadStats& stats)
+{
+	char summary[160];
+	FormatConstantUploadSummary(stats, summary, sizeof(summary));
+	return summary;
+}
+
+void FormatConstantUploadSummary(const ConstantUploadStats& stats, char* buffer, size_t size)
+{
+	snprintf(buffer, size, "Constants: %llu B/frame (%llu frame, %llu view, %llu object), %llu B skipped"
+		, static_cast<unsigned long long>(stats.TotalBytesUploaded())
+		, static_cast<unsigned long long>(stats.BytesUploaded[static_cast<int>(UpdateFrequency::PerFrame)])
+		, static_cast<unsigned long long>(stats.BytesUploaded[static_cast<int>(UpdateFrequency::PerView)])
+		, static_cast<unsigned long long>(stats.BytesUploaded[static_cast<int>(UpdateFrequency::PerObject)])
+		, static_cast<unsigned long long>(stats.BytesSkipped));
+}
+
+//
+// ConstantUpdater
+//
+
+ConstantUpdater::ConstantUpdater()
+	: mCurrent()
+	, mLast()
+{
+}
+
+ConstantBlock* ConstantUpdater::AddBlock(RenderConstant* constant, uint32_t size, UpdateFrequency frequency)
+{
+	mBlocks.push_back(std::unique_ptr<ConstantBlock>(new ConstantBlock(constant, size, frequency)));
+	return mBlocks.back().get();
+}
+
+void ConstantUpdater::BeginFrame()
+{
+	mLast = mCurrent;
+	mCurrent = ConstantUploadStats();
+}
+
+void ConstantUpdater::Commit(ConstantBlock* block, IConstantUploader& uploader)
+{
+	if (block->mDirty)
+	{
+		uploader.Upload(block->mConstant, block->mShadow.data(), block->Size());
+		block->mDirty = false;
+		mCurrent.BytesUploaded[static_cast<int>(block->mFrequency)] += block->Size();
+		mCurrent.Uploads++;
+	}
+	else
+	{
+		mCurrent.BytesSkipped += block->Size();
+		mCurrent.SkippedUploads++;
+	}
+}
+
+void ConstantUpdater::Commit(IConstantUploader& uploader)
+{
+	for (size_t i = 0; i < mBlocks.size(); i++)
+	{
+		Commit(mBlocks[i].get(), uploader);
+	}
+}
@@ -0,0 +1,124 @@
+#ifndef CONSTANTDATA_H
+#define CONSTANTDATA_H
+
+#include "RenderTypes.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// How often a block of constant data is expected to change
+enum class UpdateFrequency
+{
+	PerFrame,
+	PerView,
+	PerObject,
+	Count
+};
+
+const char* UpdateFrequencyName(UpdateFrequency frequency);
+
+// Destination of constant data uploads
+class IConstantUploader
+{
+public:
+	virtual ~IConstantUploader() {}
+	virtual void Upload(RenderConstant* constant, const void* data, uint32_t size) = 0;
+};
+
+// Keeps a log of every upload, for headless runs and for checking the
+// dirty tracking
+class RecordingConstantUploader : public IConstantUploader
+{
+public:
+	struct Record
+	{
+		RenderConstant* Constant;
+		uint32_t Size;
+	};
+
+	void Upload(RenderConstant* constant, const void* data, uint32_t size);
+	void Clear() { Records.clear(); }
+
+	std::vector<Record> Records;
+};
+
+// Shadow copy of the contents of one constant. Set compares against the
+// shadow copy and only marks the block dirty when the bytes differ.
+class ConstantBlock
+{
+public:
+	ConstantBlock(RenderConstant* constant, uint32_t size, UpdateFrequency frequency);
+
+	void Set(const void* data);
+
+	template<typename T>
+	void Set(const T& value)
+	{
+		static_assert(sizeof(T) > 0, "Constant data must not be empty");
+		SetChecked(&value, sizeof(T));
+	}
+
+	bool IsDirty() const { return mDirty; }
+	void MarkDirty() { mDirty = true; }
+
+	RenderConstant* Constant() const { return mConstant; }
+	uint32_t Size() const { return static_cast<uint32_t>(mShadow.size()); }
+	UpdateFrequency Frequency() const { return mFrequency; }
+	const void* Data() const { return mShadow.data(); }
+
+private:
+	friend class ConstantUpdater;
+
+	void SetChecked(const void* data, uint32_t size);
+
+	RenderConstant* mConstant;
+	UpdateFrequency mFrequency;
+	std::vector<uint8_t> mShadow;
+	bool mDirty;
+};
+
+struct ConstantUploadStats
+{
+	uint64_t BytesUploaded[static_cast<int>(UpdateFrequency::Count)];
+	uint64_t BytesSkipped;
+	uint32_t Uploads;
+	uint32_t SkippedUploads;
+
+	uint64_t TotalBytesUploaded() const;
+};
+
+// "Constants: 64 B/frame (0 frame, 0 view, 64 object), 12 B skipped"
+std::string ConstantUploadSummary(const ConstantUploadStats& stats);
+// The same into 'buffer' without allocating, truncated to fit
+void FormatConstantUploadSummary(const ConstantUploadStats& stats, char* buffer, size_t size);
+
+// Owns the constant blocks of an app and uploads the dirty ones on Commit.
+// Blocks start dirty so the first commit fills every constant.
+class ConstantUpdater
+{
+public:
+	ConstantUpdater();
+
+	ConstantBlock* AddBlock(RenderConstant* constant, uint32_t size, UpdateFrequency frequency);
+
+	// Starts a new frame of statistics, the previous frame stays readable
+	void BeginFrame();
+
+	// Uploads dirty blocks of all frequencies
+	void Commit(IConstantUploader& uploader);
+	// Uploads one block if dirty. For per object data that has to reach the
+	// GPU before the draw that uses it.
+	void Commit(ConstantBlock* block, IConstantUploader& uploader);
+
+	const ConstantUploadStats& CurrentFrame() const { return mCurrent; }
+	const ConstantUploadStats& LastFrame() const { return mLast; }
+
+private:
+	std::vector<std::unique_ptr<ConstantBlock>> mBlocks;
+	ConstantUploadStats mCurrent;
+	ConstantUploadStats mLast;
+};
+
+#endif // CONSTANTDATA_H
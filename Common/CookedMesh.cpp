@@ -0,0 +1,278 @@
+#include "CookedMesh.h"
+#include "MeshCodec.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+
+namespace
+{
+	// "MSH2", bump the digit when the layout changes
+	const uint32_t cookedMeshMagic = 0x3248534D;
+
+	static_assert(sizeof(CookedMeshHeader) == 112, "CookedMeshHeader has padding");
+
+	float SignNotZero(float value)
+	{
+		return value >= 0.0f ? 1.0f : -1.0f;
+	}
+
+	// In double, float rounding at 65535 steps would be off by up to 0.004
+	uint16_t QuantizeSteps(float value, float offset, float scale, uint32_t maxStep)
+	{
+		double steps = scale > 0.0f ? (static_cast<double>(value) - offset) / scale + 0.5 : 0.0;
+		return static_cast<uint16_t>(Clamp(steps, 0.0, static_cast<double>(maxStep)));
+	}
+
+	int16_t QuantizeSnorm(float value)
+	{
+		return static_cast<int16_t>(std::lround(Clamp(value, -1.0f, 1.0f) * 32767.0f));
+	}
+
+	float Scale(float extent, uint32_t maxStep)
+	{
+		return extent > 0.0f ? extent / maxStep : 0.0f;
+	}
+
+	// Leaves the file at the vertices. Checked against the file's size, so a
+	// damaged count fails here instead of allocating.
+	bool ReadHeader(FILE* file, CookedMeshHeader& header)
+	{
+		bool valid = fread(&header, sizeof(header), 1, file) == 1 && header.Magic == cookedMeshMagic
+			&& (header.IndexSize == 2 || header.IndexSize == 4);
+		if ((header.Flags & CookedMeshCompressed) == 0)
+		{
+			valid = valid && header.VertexDataBytes == static_cast<uint64_t>(header.VertexCount) * sizeof(CookedVertex)
+				&& header.IndexDataBytes == static_cast<uint64_t>(header.IndexCount) * header.IndexSize;
+		}
+		else
+		{
+			// Counts the stored bytes cannot decode to are damaged, checked before they are allocated
+			valid = valid && header.VertexCount <= MaxVertexCount(header.VertexDataBytes, sizeof(CookedVertex))
+				&& header.IndexCount <= MaxIndexCount(header.IndexDataBytes);
+		}
+		long start = ftell(file);
+		valid = valid && fseek(file, 0, SEEK_END) == 0;
+		uint64_t expected = static_cast<uint64_t>(header.VertexDataBytes) + header.IndexDataBytes;
+		return valid && static_cast<uint64_t>(ftell(file) - start) == expected && fseek(file, start, SEEK_SET) == 0;
+	}
+}
+
+void QuantizeMesh(const std::vector<Float3>& positions, const std::vector<Float3>& normals, const std::vector<Float2>& texCoords,
+	const std::vector<uint32_t>& indices, uint32_t positionBits, CookedMesh& mesh)
+{
+	CookedMeshHeader& header = mesh.Header;
+	header = CookedMeshHeader();
+	header.Magic = cookedMeshMagic;
+	header.VertexCount = static_cast<uint32_t>(positions.size());
+	header.IndexCount = static_cast<uint32_t>(indices.size());
+	header.IndexSize = positions.size() <= 0x10000 ? 2 : 4;
+	header.Flags = texCoords.empty() ? 0 : CookedMeshTexCoords;
+	header.PositionBits = Clamp(positionBits, 1u, 16u);
+
+	Float3 min(FLT_MAX, FLT_MAX, FLT_MAX);
+	Float3 max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (size_t i = 0; i < positions.size(); i++)
+	{
+		min = Float3(std::min(min.x, positions[i].x), std::min(min.y, positions[i].y), std::min(min.z, positions[i].z));
+		max = Float3(std::max(max.x, positions[i].x), std::max(max.y, positions[i].y), std::max(max.z, positions[i].z));
+	}
+	if (positions.empty())
+	{
+		min = max = Float3();
+	}
+	uint32_t maxStep = (1u << header.PositionBits) - 1;
+	header.BoundsMin = min;
+	header.BoundsMax = max;
+	header.PositionOffset = min;
+	header.PositionScale = Float3(Scale(max.x - min.x, maxStep), Scale(max.y - min.y, maxStep), Scale(max.z - min.z, maxStep));
+
+	Float2 texMin(FLT_MAX, FLT_MAX);
+	Float2 texMax(-FLT_MAX, -FLT_MAX);
+	for (size_t i = 0; i < texCoords.size(); i++)
+	{
+		texMin = Float2(std::min(texMin.x, texCoords[i].x), std::min(texMin.y, texCoords[i].y));
+		texMax = Float2(std::max(texMax.x, texCoords[i].x), std::max(texMax.y, texCoords[i].y));
+	}
+	if (!texCoords.empty())
+	{
+		header.TexCoordOffset = texMin;
+		header.TexCoordScale = Float2(Scale(texMax.x - texMin.x, 0xFFFF), Scale(texMax.y - texMin.y, 0xFFFF));
+	}
+
+	mesh.Vertices.resize(positions.size());
+	for (size_t i = 0; i < positions.size(); i++)
+	{
+		CookedVertex& vertex = mesh.Vertices[i];
+		const Float3& p = positions[i];
+		vertex.Position[0] = QuantizeSteps(p.x, header.PositionOffset.x, header.PositionScale.x, maxStep);
+		vertex.Position[1] = QuantizeSteps(p.y, header.PositionOffset.y, header.PositionScale.y, maxStep);
+		vertex.Position[2] = QuantizeSteps(p.z, header.PositionOffset.z, header.PositionScale.z, maxStep);
+		vertex.Position[3] = 0;
+
+		// Onto the octahedron, the lower half folded over the upper one
+		const Float3& n = normals[i];
+		float length = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+		float x = length > 0.0f ? n.x / length : 0.0f;
+		float y = length > 0.0f ? n.y / length : 0.0f;
+		if (n.z < 0.0f)
+		{
+			float foldedX = (1.0f - std::fabs(y)) * SignNotZero(x);
+			y = (1.0f - std::fabs(x)) * SignNotZero(y);
+			x = foldedX;
+		}
+		vertex.Normal[0] = QuantizeSnorm(x);
+		vertex.Normal[1] = QuantizeSnorm(y);
+
+		vertex.TexCoord[0] = 0;
+		vertex.TexCoord[1] = 0;
+		if (!texCoords.empty())
+		{
+			vertex.TexCoord[0] = QuantizeSteps(texCoords[i].x, header.TexCoordOffset.x, header.TexCoordScale.x, 0xFFFF);
+			vertex.TexCoord[1] = QuantizeSteps(texCoords[i].y, header.TexCoordOffset.y, header.TexCoordScale.y, 0xFFFF);
+		}
+	}
+	mesh.Indices = indices;
+}
+
+Float3 DecodePosition(const CookedMeshHeader& header, const CookedVertex& vertex)
+{
+	return Float3(header.PositionOffset.x + vertex.Position[0] * header.PositionScale.x
+		, header.PositionOffset.y + vertex.Position[1] * header.PositionScale.y
+		, header.PositionOffset.z + vertex.Position[2] * header.PositionScale.z);
+}
+
+Float3 DecodeNormal(const CookedVertex& vertex)
+{
+	float x = vertex.Normal[0] / 32767.0f;
+	float y = vertex.Normal[1] / 32767.0f;
+	float z = 1.0f - std::fabs(x) - std::fabs(y);
+	if (z < 0.0f)
+	{
+		float unfoldedX = (1.0f - std::fabs(y)) * SignNotZero(x);
+		y = (1.0f - std::fabs(x)) * SignNotZero(y);
+		x = unfoldedX;
+	}
+	return Normalize3(Float3(x, y, z));
+}
+
+Float2 DecodeTexCoord(const CookedMeshHeader& header, const CookedVertex& vertex)
+{
+	return Float2(header.TexCoordOffset.x + vertex.TexCoord[0] * header.TexCoordScale.x
+		, header.TexCoordOffset.y + vertex.TexCoord[1] * header.TexCoordScale.y);
+}
+
+uint64_t WriteCookedMesh(const std::string& fileName, const CookedMesh& mesh)
+{
+	std::string temporary = fileName + ".tmp";
+	FILE* file = fopen(temporary.c_str(), "wb");
+	if (file == nullptr)
+	{
+		return 0;
+	}
+
+	CookedMeshHeader header = mesh.Header;
+	std::vector<uint8_t> vertexData;
+	std::vector<uint8_t> indexData;
+	if ((header.Flags & CookedMeshCompressed) != 0)
+	{
+		EncodeVertexBuffer(mesh.Vertices.data(), static_cast<uint32_t>(mesh.Vertices.size()), sizeof(CookedVertex), vertexData);
+		EncodeIndexBuffer(mesh.Indices.data(), static_cast<uint32_t>(mesh.Indices.size()), indexData);
+	}
+	else
+	{
+		const uint8_t* vertices = reinterpret_cast<const uint8_t*>(mesh.Vertices.data());
+		vertexData.assign(vertices, vertices + mesh.Vertices.size() * sizeof(CookedVertex));
+		if (header.IndexSize == 2)
+		{
+			std::vector<uint16_t> narrow(mesh.Indices.begin(), mesh.Indices.end());
+			const uint8_t* indices = reinterpret_cast<const uint8_t*>(narrow.data());
+			indexData.assign(indices, indices + narrow.size() * sizeof(uint16_t));
+		}
+		else
+		{
+			const uint8_t* indices = reinterpret_cast<const uint8_t*>(mesh.Indices.data());
+			indexData.assign(indices, indices + mesh.Indices.size() * sizeof(uint32_t));
+		}
+	}
+	header.VertexDataBytes = static_cast<uint32_t>(vertexData.size());
+	header.IndexDataBytes = static_cast<uint32_t>(indexData.size());
+
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1
+		&& (vertexData.empty() || fwrite(vertexData.data(), vertexData.size(), 1, file) == 1)
+		&& (indexData.empty() || fwrite(indexData.data(), indexData.size(), 1, file) == 1);
+	written = fclose(file) == 0 && written;
+
+	std::error_code error;
+	if (written)
+	{
+		std::filesystem::rename(temporary, fileName, error);
+		written = !error;
+	}
+	if (!written)
+	{
+		std::filesystem::remove(temporary, error);
+		return 0;
+	}
+	return sizeof(header) + vertexData.size() + indexData.size();
+}
+
+bool ReadCookedMesh(const std::string& fileName, CookedMesh& mesh)
+{
+	FILE* file = fopen(fileName.c_str(), "rb");
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	CookedMeshHeader& header = mesh.Header;
+	bool valid = ReadHeader(file, header);
+	if (valid)
+	{
+		mesh.Vertices.resize(header.VertexCount);
+		mesh.Indices.resize(header.IndexCount);
+		if ((header.Flags & CookedMeshCompressed) != 0)
+		{
+			// Read whole and decoded straight into the mesh
+			std::vector<uint8_t> data(static_cast<size_t>(header.VertexDataBytes) + header.IndexDataBytes);
+			valid = data.empty() || fread(data.data(), data.size(), 1, file) == 1;
+			valid = valid && DecodeVertexBuffer(mesh.Vertices.data(), header.VertexCount, sizeof(CookedVertex), data.data(), header.VertexDataBytes)
+				&& DecodeIndexBuffer(mesh.Indices.data(), header.IndexCount, data.data() + header.VertexDataBytes, header.IndexDataBytes);
+		}
+		else
+		{
+			valid = mesh.Vertices.empty() || fread(mesh.Vertices.data(), mesh.Vertices.size() * sizeof(CookedVertex), 1, file) == 1;
+			if (header.IndexSize == 2)
+			{
+				std::vector<uint16_t> narrow(header.IndexCount);
+				valid = valid && (narrow.empty() || fread(narrow.data(), narrow.size() * sizeof(uint16_t), 1, file) == 1);
+				std::copy(narrow.begin(), narrow.end(), mesh.Indices.begin());
+			}
+			else
+			{
+				valid = valid && (mesh.Indices.empty() || fread(mesh.Indices.data(), mesh.Indices.size() * sizeof(uint32_t), 1, file) == 1);
+			}
+		}
+	}
+	fclose(file);
+
+	for (size_t i = 0; valid && i < mesh.Indices.size(); i++)
+	{
+		valid = mesh.Indices[i] < header.VertexCount;
+	}
+	return valid;
+}
+
+bool ReadCookedMeshHeader(const std::string& fileName, CookedMeshHeader& header)
+{
+	FILE* file = fopen(fileName.c_str(), "rb");
+	if (file == nullptr)
+	{
+		return false;
+	}
+	bool valid = ReadHeader(file, header);
+	fclose(file);
+	return valid;
+}
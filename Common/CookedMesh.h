@@ -0,0 +1,77 @@
+#ifndef COOKEDMESH_H
+#define COOKEDMESH_H
+
+#include "MathTypes.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Runtime mesh format written by AssetCooker. The vertices are quantized
+// and the triangles already in vertex cache order, so loading is a read
+// and the GPU could take the buffers as they are. Normals are octahedral,
+// the tangent frames can be rebuilt with GenerateTangents. With
+// CookedMeshCompressed the buffers are stored with MeshCodec and decoded
+// as they are read.
+struct CookedVertex
+{
+	uint16_t Position[4];	// Steps of PositionScale from PositionOffset, w is unused
+	int16_t Normal[2];		// Octahedral snorm
+	uint16_t TexCoord[2];	// Steps of TexCoordScale from TexCoordOffset
+};
+
+static_assert(sizeof(CookedVertex) == 16, "CookedVertex has padding");
+
+struct CookedMeshHeader
+{
+	uint32_t Magic;
+	uint32_t VertexCount;
+	uint32_t IndexCount;
+	uint32_t IndexSize;			// 2 when every index fits, else 4
+	uint32_t Flags;
+	uint32_t PositionBits;		// Precision the positions were quantized to
+	Float3 BoundsMin;			// Of the source positions
+	Float3 BoundsMax;
+	Float3 PositionOffset;
+	Float3 PositionScale;
+	Float2 TexCoordOffset;
+	Float2 TexCoordScale;
+	uint64_t SourceHash;		// Of the source file the mesh was cooked from
+	uint64_t SettingsHash;		// Of the cook settings and format version
+	uint32_t VertexDataBytes;	// Stored size of the vertices and indices, set by WriteCookedMesh
+	uint32_t IndexDataBytes;
+};
+
+// Set when the source had texture coordinates
+const uint32_t CookedMeshTexCoords = 1;
+// Set to have WriteCookedMesh compress the vertices and indices
+const uint32_t CookedMeshCompressed = 2;
+
+struct CookedMesh
+{
+	CookedMeshHeader Header;
+	std::vector<CookedVertex> Vertices;
+	// 32-bit in memory whatever IndexSize is in the file
+	std::vector<uint32_t> Indices;
+};
+
+// Quantizes the positions to 'positionBits' (1 to 16) within their bounds
+// and the normals to 16-bit octahedral. 'texCoords' may be empty. The
+// indices are copied as they are.
+void QuantizeMesh(const std::vector<Float3>& positions, const std::vector<Float3>& normals, const std::vector<Float2>& texCoords,
+	const std::vector<uint32_t>& indices, uint32_t positionBits, CookedMesh& mesh);
+
+Float3 DecodePosition(const CookedMeshHeader& header, const CookedVertex& vertex);
+Float3 DecodeNormal(const CookedVertex& vertex);
+Float2 DecodeTexCoord(const CookedMeshHeader& header, const CookedVertex& vertex);
+
+// Written next to the file and renamed, so a reader never sees half of it.
+// Returns the bytes written, 0 on failure.
+uint64_t WriteCookedMesh(const std::string& fileName, const CookedMesh& mesh);
+
+// False if the file is missing, truncated or of another format version. The
+// header alone is enough to see whether a cooked file is current.
+bool ReadCookedMesh(const std::string& fileName, CookedMesh& mesh);
+bool ReadCookedMeshHeader(const std::string& fileName, CookedMeshHeader& header);
+
+#endif // COOKEDMESH_H
@@ -0,0 +1,76 @@
+#include "D3D11DeviceContext.h"
+
+void SetEffectConstant(ID3DX11EffectVariable* variable, const void* data, uint32_t size)
+{
+	// Matrices go through SetMatrix so the effect handles the packing order
+	ID3DX11EffectMatrixVariable* matrix = variable->AsMatrix();
+	if (matrix->IsValid() && size == 16 * sizeof(float))
+	{
+		HR(matrix->SetMatrix(static_cast<const float*>(data)));
+	}
+	else
+	{
+		HR(variable->SetRawValue(data, 0, size));
+	}
+}
+
+D3D11DeviceContext::D3D11DeviceContext(ID3D11DeviceContext* context)
+	: mContext(context)
+	, mRenderTarget(nullptr)
+	, mDepthStencil(nullptr)
+{
+}
+
+void D3D11DeviceContext::SetTargets(ID3D11RenderTargetView* renderTarget, ID3D11DepthStencilView* depthStencil)
+{
+	mRenderTarget = renderTarget;
+	mDepthStencil = depthStencil;
+}
+
+void D3D11DeviceContext::ClearRenderTarget(const Float4& color)
+{
+	mContext->ClearRenderTargetView(mRenderTarget, &color.x);
+}
+
+void D3D11DeviceContext::ClearDepthStencil(float depth, uint8_t stencil)
+{
+	mContext->ClearDepthStencilView(mDepthStencil, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, depth, stencil);
+}
+
+void D3D11DeviceContext::SetInputLayout(RenderInputLayout* layout)
+{
+	mContext->IASetInputLayout(ToD3D11(layout));
+}
+
+void D3D11DeviceContext::SetPrimitiveTopology(PrimitiveTopology topology)
+{
+	mContext->IASetPrimitiveTopology(ToD3D11Topology(topology));
+}
+
+void D3D11DeviceContext::SetVertexBuffer(uint32_t slot, RenderBuffer* buffer, uint32_t stride, uint32_t offset)
+{
+	ID3D11Buffer* d3dBuffer = ToD3D11(buffer);
+	UINT d3dStride = stride;
+	UINT d3dOffset = offset;
+	mContext->IASetVertexBuffers(slot, 1, &d3dBuffer, &d3dStride, &d3dOffset);
+}
+
+void D3D11DeviceContext::SetIndexBuffer(RenderBuffer* buffer, IndexFormat format, uint32_t offset)
+{
+	mContext->IASetIndexBuffer(ToD3D11(buffer), ToDXGIFormat(format), offset);
+}
+
+void D3D11DeviceContext::SetConstants(RenderConstant* constant, const void* data, uint32_t size)
+{
+	SetEffectConstant(ToD3D11(constant), data, size);
+}
+
+void D3D11DeviceContext::ApplyPass(RenderPass* pass)
+{
+	ToD3D11(pass)->Apply(0, mContext);
+}
+
+void D3D11DeviceContext::DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex)
+{
+	mContext->DrawIndexed(indexCount, startIndex, baseVertex);
+}
@@ -0,0 +1,66 @@
+#ifndef D3D11DEVICECONTEXT_H
+#define D3D11DEVICECONTEXT_H
+
+#include "d3dUtil.h"
+#include "d3dx11effect.h"
+#include "DeviceContext.h"
+
+// Sets an effect variable from raw constant data
+void SetEffectConstant(ID3DX11EffectVariable* variable, const void* data, uint32_t size);
+
+// IDeviceContext over a D3D11 immediate or deferred context
+class D3D11DeviceContext : public IDeviceContext
+{
+public:
+	explicit D3D11DeviceContext(ID3D11DeviceContext* context);
+
+	// Targets of the clears, they change when the swap chain is resized
+	void SetTargets(ID3D11RenderTargetView* renderTarget, ID3D11DepthStencilView* depthStencil);
+
+	void ClearRenderTarget(const Float4& color);
+	void ClearDepthStencil(float depth, uint8_t stencil);
+	void SetInputLayout(RenderInputLayout* layout);
+	void SetPrimitiveTopology(PrimitiveTopology topology);
+	void SetVertexBuffer(uint32_t slot, RenderBuffer* buffer, uint32_t stride, uint32_t offset);
+	void SetIndexBuffer(RenderBuffer* buffer, IndexFormat format, uint32_t offset);
+	void SetConstants(RenderConstant* constant, const void* data, uint32_t size);
+	void ApplyPass(RenderPass* pass);
+	void DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex);
+
+private:
+	ID3D11DeviceContext* mContext;
+	ID3D11RenderTargetView* mRenderTarget;
+	ID3D11DepthStencilView* mDepthStencil;
+};
+
+inline D3D11_PRIMITIVE_TOPOLOGY ToD3D11Topology(PrimitiveTopology topology)
+{
+	switch (topology)
+	{
+	case PrimitiveTopology::PointList: return D3D11_PRIMITIVE_TOPOLOGY_POINTLIST;
+	case PrimitiveTopology::LineList: return D3D11_PRIMITIVE_TOPOLOGY_LINELIST;
+	case PrimitiveTopology::LineStrip: return D3D11_PRIMITIVE_TOPOLOGY_LINESTRIP;
+	case PrimitiveTopology::TriangleStrip: return D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP;
+	default: return D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	}
+}
+
+inline DXGI_FORMAT ToDXGIFormat(IndexFormat format)
+{
+	return format == IndexFormat::UInt16 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+}
+
+// Conversions between D3D11 objects and the backend neutral names
+inline RenderBuffer* ToRenderBuffer(ID3D11Buffer* buffer) { return reinterpret_cast<RenderBuffer*>(buffer); }
+inline RenderInputLayout* ToRenderInputLayout(ID3D11InputLayout* layout) { return reinterpret_cast<RenderInputLayout*>(layout); }
+inline RenderEffect* ToRenderEffect(ID3DX11Effect* effect) { return reinterpret_cast<RenderEffect*>(effect); }
+inline RenderPass* ToRenderPass(ID3DX11EffectPass* pass) { return reinterpret_cast<RenderPass*>(pass); }
+inline RenderConstant* ToRenderConstant(ID3DX11EffectVariable* variable) { return reinterpret_cast<RenderConstant*>(variable); }
+
+inline ID3D11Buffer* ToD3D11(RenderBuffer* buffer) { return reinterpret_cast<ID3D11Buffer*>(buffer); }
+inline ID3D11InputLayout* ToD3D11(RenderInputLayout* layout) { return reinterpret_cast<ID3D11InputLayout*>(layout); }
+inline ID3DX11Effect* ToD3D11(RenderEffect* effect) { return reinterpret_cast<ID3DX11Effect*>(effect); }
+inline ID3DX11EffectPass* ToD3D11(RenderPass* pass) { return reinterpret_cast<ID3DX11EffectPass*>(pass); }
+inline ID3DX11EffectVariable* ToD3D11(RenderConstant* constant) { return reinterpret_cast<ID3DX11EffectVariable*>(constant); }
+
+#endif // D3D11DEVICECONTEXT_H
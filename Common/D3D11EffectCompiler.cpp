@@ -0,0 +1,43 @@
+#include "D3D11EffectCompiler.h"
+
+#include <d3dcompiler.h>
+
+std::string D3D11EffectCompiler::Name() const
+{
+	return "D3DCompile " + std::to_string(D3D_COMPILER_VERSION) + " fx_5_0";
+}
+
+bool D3D11EffectCompiler::Compile(const std::string& fileName, const std::string& source, const std::vector<EffectDefine>& defines,
+	uint32_t flags, std::vector<uint8_t>& bytecode, std::string& errors)
+{
+	// Null terminated
+	std::vector<D3D_SHADER_MACRO> macros;
+	for (size_t i = 0; i < defines.size(); i++)
+	{
+		D3D_SHADER_MACRO macro = { defines[i].Name.c_str(), defines[i].Value.c_str() };
+		macros.push_back(macro);
+	}
+	D3D_SHADER_MACRO end = { NULL, NULL };
+	macros.push_back(end);
+
+	ID3DBlob* code = NULL;
+	ID3DBlob* messages = NULL;
+	HRESULT hr = D3DCompile(source.data(), source.size(), fileName.c_str(), macros.data(), D3D_COMPILE_STANDARD_FILE_INCLUDE,
+		NULL, "fx_5_0", flags, 0, &code, &messages);
+
+	if (messages != NULL)
+	{
+		errors.assign(static_cast<const char*>(messages->GetBufferPointer()), messages->GetBufferSize());
+		ReleaseCOM(messages);
+	}
+	if (FAILED(hr))
+	{
+		ReleaseCOM(code);
+		return false;
+	}
+
+	const uint8_t* data = static_cast<const uint8_t*>(code->GetBufferPointer());
+	bytecode.assign(data, data + code->GetBufferSize());
+	ReleaseCOM(code);
+	return true;
+}
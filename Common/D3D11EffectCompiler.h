@@ -0,0 +1,18 @@
+#ifndef D3D11EFFECTCOMPILER_H
+#define D3D11EFFECTCOMPILER_H
+
+#include "d3dUtil.h"
+#include "EffectCache.h"
+
+// Compiles effects to fx_5_0 bytecode with D3DCompile, includes are
+// resolved relative to the effect file
+class D3D11EffectCompiler : public IEffectCompiler
+{
+public:
+	std::string Name() const;
+
+	bool Compile(const std::string& fileName, const std::string& source, const std::vector<EffectDefine>& defines,
+		uint32_t flags, std::vector<uint8_t>& bytecode, std::string& errors);
+};
+
+#endif // D3D11EFFECTCOMPILER_H
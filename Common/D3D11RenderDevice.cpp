@@ -0,0 +1,309 @@
+#include "D3D11RenderDevice.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	// Ends an event query after each frame. Queries are reused once the GPU
+	// has passed them, so there are about as many as frames in flight. When
+	// no query can be created the newest pending one is ended again, so a
+	// frame is never reported finished before the GPU has passed it.
+	class D3D11FrameFence : public IFrameFence
+	{
+	public:
+		D3D11FrameFence(ID3D11Device* device, ID3D11DeviceContext* context)
+			: mDevice(device)
+			, mContext(context)
+			, mCompleted(0)
+			, mWaitSource(nullptr)
+			, mWaitStaging(nullptr)
+		{
+			// Every query is free or pending, with one made up front a failed
+			// creation later always finds a pending one
+			ID3D11Query* query = CreateEventQuery();
+			if (query != nullptr)
+			{
+				mFree.push_back(query);
+			}
+		}
+
+		~D3D11FrameFence()
+		{
+			for (size_t i = 0; i < mPending.size(); i++)
+			{
+				ReleaseCOM(mPending[i].Query);
+			}
+			for (size_t i = 0; i < mFree.size(); i++)
+			{
+				ReleaseCOM(mFree[i]);
+			}
+			ReleaseCOM(mWaitSource);
+			ReleaseCOM(mWaitStaging);
+		}
+
+		void Signal(uint64_t frame)
+		{
+			ID3D11Query* query = nullptr;
+			if (!mFree.empty())
+			{
+				query = mFree.back();
+				mFree.pop_back();
+			}
+			else
+			{
+				query = CreateEventQuery();
+			}
+
+			if (query == nullptr)
+			{
+				if (!mPending.empty())
+				{
+					// Ended again it finishes after this frame, the frame it
+					// marked before is reported finished with it
+					mContext->End(mPending.back().Query);
+					mPending.back().Frame = frame;
+				}
+				else if (WaitForGpu())
+				{
+					// Only when not even the first query could be created
+					mCompleted = frame;
+				}
+				return;
+			}
+			mContext->End(query);
+			PendingFrame pending = { frame, query };
+			mPending.push_back(pending);
+		}
+
+		uint64_t CompletedFrame()
+		{
+			Poll(D3D11_ASYNC_GETDATA_DONOTFLUSH);
+			return mCompleted;
+		}
+
+		void Wait(uint64_t frame)
+		{
+			while (mCompleted < frame && !mPending.empty())
+			{
+				// Flushes so the query is not stuck behind unsubmitted commands
+				Poll(0);
+				if (mCompleted < frame)
+				{
+					std::this_thread::yield();
+				}
+			}
+		}
+
+	private:
+		ID3D11Query* CreateEventQuery()
+		{
+			D3D11_QUERY_DESC desc;
+			desc.Query = D3D11_QUERY_EVENT;
+			desc.MiscFlags = 0;
+			ID3D11Query* query = nullptr;
+			return SUCCEEDED(mDevice->CreateQuery(&desc, &query)) ? query : nullptr;
+		}
+
+		// Maps a staging copy, which blocks until the GPU has run every
+		// command before it. False if it could not wait.
+		bool WaitForGpu()
+		{
+			D3D11_BUFFER_DESC bd;
+			bd.Usage = D3D11_USAGE_DEFAULT;
+			bd.ByteWidth = 16;
+			bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+			bd.CPUAccessFlags = 0;
+			bd.MiscFlags = 0;
+			bd.StructureByteStride = 0;
+			if (mWaitSource == nullptr && FAILED(mDevice->CreateBuffer(&bd, nullptr, &mWaitSource)))
+			{
+				return false;
+			}
+			bd.Usage = D3D11_USAGE_STAGING;
+			bd.BindFlags = 0;
+			bd.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+			if (mWaitStaging == nullptr && FAILED(mDevice->CreateBuffer(&bd, nullptr, &mWaitStaging)))
+			{
+				return false;
+			}
+
+			mContext->CopyResource(mWaitStaging, mWaitSource);
+			D3D11_MAPPED_SUBRESOURCE mapped;
+			if (FAILED(mContext->Map(mWaitStaging, 0, D3D11_MAP_READ, 0, &mapped)))
+			{
+				return false;
+			}
+			mContext->Unmap(mWaitStaging, 0);
+			return true;
+		}
+
+		struct PendingFrame
+		{
+			uint64_t Frame;
+			ID3D11Query* Query;
+		};
+
+		// Queries finish in order, stops at the first that has not
+		void Poll(UINT flags)
+		{
+			size_t done = 0;
+			for (; done < mPending.size(); done++)
+			{
+				BOOL finished = FALSE;
+				if (mContext->GetData(mPending[done].Query, &finished, sizeof(finished), flags) != S_OK || !finished)
+				{
+					break;
+				}
+				mCompleted = mPending[done].Frame;
+				mFree.push_back(mPending[done].Query);
+			}
+			mPending.erase(mPending.begin(), mPending.begin() + done);
+		}
+
+		ID3D11Device* mDevice;
+		ID3D11DeviceContext* mContext;
+		uint64_t mCompleted;
+		std::vector<PendingFrame> mPending;
+		std::vector<ID3D11Query*> mFree;
+		// For WaitForGpu, created on first use
+		ID3D11Buffer* mWaitSource;
+		ID3D11Buffer* mWaitStaging;
+	};
+}
+
+D3D11RenderDevice::D3D11RenderDevice(ID3D11Device* device, ID3D11DeviceContext* context, const std::string& effectCacheDirectory)
+	: mDevice(device)
+	, mD3DContext(context)
+	, mContext(context)
+	, mEffectCache(mEffectCompiler, effectCacheDirectory)
+{
+}
+
+RenderBuffer* D3D11RenderDevice::CreateBuffer(const BufferDesc& desc, const void* initialData)
+{
+	D3D11_BUFFER_DESC bd;
+	bd.Usage = desc.Usage == BufferUsage::Dynamic ? D3D11_USAGE_DYNAMIC : D3D11_USAGE_IMMUTABLE;
+	bd.ByteWidth = desc.ByteWidth;	// Size in bytes
+	bd.BindFlags = desc.Binding == BufferBinding::Index ? D3D11_BIND_INDEX_BUFFER : D3D11_BIND_VERTEX_BUFFER;
+	bd.CPUAccessFlags = desc.Usage == BufferUsage::Dynamic ? D3D11_CPU_ACCESS_WRITE : 0;
+	bd.MiscFlags = 0;
+	bd.StructureByteStride = 0;
+
+	D3D11_SUBRESOURCE_DATA initData;
+	initData.pSysMem = initialData;
+	initData.SysMemPitch = 0;
+	initData.SysMemSlicePitch = 0;
+
+	ID3D11Buffer* buffer = nullptr;
+	HR(mDevice->CreateBuffer(&bd, initialData != nullptr ? &initData : nullptr, &buffer));
+	return ToRenderBuffer(buffer);
+}
+
+void D3D11RenderDevice::ReleaseBuffer(RenderBuffer* buffer)
+{
+	ID3D11Buffer* d3dBuffer = ToD3D11(buffer);
+	ReleaseCOM(d3dBuffer);
+}
+
+void* D3D11RenderDevice::MapBuffer(RenderBuffer* buffer, MapMode mode)
+{
+	D3D11_MAPPED_SUBRESOURCE mapped;
+	D3D11_MAP map = mode == MapMode::Discard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE;
+	if (FAILED(mD3DContext->Map(ToD3D11(buffer), 0, map, 0, &mapped)))
+	{
+		return nullptr;
+	}
+	return mapped.pData;
+}
+
+void D3D11RenderDevice::UnmapBuffer(RenderBuffer* buffer)
+{
+	mD3DContext->Unmap(ToD3D11(buffer), 0);
+}
+
+IFrameFence* D3D11RenderDevice::CreateFrameFence()
+{
+	return new D3D11FrameFence(mDevice, mD3DContext);
+}
+
+void D3D11RenderDevice::ReleaseFrameFence(IFrameFence* fence)
+{
+	delete fence;
+}
+
+RenderEffect* D3D11RenderDevice::CreateEffect(const char* fileName)
+{
+	DWORD shaderFlags = 0;
+#if defined(DEBUG) || defined(_DEBUG)
+	shaderFlags |= D3D10_SHADER_DEBUG;
+	shaderFlags |= D3D10_SHADER_SKIP_OPTIMIZATION;
+#endif
+
+	DWORD effectFlags = 0;
+
+	std::vector<uint8_t> bytecode;
+	std::string errors;
+	bool loaded = mEffectCache.Load(fileName, std::vector<EffectDefine>(), shaderFlags, bytecode, errors);
+
+	if (!errors.empty())
+	{
+		MessageBoxA(0, errors.c_str(), 0, 0);
+	}
+	if (!loaded)
+	{
+		return nullptr;
+	}
+
+	ID3DX11Effect* effect = nullptr;
+	HRESULT hr = D3DX11CreateEffectFromMemory(bytecode.data(), bytecode.size(), effectFlags, mDevice, &effect);
+	if (FAILED(hr))
+	{
+		DXTrace(__FILEW__, (DWORD)__LINE__, hr, L"D3DX11CreateEffectFromMemory Failed", true);
+		return nullptr;
+	}
+	return ToRenderEffect(effect);
+}
+
+void D3D11RenderDevice::ReleaseEffect(RenderEffect* effect)
+{
+	ID3DX11Effect* d3dEffect = ToD3D11(effect);
+	ReleaseCOM(d3dEffect);
+}
+
+uint32_t D3D11RenderDevice::PassCount(RenderEffect* effect, const char* technique)
+{
+	D3DX11_TECHNIQUE_DESC techDesc;
+	HR(ToD3D11(effect)->GetTechniqueByName(technique)->GetDesc(&techDesc));
+	return techDesc.Passes;
+}
+
+RenderPass* D3D11RenderDevice::FindPass(RenderEffect* effect, const char* technique, uint32_t pass)
+{
+	return ToRenderPass(ToD3D11(effect)->GetTechniqueByName(technique)->GetPassByIndex(pass));
+}
+
+RenderConstant* D3D11RenderDevice::FindConstant(RenderEffect* effect, const char* name)
+{
+	ID3DX11EffectVariable* variable = ToD3D11(effect)->GetVariableByName(name);
+	return variable->IsValid() ? ToRenderConstant(variable) : nullptr;
+}
+
+RenderInputLayout* D3D11RenderDevice::CreateInputLayout(const std::vector<StreamElement>& elements, RenderPass* pass)
+{
+	std::vector<D3D11_INPUT_ELEMENT_DESC> vertexDesc = InputElementDescs(elements);
+
+	D3DX11_PASS_DESC passDesc;
+	ToD3D11(pass)->GetDesc(&passDesc);
+
+	ID3D11InputLayout* layout = nullptr;
+	HR(mDevice->CreateInputLayout(vertexDesc.data(), static_cast<UINT>(vertexDesc.size()), passDesc.pIAInputSignature, passDesc.IAInputSignatureSize, &layout));
+	return ToRenderInputLayout(layout);
+}
+
+void D3D11RenderDevice::ReleaseInputLayout(RenderInputLayout* layout)
+{
+	ID3D11InputLayout* d3dLayout = ToD3D11(layout);
+	ReleaseCOM(d3dLayout);
+}
@@ -0,0 +1,51 @@
+#ifndef D3D11RENDERDEVICE_H
+#define D3D11RENDERDEVICE_H
+
+#include "d3dUtil.h"
+#include "d3dx11effect.h"
+#include "RenderDevice.h"
+#include "D3D11DeviceContext.h"
+#include "D3D11EffectCompiler.h"
+#include "EffectCache.h"
+
+// IRenderDevice over a D3D11 device. Effects are compiled from .fx files
+// and kept in an EffectCache in 'effectCacheDirectory', so later launches
+// load the bytecode instead of compiling again.
+class D3D11RenderDevice : public IRenderDevice
+{
+public:
+	D3D11RenderDevice(ID3D11Device* device, ID3D11DeviceContext* context, const std::string& effectCacheDirectory = "FXCache");
+
+	IDeviceContext& ImmediateContext() { return mContext; }
+	D3D11DeviceContext& Context() { return mContext; }
+
+	RenderBuffer* CreateBuffer(const BufferDesc& desc, const void* initialData);
+	void ReleaseBuffer(RenderBuffer* buffer);
+
+	void* MapBuffer(RenderBuffer* buffer, MapMode mode);
+	void UnmapBuffer(RenderBuffer* buffer);
+
+	// Event queries, one per frame in flight
+	IFrameFence* CreateFrameFence();
+	void ReleaseFrameFence(IFrameFence* fence);
+
+	RenderEffect* CreateEffect(const char* fileName);
+	void ReleaseEffect(RenderEffect* effect);
+	const EffectCacheStats& EffectStats() const { return mEffectCache.Stats(); }
+
+	uint32_t PassCount(RenderEffect* effect, const char* technique);
+	RenderPass* FindPass(RenderEffect* effect, const char* technique, uint32_t pass);
+	RenderConstant* FindConstant(RenderEffect* effect, const char* name);
+
+	RenderInputLayout* CreateInputLayout(const std::vector<StreamElement>& elements, RenderPass* pass);
+	void ReleaseInputLayout(RenderInputLayout* layout);
+
+private:
+	ID3D11Device* mDevice;
+	ID3D11DeviceContext* mD3DContext;
+	D3D11DeviceContext mContext;
+	D3D11EffectCompiler mEffectCompiler;
+	EffectCache mEffectCache;
+};
+
+#endif // D3D11RENDERDEVICE_H
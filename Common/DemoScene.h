@@ -0,0 +1,47 @@
+#ifndef DEMOSCENE_H
+#define DEMOSCENE_H
+
+#include "RenderDevice.h"
+
+#include <cstdint>
+#include <string>
+
+enum MouseButton : uint32_t
+{
+	MouseButtonLeft = 1,
+	MouseButtonRight = 2,
+	MouseButtonMiddle = 4
+};
+
+// The platform independent part of a demo: resources, camera, per-frame
+// update and draw submission. SceneApp runs a scene in a window on D3D11,
+// the headless driver runs it on the null device.
+class DemoScene
+{
+public:
+	virtual ~DemoScene() {}
+
+	// Creates the scene's resources on 'device', which must outlive the scene
+	virtual bool Init(IRenderDevice& device) = 0;
+	// Releases everything Init created
+	virtual void Shutdown() = 0;
+
+	virtual void OnResize(int width, int height) = 0;
+	virtual void UpdateScene(float dt, float totalTime) = 0;
+	// With a fixed step the frame is drawn 'alpha' of a step after the last
+	// UpdateScene. Scenes that keep their previous state blend towards it,
+	// the others draw the last step.
+	virtual void Interpolate(float /*alpha*/) {}
+	// Clears and draws into the device's immediate context, presenting is up to the caller
+	virtual void DrawScene() = 0;
+
+	// Window caption, may change between frames
+	virtual const std::string& Caption() const = 0;
+
+	// 'buttons' is a combination of MouseButton flags
+	virtual void OnMouseDown(uint32_t /*buttons*/, int /*x*/, int /*y*/) {}
+	virtual void OnMouseUp(uint32_t /*buttons*/, int /*x*/, int /*y*/) {}
+	virtual void OnMouseMove(uint32_t /*buttons*/, int /*x*/, int /*y*/) {}
+};
+
+#endif // DEMOSCENE_H
@@ -0,0 +1,63 @@
+#include "DeviceContext.h"
+
+uint32_t PrimitiveTriangleCount(PrimitiveTopology topology, uint32_t indexCount)
+{
+	switch (topology)
+	{
+	case PrimitiveTopology::TriangleList: return indexCount / 3;
+	case PrimitiveTopology::TriangleStrip: return indexCount >= 3 ? indexCount - 2 : 0;
+	default: return 0;
+	}
+}
+
+//
+// NullDeviceContext
+//
+
+NullDeviceContext::NullDeviceContext()
+	: CallCount(0)
+	, ClearCount(0)
+	, DrawCount(0)
+	, IndexCount(0)
+	, TriangleCount(0)
+	, ConstantBytes(0)
+	, mTopology(PrimitiveTopology::TriangleList)
+{
+}
+
+void NullDeviceContext::ClearRenderTarget(const Float4&)
+{
+	CallCount++;
+	ClearCount++;
+}
+
+void NullDeviceContext::ClearDepthStencil(float, uint8_t)
+{
+	CallCount++;
+	ClearCount++;
+}
+
+void NullDeviceContext::SetInputLayout(RenderInputLayout*) { CallCount++; }
+void NullDeviceContext::SetVertexBuffer(uint32_t, RenderBuffer*, uint32_t, uint32_t) { CallCount++; }
+void NullDeviceContext::SetIndexBuffer(RenderBuffer*, IndexFormat, uint32_t) { CallCount++; }
+void NullDeviceContext::ApplyPass(RenderPass*) { CallCount++; }
+
+void NullDeviceContext::SetPrimitiveTopology(PrimitiveTopology topology)
+{
+	CallCount++;
+	mTopology = topology;
+}
+
+void NullDeviceContext::SetConstants(RenderConstant*, const void*, uint32_t size)
+{
+	CallCount++;
+	ConstantBytes += size;
+}
+
+void NullDeviceContext::DrawIndexed(uint32_t indexCount, uint32_t, int32_t)
+{
+	CallCount++;
+	DrawCount++;
+	IndexCount += indexCount;
+	TriangleCount += PrimitiveTriangleCount(mTopology, indexCount);
+}
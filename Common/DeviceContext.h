@@ -0,0 +1,76 @@
+#ifndef DEVICECONTEXT_H
+#define DEVICECONTEXT_H
+
+#include "RenderTypes.h"
+#include "ConstantData.h"
+#include "MathTypes.h"
+
+#include <cstdint>
+
+// The part of a device context the demos use to submit draws. Implemented
+// by the D3D11 backend, by the null backend and by wrappers such as the
+// state cache. Command buffers replay onto any context.
+class IDeviceContext
+{
+public:
+	virtual ~IDeviceContext() {}
+
+	// Clear the bound render target and depth stencil buffer
+	virtual void ClearRenderTarget(const Float4& color) = 0;
+	virtual void ClearDepthStencil(float depth, uint8_t stencil) = 0;
+
+	virtual void SetInputLayout(RenderInputLayout* layout) = 0;
+	virtual void SetPrimitiveTopology(PrimitiveTopology topology) = 0;
+	virtual void SetVertexBuffer(uint32_t slot, RenderBuffer* buffer, uint32_t stride, uint32_t offset) = 0;
+	virtual void SetIndexBuffer(RenderBuffer* buffer, IndexFormat format, uint32_t offset) = 0;
+	virtual void SetConstants(RenderConstant* constant, const void* data, uint32_t size) = 0;
+	virtual void ApplyPass(RenderPass* pass) = 0;
+	virtual void DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex) = 0;
+};
+
+// Counts calls and does nothing else
+class NullDeviceContext : public IDeviceContext
+{
+public:
+	NullDeviceContext();
+
+	void ClearRenderTarget(const Float4& color);
+	void ClearDepthStencil(float depth, uint8_t stencil);
+	void SetInputLayout(RenderInputLayout* layout);
+	void SetPrimitiveTopology(PrimitiveTopology topology);
+	void SetVertexBuffer(uint32_t slot, RenderBuffer* buffer, uint32_t stride, uint32_t offset);
+	void SetIndexBuffer(RenderBuffer* buffer, IndexFormat format, uint32_t offset);
+	void SetConstants(RenderConstant* constant, const void* data, uint32_t size);
+	void ApplyPass(RenderPass* pass);
+	void DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex);
+
+	uint64_t CallCount;
+	uint64_t ClearCount;
+	uint64_t DrawCount;
+	uint64_t IndexCount;
+	uint64_t TriangleCount;
+	uint64_t ConstantBytes;
+
+private:
+	PrimitiveTopology mTopology;
+};
+
+// Triangles drawn by 'indexCount' indices
+uint32_t PrimitiveTriangleCount(PrimitiveTopology topology, uint32_t indexCount);
+
+// Sends committed constant blocks to a context
+class ContextConstantUploader : public IConstantUploader
+{
+public:
+	explicit ContextConstantUploader(IDeviceContext& context) : mContext(context) {}
+
+	void Upload(RenderConstant* constant, const void* data, uint32_t size)
+	{
+		mContext.SetConstants(constant, data, size);
+	}
+
+private:
+	IDeviceContext& mContext;
+};
+
+#endif // DEVICECONTEXT_H
@@ -0,0 +1,265 @@
+#include "DisplayModeTable.h"
+#include "Hash.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+	const char* const header = "DisplayModeTable 1";
+
+	// Refresh rates compared exactly, as rationals
+	bool RefreshLess(const DisplayMode& a, const DisplayMode& b)
+	{
+		uint64_t aDenominator = a.RefreshDenominator != 0 ? a.RefreshDenominator : 1;
+		uint64_t bDenominator = b.RefreshDenominator != 0 ? b.RefreshDenominator : 1;
+		return a.RefreshNumerator * bDenominator < b.RefreshNumerator * aDenominator;
+	}
+
+	bool ModeLess(const DisplayMode& a, const DisplayMode& b)
+	{
+		if (a.Width != b.Width)
+		{
+			return a.Width < b.Width;
+		}
+		if (a.Height != b.Height)
+		{
+			return a.Height < b.Height;
+		}
+		return RefreshLess(a, b);
+	}
+
+	bool SizeLess(const DisplayMode& a, const DisplayMode& b)
+	{
+		return a.Width != b.Width ? a.Width < b.Width : a.Height < b.Height;
+	}
+
+	// The rest of the line after the fields read so far, without the separating space
+	std::string RestOfLine(std::istringstream& fields)
+	{
+		std::string rest;
+		std::getline(fields, rest);
+		return rest.empty() ? rest : rest.substr(1);
+	}
+}
+
+DisplayModeTable::DisplayModeTable(uint32_t format)
+	: mFormat(format)
+{
+}
+
+void DisplayModeTable::Clear()
+{
+	mAdapters.clear();
+	mOutputs.clear();
+	mModes.clear();
+}
+
+uint32_t DisplayModeTable::AddAdapter(const DisplayAdapterInfo& adapter)
+{
+	mAdapters.push_back(adapter);
+	mAdapters.back().FirstOutput = static_cast<uint32_t>(mOutputs.size());
+	mAdapters.back().OutputCount = 0;
+	return static_cast<uint32_t>(mAdapters.size() - 1);
+}
+
+uint32_t DisplayModeTable::AddOutput(const std::string& name)
+{
+	DisplayOutputInfo output = { name, static_cast<uint32_t>(mAdapters.size() - 1), static_cast<uint32_t>(mModes.size()), 0 };
+	mOutputs.push_back(output);
+	mAdapters.back().OutputCount++;
+	return static_cast<uint32_t>(mOutputs.size() - 1);
+}
+
+void DisplayModeTable::AddMode(const DisplayMode& mode)
+{
+	mModes.push_back(mode);
+	mOutputs.back().ModeCount++;
+}
+
+void DisplayModeTable::Sort()
+{
+	for (size_t i = 0; i < mOutputs.size(); i++)
+	{
+		DisplayMode* first = mModes.data() + mOutputs[i].FirstMode;
+		std::stable_sort(first, first + mOutputs[i].ModeCount, ModeLess);
+	}
+}
+
+const DisplayMode* DisplayModeTable::Modes(uint32_t output) const
+{
+	return mModes.data() + mOutputs[output].FirstMode;
+}
+
+const DisplayMode* DisplayModeTable::FindBestMode(uint32_t output, uint32_t width, uint32_t height, double refreshHz) const
+{
+	const DisplayOutputInfo& info = mOutputs[output];
+	if (info.ModeCount == 0)
+	{
+		return nullptr;
+	}
+	const DisplayMode* first = mModes.data() + info.FirstMode;
+	const DisplayMode* last = first + info.ModeCount;
+
+	// First mode at least as wide, then on to one tall enough
+	DisplayMode wanted = {};
+	wanted.Width = width;
+	wanted.Height = height;
+	const DisplayMode* size = std::lower_bound(first, last, wanted, SizeLess);
+	while (size != last && size->Height < height)
+	{
+		size++;
+	}
+	if (size == last)
+	{
+		size = last - 1;
+	}
+
+	// The modes of that size, by refresh rate
+	const DisplayMode* sizeFirst = std::lower_bound(first, last, *size, SizeLess);
+	const DisplayMode* sizeLast = std::upper_bound(first, last, *size, SizeLess);
+	const DisplayMode* refresh = std::lower_bound(sizeFirst, sizeLast, refreshHz,
+		[](const DisplayMode& mode, double hz) { return mode.RefreshHz() < hz; });
+	if (refresh == sizeLast)
+	{
+		return sizeLast - 1;
+	}
+	if (refresh != sizeFirst && std::fabs((refresh - 1)->RefreshHz() - refreshHz) <= std::fabs(refresh->RefreshHz() - refreshHz))
+	{
+		return refresh - 1;
+	}
+	return refresh;
+}
+
+uint64_t DisplayModeTable::Fingerprint() const
+{
+	uint64_t hash = HashValue(mFormat);
+	for (size_t i = 0; i < mAdapters.size(); i++)
+	{
+		const DisplayAdapterInfo& adapter = mAdapters[i];
+		hash = HashString(adapter.Description, hash);
+		hash = HashValue(adapter.VendorId, hash);
+		hash = HashValue(adapter.DeviceId, hash);
+		hash = HashValue(adapter.SubSysId, hash);
+		hash = HashValue(adapter.Revision, hash);
+		hash = HashValue(adapter.DedicatedVideoMemory, hash);
+		hash = HashValue(adapter.DriverVersion, hash);
+		hash = HashValue(adapter.OutputCount, hash);
+		for (uint32_t j = 0; j < adapter.OutputCount; j++)
+		{
+			hash = HashString(mOutputs[adapter.FirstOutput + j].Name, hash);
+		}
+	}
+	return hash;
+}
+
+bool DisplayModeTable::Save(const std::string& fileName) const
+{
+	FILE* file = fopen(fileName.c_str(), "w");
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	fprintf(file, "%s\nformat %u\n", header, mFormat);
+	for (size_t i = 0; i < mAdapters.size(); i++)
+	{
+		const DisplayAdapterInfo& adapter = mAdapters[i];
+		fprintf(file, "adapter %u %u %u %u %llu %llu %s\n"
+			, adapter.VendorId
+			, adapter.DeviceId
+			, adapter.SubSysId
+			, adapter.Revision
+			, static_cast<unsigned long long>(adapter.DedicatedVideoMemory)
+			, static_cast<unsigned long long>(adapter.DriverVersion)
+			, adapter.Description.c_str());
+
+		for (uint32_t j = 0; j < adapter.OutputCount; j++)
+		{
+			const DisplayOutputInfo& output = mOutputs[adapter.FirstOutput + j];
+			fprintf(file, "output %s\n", output.Name.c_str());
+			for (uint32_t k = 0; k < output.ModeCount; k++)
+			{
+				const DisplayMode& mode = mModes[output.FirstMode + k];
+				fprintf(file, "mode %u %u %u %u %u %u\n", mode.Width, mode.Height, mode.RefreshNumerator, mode.RefreshDenominator, mode.ScanlineOrdering, mode.Scaling);
+			}
+		}
+	}
+	return fclose(file) == 0;
+}
+
+bool DisplayModeTable::Load(const std::string& fileName)
+{
+	Clear();
+	std::ifstream file(fileName.c_str());
+	std::string line;
+	if (!file || !std::getline(file, line) || line != header)
+	{
+		return false;
+	}
+
+	while (std::getline(file, line))
+	{
+		std::istringstream fields(line);
+		std::string kind;
+		fields >> kind;
+
+		bool parsed = false;
+		if (kind == "format")
+		{
+			parsed = static_cast<bool>(fields >> mFormat);
+		}
+		else if (kind == "adapter")
+		{
+			DisplayAdapterInfo adapter = {};
+			parsed = static_cast<bool>(fields >> adapter.VendorId >> adapter.DeviceId >> adapter.SubSysId >> adapter.Revision
+				>> adapter.DedicatedVideoMemory >> adapter.DriverVersion);
+			adapter.Description = RestOfLine(fields);
+			if (parsed)
+			{
+				AddAdapter(adapter);
+			}
+		}
+		else if (kind == "output" && !mAdapters.empty())
+		{
+			AddOutput(RestOfLine(fields));
+			parsed = true;
+		}
+		else if (kind == "mode" && !mOutputs.empty())
+		{
+			DisplayMode mode = {};
+			uint32_t scanlineOrdering = 0;
+			uint32_t scaling = 0;
+			parsed = static_cast<bool>(fields >> mode.Width >> mode.Height >> mode.RefreshNumerator >> mode.RefreshDenominator >> scanlineOrdering >> scaling);
+			mode.ScanlineOrdering = static_cast<uint8_t>(scanlineOrdering);
+			mode.Scaling = static_cast<uint8_t>(scaling);
+			if (parsed)
+			{
+				AddMode(mode);
+			}
+		}
+		else if (kind.empty() || kind[0] == '#')
+		{
+			parsed = true;
+		}
+
+		if (!parsed)
+		{
+			Clear();
+			return false;
+		}
+	}
+
+	Sort();
+	return true;
+}
+
+std::string FormatDisplayMode(const DisplayMode& mode)
+{
+	char text[64];
+	snprintf(text, sizeof(text), "%ux%u @ %.2f Hz", mode.Width, mode.Height, mode.RefreshHz());
+	return text;
+}
@@ -0,0 +1,102 @@
+#ifndef DISPLAYMODETABLE_H
+#define DISPLAYMODETABLE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The fields of DXGI_MODE_DESC that differ between the modes of one format
+struct DisplayMode
+{
+	uint32_t Width;
+	uint32_t Height;
+	uint32_t RefreshNumerator;
+	uint32_t RefreshDenominator;
+	uint8_t ScanlineOrdering;	// DXGI_MODE_SCANLINE_ORDER
+	uint8_t Scaling;			// DXGI_MODE_SCALING
+
+	double RefreshHz() const { return RefreshDenominator != 0 ? static_cast<double>(RefreshNumerator) / RefreshDenominator : 0.0; }
+};
+
+struct DisplayAdapterInfo
+{
+	std::string Description;
+	uint32_t VendorId;
+	uint32_t DeviceId;
+	uint32_t SubSysId;
+	uint32_t Revision;
+	uint64_t DedicatedVideoMemory;
+	uint64_t DriverVersion;		// User mode driver, 0 if unknown
+	uint32_t FirstOutput;		// Set by AddAdapter
+	uint32_t OutputCount;
+};
+
+struct DisplayOutputInfo
+{
+	std::string Name;
+	uint32_t Adapter;
+	uint32_t FirstMode;
+	uint32_t ModeCount;
+};
+
+// Adapters, their outputs and the display modes of each output in one
+// format, in flat arrays. Sort orders every output's modes by width, height
+// and refresh rate so FindBestMode is a binary search.
+//
+// The table is saved as text between launches. A launch enumerates only the
+// adapters and outputs, which is cheap, and trusts the saved modes if the
+// Fingerprint of both matches:
+//
+//	DisplayModeTable 1
+//	format 28
+//	adapter 4318 7170 0 161 8589934592 0 NVIDIA GeForce GTX 1080
+//	output \\.\DISPLAY1
+//	mode 1920 1080 60000 1000 0 0
+//
+// A mode line is width, height, refresh numerator and denominator, scanline
+// ordering and scaling. Recorded lists in this format load on any platform.
+class DisplayModeTable
+{
+public:
+	// 'format' is a DXGI_FORMAT
+	explicit DisplayModeTable(uint32_t format = 0);
+
+	void Clear();
+
+	// Outputs go to the last adapter, modes to the last output
+	uint32_t AddAdapter(const DisplayAdapterInfo& adapter);
+	uint32_t AddOutput(const std::string& name);
+	void AddMode(const DisplayMode& mode);
+	// Call after adding modes, before FindBestMode
+	void Sort();
+
+	uint32_t Format() const { return mFormat; }
+	const std::vector<DisplayAdapterInfo>& Adapters() const { return mAdapters; }
+	const std::vector<DisplayOutputInfo>& Outputs() const { return mOutputs; }
+	const DisplayMode* Modes(uint32_t output) const;
+
+	// The mode of 'output' to use for a width x height window at refreshHz:
+	// that size if the output has it, else the first larger width with
+	// enough height, else the largest mode; of that size the refresh rate
+	// nearest to refreshHz. Null if the output has no modes.
+	const DisplayMode* FindBestMode(uint32_t output, uint32_t width, uint32_t height, double refreshHz) const;
+
+	// Hash of the format, adapters and outputs, not the modes. Two tables
+	// with the same fingerprint describe the same hardware.
+	uint64_t Fingerprint() const;
+
+	bool Save(const std::string& fileName) const;
+	// False if the file is missing or a line does not parse. Sorts.
+	bool Load(const std::string& fileName);
+
+private:
+	uint32_t mFormat;
+	std::vector<DisplayAdapterInfo> mAdapters;
+	std::vector<DisplayOutputInfo> mOutputs;
+	std::vector<DisplayMode> mModes;
+};
+
+// One line, "1920x1080 @ 59.94 Hz"
+std::string FormatDisplayMode(const DisplayMode& mode);
+
+#endif // DISPLAYMODETABLE_H
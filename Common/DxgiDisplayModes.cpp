@@ -0,0 +1,121 @@
+#include "DxgiDisplayModes.h"
+#include "Log.h"
+
+#include <vector>
+
+namespace
+{
+	// Enough for every mode of one format on common monitors, so one call per output
+	const UINT initialModeCapacity = 256;
+
+	// Adapter and output names are ASCII in practice
+	std::string Narrow(const WCHAR* text)
+	{
+		std::string narrow;
+		for (; *text != 0; text++)
+		{
+			narrow.push_back(*text < 128 ? static_cast<char>(*text) : '?');
+		}
+		return narrow;
+	}
+
+	DisplayAdapterInfo AdapterInfo(IDXGIAdapter* adapter)
+	{
+		DXGI_ADAPTER_DESC desc;
+		adapter->GetDesc(&desc);
+
+		DisplayAdapterInfo info = {};
+		info.Description = Narrow(desc.Description);
+		info.VendorId = desc.VendorId;
+		info.DeviceId = desc.DeviceId;
+		info.SubSysId = desc.SubSysId;
+		info.Revision = desc.Revision;
+		info.DedicatedVideoMemory = desc.DedicatedVideoMemory;
+
+		// A new driver may list other modes
+		LARGE_INTEGER driverVersion;
+		if (SUCCEEDED(adapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &driverVersion)))
+		{
+			info.DriverVersion = static_cast<uint64_t>(driverVersion.QuadPart);
+		}
+		return info;
+	}
+
+	// Reuses 'buffer' across outputs and only asks for the count if it is too small
+	UINT GetModes(IDXGIOutput* output, DXGI_FORMAT format, std::vector<DXGI_MODE_DESC>& buffer)
+	{
+		UINT count = static_cast<UINT>(buffer.size());
+		HRESULT hr = output->GetDisplayModeList(format, 0, &count, buffer.data());
+		if (hr == DXGI_ERROR_MORE_DATA)
+		{
+			output->GetDisplayModeList(format, 0, &count, NULL);
+			buffer.resize(count);
+			hr = output->GetDisplayModeList(format, 0, &count, buffer.data());
+		}
+		// Remote sessions have no modes
+		return SUCCEEDED(hr) ? count : 0;
+	}
+}
+
+bool EnumerateDisplayModes(IDXGIFactory* factory, DXGI_FORMAT format, const std::string& cacheFile, DisplayModeTable& table)
+{
+	table = DisplayModeTable(format);
+	std::vector<IDXGIOutput*> outputs;
+
+	IDXGIAdapter* adapter = NULL;
+	for (UINT adapterIndex = 0; factory->EnumAdapters(adapterIndex, &adapter) != DXGI_ERROR_NOT_FOUND; adapterIndex++)
+	{
+		table.AddAdapter(AdapterInfo(adapter));
+
+		IDXGIOutput* output = NULL;
+		for (UINT outputIndex = 0; adapter->EnumOutputs(outputIndex, &output) != DXGI_ERROR_NOT_FOUND; outputIndex++)
+		{
+			DXGI_OUTPUT_DESC desc;
+			output->GetDesc(&desc);
+			table.AddOutput(Narrow(desc.DeviceName));
+			outputs.push_back(output);
+		}
+		ReleaseCOM(adapter);
+	}
+
+	DisplayModeTable cached;
+	bool useCache = !cacheFile.empty() && cached.Load(cacheFile) && cached.Fingerprint() == table.Fingerprint();
+	if (useCache)
+	{
+		table = cached;
+	}
+	else
+	{
+		// Outputs were added in the same order, so modes go to the right one
+		DisplayModeTable enumerated(format);
+		std::vector<DXGI_MODE_DESC> buffer(initialModeCapacity);
+		for (size_t i = 0, output = 0; i < table.Adapters().size(); i++)
+		{
+			enumerated.AddAdapter(table.Adapters()[i]);
+			for (uint32_t j = 0; j < table.Adapters()[i].OutputCount; j++, output++)
+			{
+				enumerated.AddOutput(table.Outputs()[output].Name);
+				UINT count = GetModes(outputs[output], format, buffer);
+				for (UINT k = 0; k < count; k++)
+				{
+					DisplayMode mode = { buffer[k].Width, buffer[k].Height, buffer[k].RefreshRate.Numerator, buffer[k].RefreshRate.Denominator,
+						static_cast<uint8_t>(buffer[k].ScanlineOrdering), static_cast<uint8_t>(buffer[k].Scaling) };
+					enumerated.AddMode(mode);
+				}
+			}
+		}
+		enumerated.Sort();
+		table = enumerated;
+
+		if (!cacheFile.empty() && !table.Save(cacheFile))
+		{
+			LogMessage("Could not write " + cacheFile + "\n");
+		}
+	}
+
+	for (size_t i = 0; i < outputs.size(); i++)
+	{
+		ReleaseCOM(outputs[i]);
+	}
+	return useCache;
+}
@@ -0,0 +1,15 @@
+#ifndef DXGIDISPLAYMODES_H
+#define DXGIDISPLAYMODES_H
+
+#include "d3dUtil.h"
+#include "DisplayModeTable.h"
+
+#include <string>
+
+// Fills 'table' with the adapters and outputs of 'factory' and the modes of
+// every output in 'format'. Adapters and outputs are always enumerated, the
+// modes come from 'cacheFile' if its fingerprint matches, else from
+// GetDisplayModeList and the cache is rewritten. True if the cache was used.
+bool EnumerateDisplayModes(IDXGIFactory* factory, DXGI_FORMAT format, const std::string& cacheFile, DisplayModeTable& table);
+
+#endif // DXGIDISPLAYMODES_H
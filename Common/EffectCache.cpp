@@ -0,0 +1,273 @@
+#include "EffectCache.h"
+#include "Hash.h"
+#include "Log.h"
+#include "StartupTrace.h"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+namespace
+{
+	// "FXC1", bump the digit when the layout changes
+	const uint32_t blobMagic = 0x31435846;
+
+	struct BlobHeader
+	{
+		uint32_t Magic;
+		uint32_t Size;
+		uint64_t Key;
+		double CompileMs;
+	};
+
+	bool ReadFile(const std::string& fileName, std::string& text)
+	{
+		std::ifstream file(fileName.c_str(), std::ios::binary);
+		if (!file)
+		{
+			return false;
+		}
+		text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		CountFileBytesRead(text.size());
+		return true;
+	}
+
+	// Including the separator, empty for a bare name
+	std::string DirectoryOf(const std::string& fileName)
+	{
+		size_t separator = fileName.find_last_of("/\\");
+		return separator == std::string::npos ? std::string() : fileName.substr(0, separator + 1);
+	}
+
+	// Names of the #include "name" and #include <name> lines, in order
+	std::vector<std::string> FindIncludes(const std::string& source)
+	{
+		std::vector<std::string> names;
+		std::istringstream lines(source);
+		std::string line;
+		while (std::getline(lines, line))
+		{
+			size_t at = line.find_first_not_of(" \t");
+			if (at == std::string::npos || line[at] != '#')
+			{
+				continue;
+			}
+			at = line.find_first_not_of(" \t", at + 1);
+			if (at == std::string::npos || line.compare(at, 7, "include") != 0)
+			{
+				continue;
+			}
+			size_t open = line.find_first_of("\"<", at + 7);
+			if (open == std::string::npos)
+			{
+				continue;
+			}
+			size_t close = line.find(line[open] == '"' ? '"' : '>', open + 1);
+			if (close != std::string::npos)
+			{
+				names.push_back(line.substr(open + 1, close - open - 1));
+			}
+		}
+		return names;
+	}
+
+	// Depth first, each file once. A missing include only hashes its name,
+	// the compiler reports it.
+	uint64_t HashIncludes(const std::string& source, const std::string& directory, std::vector<std::string>& visited, uint64_t hash)
+	{
+		std::vector<std::string> names = FindIncludes(source);
+		for (size_t i = 0; i < names.size(); i++)
+		{
+			std::string path = directory + names[i];
+			hash = HashString(path, hash);
+
+			bool seen = false;
+			for (size_t j = 0; j < visited.size() && !seen; j++)
+			{
+				seen = visited[j] == path;
+			}
+			if (seen)
+			{
+				continue;
+			}
+			visited.push_back(path);
+
+			std::string text;
+			if (ReadFile(path, text))
+			{
+				hash = HashString(text, hash);
+				hash = HashIncludes(text, DirectoryOf(path), visited, hash);
+			}
+		}
+		return hash;
+	}
+
+	uint64_t EffectKey(const std::string& compiler, const std::string& fileName, const std::string& source,
+		const std::vector<EffectDefine>& defines, uint32_t flags)
+	{
+		uint64_t hash = HashString(compiler);
+		hash = HashValue(flags, hash);
+		for (size_t i = 0; i < defines.size(); i++)
+		{
+			hash = HashString(defines[i].Name, hash);
+			hash = HashString(defines[i].Value, hash);
+		}
+		hash = HashString(fileName, hash);
+		hash = HashString(source, hash);
+
+		std::vector<std::string> visited;
+		hash = HashIncludes(source, DirectoryOf(fileName), visited, hash);
+
+		// Zero means unreadable
+		return hash != 0 ? hash : 1;
+	}
+
+	double MillisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+EffectCache::EffectCache(IEffectCompiler& compiler, const std::string& directory)
+	: mCompiler(compiler)
+	, mDirectory(directory)
+	, mStats()
+{
+}
+
+bool EffectCache::Load(const std::string& fileName, const std::vector<EffectDefine>& defines, uint32_t flags,
+	std::vector<uint8_t>& bytecode, std::string& errors)
+{
+	auto start = std::chrono::steady_clock::now();
+	errors.clear();
+
+	std::string source;
+	if (!ReadFile(fileName, source))
+	{
+		errors = "Could not read " + fileName;
+		mStats.Misses++;
+		mStats.Failures++;
+		return false;
+	}
+
+	uint64_t key = EffectKey(mCompiler.Name(), fileName, source, defines, flags);
+	double storedCompileMs = 0.0;
+	if (!mDirectory.empty() && ReadBlob(key, bytecode, storedCompileMs))
+	{
+		double loadMs = MillisecondsSince(start);
+		mStats.Hits++;
+		mStats.LoadMs += loadMs;
+		mStats.SavedMs += storedCompileMs - loadMs;
+		return true;
+	}
+
+	mStats.Misses++;
+	auto compileStart = std::chrono::steady_clock::now();
+	bool compiled = mCompiler.Compile(fileName, source, defines, flags, bytecode, errors);
+	double compileMs = MillisecondsSince(compileStart);
+	mStats.CompileMs += compileMs;
+	if (!compiled)
+	{
+		mStats.Failures++;
+		return false;
+	}
+
+	if (!mDirectory.empty())
+	{
+		WriteBlob(key, bytecode, compileMs);
+	}
+	return true;
+}
+
+uint64_t EffectCache::Key(const std::string& fileName, const std::vector<EffectDefine>& defines, uint32_t flags) const
+{
+	std::string source;
+	if (!ReadFile(fileName, source))
+	{
+		return 0;
+	}
+	return EffectKey(mCompiler.Name(), fileName, source, defines, flags);
+}
+
+std::string EffectCache::BlobPath(uint64_t key) const
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.fxo", static_cast<unsigned long long>(key));
+	return mDirectory + "/" + name;
+}
+
+bool EffectCache::ReadBlob(uint64_t key, std::vector<uint8_t>& bytecode, double& compileMs) const
+{
+	FILE* file = fopen(BlobPath(key).c_str(), "rb");
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	BlobHeader header;
+	bool valid = fread(&header, sizeof(header), 1, file) == 1 && header.Magic == blobMagic && header.Key == key;
+
+	// The rest of the file must be exactly the bytecode, checked before the
+	// size is trusted for allocating
+	long start = ftell(file);
+	valid = valid && fseek(file, 0, SEEK_END) == 0 && static_cast<uint64_t>(ftell(file) - start) == header.Size
+		&& fseek(file, start, SEEK_SET) == 0;
+	if (valid)
+	{
+		bytecode.resize(header.Size);
+		valid = header.Size == 0 || fread(bytecode.data(), header.Size, 1, file) == 1;
+	}
+	fclose(file);
+	CountFileBytesRead(valid ? sizeof(header) + header.Size : 0);
+
+	compileMs = valid ? header.CompileMs : 0.0;
+	return valid;
+}
+
+void EffectCache::WriteBlob(uint64_t key, const std::vector<uint8_t>& bytecode, double compileMs) const
+{
+	std::error_code error;
+	std::filesystem::create_directories(mDirectory, error);
+
+	// Written next to the blob and renamed, so a blob is never half written
+	std::string path = BlobPath(key);
+	std::string temporary = path + ".tmp";
+	FILE* file = fopen(temporary.c_str(), "wb");
+	if (file == nullptr)
+	{
+		LogMessage("Could not write " + temporary + "\n");
+		return;
+	}
+
+	BlobHeader header = { blobMagic, static_cast<uint32_t>(bytecode.size()), key, compileMs };
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1
+		&& (bytecode.empty() || fwrite(bytecode.data(), bytecode.size(), 1, file) == 1);
+	written = fclose(file) == 0 && written;
+
+	if (written)
+	{
+		std::filesystem::rename(temporary, path, error);
+		written = !error;
+	}
+	if (!written)
+	{
+		LogMessage("Could not write " + path + "\n");
+		std::filesystem::remove(temporary, error);
+	}
+}
+
+std::string EffectCacheSummary(const EffectCacheStats& stats)
+{
+	uint32_t loads = stats.Hits + stats.Misses;
+	char summary[160];
+	snprintf(summary, sizeof(summary), "Effects: %u cached, %u compiled (%.0f%% hits), %.1f ms compiling, %.1f ms saved"
+		, stats.Hits
+		, stats.Misses - stats.Failures
+		, loads > 0 ? 100.0 * stats.Hits / loads : 0.0
+		, stats.CompileMs
+		, stats.SavedMs);
+	return summary;
+}
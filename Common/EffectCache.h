@@ -0,0 +1,81 @@
+#ifndef EFFECTCACHE_H
+#define EFFECTCACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct EffectDefine
+{
+	std::string Name;
+	std::string Value;
+};
+
+// Turns effect source into the bytecode the effects framework loads. The
+// D3D11 device compiles with fxc, the headless checks use a stub.
+class IEffectCompiler
+{
+public:
+	virtual ~IEffectCompiler() {}
+
+	// Part of the cache key, so blobs of another compiler version are not used
+	virtual std::string Name() const = 0;
+
+	// 'source' is the text of 'fileName', includes are resolved relative to
+	// it. 'errors' receives the messages, warnings too when it succeeds.
+	virtual bool Compile(const std::string& fileName, const std::string& source, const std::vector<EffectDefine>& defines,
+		uint32_t flags, std::vector<uint8_t>& bytecode, std::string& errors) = 0;
+};
+
+struct EffectCacheStats
+{
+	uint32_t Hits;
+	uint32_t Misses;
+	uint32_t Failures;		// Misses that did not compile
+	double CompileMs;		// Spent compiling the misses
+	double LoadMs;			// Spent reading and checking the hits
+	double SavedMs;			// What the hits took to compile when they were stored, less LoadMs
+};
+
+// Content addressed cache of compiled effects on disk. The key is a 64-bit
+// FNV-1a hash of the compiler name, the flags, the defines, the file name
+// and the text of the effect and every file it includes, so changing any of
+// them compiles again. A blob that is missing, truncated or stored under
+// another key is a miss and is replaced.
+//
+// Includes are found by scanning for #include lines, one in a disabled
+// #if block still counts, which at worst costs an extra compile.
+class EffectCache
+{
+public:
+	// Blobs are stored in 'directory', which is created when needed. With
+	// an empty directory every load compiles.
+	EffectCache(IEffectCompiler& compiler, const std::string& directory);
+
+	// The bytecode of 'fileName' from the cache or the compiler. False if the
+	// file can not be read or does not compile, with the reason in 'errors'.
+	bool Load(const std::string& fileName, const std::vector<EffectDefine>& defines, uint32_t flags,
+		std::vector<uint8_t>& bytecode, std::string& errors);
+
+	// Zero if the effect file can not be read
+	uint64_t Key(const std::string& fileName, const std::vector<EffectDefine>& defines, uint32_t flags) const;
+
+	const EffectCacheStats& Stats() const { return mStats; }
+	std::string BlobPath(uint64_t key) const;
+
+private:
+	EffectCache(const EffectCache&);
+	EffectCache& operator=(const EffectCache&);
+
+	bool ReadBlob(uint64_t key, std::vector<uint8_t>& bytecode, double& compileMs) const;
+	void WriteBlob(uint64_t key, const std::vector<uint8_t>& bytecode, double compileMs) const;
+
+	IEffectCompiler& mCompiler;
+	std::string mDirectory;
+	EffectCacheStats mStats;
+};
+
+// "Effects: 2 cached, 1 compiled (50% hits), 12.3 ms compiling, 48.0 ms saved"
+std::string EffectCacheSummary(const EffectCacheStats& stats);
+
+#endif // EFFECTCACHE_H
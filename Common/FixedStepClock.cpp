@@ -0,0 +1,55 @@
+#include "FixedStepClock.h"
+#include "DemoScene.h"
+#include "InputQueue.h"
+
+FixedStepClock::FixedStepClock(float stepSeconds, uint32_t maxStepsPerFrame)
+	: mStep(stepSeconds)
+	, mMaxSteps(maxStepsPerFrame == 0 ? 1 : maxStepsPerFrame)
+	, mAccumulated(0.0)
+	, mStepCount(0)
+	, mDropped(0.0)
+{
+}
+
+uint32_t FixedStepClock::Advance(double frameSeconds)
+{
+	// A paused timer or a clock that went back
+	if (frameSeconds > 0.0)
+	{
+		mAccumulated += frameSeconds;
+	}
+
+	uint32_t steps = 0;
+	while (mAccumulated >= mStep && steps < mMaxSteps)
+	{
+		mAccumulated -= mStep;
+		steps++;
+	}
+
+	if (mAccumulated >= mStep)
+	{
+		// Keep the fraction so the interpolation does not jump
+		double whole = static_cast<double>(static_cast<uint64_t>(mAccumulated / mStep)) * mStep;
+		mDropped += whole;
+		mAccumulated -= whole;
+	}
+
+	mStepCount += steps;
+	return steps;
+}
+
+uint32_t RunFixedSteps(FixedStepClock& clock, DemoScene& scene, InputQueue* input, double frameSeconds)
+{
+	uint32_t steps = clock.Advance(frameSeconds);
+	uint64_t firstStep = clock.StepCount() - steps;
+	for (uint32_t i = 1; i <= steps; i++)
+	{
+		if (input != nullptr)
+		{
+			DispatchInput(*input, scene);
+		}
+		scene.UpdateScene(clock.Step(), static_cast<float>((firstStep + i) * static_cast<double>(clock.Step())));
+	}
+	scene.Interpolate(clock.Alpha());
+	return steps;
+}
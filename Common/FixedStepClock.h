@@ -0,0 +1,55 @@
+#ifndef FIXEDSTEPCLOCK_H
+#define FIXEDSTEPCLOCK_H
+
+#include <cstdint>
+
+class DemoScene;
+class InputQueue;
+
+// Splits rendered frame times into simulation steps of a fixed length:
+//
+//	uint32_t steps = clock.Advance(frameSeconds);
+//	for (uint32_t i = 0; i < steps; i++)
+//	{
+//		scene.UpdateScene(clock.Step(), ...);
+//	}
+//	scene.Interpolate(clock.Alpha());
+//	scene.DrawScene();
+//
+// RunFixedSteps does this for a DemoScene.
+//
+// The simulation does the same steps whatever the frame rate, a long frame
+// runs several and a short one may run none. Time that would need more than
+// maxStepsPerFrame steps is dropped so a slow frame cannot make the next one
+// slower still.
+class FixedStepClock
+{
+public:
+	FixedStepClock(float stepSeconds, uint32_t maxStepsPerFrame);
+
+	// Adds the time of a rendered frame and returns how many steps to run now
+	uint32_t Advance(double frameSeconds);
+
+	float Step() const { return mStep; }
+	// How far the frame is between the last two steps, 0 to 1
+	float Alpha() const { return static_cast<float>(mAccumulated / mStep); }
+
+	// Simulated time after the steps Advance returned
+	double SimulationTime() const { return mStepCount * static_cast<double>(mStep); }
+	uint64_t StepCount() const { return mStepCount; }
+	double DroppedSeconds() const { return mDropped; }
+
+private:
+	float mStep;
+	uint32_t mMaxSteps;
+	double mAccumulated;
+	uint64_t mStepCount;
+	double mDropped;
+};
+
+// Runs the steps of a frame on 'scene', each with the simulated time at its
+// end and after handing it the queued input when 'input' is given, then
+// interpolates the scene for drawing. Returns the number of steps.
+uint32_t RunFixedSteps(FixedStepClock& clock, DemoScene& scene, InputQueue* input, double frameSeconds);
+
+#endif // FIXEDSTEPCLOCK_H
@@ -0,0 +1,104 @@
+#include "FrameArena.h"
+#include "Log.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+
+namespace
+{
+	const size_t regionAlignment = 64;
+
+	size_t AlignUp(size_t value, size_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+}
+
+FrameArena::FrameArena(size_t bytesPerFrame, uint32_t framesInFlight)
+	: mMemory(nullptr)
+	, mBytesPerFrame(AlignUp(bytesPerFrame, regionAlignment))
+	, mFramesInFlight(framesInFlight == 0 ? 1 : framesInFlight)
+	, mRegion(0)
+	, mFrame(0)
+	, mUsed(0)
+	, mPeak(0)
+	, mOverflowBlocks(mFramesInFlight)
+	, mOverflowBytes(mFramesInFlight, 0)
+	, mOverflows(0)
+	, mStaleAccesses(0)
+{
+	// Regions start on cache lines so frames never share one
+	mMemory = static_cast<uint8_t*>(::operator new(mBytesPerFrame * mFramesInFlight, std::align_val_t(regionAlignment)));
+}
+
+FrameArena::~FrameArena()
+{
+	for (uint32_t i = 0; i < mFramesInFlight; i++)
+	{
+		ReleaseOverflow(i);
+	}
+	::operator delete(mMemory, std::align_val_t(regionAlignment));
+}
+
+void FrameArena::BeginFrame()
+{
+	mPeak = UsedBytes() > mPeak ? UsedBytes() : mPeak;
+
+	mFrame++;
+	mRegion = static_cast<uint32_t>(mFrame % mFramesInFlight);
+	mUsed = 0;
+	ReleaseOverflow(mRegion);
+
+#ifdef FRAMEARENA_CHECKS
+	memset(mMemory + mRegion * mBytesPerFrame, 0xDD, mBytesPerFrame);
+#endif
+}
+
+void* FrameArena::Allocate(size_t size, size_t alignment)
+{
+	if (size == 0)
+	{
+		return nullptr;
+	}
+
+	size_t offset = AlignUp(mUsed, alignment);
+	if (offset + size <= mBytesPerFrame)
+	{
+		mUsed = offset + size;
+		return mMemory + mRegion * mBytesPerFrame + offset;
+	}
+
+#ifdef FRAMEARENA_CHECKS
+	if (mOverflowBlocks[mRegion].empty())
+	{
+		LogMessage("FrameArena: frame " + std::to_string(mFrame) + " needs more than " + std::to_string(mBytesPerFrame) + " bytes\n");
+	}
+#endif
+	OverflowBlock block = { ::operator new(size, std::align_val_t(alignment)), alignment };
+	mOverflowBlocks[mRegion].push_back(block);
+	mOverflowBytes[mRegion] += size;
+	mOverflows++;
+	return block.Memory;
+}
+
+void FrameArena::ReportStaleAccess(uint64_t frame) const
+{
+	if (mStaleAccesses == 0)
+	{
+		LogMessage("FrameArena: data of frame " + std::to_string(frame) + " used in frame " + std::to_string(mFrame) + "\n");
+	}
+	mStaleAccesses++;
+}
+
+void FrameArena::ReleaseOverflow(uint32_t region)
+{
+	std::vector<OverflowBlock>& blocks = mOverflowBlocks[region];
+	for (size_t i = 0; i < blocks.size(); i++)
+	{
+		::operator delete(blocks[i].Memory, std::align_val_t(blocks[i].Alignment));
+	}
+	blocks.clear();
+	mOverflowBytes[region] = 0;
+}
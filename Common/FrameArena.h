@@ -0,0 +1,150 @@
+#ifndef FRAMEARENA_H
+#define FRAMEARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#if defined(DEBUG) || defined(_DEBUG)
+#define FRAMEARENA_CHECKS
+#endif
+
+class FrameArena;
+
+// Array in a FrameArena. With FRAMEARENA_CHECKS indexing checks that the
+// frame it was allocated in is still in flight.
+template<typename T>
+class FrameSpan
+{
+public:
+	FrameSpan()
+		: mData(nullptr)
+		, mSize(0)
+		, mArena(nullptr)
+		, mFrame(0)
+	{
+	}
+
+	FrameSpan(T* data, uint32_t size, const FrameArena* arena, uint64_t frame)
+		: mData(data)
+		, mSize(size)
+		, mArena(arena)
+		, mFrame(frame)
+	{
+	}
+
+	T& operator[](uint32_t index) const;
+
+	T* Data() const { return mData; }
+	uint32_t Size() const { return mSize; }
+	bool Empty() const { return mSize == 0; }
+	T* begin() const { return mData; }
+	T* end() const { return mData + mSize; }
+
+private:
+	T* mData;
+	uint32_t mSize;
+	const FrameArena* mArena;
+	uint64_t mFrame;
+};
+
+// Bump allocator for data that lives for one frame: draw lists, matrices,
+// culling results. The memory is split into one region per frame in
+// flight, BeginFrame moves to the next region and frees the allocations
+// made framesInFlight frames ago at once. Nothing is destructed, so only
+// trivially destructible types go in.
+//
+// An allocation that does not fit falls back to the heap until the region
+// is reused and is counted as an overflow, size the arena by PeakBytes.
+// With FRAMEARENA_CHECKS (debug builds) overflows are logged, reused
+// regions are filled with 0xDD and FrameSpan catches use after the frame.
+class FrameArena
+{
+public:
+	FrameArena(size_t bytesPerFrame, uint32_t framesInFlight);
+	~FrameArena();
+
+	void BeginFrame();
+
+	// Null only for size 0
+	void* Allocate(size_t size, size_t alignment = 16);
+
+	// Uninitialized
+	template<typename T>
+	FrameSpan<T> AllocateArray(uint32_t count)
+	{
+		static_assert(std::is_trivially_destructible<T>::value, "FrameArena never runs destructors");
+		T* data = static_cast<T*>(Allocate(sizeof(T) * count, alignof(T) < 16 ? 16 : alignof(T)));
+		return FrameSpan<T>(data, count, this, mFrame);
+	}
+
+	// Every element is a copy of 'value'
+	template<typename T>
+	FrameSpan<T> AllocateArray(uint32_t count, const T& value)
+	{
+		FrameSpan<T> span = AllocateArray<T>(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			new (span.Data() + i) T(value);
+		}
+		return span;
+	}
+
+	// Allocations of 'frame' are still valid
+	bool IsLive(uint64_t frame) const { return frame <= mFrame && mFrame - frame < mFramesInFlight; }
+
+	uint64_t Frame() const { return mFrame; }
+	size_t BytesPerFrame() const { return mBytesPerFrame; }
+	// In the current frame, including overflow
+	size_t UsedBytes() const { return mUsed + mOverflowBytes[mRegion]; }
+	// Most any frame used
+	size_t PeakBytes() const { return mPeak; }
+	uint64_t OverflowCount() const { return mOverflows; }
+
+	// Called by FrameSpan with FRAMEARENA_CHECKS, counts and logs a use after the frame
+	void ReportStaleAccess(uint64_t frame) const;
+	uint64_t StaleAccessCount() const { return mStaleAccesses; }
+
+private:
+	FrameArena(const FrameArena&);
+	FrameArena& operator=(const FrameArena&);
+
+	void ReleaseOverflow(uint32_t region);
+
+	uint8_t* mMemory;
+	size_t mBytesPerFrame;
+	uint32_t mFramesInFlight;
+
+	uint32_t mRegion;
+	uint64_t mFrame;
+	size_t mUsed;
+	size_t mPeak;
+
+	struct OverflowBlock
+	{
+		void* Memory;
+		size_t Alignment;
+	};
+
+	// Heap blocks of the allocations that did not fit, per region
+	std::vector<std::vector<OverflowBlock>> mOverflowBlocks;
+	std::vector<size_t> mOverflowBytes;
+	uint64_t mOverflows;
+	mutable uint64_t mStaleAccesses;
+};
+
+template<typename T>
+T& FrameSpan<T>::operator[](uint32_t index) const
+{
+#ifdef FRAMEARENA_CHECKS
+	if (mArena != nullptr && !mArena->IsLive(mFrame))
+	{
+		mArena->ReportStaleAccess(mFrame);
+	}
+#endif
+	return mData[index];
+}
+
+#endif // FRAMEARENA_H
@@ -0,0 +1,370 @@
+#include "FrameProfiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+
+namespace
+{
+	// Every thread buffer ever created and the clock origin of the trace
+	struct ProfileRegistry
+	{
+		ProfileRegistry()
+			: OriginTicks(ProfileTimestamp())
+			, OriginTime(std::chrono::steady_clock::now())
+		{
+		}
+
+		std::mutex Mutex;
+		std::vector<ProfileThreadBuffer*> Buffers;
+		uint64_t OriginTicks;
+		std::chrono::steady_clock::time_point OriginTime;
+	};
+
+	// Never destroyed, like the buffers it lists, so threads still running
+	// at exit can register and the buffers stay reachable
+	ProfileRegistry& Registry()
+	{
+		static ProfileRegistry* registry = new ProfileRegistry();
+		return *registry;
+	}
+
+	std::string EscapeJson(const char* text)
+	{
+		std::string escaped;
+		for (const char* c = text; *c != '\0'; c++)
+		{
+			if (*c == '"' || *c == '\\')
+			{
+				escaped += '\\';
+			}
+			escaped += *c;
+		}
+		return escaped;
+	}
+}
+
+//
+// ProfileThreadBuffer
+//
+
+ProfileThreadBuffer::ProfileThreadBuffer(uint32_t threadIndex)
+	: mEvents(new ProfileEvent[Capacity])
+	, mWriteIndex(0)
+	, mThreadIndex(threadIndex)
+{
+}
+
+ProfileThreadBuffer::~ProfileThreadBuffer()
+{
+	delete[] mEvents;
+}
+
+ProfileThreadBuffer* ProfilerDetail::RegisterThread()
+{
+	ProfileRegistry& registry = Registry();
+	std::lock_guard<std::mutex> lock(registry.Mutex);
+
+	// Never freed, a profiler may read it after the thread has exited
+	ProfileThreadBuffer* buffer = new ProfileThreadBuffer(static_cast<uint32_t>(registry.Buffers.size()));
+	registry.Buffers.push_back(buffer);
+	threadBuffer = buffer;
+	return buffer;
+}
+
+//
+// FrameProfiler::Histogram
+//
+
+FrameProfiler::Histogram::Histogram()
+	: mBuckets(BucketCount, 0)
+	, mCount(0)
+	, mTotal(0)
+	, mMin(UINT64_MAX)
+	, mMax(0)
+{
+}
+
+uint32_t FrameProfiler::Histogram::BucketIndex(uint64_t value)
+{
+	// Values below SubBuckets get a bucket each
+	if (value < SubBuckets)
+	{
+		return static_cast<uint32_t>(value);
+	}
+
+	uint32_t highestBit = 0;
+	while ((value >> (highestBit + 1)) != 0)
+	{
+		highestBit++;
+	}
+	// highestBit >= 3, the next three bits select the sub-bucket
+	uint32_t subBucket = static_cast<uint32_t>(value >> (highestBit - 3)) & (SubBuckets - 1);
+	return (highestBit - 2) * SubBuckets + subBucket;
+}
+
+uint64_t FrameProfiler::Histogram::BucketStart(uint32_t index)
+{
+	if (index < SubBuckets)
+	{
+		return index;
+	}
+	uint32_t highestBit = index / SubBuckets + 2;
+	uint64_t subBucket = index % SubBuckets;
+	return (SubBuckets + subBucket) << (highestBit - 3);
+}
+
+void FrameProfiler::Histogram::Add(uint64_t nanoseconds)
+{
+	mBuckets[BucketIndex(nanoseconds)]++;
+	mCount++;
+	mTotal += nanoseconds;
+	mMin = std::min(mMin, nanoseconds);
+	mMax = std::max(mMax, nanoseconds);
+}
+
+void FrameProfiler::Histogram::Merge(const Histogram& other)
+{
+	for (uint32_t i = 0; i < BucketCount; i++)
+	{
+		mBuckets[i] += other.mBuckets[i];
+	}
+	mCount += other.mCount;
+	mTotal += other.mTotal;
+	mMin = std::min(mMin, other.mMin);
+	mMax = std::max(mMax, other.mMax);
+}
+
+double FrameProfiler::Histogram::Percentile(double fraction) const
+{
+	if (mCount == 0)
+	{
+		return 0.0;
+	}
+
+	uint64_t rank = static_cast<uint64_t>(fraction * (mCount - 1)) + 1;
+	uint64_t seen = 0;
+	for (uint32_t i = 0; i < BucketCount; i++)
+	{
+		seen += mBuckets[i];
+		if (seen >= rank)
+		{
+			// The extremes are known exactly
+			double start = static_cast<double>(std::max(BucketStart(i), mMin));
+			double end = i + 1 < BucketCount ? static_cast<double>(std::min(BucketStart(i + 1), mMax + 1)) : static_cast<double>(mMax + 1);
+			return 0.5 * (start + end);
+		}
+	}
+	return static_cast<double>(mMax);
+}
+
+//
+// FrameProfiler
+//
+
+FrameProfiler::FrameProfiler()
+	: mEventCopy(ProfileThreadBuffer::Capacity)
+	, mLostEvents(0)
+	, mNanosecondsPerTick(1.0)
+{
+	// Threads that already recorded scopes are read from their current position
+	UpdateCursors();
+	for (size_t i = 0; i < mCursors.size(); i++)
+	{
+		mCursors[i].First = mCursors[i].Buffer->WriteIndex();
+		mCursors[i].Next = mCursors[i].First;
+	}
+	UpdateTickRate();
+}
+
+void FrameProfiler::UpdateCursors()
+{
+	ProfileRegistry& registry = Registry();
+	std::lock_guard<std::mutex> lock(registry.Mutex);
+	for (size_t i = mCursors.size(); i < registry.Buffers.size(); i++)
+	{
+		Cursor cursor = { registry.Buffers[i], 0, 0 };
+		mCursors.push_back(cursor);
+	}
+}
+
+void FrameProfiler::UpdateTickRate()
+{
+	ProfileRegistry& registry = Registry();
+	uint64_t ticks = ProfileTimestamp() - registry.OriginTicks;
+	double nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - registry.OriginTime).count();
+	if (ticks > 0 && nanoseconds > 0.0)
+	{
+		mNanosecondsPerTick = nanoseconds / ticks;
+	}
+}
+
+FrameProfiler::EventRange FrameProfiler::CopyEvents(const ProfileThreadBuffer& buffer, uint64_t from)
+{
+	const uint64_t capacity = ProfileThreadBuffer::Capacity;
+
+	EventRange range;
+	range.End = buffer.WriteIndex();
+	range.First = std::max(from, range.End > capacity ? range.End - capacity : 0);
+	for (uint64_t index = range.First; index < range.End; index++)
+	{
+		mEventCopy[index - range.First] = buffer.Event(index);
+	}
+
+	// The owner writes event 'written' into the slot of 'written - capacity'
+	// before publishing it, so anything up to there may be newer or torn
+	std::atomic_thread_fence(std::memory_order_acquire);
+	uint64_t written = buffer.WriteIndex();
+	range.Valid = std::min(range.End, std::max(range.First, written >= capacity ? written - capacity + 1 : 0));
+	return range;
+}
+
+void FrameProfiler::Collect()
+{
+	UpdateCursors();
+	UpdateTickRate();
+
+	for (size_t i = 0; i < mCursors.size(); i++)
+	{
+		Cursor& cursor = mCursors[i];
+		EventRange range = CopyEvents(*cursor.Buffer, cursor.Next);
+		mLostEvents += range.Valid - cursor.Next;
+
+		for (uint64_t index = range.Valid; index < range.End; index++)
+		{
+			const ProfileEvent& event = mEventCopy[index - range.First];
+			double nanoseconds = (event.End - event.Start) * mNanosecondsPerTick;
+			mHistograms[event.Name].Add(static_cast<uint64_t>(nanoseconds + 0.5));
+		}
+		cursor.Next = range.End;
+	}
+}
+
+void FrameProfiler::ResetHistograms()
+{
+	mHistograms.clear();
+}
+
+std::vector<PhaseStats> FrameProfiler::Phases() const
+{
+	// The same name from literals in different files is one phase
+	std::map<std::string, Histogram> byName;
+	for (auto it = mHistograms.begin(); it != mHistograms.end(); ++it)
+	{
+		byName[it->first].Merge(it->second);
+	}
+
+	std::vector<PhaseStats> phases;
+	for (auto it = byName.begin(); it != byName.end(); ++it)
+	{
+		const Histogram& histogram = it->second;
+		PhaseStats phase;
+		phase.Name = it->first;
+		phase.Count = histogram.Count();
+		phase.TotalMs = histogram.Total() / 1000000.0;
+		phase.MinUs = histogram.Min() / 1000.0;
+		phase.MedianUs = histogram.Percentile(0.5) / 1000.0;
+		phase.P90Us = histogram.Percentile(0.9) / 1000.0;
+		phase.P99Us = histogram.Percentile(0.99) / 1000.0;
+		phase.MaxUs = histogram.Max() / 1000.0;
+		phases.push_back(phase);
+	}
+	return phases;
+}
+
+std::string FrameProfiler::Report() const
+{
+	std::string report;
+	char line[256];
+	snprintf(line, sizeof(line), "%-24s %8s %10s %9s %9s %9s %9s %9s\n", "phase (us)", "count", "total ms", "min", "p50", "p90", "p99", "max");
+	report += line;
+
+	std::vector<PhaseStats> phases = Phases();
+	for (size_t i = 0; i < phases.size(); i++)
+	{
+		const PhaseStats& phase = phases[i];
+		snprintf(line, sizeof(line), "%-24s %8llu %10.3f %9.2f %9.2f %9.2f %9.2f %9.2f\n"
+			, phase.Name.c_str()
+			, static_cast<unsigned long long>(phase.Count)
+			, phase.TotalMs
+			, phase.MinUs
+			, phase.MedianUs
+			, phase.P90Us
+			, phase.P99Us
+			, phase.MaxUs);
+		report += line;
+	}
+	if (mLostEvents > 0)
+	{
+		snprintf(line, sizeof(line), "%llu events were overwritten before they were collected\n", static_cast<unsigned long long>(mLostEvents));
+		report += line;
+	}
+	return report;
+}
+
+bool FrameProfiler::WriteChromeTrace(const std::string& fileName)
+{
+	UpdateCursors();
+	UpdateTickRate();
+
+	FILE* file = fopen(fileName.c_str(), "w");
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	// The first scope of the program may start before the origin
+	uint64_t originTicks = Registry().OriginTicks;
+	double microsecondsPerTick = mNanosecondsPerTick / 1000.0;
+
+	fprintf(file, "{\"traceEvents\":[\n");
+	bool first = true;
+	for (size_t i = 0; i < mCursors.size(); i++)
+	{
+		const Cursor& cursor = mCursors[i];
+		uint32_t thread = cursor.Buffer->ThreadIndex();
+		fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"Thread %u\"}}", first ? "" : ",\n", thread, thread);
+		first = false;
+
+		EventRange range = CopyEvents(*cursor.Buffer, cursor.First);
+		for (uint64_t index = range.Valid; index < range.End; index++)
+		{
+			const ProfileEvent& event = mEventCopy[index - range.First];
+			fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}"
+				, EscapeJson(event.Name).c_str()
+				, thread
+				, static_cast<int64_t>(event.Start - originTicks) * microsecondsPerTick
+				, (event.End - event.Start) * microsecondsPerTick);
+		}
+	}
+	fprintf(file, "\n]}\n");
+	return fclose(file) == 0;
+}
+
+double FrameProfiler::MeasureScopeOverhead(uint32_t iterations)
+{
+	// Registers the thread outside the timed loop
+	CurrentProfileBuffer();
+
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < iterations; i++)
+	{
+		PROFILE_SCOPE("ProfileOverhead");
+	}
+	auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::nano>(end - start).count() / std::max(1u, iterations);
+}
+
+double FrameProfiler::MeasureTimestampCost(uint32_t iterations)
+{
+	// Summed so the reads are not optimized away
+	uint64_t sum = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < iterations; i++)
+	{
+		sum += ProfileTimestamp();
+	}
+	auto end = std::chrono::steady_clock::now();
+	double nanoseconds = std::chrono::duration<double, std::nano>(end - start).count();
+	return (nanoseconds + (sum & 1)) / std::max(1u, iterations);
+}
@@ -0,0 +1,248 @@
+#ifndef FRAMEPROFILER_H
+#define FRAMEPROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define FRAMEPROFILER_RDTSC
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define FRAMEPROFILER_RDTSC
+#endif
+
+// Scoped CPU timing markers:
+//
+//	void Scene::BuildFX()
+//	{
+//		PROFILE_SCOPE("BuildFX");
+//		...
+//
+// A scope stores its name and start and end ticks in a ring buffer owned by
+// the calling thread, there are no locks or allocations after the first
+// scope of a thread. A FrameProfiler collects the rings into per-phase
+// histograms and writes Chrome trace events (chrome://tracing, Perfetto).
+// Names must be string literals or otherwise outlive the profiler.
+//
+// Define DISABLE_FRAME_PROFILER to compile the scopes out.
+
+// Raw clock of the scopes, the time stamp counter where there is one
+inline uint64_t ProfileTimestamp()
+{
+#ifdef FRAMEPROFILER_RDTSC
+	return __rdtsc();
+#else
+	return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+struct ProfileEvent
+{
+	const char* Name;
+	uint64_t Start;
+	uint64_t End;
+};
+
+// Events of one thread. Only the owning thread writes, readers on other
+// threads see everything before WriteIndex. The owner may be overwriting the
+// slot of WriteIndex - Capacity, so a reader copies events out and then
+// drops the ones the owner has reached since. A thread that records more
+// than Capacity events between two collections loses the oldest ones.
+class ProfileThreadBuffer
+{
+public:
+	static const uint32_t Capacity = 1 << 14;
+
+	explicit ProfileThreadBuffer(uint32_t threadIndex);
+	~ProfileThreadBuffer();
+
+	void Record(const char* name, uint64_t start, uint64_t end)
+	{
+		uint64_t index = mWriteIndex.load(std::memory_order_relaxed);
+		// The slot may be read while it is written, readers check WriteIndex
+		// after copying and this keeps the writes after the last index store.
+		// No instruction on x86.
+		std::atomic_thread_fence(std::memory_order_release);
+		ProfileEvent& event = mEvents[index & (Capacity - 1)];
+		event.Name = name;
+		event.Start = start;
+		event.End = end;
+		mWriteIndex.store(index + 1, std::memory_order_release);
+	}
+
+	uint64_t WriteIndex() const { return mWriteIndex.load(std::memory_order_acquire); }
+	const ProfileEvent& Event(uint64_t index) const { return mEvents[index & (Capacity - 1)]; }
+	// Order in which the threads recorded their first scope
+	uint32_t ThreadIndex() const { return mThreadIndex; }
+
+private:
+	ProfileThreadBuffer(const ProfileThreadBuffer&);
+	ProfileThreadBuffer& operator=(const ProfileThreadBuffer&);
+
+	ProfileEvent* mEvents;
+	std::atomic<uint64_t> mWriteIndex;
+	uint32_t mThreadIndex;
+};
+
+namespace ProfilerDetail
+{
+	// Constant initialized so reading it needs no guard
+	inline thread_local ProfileThreadBuffer* threadBuffer = nullptr;
+
+	// Creates the buffer of the calling thread, it lives until the program exits
+	ProfileThreadBuffer* RegisterThread();
+}
+
+inline ProfileThreadBuffer& CurrentProfileBuffer()
+{
+	ProfileThreadBuffer* buffer = ProfilerDetail::threadBuffer;
+	if (buffer == nullptr)
+	{
+		buffer = ProfilerDetail::RegisterThread();
+	}
+	return *buffer;
+}
+
+class ProfileScope
+{
+public:
+	explicit ProfileScope(const char* name)
+		: mName(name)
+		, mStart(ProfileTimestamp())
+	{
+	}
+
+	~ProfileScope()
+	{
+		CurrentProfileBuffer().Record(mName, mStart, ProfileTimestamp());
+	}
+
+private:
+	ProfileScope(const ProfileScope&);
+	ProfileScope& operator=(const ProfileScope&);
+
+	const char* mName;
+	uint64_t mStart;
+};
+
+#define PROFILE_CONCATENATE_INNER(a, b) a##b
+#define PROFILE_CONCATENATE(a, b) PROFILE_CONCATENATE_INNER(a, b)
+
+#ifdef DISABLE_FRAME_PROFILER
+#define PROFILE_SCOPE(name)
+#else
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCATENATE(profileScope, __LINE__)(name)
+#endif
+
+// Times of one phase in microseconds
+struct PhaseStats
+{
+	std::string Name;
+	uint64_t Count;
+	double TotalMs;
+	double MinUs;
+	double MedianUs;
+	double P90Us;
+	double P99Us;
+	double MaxUs;
+};
+
+// Reads the scopes of every thread recorded after the profiler was created.
+// Collect runs on one thread at a time, typically once per frame.
+class FrameProfiler
+{
+public:
+	FrameProfiler();
+
+	// Adds the scopes recorded since the last call to the histograms
+	void Collect();
+	void ResetHistograms();
+
+	// Sorted by name
+	std::vector<PhaseStats> Phases() const;
+	// One line per phase
+	std::string Report() const;
+
+	// The most recent events of every thread, up to ProfileThreadBuffer::Capacity each
+	bool WriteChromeTrace(const std::string& fileName);
+
+	// Events overwritten before or while they were collected
+	uint64_t LostEvents() const { return mLostEvents; }
+
+	// Nanoseconds per empty scope on the calling thread. Records 'iterations'
+	// scopes, so call it before creating a profiler that should not see them.
+	static double MeasureScopeOverhead(uint32_t iterations);
+	// Nanoseconds per ProfileTimestamp, a scope reads it twice
+	static double MeasureTimestampCost(uint32_t iterations);
+
+private:
+	// Log-linear buckets, 8 per power of two, so percentiles are within 1/16
+	class Histogram
+	{
+	public:
+		Histogram();
+
+		void Add(uint64_t nanoseconds);
+		// Middle of the bucket holding the given fraction of the samples
+		double Percentile(double fraction) const;
+
+		// Adds the samples of another histogram
+		void Merge(const Histogram& other);
+
+		uint64_t Count() const { return mCount; }
+		uint64_t Total() const { return mTotal; }
+		uint64_t Min() const { return mMin; }
+		uint64_t Max() const { return mMax; }
+
+	private:
+		static const uint32_t SubBuckets = 8;
+		static const uint32_t BucketCount = 64 * SubBuckets;
+
+		static uint32_t BucketIndex(uint64_t value);
+		static uint64_t BucketStart(uint32_t index);
+
+		std::vector<uint32_t> mBuckets;
+		uint64_t mCount;
+		uint64_t mTotal;
+		uint64_t mMin;
+		uint64_t mMax;
+	};
+
+	struct Cursor
+	{
+		const ProfileThreadBuffer* Buffer;
+		uint64_t First;		// Oldest event the profiler may read
+		uint64_t Next;		// Next event to collect
+	};
+
+	// Events from First to End of one thread copied to mEventCopy, those
+	// before Valid were overwritten before or while they were copied
+	struct EventRange
+	{
+		uint64_t First;
+		uint64_t Valid;
+		uint64_t End;
+	};
+
+	// Starts reading threads that recorded their first scope since the last call
+	void UpdateCursors();
+	// Copies the events of 'buffer' from 'from' to its write index
+	EventRange CopyEvents(const ProfileThreadBuffer& buffer, uint64_t from);
+	// Ticks to nanoseconds, calibrated against steady_clock
+	void UpdateTickRate();
+
+	std::vector<Cursor> mCursors;
+	// Collect copies the events here before reading them
+	std::vector<ProfileEvent> mEventCopy;
+	// By name pointer, Phases merges names that are equal but not the same literal
+	std::map<const char*, Histogram> mHistograms;
+	uint64_t mLostEvents;
+	double mNanosecondsPerTick;
+};
+
+#endif // FRAMEPROFILER_H
@@ -0,0 +1,36 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 64-bit FNV-1a, for cache keys and fingerprints rather than hash tables
+const uint64_t Fnv1aOffset = 14695981039346656037ull;
+
+inline uint64_t Fnv1a(const void* data, size_t size, uint64_t hash = Fnv1aOffset)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+// With the length, so "ab" "c" and "a" "bc" differ
+inline uint64_t HashString(const std::string& text, uint64_t hash = Fnv1aOffset)
+{
+	uint64_t length = text.size();
+	hash = Fnv1a(text.data(), text.size(), hash);
+	return Fnv1a(&length, sizeof(length), hash);
+}
+
+template<typename T>
+uint64_t HashValue(const T& value, uint64_t hash = Fnv1aOffset)
+{
+	return Fnv1a(&value, sizeof(value), hash);
+}
+
+#endif // HASH_H
@@ -0,0 +1,73 @@
+#include "InputQueue.h"
+
+#include <chrono>
+
+uint64_t InputTimestamp()
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+InputQueue::InputQueue()
+	: mHead(0)
+	, mCachedTail(0)
+	, mDropped(0)
+	, mTail(0)
+	, mCachedHead(0)
+{
+}
+
+bool InputQueue::Push(const InputEvent& event)
+{
+	uint32_t head = mHead.load(std::memory_order_relaxed);
+	if (head - mCachedTail == Capacity)
+	{
+		mCachedTail = mTail.load(std::memory_order_acquire);
+		if (head - mCachedTail == Capacity)
+		{
+			mDropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+	}
+
+	mEvents[head & (Capacity - 1)] = event;
+	mHead.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+bool InputQueue::Pop(InputEvent& event)
+{
+	uint32_t tail = mTail.load(std::memory_order_relaxed);
+	if (tail == mCachedHead)
+	{
+		mCachedHead = mHead.load(std::memory_order_acquire);
+		if (tail == mCachedHead)
+		{
+			return false;
+		}
+	}
+
+	event = mEvents[tail & (Capacity - 1)];
+	mTail.store(tail + 1, std::memory_order_release);
+	return true;
+}
+
+uint32_t InputQueue::Clear()
+{
+	uint32_t tail = mTail.load(std::memory_order_relaxed);
+	mCachedHead = mHead.load(std::memory_order_acquire);
+	mTail.store(mCachedHead, std::memory_order_release);
+	return mCachedHead - tail;
+}
+
+uint32_t DispatchInput(InputQueue& queue, DemoScene& scene)
+{
+	return queue.Drain([&scene](const InputEvent& event)
+	{
+		switch (event.Type)
+		{
+		case InputEventType::MouseDown: scene.OnMouseDown(event.Buttons, event.X, event.Y); break;
+		case InputEventType::MouseUp: scene.OnMouseUp(event.Buttons, event.X, event.Y); break;
+		case InputEventType::MouseMove: scene.OnMouseMove(event.Buttons, event.X, event.Y); break;
+		}
+	});
+}
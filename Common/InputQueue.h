@@ -0,0 +1,103 @@
+#ifndef INPUTQUEUE_H
+#define INPUTQUEUE_H
+
+#include "DemoScene.h"
+
+#include <atomic>
+#include <cstdint>
+
+enum class InputEventType : uint32_t
+{
+	MouseDown,
+	MouseUp,
+	MouseMove
+};
+
+struct InputEvent
+{
+	InputEventType Type;
+	uint32_t Buttons;		// MouseButton flags
+	int X;
+	int Y;
+	uint64_t Timestamp;		// InputTimestamp() when it happened
+};
+
+// Steady clock in nanoseconds
+uint64_t InputTimestamp();
+
+// Lock-free ring of input events from one producer, the window's message
+// handlers, to one consumer, the simulation, which drains it once per step.
+// Neither side blocks: a full queue drops the event and counts it. SceneApp
+// runs both sides on the window thread, so there the queue only defers
+// input to the next step; the simulation could move to a thread of its own
+// without changing it.
+class InputQueue
+{
+public:
+	static const uint32_t Capacity = 1 << 10;
+
+	InputQueue();
+
+	// Producer only, false if the queue was full
+	bool Push(const InputEvent& event);
+
+	// Consumer only, the oldest event
+	bool Pop(InputEvent& event);
+
+	// Consumer only, discards the queued events and returns how many
+	uint32_t Clear();
+
+	// Consumer only. Calls handler(event) for the events queued when it is
+	// called, skipping a move that is directly followed by a move with the
+	// same buttons: the scenes only use the latest position. Returns the
+	// number of events handed out.
+	template<typename Handler>
+	uint32_t Drain(const Handler& handler);
+
+	uint64_t DroppedCount() const { return mDropped.load(std::memory_order_relaxed); }
+
+private:
+	InputQueue(const InputQueue&);
+	InputQueue& operator=(const InputQueue&);
+
+	// Each side keeps its own index and a copy of the other one on its own
+	// cache line, and only reloads the other side's index when the copy
+	// says the queue is full or empty
+	alignas(64) std::atomic<uint32_t> mHead;	// Next slot the producer writes
+	uint32_t mCachedTail;
+	std::atomic<uint64_t> mDropped;
+	alignas(64) std::atomic<uint32_t> mTail;	// Next slot the consumer reads
+	uint32_t mCachedHead;
+	alignas(64) InputEvent mEvents[Capacity];
+};
+
+template<typename Handler>
+uint32_t InputQueue::Drain(const Handler& handler)
+{
+	uint32_t tail = mTail.load(std::memory_order_relaxed);
+	mCachedHead = mHead.load(std::memory_order_acquire);
+
+	uint32_t handled = 0;
+	for (; tail != mCachedHead; tail++)
+	{
+		const InputEvent& event = mEvents[tail & (Capacity - 1)];
+		if (event.Type == InputEventType::MouseMove && tail + 1 != mCachedHead)
+		{
+			const InputEvent& next = mEvents[(tail + 1) & (Capacity - 1)];
+			if (next.Type == InputEventType::MouseMove && next.Buttons == event.Buttons)
+			{
+				continue;
+			}
+		}
+		handler(event);
+		handled++;
+	}
+
+	mTail.store(tail, std::memory_order_release);
+	return handled;
+}
+
+// Drains 'queue' into the scene's mouse handlers
+uint32_t DispatchInput(InputQueue& queue, DemoScene& scene);
+
+#endif // INPUTQUEUE_H
@@ -0,0 +1,414 @@
+#include "JobSystem.h"
+
+namespace
+{
+	struct ThreadWorker
+	{
+		const void* System;
+		void* Worker;
+	};
+
+	thread_local ThreadWorker currentWorker = { nullptr, nullptr };
+
+	// Failed searches before an idle worker goes to sleep
+	const uint32_t idleSpins = 64;
+}
+
+//
+// JobCounter
+//
+
+JobCounter::JobCounter()
+	: mPending(0)
+	, mFinishing(0)
+	, mWaiting(nullptr)
+{
+}
+
+//
+// JobDeque
+//
+
+JobDeque::JobDeque()
+	: mTop(0)
+	, mBottom(0)
+{
+	for (int64_t i = 0; i < Capacity; i++)
+	{
+		mJobs[i].store(nullptr, std::memory_order_relaxed);
+	}
+}
+
+bool JobDeque::Push(Job* job)
+{
+	int64_t bottom = mBottom.load(std::memory_order_relaxed);
+	int64_t top = mTop.load(std::memory_order_acquire);
+	if (bottom - top >= Capacity)
+	{
+		return false;
+	}
+	mJobs[bottom & (Capacity - 1)].store(job, std::memory_order_relaxed);
+	mBottom.store(bottom + 1, std::memory_order_release);
+	return true;
+}
+
+Job* JobDeque::Pop()
+{
+	int64_t bottom = mBottom.load(std::memory_order_relaxed) - 1;
+	mBottom.store(bottom, std::memory_order_relaxed);
+	// The bottom must be visible before the top is read, or a thief could take the same job
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t top = mTop.load(std::memory_order_relaxed);
+
+	if (top > bottom)
+	{
+		mBottom.store(bottom + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	Job* job = mJobs[bottom & (Capacity - 1)].load(std::memory_order_relaxed);
+	if (top == bottom)
+	{
+		// Last job, race the thieves for it
+		if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			job = nullptr;
+		}
+		mBottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+Job* JobDeque::Steal()
+{
+	int64_t top = mTop.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t bottom = mBottom.load(std::memory_order_acquire);
+	if (top >= bottom)
+	{
+		return nullptr;
+	}
+
+	Job* job = mJobs[top & (Capacity - 1)].load(std::memory_order_relaxed);
+	if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+	{
+		return nullptr;
+	}
+	return job;
+}
+
+bool JobDeque::IsEmpty() const
+{
+	int64_t top = mTop.load(std::memory_order_acquire);
+	int64_t bottom = mBottom.load(std::memory_order_acquire);
+	return top >= bottom;
+}
+
+//
+// JobSystem
+//
+
+JobSystem::JobSystem(uint32_t threadCount)
+	: mSleeping(0)
+	, mWakeGeneration(0)
+	, mQuit(false)
+{
+	threadCount = threadCount == 0 ? 1 : threadCount;
+	for (uint32_t i = 0; i < threadCount; i++)
+	{
+		Worker* worker = new Worker();
+		worker->Pool = std::vector<Job>(PoolSize);
+		for (uint32_t j = 0; j < PoolSize; j++)
+		{
+			worker->Pool[j].Finished.store(true, std::memory_order_relaxed);
+		}
+		worker->NextJob = 0;
+		worker->Index = i;
+		worker->Random = 0x9E3779B9u * (i + 1);
+		worker->Steals.store(0, std::memory_order_relaxed);
+		mWorkers.push_back(worker);
+	}
+
+	currentWorker.System = this;
+	currentWorker.Worker = mWorkers[0];
+	for (uint32_t i = 1; i < threadCount; i++)
+	{
+		mThreads.push_back(std::thread(&JobSystem::WorkerLoop, this, i));
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+		mQuit = true;
+	}
+	mWakeUp.notify_all();
+	for (size_t i = 0; i < mThreads.size(); i++)
+	{
+		mThreads[i].join();
+	}
+
+	if (currentWorker.System == this)
+	{
+		currentWorker.System = nullptr;
+		currentWorker.Worker = nullptr;
+	}
+	for (size_t i = 0; i < mWorkers.size(); i++)
+	{
+		delete mWorkers[i];
+	}
+}
+
+JobSystem::Worker* JobSystem::CurrentWorker() const
+{
+	return currentWorker.System == this ? static_cast<Worker*>(currentWorker.Worker) : nullptr;
+}
+
+uint64_t JobSystem::StealCount() const
+{
+	uint64_t steals = 0;
+	for (size_t i = 0; i < mWorkers.size(); i++)
+	{
+		steals += mWorkers[i]->Steals.load(std::memory_order_relaxed);
+	}
+	return steals;
+}
+
+void JobSystem::Run(JobFunction function, void* data, JobCounter* counter, JobCounter* dependency)
+{
+	Worker* worker = CurrentWorker();
+	if (worker == nullptr)
+	{
+		if (dependency != nullptr)
+		{
+			while (!dependency->IsDone())
+			{
+				std::this_thread::yield();
+			}
+		}
+		function(data);
+		return;
+	}
+
+	if (counter != nullptr)
+	{
+		counter->mPending.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	Job* job = AllocateJob(*worker);
+	job->Function = function;
+	job->Data = data;
+	job->Counter = counter;
+	job->NextWaiting = nullptr;
+
+	if (dependency != nullptr && dependency->mPending.load(std::memory_order_acquire) != 0)
+	{
+		// Checked again under the lock, the last job of the dependency takes the list under it
+		std::lock_guard<std::mutex> lock(dependency->mMutex);
+		if (dependency->mPending.load(std::memory_order_acquire) != 0)
+		{
+			job->NextWaiting = dependency->mWaiting;
+			dependency->mWaiting = job;
+			return;
+		}
+	}
+	Push(*worker, job);
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+	Worker* worker = CurrentWorker();
+	while (!counter.IsDone())
+	{
+		if (worker == nullptr || !RunOneJob(*worker))
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+Job* JobSystem::AllocateJob(Worker& worker)
+{
+	Job* job = &worker.Pool[worker.NextJob];
+	worker.NextJob = (worker.NextJob + 1) & (PoolSize - 1);
+
+	// The pool wrapped around onto a job that has not run yet
+	while (!job->Finished.load(std::memory_order_acquire))
+	{
+		if (!RunOneJob(worker))
+		{
+			std::this_thread::yield();
+		}
+	}
+	job->Finished.store(false, std::memory_order_relaxed);
+	return job;
+}
+
+void JobSystem::Push(Worker& worker, Job* job)
+{
+	if (!worker.Deque.Push(job))
+	{
+		// Full, running it here keeps the order of dependencies
+		Execute(job);
+		return;
+	}
+
+	// Pairs with the fence in WorkerLoop, either the sleeper sees the job or we see the sleeper
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (mSleeping.load(std::memory_order_relaxed) != 0)
+	{
+		WakeWorker();
+	}
+}
+
+void JobSystem::Execute(Job* job)
+{
+	job->Function(job->Data);
+
+	JobCounter* counter = job->Counter;
+	job->Finished.store(true, std::memory_order_release);
+	if (counter == nullptr)
+	{
+		return;
+	}
+
+	counter->mFinishing.fetch_add(1, std::memory_order_acq_rel);
+	if (counter->mPending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+	{
+		Job* waiting = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(counter->mMutex);
+			waiting = counter->mWaiting;
+			counter->mWaiting = nullptr;
+		}
+
+		Worker* worker = CurrentWorker();
+		while (waiting != nullptr)
+		{
+			Job* next = waiting->NextWaiting;
+			if (worker != nullptr)
+			{
+				Push(*worker, waiting);
+			}
+			else
+			{
+				Execute(waiting);
+			}
+			waiting = next;
+		}
+	}
+	// The counter may be destroyed after this
+	counter->mFinishing.fetch_sub(1, std::memory_order_release);
+}
+
+bool JobSystem::RunOneJob(Worker& worker)
+{
+	Job* job = worker.Deque.Pop();
+	if (job == nullptr && mWorkers.size() > 1)
+	{
+		// Xorshift picks where to start so thieves spread over the victims
+		worker.Random ^= worker.Random << 13;
+		worker.Random ^= worker.Random >> 17;
+		worker.Random ^= worker.Random << 5;
+
+		uint32_t count = static_cast<uint32_t>(mWorkers.size());
+		uint32_t start = worker.Random % count;
+		for (uint32_t i = 0; i < count && job == nullptr; i++)
+		{
+			uint32_t victim = (start + i) % count;
+			if (victim != worker.Index)
+			{
+				job = mWorkers[victim]->Deque.Steal();
+			}
+		}
+		if (job != nullptr)
+		{
+			worker.Steals.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	if (job == nullptr)
+	{
+		return false;
+	}
+	Execute(job);
+	return true;
+}
+
+bool JobSystem::HasQueuedJobs() const
+{
+	for (size_t i = 0; i < mWorkers.size(); i++)
+	{
+		if (!mWorkers[i]->Deque.IsEmpty())
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void JobSystem::WakeWorker()
+{
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+		mWakeGeneration++;
+	}
+	mWakeUp.notify_one();
+}
+
+void JobSystem::WorkerLoop(uint32_t index)
+{
+	Worker& worker = *mWorkers[index];
+	currentWorker.System = this;
+	currentWorker.Worker = &worker;
+
+	uint32_t idle = 0;
+	for (;;)
+	{
+		if (RunOneJob(worker))
+		{
+			idle = 0;
+			continue;
+		}
+		if (++idle < idleSpins)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		idle = 0;
+
+		std::unique_lock<std::mutex> lock(mSleepMutex);
+		if (mQuit)
+		{
+			return;
+		}
+		uint64_t seenGeneration = mWakeGeneration;
+		mSleeping.fetch_add(1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (!HasQueuedJobs())
+		{
+			mWakeUp.wait(lock, [&] { return mQuit || mWakeGeneration != seenGeneration; });
+		}
+		mSleeping.fetch_sub(1, std::memory_order_relaxed);
+		if (mQuit)
+		{
+			return;
+		}
+	}
+}
+
+void JobSystem::RunRanges(void* data)
+{
+	ParallelRange& range = *static_cast<ParallelRange*>(data);
+	for (;;)
+	{
+		uint32_t first = range.Next.fetch_add(range.BatchSize, std::memory_order_relaxed);
+		if (first >= range.Count)
+		{
+			return;
+		}
+		uint32_t end = range.Count - first < range.BatchSize ? range.Count : first + range.BatchSize;
+		range.Call(range.Function, first, end);
+	}
+}
@@ -0,0 +1,194 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobCounter;
+
+typedef void (*JobFunction)(void* data);
+
+struct Job
+{
+	JobFunction Function;
+	void* Data;
+	JobCounter* Counter;		// Decremented when the job has run, may be null
+	Job* NextWaiting;			// In the waiting list of the counter it depends on
+	std::atomic<bool> Finished;	// The pool slot may be reused
+};
+
+// Number of unfinished jobs added with it. A job that depends on a counter
+// waits until every job added with that counter has run.
+//
+// Add all jobs of a batch before anything depends on or waits for the
+// counter, and destroy it only after JobSystem::Wait returned or IsDone.
+class JobCounter
+{
+public:
+	JobCounter();
+
+	bool IsDone() const
+	{
+		return mPending.load(std::memory_order_acquire) == 0 && mFinishing.load(std::memory_order_acquire) == 0;
+	}
+
+private:
+	friend class JobSystem;
+
+	JobCounter(const JobCounter&);
+	JobCounter& operator=(const JobCounter&);
+
+	std::atomic<uint32_t> mPending;
+	// Threads still touching the counter after their job decremented it
+	std::atomic<uint32_t> mFinishing;
+	std::mutex mMutex;
+	Job* mWaiting;
+};
+
+// Chase-Lev work stealing deque with a fixed capacity. The owning thread
+// pushes and pops at the bottom, any thread steals from the top.
+class JobDeque
+{
+public:
+	static const int64_t Capacity = 1 << 12;
+
+	JobDeque();
+
+	// Owner only, false when full
+	bool Push(Job* job);
+	// Owner only, the most recently pushed job
+	Job* Pop();
+	// Any thread, the oldest job. Null when empty or another thread won the race.
+	Job* Steal();
+
+	bool IsEmpty() const;
+
+private:
+	JobDeque(const JobDeque&);
+	JobDeque& operator=(const JobDeque&);
+
+	// On their own cache lines, thieves write the top and the owner the bottom
+	alignas(64) std::atomic<int64_t> mTop;
+	alignas(64) std::atomic<int64_t> mBottom;
+	alignas(64) std::atomic<Job*> mJobs[Capacity];
+};
+
+// Work stealing scheduler for loading, generation and per-frame work:
+//
+//	JobCounter heights;
+//	jobs.ParallelFor(vertexCount, 256, [&](uint32_t first, uint32_t end) { ... });
+//	jobs.Run(&BuildNormals, &mesh, &normals, &heights);	// After the heights
+//	jobs.Wait(normals);
+//
+// Every thread owns a deque and takes its newest job first, idle threads
+// steal the oldest job of a random other thread and sleep when there is
+// nothing to steal. The thread that created the system is thread 0 and runs
+// jobs while it waits. Run and Wait may be called from that thread and from
+// jobs; any other thread runs the job on the spot.
+class JobSystem
+{
+public:
+	// Jobs one thread may have created and not yet finished
+	static const uint32_t PoolSize = 1 << 13;
+
+	// threadCount includes the calling thread
+	explicit JobSystem(uint32_t threadCount);
+	~JobSystem();
+
+	// Queues function(data). 'counter' counts the job until it has run and
+	// the job does not start before 'dependency' is done, both may be null.
+	void Run(JobFunction function, void* data, JobCounter* counter = nullptr, JobCounter* dependency = nullptr);
+
+	// Runs jobs until the counter is done
+	void Wait(JobCounter& counter);
+
+	// Calls function(first, end) on ranges of at most batchSize indices
+	// covering [0, count) and returns when all have run
+	template<typename Function>
+	void ParallelFor(uint32_t count, uint32_t batchSize, const Function& function);
+
+	uint32_t ThreadCount() const { return static_cast<uint32_t>(mWorkers.size()); }
+	// Jobs taken from another thread's deque
+	uint64_t StealCount() const;
+
+private:
+	struct Worker
+	{
+		JobDeque Deque;
+		std::vector<Job> Pool;
+		uint32_t NextJob;
+		uint32_t Index;
+		uint32_t Random;
+		std::atomic<uint64_t> Steals;
+	};
+
+	// Ranges handed out to the jobs of one ParallelFor
+	struct ParallelRange
+	{
+		void (*Call)(const void* function, uint32_t first, uint32_t end);
+		const void* Function;
+		uint32_t Count;
+		uint32_t BatchSize;
+		std::atomic<uint32_t> Next;
+	};
+
+	static void RunRanges(void* data);
+
+	JobSystem(const JobSystem&);
+	JobSystem& operator=(const JobSystem&);
+
+	// Null on threads that do not belong to this system
+	Worker* CurrentWorker() const;
+	Job* AllocateJob(Worker& worker);
+	void Push(Worker& worker, Job* job);
+	void Execute(Job* job);
+	// Pops or steals one job and runs it, false if there was none
+	bool RunOneJob(Worker& worker);
+	bool HasQueuedJobs() const;
+	void WakeWorker();
+	void WorkerLoop(uint32_t index);
+
+	std::vector<Worker*> mWorkers;
+	std::vector<std::thread> mThreads;
+
+	std::mutex mSleepMutex;
+	std::condition_variable mWakeUp;
+	std::atomic<uint32_t> mSleeping;
+	uint64_t mWakeGeneration;
+	bool mQuit;
+};
+
+template<typename Function>
+void JobSystem::ParallelFor(uint32_t count, uint32_t batchSize, const Function& function)
+{
+	if (count == 0)
+	{
+		return;
+	}
+	batchSize = batchSize == 0 ? 1 : batchSize;
+
+	ParallelRange range;
+	range.Call = [](const void* f, uint32_t first, uint32_t end) { (*static_cast<const Function*>(f))(first, end); };
+	range.Function = &function;
+	range.Count = count;
+	range.BatchSize = batchSize;
+	range.Next.store(0, std::memory_order_relaxed);
+
+	// One job per thread at most, each takes batches until none are left
+	uint32_t batches = (count + batchSize - 1) / batchSize;
+	uint32_t jobCount = batches < ThreadCount() ? batches : ThreadCount();
+
+	JobCounter counter;
+	for (uint32_t i = 1; i < jobCount; i++)
+	{
+		Run(&RunRanges, &range, &counter);
+	}
+	RunRanges(&range);
+	Wait(counter);
+}
+
+#endif // JOBSYSTEM_H
@@ -0,0 +1,16 @@
+#include "Log.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <cstdio>
+#endif
+
+void LogMessage(const std::string& message)
+{
+#if defined(_WIN32)
+	OutputDebugStringA(message.c_str());
+#else
+	fputs(message.c_str(), stderr);
+#endif
+}
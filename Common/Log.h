@@ -0,0 +1,9 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <string>
+
+// Writes to the debugger output on Windows and to stderr elsewhere
+void LogMessage(const std::string& message);
+
+#endif // LOG_H
@@ -0,0 +1,251 @@
+#ifndef MATHTYPES_H
+#define MATHTYPES_H
+
+#include <cmath>
+
+// Plain float vectors with the same memory layout as XMFLOAT2/3/4 and
+// XMFLOAT4X4. Unlike the DirectXMath types they are usable in constexpr
+// code and build on any platform.
+
+struct Float2
+{
+	constexpr Float2() : x(0.0f), y(0.0f) {}
+	constexpr Float2(float _x, float _y) : x(_x), y(_y) {}
+
+	float x;
+	float y;
+};
+
+struct Float3
+{
+	constexpr Float3() : x(0.0f), y(0.0f), z(0.0f) {}
+	constexpr Float3(float _x, float _y, float _z) : x(_x), y(_y), z(_z) {}
+
+	float x;
+	float y;
+	float z;
+};
+
+struct Float4
+{
+	constexpr Float4() : x(0.0f), y(0.0f), z(0.0f), w(0.0f) {}
+	constexpr Float4(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w) {}
+
+	float x;
+	float y;
+	float z;
+	float w;
+};
+
+// Row major with row vectors, like XMFLOAT4X4, so it can be handed to the
+// effects as is
+struct Float4x4
+{
+	float m[4][4];
+};
+
+static_assert(sizeof(Float2) == 8, "Float2 must match XMFLOAT2");
+static_assert(sizeof(Float3) == 12, "Float3 must match XMFLOAT3");
+static_assert(sizeof(Float4) == 16, "Float4 must match XMFLOAT4");
+static_assert(sizeof(Float4x4) == 64, "Float4x4 must match XMFLOAT4X4");
+
+//
+// The few DirectXMath functions the scenes need, with the same conventions
+// (left handed, row vectors, depth from 0 to 1)
+//
+
+const float MathPi = 3.1415926535f;
+
+template<typename T>
+T Clamp(const T& x, const T& low, const T& high)
+{
+	return x < low ? low : (x > high ? high : x);
+}
+
+inline float DegreesToRadians(float degrees)
+{
+	return degrees * (MathPi / 180.0f);
+}
+
+inline Float3 Subtract(const Float3& a, const Float3& b)
+{
+	return Float3(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+
+inline float Dot(const Float3& a, const Float3& b)
+{
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+inline Float3 Cross(const Float3& a, const Float3& b)
+{
+	return Float3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+inline Float3 Normalize3(const Float3& v)
+{
+	float length = std::sqrt(Dot(v, v));
+	return length > 0.0f ? Float3(v.x / length, v.y / length, v.z / length) : v;
+}
+
+inline Float4x4 MatrixIdentity()
+{
+	Float4x4 result = {{
+		{ 1.0f, 0.0f, 0.0f, 0.0f },
+		{ 0.0f, 1.0f, 0.0f, 0.0f },
+		{ 0.0f, 0.0f, 1.0f, 0.0f },
+		{ 0.0f, 0.0f, 0.0f, 1.0f }
+	}};
+	return result;
+}
+
+inline Float4x4 MatrixMultiply(const Float4x4& a, const Float4x4& b)
+{
+	Float4x4 result;
+	for (int row = 0; row < 4; row++)
+	{
+		for (int column = 0; column < 4; column++)
+		{
+			result.m[row][column] = a.m[row][0] * b.m[0][column] + a.m[row][1] * b.m[1][column]
+				+ a.m[row][2] * b.m[2][column] + a.m[row][3] * b.m[3][column];
+		}
+	}
+	return result;
+}
+
+inline Float4x4 MatrixTranslation(float x, float y, float z)
+{
+	Float4x4 result = MatrixIdentity();
+	result.m[3][0] = x;
+	result.m[3][1] = y;
+	result.m[3][2] = z;
+	return result;
+}
+
+inline Float4x4 MatrixScaling(float x, float y, float z)
+{
+	Float4x4 result = MatrixIdentity();
+	result.m[0][0] = x;
+	result.m[1][1] = y;
+	result.m[2][2] = z;
+	return result;
+}
+
+inline Float4x4 MatrixRotationX(float angle)
+{
+	float s = std::sin(angle);
+	float c = std::cos(angle);
+	Float4x4 result = MatrixIdentity();
+	result.m[1][1] = c;
+	result.m[1][2] = s;
+	result.m[2][1] = -s;
+	result.m[2][2] = c;
+	return result;
+}
+
+inline Float4x4 MatrixRotationY(float angle)
+{
+	float s = std::sin(angle);
+	float c = std::cos(angle);
+	Float4x4 result = MatrixIdentity();
+	result.m[0][0] = c;
+	result.m[0][2] = -s;
+	result.m[2][0] = s;
+	result.m[2][2] = c;
+	return result;
+}
+
+inline Float4x4 MatrixRotationZ(float angle)
+{
+	float s = std::sin(angle);
+	float c = std::cos(angle);
+	Float4x4 result = MatrixIdentity();
+	result.m[0][0] = c;
+	result.m[0][1] = s;
+	result.m[1][0] = -s;
+	result.m[1][1] = c;
+	return result;
+}
+
+// Roll around z first, then pitch around x, then yaw around y
+inline Float4x4 MatrixRotationRollPitchYaw(float pitch, float yaw, float roll)
+{
+	return MatrixMultiply(MatrixMultiply(MatrixRotationZ(roll), MatrixRotationX(pitch)), MatrixRotationY(yaw));
+}
+
+inline Float4x4 MatrixLookAtLH(const Float3& eye, const Float3& target, const Float3& up)
+{
+	Float3 zAxis = Normalize3(Subtract(target, eye));
+	Float3 xAxis = Normalize3(Cross(up, zAxis));
+	Float3 yAxis = Cross(zAxis, xAxis);
+
+	Float4x4 result = {{
+		{ xAxis.x, yAxis.x, zAxis.x, 0.0f },
+		{ xAxis.y, yAxis.y, zAxis.y, 0.0f },
+		{ xAxis.z, yAxis.z, zAxis.z, 0.0f },
+		{ -Dot(xAxis, eye), -Dot(yAxis, eye), -Dot(zAxis, eye), 1.0f }
+	}};
+	return result;
+}
+
+inline Float4x4 MatrixPerspectiveFovLH(float fovAngleY, float aspectRatio, float nearZ, float farZ)
+{
+	float height = 1.0f / std::tan(0.5f * fovAngleY);
+	float width = height / aspectRatio;
+	float range = farZ / (farZ - nearZ);
+
+	Float4x4 result = {{
+		{ width, 0.0f, 0.0f, 0.0f },
+		{ 0.0f, height, 0.0f, 0.0f },
+		{ 0.0f, 0.0f, range, 1.0f },
+		{ 0.0f, 0.0f, -range * nearZ, 0.0f }
+	}};
+	return result;
+}
+
+// General inverse by cofactors. A singular matrix gives the identity.
+inline Float4x4 MatrixInverse(const Float4x4& matrix)
+{
+	const float* m = &matrix.m[0][0];
+	float inverse[16];
+	inverse[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] + m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+	inverse[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] - m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+	inverse[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] + m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+	inverse[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] - m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+	inverse[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] - m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+	inverse[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] + m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+	inverse[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] - m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+	inverse[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] + m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+	inverse[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15] + m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+	inverse[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15] - m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+	inverse[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15] + m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+	inverse[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14] - m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+	inverse[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11] - m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+	inverse[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11] + m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+	inverse[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11] - m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+	inverse[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10] + m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+
+	float determinant = m[0] * inverse[0] + m[1] * inverse[4] + m[2] * inverse[8] + m[3] * inverse[12];
+	if (determinant == 0.0f)
+	{
+		return MatrixIdentity();
+	}
+
+	Float4x4 result;
+	for (int i = 0; i < 16; i++)
+	{
+		(&result.m[0][0])[i] = inverse[i] / determinant;
+	}
+	return result;
+}
+
+inline Float4 Transform(const Float4& v, const Float4x4& matrix)
+{
+	return Float4(
+		v.x * matrix.m[0][0] + v.y * matrix.m[1][0] + v.z * matrix.m[2][0] + v.w * matrix.m[3][0],
+		v.x * matrix.m[0][1] + v.y * matrix.m[1][1] + v.z * matrix.m[2][1] + v.w * matrix.m[3][1],
+		v.x * matrix.m[0][2] + v.y * matrix.m[1][2] + v.z * matrix.m[2][2] + v.w * matrix.m[3][2],
+		v.x * matrix.m[0][3] + v.y * matrix.m[1][3] + v.z * matrix.m[2][3] + v.w * matrix.m[3][3]);
+}
+
+#endif // MATHTYPES_H
@@ -0,0 +1,582 @@
+#include "MeshBvh.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MESHBVH_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	const uint32_t binCount = 16;
+	const uint32_t maxLeafTriangles = 16;
+	// Below this depth splits follow the heuristic, deeper ones halve the triangles
+	const uint32_t maxSahDepth = 64;
+	const uint32_t stackSize = 128;
+	// Relative costs of testing a node's two child boxes and a block of four triangles
+	const float nodeCost = 1.0f;
+	const float blockCost = 2.0f;
+
+	struct BinBounds
+	{
+		Float3 Min;
+		Float3 Max;
+	};
+
+	BinBounds EmptyBounds()
+	{
+		BinBounds bounds = { Float3(FLT_MAX, FLT_MAX, FLT_MAX), Float3(-FLT_MAX, -FLT_MAX, -FLT_MAX) };
+		return bounds;
+	}
+
+	void Grow(BinBounds& bounds, const Float3& min, const Float3& max)
+	{
+		bounds.Min = Float3(std::min(bounds.Min.x, min.x), std::min(bounds.Min.y, min.y), std::min(bounds.Min.z, min.z));
+		bounds.Max = Float3(std::max(bounds.Max.x, max.x), std::max(bounds.Max.y, max.y), std::max(bounds.Max.z, max.z));
+	}
+
+	// Half the surface area, 0 for empty bounds
+	float HalfArea(const BinBounds& bounds)
+	{
+		Float3 size = Subtract(bounds.Max, bounds.Min);
+		if (size.x < 0.0f || size.y < 0.0f || size.z < 0.0f)
+		{
+			return 0.0f;
+		}
+		return size.x * size.y + size.y * size.z + size.z * size.x;
+	}
+
+	float Axis(const Float3& v, uint32_t axis)
+	{
+		return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+	}
+
+	float Blocks(uint32_t triangles)
+	{
+		return static_cast<float>((triangles + 3) / 4);
+	}
+
+	uint32_t BinOf(float centroid, float min, float scale)
+	{
+		int bin = static_cast<int>((centroid - min) * scale);
+		return static_cast<uint32_t>(Clamp(bin, 0, static_cast<int>(binCount) - 1));
+	}
+
+	// Entry distance of the ray into the box, FLT_MAX if it misses or enters beyond 'best'
+	float BoxEntry(const Float3& min, const Float3& max, const Ray& ray, const Float3& inverse, float best)
+	{
+		float x1 = (min.x - ray.Origin.x) * inverse.x;
+		float x2 = (max.x - ray.Origin.x) * inverse.x;
+		float y1 = (min.y - ray.Origin.y) * inverse.y;
+		float y2 = (max.y - ray.Origin.y) * inverse.y;
+		float z1 = (min.z - ray.Origin.z) * inverse.z;
+		float z2 = (max.z - ray.Origin.z) * inverse.z;
+		float enter = std::max(std::max(std::min(x1, x2), std::min(y1, y2)), std::min(z1, z2));
+		float exit = std::min(std::min(std::max(x1, x2), std::max(y1, y2)), std::max(z1, z2));
+		return exit >= enter && exit > 0.0f && enter < best ? enter : FLT_MAX;
+	}
+}
+
+Ray ScreenPointToRay(float x, float y, float width, float height, const Float4x4& viewProj)
+{
+	Float4x4 inverse = MatrixInverse(viewProj);
+	float ndcX = 2.0f * x / width - 1.0f;
+	float ndcY = 1.0f - 2.0f * y / height;
+
+	Float4 nearPoint = Transform(Float4(ndcX, ndcY, 0.0f, 1.0f), inverse);
+	Float4 farPoint = Transform(Float4(ndcX, ndcY, 1.0f, 1.0f), inverse);
+	Float3 origin(nearPoint.x / nearPoint.w, nearPoint.y / nearPoint.w, nearPoint.z / nearPoint.w);
+	Float3 end(farPoint.x / farPoint.w, farPoint.y / farPoint.w, farPoint.z / farPoint.w);
+
+	Ray ray = { origin, Normalize3(Subtract(end, origin)) };
+	return ray;
+}
+
+MeshBvh::MeshBvh()
+	: mPositions(nullptr)
+	, mStride(0)
+	, mIndices(nullptr)
+	, mTriangleCount(0)
+	, mLeafCount(0)
+	, mDepth(0)
+{
+}
+
+void MeshBvh::Clear()
+{
+	mNodes.clear();
+	mBlocks.clear();
+	mTriangleIds.clear();
+	mTriangleCount = 0;
+	mLeafCount = 0;
+	mDepth = 0;
+}
+
+void MeshBvh::Build(const void* positions, uint32_t stride, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount)
+{
+	Clear();
+	mPositions = static_cast<const uint8_t*>(positions);
+	mStride = stride;
+	mIndices = indices;
+
+	uint32_t triangleCount = indexCount / 3;
+	mBuild.clear();
+	mBuild.reserve(triangleCount);
+	for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+	{
+		const uint32_t* corners = indices + triangle * 3;
+		if (corners[0] >= vertexCount || corners[1] >= vertexCount || corners[2] >= vertexCount)
+		{
+			assert(false && "Index past the last vertex");
+			continue;
+		}
+
+		BinBounds bounds = EmptyBounds();
+		for (uint32_t corner = 0; corner < 3; corner++)
+		{
+			Float3 p;
+			memcpy(&p, mPositions + corners[corner] * static_cast<size_t>(mStride), sizeof(p));
+			Grow(bounds, p, p);
+		}
+		BuildTriangle build = { bounds.Min, bounds.Max,
+			Float3(0.5f * (bounds.Min.x + bounds.Max.x), 0.5f * (bounds.Min.y + bounds.Max.y), 0.5f * (bounds.Min.z + bounds.Max.z)), triangle };
+		mBuild.push_back(build);
+	}
+	mTriangleCount = static_cast<uint32_t>(mBuild.size());
+
+	if (mTriangleCount > 0)
+	{
+		// At most 2n - 1 nodes, and a block per four triangles plus a partial one per leaf
+		mNodes.reserve(2 * mTriangleCount);
+		mBlocks.reserve(mTriangleCount / 2 + 1);
+		mTriangleIds.reserve(mBlocks.capacity() * 4);
+		mNodes.resize(1);
+		BuildNode(0, 0, mTriangleCount, 0);
+		mNodes.shrink_to_fit();
+		mBlocks.shrink_to_fit();
+	}
+
+	mTriangleIds.shrink_to_fit();
+	std::vector<BuildTriangle>().swap(mBuild);
+	mPositions = nullptr;
+	mIndices = nullptr;
+}
+
+void MeshBvh::BuildNode(uint32_t nodeIndex, uint32_t first, uint32_t count, uint32_t depth)
+{
+	mDepth = std::max(mDepth, depth + 1);
+
+	BinBounds bounds = EmptyBounds();
+	BinBounds centroids = EmptyBounds();
+	for (uint32_t i = first; i < first + count; i++)
+	{
+		Grow(bounds, mBuild[i].Min, mBuild[i].Max);
+		Grow(centroids, mBuild[i].Centroid, mBuild[i].Centroid);
+	}
+	mNodes[nodeIndex].Min = bounds.Min;
+	mNodes[nodeIndex].Max = bounds.Max;
+
+	// A block tests four triangles as fast as one
+	if (count <= 4)
+	{
+		MakeLeaf(mNodes[nodeIndex], first, count);
+		return;
+	}
+
+	int bestAxis = -1;
+	uint32_t bestSplit = 0;
+	float bestCost = FLT_MAX;
+	if (depth < maxSahDepth)
+	{
+		// All three axes binned in one pass over the triangles
+		float mins[3] = {};
+		float scales[3] = {};
+		BinBounds bins[3][binCount];
+		uint32_t binTriangles[3][binCount] = {};
+		for (uint32_t axis = 0; axis < 3; axis++)
+		{
+			mins[axis] = Axis(centroids.Min, axis);
+			float extent = Axis(centroids.Max, axis) - mins[axis];
+			scales[axis] = extent > 0.0f ? binCount / extent : 0.0f;
+			for (uint32_t bin = 0; bin < binCount; bin++)
+			{
+				bins[axis][bin] = EmptyBounds();
+			}
+		}
+		for (uint32_t i = first; i < first + count; i++)
+		{
+			const BuildTriangle& triangle = mBuild[i];
+			uint32_t x = BinOf(triangle.Centroid.x, mins[0], scales[0]);
+			uint32_t y = BinOf(triangle.Centroid.y, mins[1], scales[1]);
+			uint32_t z = BinOf(triangle.Centroid.z, mins[2], scales[2]);
+			Grow(bins[0][x], triangle.Min, triangle.Max);
+			Grow(bins[1][y], triangle.Min, triangle.Max);
+			Grow(bins[2][z], triangle.Min, triangle.Max);
+			binTriangles[0][x]++;
+			binTriangles[1][y]++;
+			binTriangles[2][z]++;
+		}
+
+		for (uint32_t axis = 0; axis < 3; axis++)
+		{
+			if (scales[axis] == 0.0f)
+			{
+				continue;
+			}
+
+			// Planes between the bins, swept from the left and then from the right
+			float leftArea[binCount - 1];
+			uint32_t leftCount[binCount - 1];
+			BinBounds left = EmptyBounds();
+			uint32_t leftTriangles = 0;
+			for (uint32_t plane = 0; plane < binCount - 1; plane++)
+			{
+				Grow(left, bins[axis][plane].Min, bins[axis][plane].Max);
+				leftTriangles += binTriangles[axis][plane];
+				leftArea[plane] = HalfArea(left);
+				leftCount[plane] = leftTriangles;
+			}
+
+			BinBounds right = EmptyBounds();
+			uint32_t rightTriangles = 0;
+			for (uint32_t plane = binCount - 1; plane > 0; plane--)
+			{
+				Grow(right, bins[axis][plane].Min, bins[axis][plane].Max);
+				rightTriangles += binTriangles[axis][plane];
+				if (leftCount[plane - 1] == 0 || rightTriangles == 0)
+				{
+					continue;
+				}
+				float cost = leftArea[plane - 1] * Blocks(leftCount[plane - 1]) + HalfArea(right) * Blocks(rightTriangles);
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = static_cast<int>(axis);
+					bestSplit = plane - 1;
+				}
+			}
+		}
+
+		float area = HalfArea(bounds);
+		float leafCost = blockCost * Blocks(count) * area;
+		float splitCost = nodeCost * area + blockCost * bestCost;
+		if (count <= maxLeafTriangles && (bestAxis < 0 || splitCost >= leafCost))
+		{
+			MakeLeaf(mNodes[nodeIndex], first, count);
+			return;
+		}
+	}
+	else if (count <= maxLeafTriangles)
+	{
+		MakeLeaf(mNodes[nodeIndex], first, count);
+		return;
+	}
+
+	uint32_t leftCount;
+	if (bestAxis >= 0)
+	{
+		uint32_t axis = static_cast<uint32_t>(bestAxis);
+		float min = Axis(centroids.Min, axis);
+		float scale = binCount / (Axis(centroids.Max, axis) - min);
+		BuildTriangle* middle = std::partition(mBuild.data() + first, mBuild.data() + first + count, [=](const BuildTriangle& triangle)
+		{
+			return BinOf(Axis(triangle.Centroid, axis), min, scale) <= bestSplit;
+		});
+		leftCount = static_cast<uint32_t>(middle - (mBuild.data() + first));
+	}
+	else
+	{
+		// Too deep or every centroid in one spot, halve along the longest axis
+		Float3 extent = Subtract(centroids.Max, centroids.Min);
+		uint32_t axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+		leftCount = count / 2;
+		std::nth_element(mBuild.data() + first, mBuild.data() + first + leftCount, mBuild.data() + first + count, [=](const BuildTriangle& a, const BuildTriangle& b)
+		{
+			return Axis(a.Centroid, axis) < Axis(b.Centroid, axis);
+		});
+	}
+	assert(leftCount > 0 && leftCount < count);
+
+	uint32_t leftChild = static_cast<uint32_t>(mNodes.size());
+	mNodes.resize(mNodes.size() + 2);
+	mNodes[nodeIndex].LeftOrFirst = leftChild;
+	mNodes[nodeIndex].Count = 0;
+	BuildNode(leftChild, first, leftCount, depth + 1);
+	BuildNode(leftChild + 1, first + leftCount, count - leftCount, depth + 1);
+}
+
+void MeshBvh::MakeLeaf(Node& node, uint32_t first, uint32_t count)
+{
+	node.LeftOrFirst = static_cast<uint32_t>(mBlocks.size());
+	node.Count = count;
+	mLeafCount++;
+
+	for (uint32_t start = 0; start < count; start += 4)
+	{
+		TriangleBlock block;
+		memset(&block, 0, sizeof(block));
+		for (uint32_t lane = 0; lane < 4; lane++)
+		{
+			if (start + lane >= count)
+			{
+				// Zero edges, the test never hits it
+				mTriangleIds.push_back(~0u);
+				continue;
+			}
+
+			uint32_t triangle = mBuild[first + start + lane].Triangle;
+			Float3 p[3];
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				memcpy(&p[corner], mPositions + mIndices[triangle * 3 + corner] * static_cast<size_t>(mStride), sizeof(Float3));
+			}
+			Float3 e1 = Subtract(p[1], p[0]);
+			Float3 e2 = Subtract(p[2], p[0]);
+			block.V0[0][lane] = p[0].x;
+			block.V0[1][lane] = p[0].y;
+			block.V0[2][lane] = p[0].z;
+			block.E1[0][lane] = e1.x;
+			block.E1[1][lane] = e1.y;
+			block.E1[2][lane] = e1.z;
+			block.E2[0][lane] = e2.x;
+			block.E2[1][lane] = e2.y;
+			block.E2[2][lane] = e2.z;
+			mTriangleIds.push_back(triangle);
+		}
+		mBlocks.push_back(block);
+	}
+}
+
+namespace
+{
+	// Moller-Trumbore on one lane of a block
+	template<typename Block>
+	bool IntersectLane(const Block& block, uint32_t lane, const Ray& ray, float best, float& distance, float& u, float& v)
+	{
+		Float3 v0(block.V0[0][lane], block.V0[1][lane], block.V0[2][lane]);
+		Float3 e1(block.E1[0][lane], block.E1[1][lane], block.E1[2][lane]);
+		Float3 e2(block.E2[0][lane], block.E2[1][lane], block.E2[2][lane]);
+
+		Float3 p = Cross(ray.Direction, e2);
+		float determinant = Dot(e1, p);
+		if (determinant == 0.0f)
+		{
+			return false;
+		}
+		float inverse = 1.0f / determinant;
+		Float3 t = Subtract(ray.Origin, v0);
+		float hitU = Dot(t, p) * inverse;
+		Float3 q = Cross(t, e1);
+		float hitV = Dot(ray.Direction, q) * inverse;
+		float hitDistance = Dot(e2, q) * inverse;
+		if (hitU >= 0.0f && hitV >= 0.0f && hitU + hitV <= 1.0f && hitDistance > 0.0f && hitDistance < best)
+		{
+			distance = hitDistance;
+			u = hitU;
+			v = hitV;
+			return true;
+		}
+		return false;
+	}
+
+	// The nearest of the block's four triangles closer than hit.Distance, hit.Triangle is the lane
+	template<typename Block>
+	bool IntersectBlock(const Block& block, const Ray& ray, RayHit& hit)
+	{
+#ifdef MESHBVH_SSE2
+		__m128 dx = _mm_set1_ps(ray.Direction.x);
+		__m128 dy = _mm_set1_ps(ray.Direction.y);
+		__m128 dz = _mm_set1_ps(ray.Direction.z);
+		__m128 e1x = _mm_loadu_ps(block.E1[0]);
+		__m128 e1y = _mm_loadu_ps(block.E1[1]);
+		__m128 e1z = _mm_loadu_ps(block.E1[2]);
+		__m128 e2x = _mm_loadu_ps(block.E2[0]);
+		__m128 e2y = _mm_loadu_ps(block.E2[1]);
+		__m128 e2z = _mm_loadu_ps(block.E2[2]);
+
+		// p = d x e2
+		__m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+		__m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+		__m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+		__m128 determinant = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+		__m128 inverse = _mm_div_ps(_mm_set1_ps(1.0f), determinant);
+
+		// t = o - v0
+		__m128 tx = _mm_sub_ps(_mm_set1_ps(ray.Origin.x), _mm_loadu_ps(block.V0[0]));
+		__m128 ty = _mm_sub_ps(_mm_set1_ps(ray.Origin.y), _mm_loadu_ps(block.V0[1]));
+		__m128 tz = _mm_sub_ps(_mm_set1_ps(ray.Origin.z), _mm_loadu_ps(block.V0[2]));
+		__m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, px), _mm_mul_ps(ty, py)), _mm_mul_ps(tz, pz)), inverse);
+
+		// q = t x e1
+		__m128 qx = _mm_sub_ps(_mm_mul_ps(ty, e1z), _mm_mul_ps(tz, e1y));
+		__m128 qy = _mm_sub_ps(_mm_mul_ps(tz, e1x), _mm_mul_ps(tx, e1z));
+		__m128 qz = _mm_sub_ps(_mm_mul_ps(tx, e1y), _mm_mul_ps(ty, e1x));
+		__m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inverse);
+		__m128 distance = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inverse);
+
+		// NaN from a zero determinant fails every compare
+		__m128 zero = _mm_setzero_ps();
+		__m128 mask = _mm_cmpneq_ps(determinant, zero);
+		mask = _mm_and_ps(mask, _mm_cmpge_ps(u, zero));
+		mask = _mm_and_ps(mask, _mm_cmpge_ps(v, zero));
+		mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(u, v), _mm_set1_ps(1.0f)));
+		mask = _mm_and_ps(mask, _mm_cmpgt_ps(distance, zero));
+		mask = _mm_and_ps(mask, _mm_cmplt_ps(distance, _mm_set1_ps(hit.Distance)));
+		int lanes = _mm_movemask_ps(mask);
+		if (lanes == 0)
+		{
+			return false;
+		}
+
+		float distances[4];
+		float us[4];
+		float vs[4];
+		_mm_storeu_ps(distances, distance);
+		_mm_storeu_ps(us, u);
+		_mm_storeu_ps(vs, v);
+		for (uint32_t lane = 0; lane < 4; lane++)
+		{
+			if ((lanes & (1 << lane)) != 0 && distances[lane] < hit.Distance)
+			{
+				hit.Triangle = lane;
+				hit.Distance = distances[lane];
+				hit.U = us[lane];
+				hit.V = vs[lane];
+			}
+		}
+		return true;
+#else
+		bool found = false;
+		for (uint32_t lane = 0; lane < 4; lane++)
+		{
+			if (IntersectLane(block, lane, ray, hit.Distance, hit.Distance, hit.U, hit.V))
+			{
+				hit.Triangle = lane;
+				found = true;
+			}
+		}
+		return found;
+#endif
+	}
+}
+
+bool MeshBvh::Intersect(const Ray& ray, RayHit& hit, float maxDistance) const
+{
+	if (mNodes.empty())
+	{
+		return false;
+	}
+
+	Float3 inverse(1.0f / ray.Direction.x, 1.0f / ray.Direction.y, 1.0f / ray.Direction.z);
+	RayHit nearest = { ~0u, maxDistance, 0.0f, 0.0f };
+	if (BoxEntry(mNodes[0].Min, mNodes[0].Max, ray, inverse, nearest.Distance) == FLT_MAX)
+	{
+		return false;
+	}
+
+	struct Entry
+	{
+		uint32_t Node;
+		float Distance;
+	};
+	Entry stack[stackSize];
+	uint32_t stackCount = 0;
+	uint32_t nodeIndex = 0;
+	for (;;)
+	{
+		const Node& node = mNodes[nodeIndex];
+		if (node.Count > 0)
+		{
+			uint32_t blockEnd = node.LeftOrFirst + (node.Count + 3) / 4;
+			for (uint32_t block = node.LeftOrFirst; block < blockEnd; block++)
+			{
+				if (IntersectBlock(mBlocks[block], ray, nearest))
+				{
+					nearest.Triangle = mTriangleIds[block * 4 + nearest.Triangle];
+				}
+			}
+		}
+		else
+		{
+			uint32_t nearChild = node.LeftOrFirst;
+			uint32_t farChild = node.LeftOrFirst + 1;
+			float nearEntry = BoxEntry(mNodes[nearChild].Min, mNodes[nearChild].Max, ray, inverse, nearest.Distance);
+			float farEntry = BoxEntry(mNodes[farChild].Min, mNodes[farChild].Max, ray, inverse, nearest.Distance);
+			if (farEntry < nearEntry)
+			{
+				std::swap(nearChild, farChild);
+				std::swap(nearEntry, farEntry);
+			}
+			if (nearEntry != FLT_MAX)
+			{
+				if (farEntry != FLT_MAX)
+				{
+					assert(stackCount < stackSize);
+					Entry entry = { farChild, farEntry };
+					stack[stackCount++] = entry;
+				}
+				nodeIndex = nearChild;
+				continue;
+			}
+		}
+
+		// Skips subtrees a closer hit has been found before
+		while (stackCount > 0 && stack[stackCount - 1].Distance >= nearest.Distance)
+		{
+			stackCount--;
+		}
+		if (stackCount == 0)
+		{
+			break;
+		}
+		nodeIndex = stack[--stackCount].Node;
+	}
+
+	if (nearest.Triangle == ~0u)
+	{
+		return false;
+	}
+	hit = nearest;
+	return true;
+}
+
+bool MeshBvh::IntersectBruteForce(const Ray& ray, RayHit& hit, float maxDistance) const
+{
+	RayHit nearest = { ~0u, maxDistance, 0.0f, 0.0f };
+	for (size_t block = 0; block < mBlocks.size(); block++)
+	{
+		for (uint32_t lane = 0; lane < 4; lane++)
+		{
+			if (IntersectLane(mBlocks[block], lane, ray, nearest.Distance, nearest.Distance, nearest.U, nearest.V))
+			{
+				nearest.Triangle = mTriangleIds[block * 4 + lane];
+			}
+		}
+	}
+
+	if (nearest.Triangle == ~0u)
+	{
+		return false;
+	}
+	hit = nearest;
+	return true;
+}
+
+size_t MeshBvh::MemoryBytes() const
+{
+	return mNodes.capacity() * sizeof(Node) + mBlocks.capacity() * sizeof(TriangleBlock) + mTriangleIds.capacity() * sizeof(uint32_t);
+}
+
+Float3 MeshBvh::BoundsMin() const
+{
+	return mNodes.empty() ? Float3(FLT_MAX, FLT_MAX, FLT_MAX) : mNodes[0].Min;
+}
+
+Float3 MeshBvh::BoundsMax() const
+{
+	return mNodes.empty() ? Float3(-FLT_MAX, -FLT_MAX, -FLT_MAX) : mNodes[0].Max;
+}
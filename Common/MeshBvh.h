@@ -0,0 +1,104 @@
+#ifndef MESHBVH_H
+#define MESHBVH_H
+
+#include "MathTypes.h"
+
+#include <cstdint>
+#include <vector>
+
+struct Ray
+{
+	Float3 Origin;
+	Float3 Direction;	// Need not be unit length, distances are in its units
+};
+
+struct RayHit
+{
+	uint32_t Triangle;	// Index of the triangle's first index / 3
+	float Distance;
+	float U;			// Barycentrics of the second and third vertex
+	float V;
+};
+
+// Ray from the near plane through pixel (x, y), counted from the top left of
+// a width x height viewport, in the space viewProj transforms from. The
+// direction is unit length.
+Ray ScreenPointToRay(float x, float y, float width, float height, const Float4x4& viewProj);
+
+// Bounding volume hierarchy over the triangles of an indexed mesh, for
+// picking and other ray queries on the CPU.
+//
+// Built top down with a binned surface area heuristic. Nodes are 32 bytes:
+// an inner node's children are next to each other, a leaf points at up to
+// 16 triangles. The triangles are copied in leaf order as a vertex and two
+// edges in blocks of four, so a leaf is tested four triangles at a time
+// with SSE2. Traversal visits the nearer child first and does not allocate.
+class MeshBvh
+{
+public:
+	MeshBvh();
+
+	// 'positions' is the first vertex's Float3 position, 'stride' the vertex size
+	void Build(const void* positions, uint32_t stride, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount);
+	void Clear();
+
+	// The nearest hit closer than maxDistance, both faces count
+	bool Intersect(const Ray& ray, RayHit& hit, float maxDistance = 1e30f) const;
+	// Every triangle, one at a time, for checking Intersect
+	bool IntersectBruteForce(const Ray& ray, RayHit& hit, float maxDistance = 1e30f) const;
+
+	bool IsEmpty() const { return mNodes.empty(); }
+	uint32_t TriangleCount() const { return mTriangleCount; }
+	uint32_t NodeCount() const { return static_cast<uint32_t>(mNodes.size()); }
+	uint32_t LeafCount() const { return mLeafCount; }
+	uint32_t Depth() const { return mDepth; }
+	size_t MemoryBytes() const;
+	// Of the root, empty boxes have Min > Max
+	Float3 BoundsMin() const;
+	Float3 BoundsMax() const;
+
+private:
+	struct Node
+	{
+		Float3 Min;
+		uint32_t LeftOrFirst;	// First child for inner nodes, first block for leaves
+		Float3 Max;
+		uint32_t Count;			// Triangles of a leaf, 0 for inner nodes
+	};
+	static_assert(sizeof(Node) == 32, "MeshBvh nodes are 32 bytes");
+
+	// Four triangles, lanes past a leaf's count are degenerate
+	struct TriangleBlock
+	{
+		float V0[3][4];
+		float E1[3][4];
+		float E2[3][4];
+	};
+
+	struct BuildTriangle
+	{
+		Float3 Min;
+		Float3 Max;
+		Float3 Centroid;
+		uint32_t Triangle;
+	};
+
+	void BuildNode(uint32_t nodeIndex, uint32_t first, uint32_t count, uint32_t depth);
+	void MakeLeaf(Node& node, uint32_t first, uint32_t count);
+
+	std::vector<Node> mNodes;
+	std::vector<TriangleBlock> mBlocks;
+	std::vector<uint32_t> mTriangleIds;		// Four per block, ~0 for padding
+
+	// Only while building
+	std::vector<BuildTriangle> mBuild;
+	const uint8_t* mPositions;
+	uint32_t mStride;
+	const uint32_t* mIndices;
+
+	uint32_t mTriangleCount;
+	uint32_t mLeafCount;
+	uint32_t mDepth;
+};
+
+#endif // MESHBVH_H
@@ -0,0 +1,551 @@
+#include "MeshCodec.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MESHCODEC_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace
+{
+	// First byte of every stream, bump the digit when the layout changes
+	const uint8_t vertexStreamVersion = 0xA1;
+	const uint8_t indexStreamVersion = 0xB1;
+
+	const uint32_t groupSize = 16;
+	const uint32_t maxBlockSize = 256;
+	// Staging for the columns of one block
+	const uint32_t stagingBytes = 8192;
+	const uint32_t maxVertexSize = 256;
+
+	// Bytes of a packed group by width code: 0, 2, 4 and 8 bits per value.
+	// At 2 and 4 bits the largest value means the byte follows the group.
+	const uint32_t groupBytes[4] = { 0, 4, 8, 16 };
+	const uint8_t escapeValues[4] = { 0, 3, 15, 0 };
+
+	// Vertices per block, a multiple of the group size whose columns fit the staging
+	uint32_t BlockVertices(uint32_t vertexSize)
+	{
+		uint32_t count = (stagingBytes / vertexSize) & ~(groupSize - 1);
+		return std::min(maxBlockSize, std::max(groupSize, count));
+	}
+
+	// Small differences of either sign become small values
+	uint8_t Zigzag8(uint8_t delta)
+	{
+		uint8_t sign = static_cast<uint8_t>(delta >> 7);
+		return static_cast<uint8_t>((delta << 1) ^ (0 - sign));
+	}
+
+	uint32_t Zigzag32(uint32_t delta)
+	{
+		return (delta << 1) ^ (0 - (delta >> 31));
+	}
+
+	uint32_t EscapedCount(const uint8_t* values, uint32_t code)
+	{
+		return static_cast<uint32_t>(std::count_if(values, values + groupSize, [code](uint8_t value) { return value >= escapeValues[code]; }));
+	}
+
+	// Appends a header with the width of each group, then the packed groups,
+	// each followed by its values too large for the width. The width is the
+	// one that takes the fewest bytes, so a few large differences among small
+	// ones cost a byte each instead of widening the whole group.
+	void EncodeColumn(const uint8_t* values, uint32_t groups, std::vector<uint8_t>& data)
+	{
+		size_t header = data.size();
+		data.resize(header + (groups + 3) / 4, 0);
+		for (uint32_t group = 0; group < groups; group++)
+		{
+			const uint8_t* v = values + group * groupSize;
+			uint32_t code = 0;
+			if (*std::max_element(v, v + groupSize) > 0)
+			{
+				code = 3;
+				uint32_t bytes = groupBytes[3];
+				for (uint32_t narrow = 1; narrow <= 2; narrow++)
+				{
+					uint32_t narrowBytes = groupBytes[narrow] + EscapedCount(v, narrow);
+					if (narrowBytes < bytes)
+					{
+						code = narrow;
+						bytes = narrowBytes;
+					}
+				}
+			}
+			data[header + group / 4] |= static_cast<uint8_t>(code << (group % 4 * 2));
+
+			uint8_t escape = escapeValues[code];
+			uint8_t packed[groupSize];
+			for (uint32_t i = 0; i < groupSize; i++)
+			{
+				packed[i] = std::min(v[i], escape);
+			}
+			if (code == 1)
+			{
+				for (uint32_t i = 0; i < groupSize; i += 4)
+				{
+					data.push_back(static_cast<uint8_t>((packed[i] << 6) | (packed[i + 1] << 4) | (packed[i + 2] << 2) | packed[i + 3]));
+				}
+			}
+			else if (code == 2)
+			{
+				for (uint32_t i = 0; i < groupSize; i += 2)
+				{
+					data.push_back(static_cast<uint8_t>((packed[i] << 4) | packed[i + 1]));
+				}
+			}
+			else if (code == 3)
+			{
+				data.insert(data.end(), v, v + groupSize);
+			}
+			for (uint32_t i = 0; (code == 1 || code == 2) && i < groupSize; i++)
+			{
+				if (v[i] >= escape)
+				{
+					data.push_back(v[i]);
+				}
+			}
+		}
+	}
+
+#ifdef MESHCODEC_SSE2
+	uint32_t LowestBit(uint32_t mask)
+	{
+#ifdef _MSC_VER
+		unsigned long bit;
+		_BitScanForward(&bit, mask);
+		return bit;
+#else
+		return static_cast<uint32_t>(__builtin_ctz(mask));
+#endif
+	}
+
+	__m128i UnpackGroup(uint32_t code, const uint8_t* data)
+	{
+		switch (code)
+		{
+		case 0:
+			return _mm_setzero_si128();
+		case 1:
+		{
+			// Value 4i + j is bits 6 - 2j of byte i
+			int32_t bits;
+			memcpy(&bits, data, sizeof(bits));
+			__m128i packed = _mm_cvtsi32_si128(bits);
+			__m128i mask = _mm_set1_epi8(3);
+			__m128i first = _mm_and_si128(_mm_srli_epi16(packed, 6), mask);
+			__m128i second = _mm_and_si128(_mm_srli_epi16(packed, 4), mask);
+			__m128i third = _mm_and_si128(_mm_srli_epi16(packed, 2), mask);
+			__m128i fourth = _mm_and_si128(packed, mask);
+			return _mm_unpacklo_epi16(_mm_unpacklo_epi8(first, second), _mm_unpacklo_epi8(third, fourth));
+		}
+		case 2:
+		{
+			// Value 2i is the high nibble of byte i
+			__m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(data));
+			__m128i mask = _mm_set1_epi8(15);
+			return _mm_unpacklo_epi8(_mm_and_si128(_mm_srli_epi16(packed, 4), mask), _mm_and_si128(packed, mask));
+		}
+		default:
+			return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+		}
+	}
+
+	__m128i Unzigzag8(__m128i value)
+	{
+		__m128i half = _mm_and_si128(_mm_srli_epi16(value, 1), _mm_set1_epi8(0x7F));
+		__m128i sign = _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(value, _mm_set1_epi8(1)));
+		return _mm_xor_si128(half, sign);
+	}
+
+	// Byte i becomes the sum of bytes 0 to i
+	__m128i PrefixSum8(__m128i value)
+	{
+		value = _mm_add_epi8(value, _mm_slli_si128(value, 1));
+		value = _mm_add_epi8(value, _mm_slli_si128(value, 2));
+		value = _mm_add_epi8(value, _mm_slli_si128(value, 4));
+		return _mm_add_epi8(value, _mm_slli_si128(value, 8));
+	}
+
+	__m128i BroadcastLastByte(__m128i value)
+	{
+		__m128i words = _mm_unpackhi_epi8(value, value);
+		return _mm_shuffle_epi32(_mm_shufflehi_epi16(words, 0xFF), 0xFF);
+	}
+
+	// Byte i of four rows of 16 bytes to the 32-bit value i, in four vectors of four
+	void Interleave4(__m128i row0, __m128i row1, __m128i row2, __m128i row3, __m128i* out)
+	{
+		__m128i low01 = _mm_unpacklo_epi8(row0, row1);
+		__m128i high01 = _mm_unpackhi_epi8(row0, row1);
+		__m128i low23 = _mm_unpacklo_epi8(row2, row3);
+		__m128i high23 = _mm_unpackhi_epi8(row2, row3);
+		out[0] = _mm_unpacklo_epi16(low01, low23);
+		out[1] = _mm_unpackhi_epi16(low01, low23);
+		out[2] = _mm_unpacklo_epi16(high01, high23);
+		out[3] = _mm_unpackhi_epi16(high01, high23);
+	}
+
+	// Four vectors of four 32-bit values, row i becomes column i
+	void Transpose4x4(__m128i& a, __m128i& b, __m128i& c, __m128i& d)
+	{
+		__m128i ab0 = _mm_unpacklo_epi32(a, b);
+		__m128i ab1 = _mm_unpackhi_epi32(a, b);
+		__m128i cd0 = _mm_unpacklo_epi32(c, d);
+		__m128i cd1 = _mm_unpackhi_epi32(c, d);
+		a = _mm_unpacklo_epi64(ab0, cd0);
+		b = _mm_unpackhi_epi64(ab0, cd0);
+		c = _mm_unpacklo_epi64(ab1, cd1);
+		d = _mm_unpackhi_epi64(ab1, cd1);
+	}
+#else
+	uint8_t Unzigzag8(uint8_t value)
+	{
+		return static_cast<uint8_t>((value >> 1) ^ (0 - (value & 1)));
+	}
+
+	uint32_t Unzigzag32(uint32_t value)
+	{
+		return (value >> 1) ^ (0 - (value & 1));
+	}
+
+	void UnpackGroup(uint32_t code, const uint8_t* data, uint8_t* values)
+	{
+		for (uint32_t i = 0; i < groupSize; i++)
+		{
+			switch (code)
+			{
+			case 0:
+				values[i] = 0;
+				break;
+			case 1:
+				values[i] = static_cast<uint8_t>((data[i / 4] >> (6 - i % 4 * 2)) & 3);
+				break;
+			case 2:
+				values[i] = static_cast<uint8_t>((data[i / 2] >> (i % 2 == 0 ? 4 : 0)) & 15);
+				break;
+			default:
+				values[i] = data[i];
+				break;
+			}
+		}
+	}
+#endif
+
+	// Unpacks a column into 'values', with Delta the running sum of its
+	// unzigzagged bytes after 'carry'. Null if 'data' ends first.
+	template<bool Delta>
+	const uint8_t* DecodeColumn(const uint8_t* at, const uint8_t* end, uint32_t groups, uint8_t carry, uint8_t* values)
+	{
+		size_t headerBytes = (groups + 3) / 4;
+		if (static_cast<size_t>(end - at) < headerBytes)
+		{
+			return nullptr;
+		}
+		const uint8_t* header = at;
+		at += headerBytes;
+
+#ifdef MESHCODEC_SSE2
+		__m128i base = _mm_set1_epi8(static_cast<char>(carry));
+		for (uint32_t group = 0; group < groups; group++)
+		{
+			uint32_t code = (header[group / 4] >> (group % 4 * 2)) & 3;
+			if (static_cast<size_t>(end - at) < groupBytes[code])
+			{
+				return nullptr;
+			}
+			__m128i value = UnpackGroup(code, at);
+			at += groupBytes[code];
+
+			// The escaped bytes are patched in place, which the index planes never load again
+			uint8_t* out = values + group * groupSize;
+			int escaped = code == 1 || code == 2
+				? _mm_movemask_epi8(_mm_cmpeq_epi8(value, _mm_set1_epi8(static_cast<char>(escapeValues[code])))) : 0;
+			if (escaped != 0)
+			{
+				_mm_store_si128(reinterpret_cast<__m128i*>(out), value);
+				for (; escaped != 0; escaped &= escaped - 1)
+				{
+					if (at == end)
+					{
+						return nullptr;
+					}
+					out[LowestBit(static_cast<uint32_t>(escaped))] = *at++;
+				}
+				if (!Delta)
+				{
+					continue;
+				}
+				value = _mm_load_si128(reinterpret_cast<const __m128i*>(out));
+			}
+			if (Delta)
+			{
+				value = _mm_add_epi8(PrefixSum8(Unzigzag8(value)), base);
+				base = BroadcastLastByte(value);
+			}
+			_mm_store_si128(reinterpret_cast<__m128i*>(out), value);
+		}
+#else
+		for (uint32_t group = 0; group < groups; group++)
+		{
+			uint32_t code = (header[group / 4] >> (group % 4 * 2)) & 3;
+			if (static_cast<size_t>(end - at) < groupBytes[code])
+			{
+				return nullptr;
+			}
+			uint8_t* value = values + group * groupSize;
+			UnpackGroup(code, at, value);
+			at += groupBytes[code];
+			for (uint32_t i = 0; (code == 1 || code == 2) && i < groupSize; i++)
+			{
+				if (value[i] == escapeValues[code])
+				{
+					if (at == end)
+					{
+						return nullptr;
+					}
+					value[i] = *at++;
+				}
+			}
+			for (uint32_t i = 0; Delta && i < groupSize; i++)
+			{
+				carry = static_cast<uint8_t>(carry + Unzigzag8(value[i]));
+				value[i] = carry;
+			}
+		}
+#endif
+		return at;
+	}
+
+	// The columns of a block, 'stride' apart, back into 'count' vertices
+	void TransposeBlock(const uint8_t* columns, uint32_t stride, uint32_t count, uint32_t vertexSize, uint8_t* vertices)
+	{
+		uint32_t column = 0;
+#ifdef MESHCODEC_SSE2
+		// 16 columns of 16 vertices at a time: each four columns to 32-bit
+		// words of four vertices, then four such words to whole vertices
+		for (; column + 16 <= vertexSize; column += 16)
+		{
+			for (uint32_t first = 0; first < count; first += groupSize)
+			{
+				const uint8_t* row = columns + column * stride + first;
+				__m128i words[4][4];
+				for (uint32_t i = 0; i < 4; i++)
+				{
+					const uint8_t* rows = row + i * 4 * stride;
+					Interleave4(_mm_load_si128(reinterpret_cast<const __m128i*>(rows)), _mm_load_si128(reinterpret_cast<const __m128i*>(rows + stride))
+						, _mm_load_si128(reinterpret_cast<const __m128i*>(rows + stride * 2)), _mm_load_si128(reinterpret_cast<const __m128i*>(rows + stride * 3)), words[i]);
+				}
+				uint32_t rowCount = std::min(groupSize, count - first);
+				for (uint32_t quad = 0; quad < 4; quad++)
+				{
+					Transpose4x4(words[0][quad], words[1][quad], words[2][quad], words[3][quad]);
+					for (uint32_t i = 0; i < 4 && quad * 4 + i < rowCount; i++)
+					{
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(vertices + (first + quad * 4 + i) * vertexSize + column), words[i][quad]);
+					}
+				}
+			}
+		}
+		for (; column < vertexSize; column += 4)
+		{
+			for (uint32_t first = 0; first < count; first += groupSize)
+			{
+				const uint8_t* row = columns + column * stride + first;
+				__m128i words[4];
+				Interleave4(_mm_load_si128(reinterpret_cast<const __m128i*>(row)), _mm_load_si128(reinterpret_cast<const __m128i*>(row + stride))
+					, _mm_load_si128(reinterpret_cast<const __m128i*>(row + stride * 2)), _mm_load_si128(reinterpret_cast<const __m128i*>(row + stride * 3)), words);
+				alignas(16) uint32_t values[groupSize];
+				for (uint32_t i = 0; i < 4; i++)
+				{
+					_mm_store_si128(reinterpret_cast<__m128i*>(values + i * 4), words[i]);
+				}
+				uint32_t rowCount = std::min(groupSize, count - first);
+				for (uint32_t i = 0; i < rowCount; i++)
+				{
+					memcpy(vertices + (first + i) * vertexSize + column, &values[i], sizeof(uint32_t));
+				}
+			}
+		}
+#else
+		for (uint32_t vertex = 0; vertex < count; vertex++)
+		{
+			for (column = 0; column < vertexSize; column++)
+			{
+				vertices[vertex * vertexSize + column] = columns[column * stride + vertex];
+			}
+		}
+#endif
+	}
+}
+
+void EncodeVertexBuffer(const void* vertices, uint32_t vertexCount, uint32_t vertexSize, std::vector<uint8_t>& data)
+{
+	data.clear();
+	data.push_back(vertexStreamVersion);
+
+	const uint8_t* source = static_cast<const uint8_t*>(vertices);
+	uint32_t blockVertices = BlockVertices(vertexSize);
+	std::vector<uint8_t> previous(vertexSize, 0);
+	std::vector<uint8_t> values(blockVertices);
+	for (uint32_t first = 0; first < vertexCount; first += blockVertices)
+	{
+		uint32_t count = std::min(blockVertices, vertexCount - first);
+		uint32_t groups = (count + groupSize - 1) / groupSize;
+		for (uint32_t column = 0; column < vertexSize; column++)
+		{
+			// The padding repeats the last vertex, so the carry is right for the next block
+			std::fill(values.begin(), values.end(), 0);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				uint8_t byte = source[static_cast<size_t>(first + i) * vertexSize + column];
+				values[i] = Zigzag8(static_cast<uint8_t>(byte - previous[column]));
+				previous[column] = byte;
+			}
+			EncodeColumn(values.data(), groups, data);
+		}
+	}
+}
+
+void EncodeIndexBuffer(const uint32_t* indices, uint32_t indexCount, std::vector<uint8_t>& data)
+{
+	data.clear();
+	data.push_back(indexStreamVersion);
+
+	uint32_t previous = 0;
+	std::vector<uint8_t> planes(4 * maxBlockSize);
+	for (uint32_t first = 0; first < indexCount; first += maxBlockSize)
+	{
+		uint32_t count = std::min(maxBlockSize, indexCount - first);
+		uint32_t groups = (count + groupSize - 1) / groupSize;
+		std::fill(planes.begin(), planes.end(), 0);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			uint32_t value = Zigzag32(indices[first + i] - previous);
+			previous = indices[first + i];
+			for (uint32_t plane = 0; plane < 4; plane++)
+			{
+				planes[plane * maxBlockSize + i] = static_cast<uint8_t>(value >> (plane * 8));
+			}
+		}
+		for (uint32_t plane = 0; plane < 4; plane++)
+		{
+			EncodeColumn(&planes[plane * maxBlockSize], groups, data);
+		}
+	}
+}
+
+uint64_t MaxVertexCount(size_t size, uint32_t vertexSize)
+{
+	// Every byte of group widths covers at most 4 groups of one column
+	return size == 0 || vertexSize == 0 ? 0 : static_cast<uint64_t>(size - 1) * 4 * groupSize / vertexSize;
+}
+
+uint64_t MaxIndexCount(size_t size)
+{
+	// Four byte planes per index
+	return size == 0 ? 0 : static_cast<uint64_t>(size - 1) * groupSize;
+}
+
+bool DecodeVertexBuffer(void* destination, uint32_t vertexCount, uint32_t vertexSize, const uint8_t* data, size_t size)
+{
+	if (vertexSize == 0 || vertexSize > maxVertexSize || vertexSize % 4 != 0 || size == 0 || data[0] != vertexStreamVersion)
+	{
+		return false;
+	}
+
+	const uint8_t* at = data + 1;
+	const uint8_t* end = data + size;
+	uint8_t* vertices = static_cast<uint8_t*>(destination);
+	uint32_t blockVertices = BlockVertices(vertexSize);
+	alignas(16) uint8_t columns[stagingBytes];
+	uint8_t previous[maxVertexSize] = {};
+	for (uint32_t first = 0; first < vertexCount; first += blockVertices)
+	{
+		uint32_t count = std::min(blockVertices, vertexCount - first);
+		uint32_t groups = (count + groupSize - 1) / groupSize;
+		for (uint32_t column = 0; column < vertexSize; column++)
+		{
+			uint8_t* values = columns + column * blockVertices;
+			at = DecodeColumn<true>(at, end, groups, previous[column], values);
+			if (at == nullptr)
+			{
+				return false;
+			}
+			previous[column] = values[groups * groupSize - 1];
+		}
+		TransposeBlock(columns, blockVertices, count, vertexSize, vertices + static_cast<size_t>(first) * vertexSize);
+	}
+	return at == end;
+}
+
+bool DecodeIndexBuffer(uint32_t* destination, uint32_t indexCount, const uint8_t* data, size_t size)
+{
+	if (size == 0 || data[0] != indexStreamVersion)
+	{
+		return false;
+	}
+
+	const uint8_t* at = data + 1;
+	const uint8_t* end = data + size;
+	alignas(16) uint8_t planes[4 * maxBlockSize];
+	uint32_t previous = 0;
+	for (uint32_t first = 0; first < indexCount; first += maxBlockSize)
+	{
+		uint32_t count = std::min(maxBlockSize, indexCount - first);
+		uint32_t groups = (count + groupSize - 1) / groupSize;
+		for (uint32_t plane = 0; plane < 4; plane++)
+		{
+			at = DecodeColumn<false>(at, end, groups, 0, planes + plane * maxBlockSize);
+			if (at == nullptr)
+			{
+				return false;
+			}
+		}
+
+#ifdef MESHCODEC_SSE2
+		__m128i base = _mm_set1_epi32(static_cast<int>(previous));
+		for (uint32_t group = 0; group < groups; group++)
+		{
+			const uint8_t* plane = planes + group * groupSize;
+			__m128i words[4];
+			Interleave4(_mm_load_si128(reinterpret_cast<const __m128i*>(plane)), _mm_load_si128(reinterpret_cast<const __m128i*>(plane + maxBlockSize))
+				, _mm_load_si128(reinterpret_cast<const __m128i*>(plane + maxBlockSize * 2)), _mm_load_si128(reinterpret_cast<const __m128i*>(plane + maxBlockSize * 3)), words);
+
+			alignas(16) uint32_t values[groupSize];
+			uint32_t* out = count - group * groupSize >= groupSize ? destination + first + group * groupSize : values;
+			for (uint32_t i = 0; i < 4; i++)
+			{
+				__m128i value = words[i];
+				__m128i sign = _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(value, _mm_set1_epi32(1)));
+				value = _mm_xor_si128(_mm_srli_epi32(value, 1), sign);
+				value = _mm_add_epi32(value, _mm_slli_si128(value, 4));
+				value = _mm_add_epi32(value, _mm_slli_si128(value, 8));
+				value = _mm_add_epi32(value, base);
+				base = _mm_shuffle_epi32(value, 0xFF);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 4), value);
+			}
+			if (out == values)
+			{
+				memcpy(destination + first + group * groupSize, values, (count - group * groupSize) * sizeof(uint32_t));
+			}
+		}
+		previous = static_cast<uint32_t>(_mm_cvtsi128_si32(base));
+#else
+		for (uint32_t i = 0; i < count; i++)
+		{
+			uint32_t value = planes[i] | (planes[maxBlockSize + i] << 8) | (planes[maxBlockSize * 2 + i] << 16)
+				| (static_cast<uint32_t>(planes[maxBlockSize * 3 + i]) << 24);
+			previous += Unzigzag32(value);
+			destination[first + i] = previous;
+		}
+#endif
+	}
+	return at == end;
+}
@@ -0,0 +1,42 @@
+#ifndef MESHCODEC_H
+#define MESHCODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Lossless compression of vertex and index buffers that decodes quickly,
+// for meshes that are already quantized and in vertex cache order. Headless
+// -meshcodec measures the decode speed.
+//
+// Vertices are split into byte columns, byte k of every vertex together,
+// and each byte is stored as the zigzagged difference to the same byte of
+// the previous vertex. Indices are stored as the zigzagged difference to
+// the previous index, split into four byte planes. Either way the bytes go
+// in groups of 16 that are packed to 0, 2, 4 or 8 bits each, with a 2-bit
+// width per group. Bytes too large for their group's width are escaped and
+// stored after it. Neighbouring vertices of a cache ordered mesh are close,
+// so most groups need 2 or 4 bits.
+//
+// The decoder takes blocks of up to 256 vertices or indices at a time and
+// unpacks, sums and transposes them with SSE2 where it is available. It
+// only writes the destination, in order, so that can be a mapped buffer.
+//
+// Vertex sizes must be a multiple of 4 up to 256 bytes.
+void EncodeVertexBuffer(const void* vertices, uint32_t vertexCount, uint32_t vertexSize, std::vector<uint8_t>& data);
+void EncodeIndexBuffer(const uint32_t* indices, uint32_t indexCount, std::vector<uint8_t>& data);
+
+// False if 'data' is of another codec version or does not end where this
+// many vertices or indices do, as damaged streams mostly don't. Counts in
+// the same group of 16 cannot be told apart, the caller stores the count.
+// The destination is then partly written, never past its end.
+bool DecodeVertexBuffer(void* destination, uint32_t vertexCount, uint32_t vertexSize, const uint8_t* data, size_t size);
+bool DecodeIndexBuffer(uint32_t* destination, uint32_t indexCount, const uint8_t* data, size_t size);
+
+// The most vertices or indices a stream of 'size' bytes can hold, as every
+// group of 16 bytes takes at least its width. A stored count above it is
+// damaged and can be rejected before the destination is allocated.
+uint64_t MaxVertexCount(size_t size, uint32_t vertexSize);
+uint64_t MaxIndexCount(size_t size);
+
+#endif // MESHCODEC_H
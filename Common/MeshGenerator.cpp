@@ -0,0 +1,210 @@
+#include "MeshGenerator.h"
+
+#include <cmath>
+
+using StaticGeometry::MeshVertex;
+
+namespace
+{
+	MeshVertex MakeVertex(const Float3& position, const Float3& normal, const Float3& tangent, const Float2& texC)
+	{
+		MeshVertex vertex;
+		vertex.Position = position;
+		vertex.Normal = normal;
+		vertex.TangentU = tangent;
+		vertex.TexC = texC;
+		return vertex;
+	}
+
+	void BuildCylinderCap(float radius, float y, float normalY, uint32_t sliceCount, float height, MeshGenerator::MeshData& meshData)
+	{
+		uint32_t baseIndex = static_cast<uint32_t>(meshData.Vertices.size());
+		float dTheta = 2.0f * MathPi / sliceCount;
+
+		// Ring vertices are duplicated because the cap needs other normals and texture coordinates
+		for (uint32_t i = 0; i <= sliceCount; i++)
+		{
+			float x = radius * cosf(i * dTheta);
+			float z = radius * sinf(i * dTheta);
+			float u = x / height + 0.5f;
+			float v = z / height + 0.5f;
+			meshData.Vertices.push_back(MakeVertex(Float3(x, y, z), Float3(0.0f, normalY, 0.0f), Float3(1.0f, 0.0f, 0.0f), Float2(u, v)));
+		}
+
+		meshData.Vertices.push_back(MakeVertex(Float3(0.0f, y, 0.0f), Float3(0.0f, normalY, 0.0f), Float3(1.0f, 0.0f, 0.0f), Float2(0.5f, 0.5f)));
+		uint32_t centerIndex = static_cast<uint32_t>(meshData.Vertices.size()) - 1;
+
+		for (uint32_t i = 0; i < sliceCount; i++)
+		{
+			meshData.Indices.push_back(centerIndex);
+			if (normalY > 0.0f)
+			{
+				meshData.Indices.push_back(baseIndex + i + 1);
+				meshData.Indices.push_back(baseIndex + i);
+			}
+			else
+			{
+				meshData.Indices.push_back(baseIndex + i);
+				meshData.Indices.push_back(baseIndex + i + 1);
+			}
+		}
+	}
+}
+
+void MeshGenerator::CreateBox(float width, float height, float depth, MeshData& meshData)
+{
+	StaticGeometry::StaticMesh<24, 36> box = StaticGeometry::MakeBox(width, height, depth);
+	meshData.Vertices.assign(box.Vertices.begin(), box.Vertices.end());
+	meshData.Indices.assign(box.Indices.begin(), box.Indices.end());
+}
+
+void MeshGenerator::CreateSphere(float radius, uint32_t sliceCount, uint32_t stackCount, MeshData& meshData)
+{
+	meshData.Vertices.clear();
+	meshData.Indices.clear();
+
+	meshData.Vertices.push_back(MakeVertex(Float3(0.0f, radius, 0.0f), Float3(0.0f, 1.0f, 0.0f), Float3(1.0f, 0.0f, 0.0f), Float2(0.0f, 0.0f)));
+
+	float phiStep = MathPi / stackCount;
+	float thetaStep = 2.0f * MathPi / sliceCount;
+
+	// Rings, the poles are not rings
+	for (uint32_t i = 1; i <= stackCount - 1; i++)
+	{
+		float phi = i * phiStep;
+		for (uint32_t j = 0; j <= sliceCount; j++)
+		{
+			float theta = j * thetaStep;
+
+			Float3 position(radius * sinf(phi) * cosf(theta), radius * cosf(phi), radius * sinf(phi) * sinf(theta));
+			Float3 tangent(-radius * sinf(phi) * sinf(theta), 0.0f, radius * sinf(phi) * cosf(theta));
+			meshData.Vertices.push_back(MakeVertex(position, Normalize3(position), Normalize3(tangent)
+				, Float2(theta / (2.0f * MathPi), phi / MathPi)));
+		}
+	}
+
+	meshData.Vertices.push_back(MakeVertex(Float3(0.0f, -radius, 0.0f), Float3(0.0f, -1.0f, 0.0f), Float3(1.0f, 0.0f, 0.0f), Float2(0.0f, 1.0f)));
+
+	// Top cap
+	for (uint32_t i = 1; i <= sliceCount; i++)
+	{
+		meshData.Indices.push_back(0);
+		meshData.Indices.push_back(i + 1);
+		meshData.Indices.push_back(i);
+	}
+
+	// Inner stacks
+	uint32_t baseIndex = 1;
+	uint32_t ringVertexCount = sliceCount + 1;
+	for (uint32_t i = 0; i < stackCount - 2; i++)
+	{
+		for (uint32_t j = 0; j < sliceCount; j++)
+		{
+			meshData.Indices.push_back(baseIndex + i * ringVertexCount + j);
+			meshData.Indices.push_back(baseIndex + i * ringVertexCount + j + 1);
+			meshData.Indices.push_back(baseIndex + (i + 1) * ringVertexCount + j);
+
+			meshData.Indices.push_back(baseIndex + (i + 1) * ringVertexCount + j);
+			meshData.Indices.push_back(baseIndex + i * ringVertexCount + j + 1);
+			meshData.Indices.push_back(baseIndex + (i + 1) * ringVertexCount + j + 1);
+		}
+	}
+
+	// Bottom cap
+	uint32_t southPoleIndex = static_cast<uint32_t>(meshData.Vertices.size()) - 1;
+	baseIndex = southPoleIndex - ringVertexCount;
+	for (uint32_t i = 0; i < sliceCount; i++)
+	{
+		meshData.Indices.push_back(southPoleIndex);
+		meshData.Indices.push_back(baseIndex + i);
+		meshData.Indices.push_back(baseIndex + i + 1);
+	}
+}
+
+void MeshGenerator::CreateCylinder(float bottomRadius, float topRadius, float height, uint32_t sliceCount, uint32_t stackCount, MeshData& meshData)
+{
+	meshData.Vertices.clear();
+	meshData.Indices.clear();
+
+	float stackHeight = height / stackCount;
+	float radiusStep = (topRadius - bottomRadius) / stackCount;
+	uint32_t ringCount = stackCount + 1;
+	float dTheta = 2.0f * MathPi / sliceCount;
+
+	// Rings from bottom to top
+	for (uint32_t i = 0; i < ringCount; i++)
+	{
+		float y = -0.5f * height + i * stackHeight;
+		float r = bottomRadius + i * radiusStep;
+
+		for (uint32_t j = 0; j <= sliceCount; j++)
+		{
+			float c = cosf(j * dTheta);
+			float s = sinf(j * dTheta);
+
+			Float3 tangent(-s, 0.0f, c);
+			float dr = bottomRadius - topRadius;
+			Float3 bitangent(dr * c, -height, dr * s);
+
+			meshData.Vertices.push_back(MakeVertex(Float3(r * c, y, r * s), Normalize3(Cross(tangent, bitangent)), tangent
+				, Float2(static_cast<float>(j) / sliceCount, 1.0f - static_cast<float>(i) / stackCount)));
+		}
+	}
+
+	uint32_t ringVertexCount = sliceCount + 1;
+	for (uint32_t i = 0; i < stackCount; i++)
+	{
+		for (uint32_t j = 0; j < sliceCount; j++)
+		{
+			meshData.Indices.push_back(i * ringVertexCount + j);
+			meshData.Indices.push_back((i + 1) * ringVertexCount + j);
+			meshData.Indices.push_back((i + 1) * ringVertexCount + j + 1);
+
+			meshData.Indices.push_back(i * ringVertexCount + j);
+			meshData.Indices.push_back((i + 1) * ringVertexCount + j + 1);
+			meshData.Indices.push_back(i * ringVertexCount + j + 1);
+		}
+	}
+
+	BuildCylinderCap(topRadius, 0.5f * height, 1.0f, sliceCount, height, meshData);
+	BuildCylinderCap(bottomRadius, -0.5f * height, -1.0f, sliceCount, height, meshData);
+}
+
+void MeshGenerator::CreateGrid(float width, float depth, uint32_t m, uint32_t n, MeshData& meshData)
+{
+	meshData.Vertices.resize(m * n);
+	meshData.Indices.resize((m - 1) * (n - 1) * 6);
+
+	float halfWidth = 0.5f * width;
+	float halfDepth = 0.5f * depth;
+	float dx = width / (n - 1);
+	float dz = depth / (m - 1);
+	float du = 1.0f / (n - 1);
+	float dv = 1.0f / (m - 1);
+
+	for (uint32_t i = 0; i < m; i++)
+	{
+		float z = halfDepth - i * dz;
+		for (uint32_t j = 0; j < n; j++)
+		{
+			meshData.Vertices[i * n + j] = MakeVertex(Float3(-halfWidth + j * dx, 0.0f, z)
+				, Float3(0.0f, 1.0f, 0.0f), Float3(1.0f, 0.0f, 0.0f), Float2(j * du, i * dv));
+		}
+	}
+
+	uint32_t k = 0;
+	for (uint32_t i = 0; i < m - 1; i++)
+	{
+		for (uint32_t j = 0; j < n - 1; j++)
+		{
+			meshData.Indices[k + 0] = i * n + j;
+			meshData.Indices[k + 1] = i * n + j + 1;
+			meshData.Indices[k + 2] = (i + 1) * n + j;
+
+			meshData.Indices[k + 3] = (i + 1) * n + j;
+			meshData.Indices[k + 4] = i * n + j + 1;
+			meshData.Indices[k + 5] = (i + 1) * n + j + 1;
+			k += 6;
+		}
+	}
+}
@@ -0,0 +1,27 @@
+#ifndef MESHGENERATOR_H
+#define MESHGENERATOR_H
+
+#include "StaticGeometry.h"
+
+#include <cstdint>
+#include <vector>
+
+// Runtime generators with the same vertex and index order as the book's
+// GeometryGenerator, usable without DirectXMath. Sizes are runtime
+// arguments, so large grids and spheres do not need StaticGeometry.
+namespace MeshGenerator
+{
+	struct MeshData
+	{
+		std::vector<StaticGeometry::MeshVertex> Vertices;
+		std::vector<uint32_t> Indices;
+	};
+
+	void CreateBox(float width, float height, float depth, MeshData& meshData);
+	void CreateSphere(float radius, uint32_t sliceCount, uint32_t stackCount, MeshData& meshData);
+	void CreateCylinder(float bottomRadius, float topRadius, float height, uint32_t sliceCount, uint32_t stackCount, MeshData& meshData);
+	// m vertices along z, n along x
+	void CreateGrid(float width, float depth, uint32_t m, uint32_t n, MeshData& meshData);
+}
+
+#endif // MESHGENERATOR_H
@@ -0,0 +1,159 @@
+#include "NullRenderDevice.h"
+
+#include <cassert>
+#include <cstring>
+
+NullRenderDevice::NullRenderDevice()
+	: BufferCount(0)
+	, BufferBytes(0)
+	, EffectCount(0)
+	, InputLayoutCount(0)
+	, FenceCount(0)
+	, MapCount(0)
+	, DiscardCount(0)
+{
+}
+
+NullRenderDevice::~NullRenderDevice()
+{
+	assert(BufferCount == 0 && EffectCount == 0 && InputLayoutCount == 0 && FenceCount == 0 && "Render objects leaked");
+}
+
+RenderBuffer* NullRenderDevice::CreateBuffer(const BufferDesc& desc, const void* initialData)
+{
+	assert((initialData != nullptr || desc.Usage == BufferUsage::Dynamic) && "Immutable buffers need initial data");
+
+	Buffer* buffer = new Buffer();
+	buffer->Desc = desc;
+	buffer->Data.resize(desc.ByteWidth);
+	if (initialData != nullptr)
+	{
+		memcpy(buffer->Data.data(), initialData, desc.ByteWidth);
+	}
+
+	BufferCount++;
+	BufferBytes += desc.ByteWidth;
+	return reinterpret_cast<RenderBuffer*>(buffer);
+}
+
+void NullRenderDevice::ReleaseBuffer(RenderBuffer* buffer)
+{
+	if (buffer == nullptr)
+	{
+		return;
+	}
+	Buffer* nullBuffer = reinterpret_cast<Buffer*>(buffer);
+	BufferCount--;
+	BufferBytes -= nullBuffer->Desc.ByteWidth;
+	delete nullBuffer;
+}
+
+void* NullRenderDevice::MapBuffer(RenderBuffer* buffer, MapMode mode)
+{
+	Buffer* nullBuffer = reinterpret_cast<Buffer*>(buffer);
+	assert(nullBuffer->Desc.Usage == BufferUsage::Dynamic && "Only dynamic buffers can be mapped");
+	MapCount++;
+	DiscardCount += mode == MapMode::Discard ? 1 : 0;
+	return nullBuffer->Data.data();
+}
+
+void NullRenderDevice::UnmapBuffer(RenderBuffer*)
+{
+}
+
+IFrameFence* NullRenderDevice::CreateFrameFence()
+{
+	FenceCount++;
+	return new NullFrameFence();
+}
+
+void NullRenderDevice::ReleaseFrameFence(IFrameFence* fence)
+{
+	if (fence == nullptr)
+	{
+		return;
+	}
+	FenceCount--;
+	delete fence;
+}
+
+RenderEffect* NullRenderDevice::CreateEffect(const char* fileName)
+{
+	Effect* effect = new Effect();
+	effect->FileName = fileName;
+	EffectCount++;
+	return reinterpret_cast<RenderEffect*>(effect);
+}
+
+void NullRenderDevice::ReleaseEffect(RenderEffect* effect)
+{
+	if (effect == nullptr)
+	{
+		return;
+	}
+	EffectCount--;
+	delete reinterpret_cast<Effect*>(effect);
+}
+
+uint32_t NullRenderDevice::PassCount(RenderEffect*, const char*)
+{
+	// Every technique in the book's effects has one pass
+	return 1;
+}
+
+RenderPass* NullRenderDevice::FindPass(RenderEffect* effect, const char* technique, uint32_t pass)
+{
+	// The same technique and index always give the same pass, like the effects framework
+	Effect* nullEffect = reinterpret_cast<Effect*>(effect);
+	for (size_t i = 0; i < nullEffect->Passes.size(); i++)
+	{
+		Pass* existing = nullEffect->Passes[i].get();
+		if (existing->Technique == technique && existing->Index == pass)
+		{
+			return reinterpret_cast<RenderPass*>(existing);
+		}
+	}
+
+	Pass* created = new Pass();
+	created->Owner = nullEffect;
+	created->Technique = technique;
+	created->Index = pass;
+	nullEffect->Passes.push_back(std::unique_ptr<Pass>(created));
+	return reinterpret_cast<RenderPass*>(created);
+}
+
+RenderConstant* NullRenderDevice::FindConstant(RenderEffect* effect, const char* name)
+{
+	Effect* nullEffect = reinterpret_cast<Effect*>(effect);
+	for (size_t i = 0; i < nullEffect->Constants.size(); i++)
+	{
+		if (nullEffect->Constants[i]->Name == name)
+		{
+			return reinterpret_cast<RenderConstant*>(nullEffect->Constants[i].get());
+		}
+	}
+
+	Constant* created = new Constant();
+	created->Owner = nullEffect;
+	created->Name = name;
+	nullEffect->Constants.push_back(std::unique_ptr<Constant>(created));
+	return reinterpret_cast<RenderConstant*>(created);
+}
+
+RenderInputLayout* NullRenderDevice::CreateInputLayout(const std::vector<StreamElement>& elements, RenderPass*)
+{
+	InputLayout* layout = new InputLayout();
+	layout->Elements = elements;
+	InputLayoutCount++;
+	return reinterpret_cast<RenderInputLayout*>(layout);
+}
+
+void NullRenderDevice::ReleaseInputLayout(RenderInputLayout* layout)
+{
+	if (layout == nullptr)
+	{
+		return;
+	}
+	InputLayoutCount--;
+	delete reinterpret_cast<InputLayout*>(layout);
+}
@@ -0,0 +1,108 @@
+#ifndef NULLRENDERDEVICE_H
+#define NULLRENDERDEVICE_H
+
+#include "RenderDevice.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Fence of a device without a GPU, a frame is finished once signalled
+class NullFrameFence : public IFrameFence
+{
+public:
+	NullFrameFence() : mCompleted(0) {}
+
+	void Signal(uint64_t frame) { mCompleted = frame; }
+	uint64_t CompletedFrame() { return mCompleted; }
+	void Wait(uint64_t) {}
+
+private:
+	uint64_t mCompleted;
+};
+
+// Device without a GPU. Resources are plain CPU objects that keep what
+// they were created with, draws only update the counters of the context.
+// Used to run the scenes headless.
+class NullRenderDevice : public IRenderDevice
+{
+public:
+	struct Buffer
+	{
+		BufferDesc Desc;
+		std::vector<uint8_t> Data;
+	};
+
+	struct Effect;
+
+	struct Pass
+	{
+		const Effect* Owner;
+		std::string Technique;
+		uint32_t Index;
+	};
+
+	struct Constant
+	{
+		const Effect* Owner;
+		std::string Name;
+	};
+
+	struct Effect
+	{
+		std::string FileName;
+		std::vector<std::unique_ptr<Pass>> Passes;
+		std::vector<std::unique_ptr<Constant>> Constants;
+	};
+
+	struct InputLayout
+	{
+		std::vector<StreamElement> Elements;
+	};
+
+	NullRenderDevice();
+	~NullRenderDevice();
+
+	IDeviceContext& ImmediateContext() { return mContext; }
+	NullDeviceContext& Context() { return mContext; }
+
+	RenderBuffer* CreateBuffer(const BufferDesc& desc, const void* initialData);
+	void ReleaseBuffer(RenderBuffer* buffer);
+
+	// Maps the buffer's own data, a draw reads it when it is issued
+	void* MapBuffer(RenderBuffer* buffer, MapMode mode);
+	void UnmapBuffer(RenderBuffer* buffer);
+
+	// Nothing runs later, a frame is finished when it is signalled
+	IFrameFence* CreateFrameFence();
+	void ReleaseFrameFence(IFrameFence* fence);
+
+	RenderEffect* CreateEffect(const char* fileName);
+	void ReleaseEffect(RenderEffect* effect);
+
+	uint32_t PassCount(RenderEffect* effect, const char* technique);
+	RenderPass* FindPass(RenderEffect* effect, const char* technique, uint32_t pass);
+	RenderConstant* FindConstant(RenderEffect* effect, const char* name);
+
+	RenderInputLayout* CreateInputLayout(const std::vector<StreamElement>& elements, RenderPass* pass);
+	void ReleaseInputLayout(RenderInputLayout* layout);
+
+	static const Buffer* ToBuffer(RenderBuffer* buffer) { return reinterpret_cast<const Buffer*>(buffer); }
+	static const Pass* ToPass(RenderPass* pass) { return reinterpret_cast<const Pass*>(pass); }
+	static const Constant* ToConstant(RenderConstant* constant) { return reinterpret_cast<const Constant*>(constant); }
+	static const InputLayout* ToInputLayout(RenderInputLayout* layout) { return reinterpret_cast<const InputLayout*>(layout); }
+
+	// Live objects and the bytes of the live buffers
+	uint32_t BufferCount;
+	uint64_t BufferBytes;
+	uint32_t EffectCount;
+	uint32_t InputLayoutCount;
+	uint32_t FenceCount;
+	uint64_t MapCount;
+	uint64_t DiscardCount;
+
+private:
+	NullDeviceContext mContext;
+};
+
+#endif // NULLRENDERDEVICE_H
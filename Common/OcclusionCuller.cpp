@@ -0,0 +1,335 @@
+#include "OcclusionCuller.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OCCLUSIONCULLER_SSE2
+#include <emmintrin.h>
+#endif
+
+Bounds ComputeBounds(const std::vector<Float3>& positions)
+{
+	Bounds bounds = { Float3(FLT_MAX, FLT_MAX, FLT_MAX), Float3(-FLT_MAX, -FLT_MAX, -FLT_MAX) };
+	for (size_t i = 0; i < positions.size(); i++)
+	{
+		const Float3& p = positions[i];
+		bounds.Min = Float3(std::min(bounds.Min.x, p.x), std::min(bounds.Min.y, p.y), std::min(bounds.Min.z, p.z));
+		bounds.Max = Float3(std::max(bounds.Max.x, p.x), std::max(bounds.Max.y, p.y), std::max(bounds.Max.z, p.z));
+	}
+	return bounds;
+}
+
+OcclusionCuller::OcclusionCuller(uint32_t width, uint32_t height)
+	: mWidth(width)
+	, mHeight(height)
+	, mStride((width + 3) & ~3u)
+	, mViewProj(MatrixIdentity())
+{
+	ResetStats();
+	mDepth.assign(mStride * mHeight, 1.0f);
+
+	Level level = { mWidth, mHeight, std::vector<float>(), std::vector<float>() };
+	mLevels.push_back(level);
+	while (level.Width > 1 || level.Height > 1)
+	{
+		level.Width = (level.Width + 1) / 2;
+		level.Height = (level.Height + 1) / 2;
+		level.Min.assign(level.Width * level.Height, 1.0f);
+		level.Max.assign(level.Width * level.Height, 1.0f);
+		mLevels.push_back(level);
+	}
+}
+
+void OcclusionCuller::ResetStats()
+{
+	mStats = OcclusionStats();
+}
+
+void OcclusionCuller::BeginFrame(const Float4x4& viewProj)
+{
+	mViewProj = viewProj;
+	std::fill(mDepth.begin(), mDepth.end(), 1.0f);
+}
+
+void OcclusionCuller::AddOccluder(const OccluderMesh& mesh, const Float4x4& world)
+{
+	Float4x4 worldViewProj = MatrixMultiply(world, mViewProj);
+
+	mClipPositions.resize(mesh.Positions.size());
+	for (size_t i = 0; i < mesh.Positions.size(); i++)
+	{
+		const Float3& p = mesh.Positions[i];
+		mClipPositions[i] = Transform(Float4(p.x, p.y, p.z, 1.0f), worldViewProj);
+	}
+
+	for (size_t i = 0; i + 2 < mesh.Indices.size(); i += 3)
+	{
+		RasterizeTriangle(mClipPositions[mesh.Indices[i]], mClipPositions[mesh.Indices[i + 1]], mClipPositions[mesh.Indices[i + 2]]);
+	}
+}
+
+void OcclusionCuller::RasterizeTriangle(const Float4& v0, const Float4& v1, const Float4& v2)
+{
+	const Float4* vertices[3] = { &v0, &v1, &v2 };
+	float x[3];
+	float y[3];
+	float z[3];
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		// Clipping would only add occlusion, dropping the triangle is conservative
+		const Float4& position = *vertices[i];
+		if (!(position.z >= 0.0f) || !(position.w > 0.0f))
+		{
+			return;
+		}
+
+		float invW = 1.0f / position.w;
+		x[i] = (position.x * invW * 0.5f + 0.5f) * mWidth;
+		y[i] = (0.5f - position.y * invW * 0.5f) * mHeight;
+		z[i] = position.z * invW;
+	}
+
+	// Clockwise triangles on screen are the front faces
+	float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+	if (!(area > 0.0f))
+	{
+		return;
+	}
+
+	// Pixels whose center is inside the bounds
+	float minX = std::min(x[0], std::min(x[1], x[2]));
+	float maxX = std::max(x[0], std::max(x[1], x[2]));
+	float minY = std::min(y[0], std::min(y[1], y[2]));
+	float maxY = std::max(y[0], std::max(y[1], y[2]));
+	int32_t firstX = static_cast<int32_t>(std::ceil(Clamp(minX - 0.5f, 0.0f, static_cast<float>(mWidth))));
+	int32_t lastX = static_cast<int32_t>(std::floor(Clamp(maxX - 0.5f, -1.0f, static_cast<float>(mWidth - 1))));
+	int32_t firstY = static_cast<int32_t>(std::ceil(Clamp(minY - 0.5f, 0.0f, static_cast<float>(mHeight))));
+	int32_t lastY = static_cast<int32_t>(std::floor(Clamp(maxY - 0.5f, -1.0f, static_cast<float>(mHeight - 1))));
+	if (firstX > lastX || firstY > lastY)
+	{
+		return;
+	}
+	mStats.OccluderTriangles++;
+
+	// Edge i is opposite vertex i and positive inside
+	float edgeA[3];
+	float edgeB[3];
+	float edgeC[3];
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		uint32_t from = (i + 1) % 3;
+		uint32_t to = (i + 2) % 3;
+		edgeA[i] = y[from] - y[to];
+		edgeB[i] = x[to] - x[from];
+		edgeC[i] = -(edgeA[i] * x[from] + edgeB[i] * y[from]);
+	}
+
+	// z / w is linear on screen, depth = depthA * x + depthB * y + depthC
+	float depthA = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+	float depthB = ((z[2] - z[0]) * (x[1] - x[0]) - (z[1] - z[0]) * (x[2] - x[0])) / area;
+	float depthC = z[0] - depthA * x[0] - depthB * y[0];
+
+#ifdef OCCLUSIONCULLER_SSE2
+	// Four pixel groups start at a multiple of four, the stride keeps the last one in the row
+	int32_t groupX = firstX & ~3;
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 laneOffsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+	const __m128 a0 = _mm_set1_ps(edgeA[0]);
+	const __m128 a1 = _mm_set1_ps(edgeA[1]);
+	const __m128 a2 = _mm_set1_ps(edgeA[2]);
+	const __m128 depthStepX = _mm_set1_ps(depthA);
+
+	for (int32_t py = firstY; py <= lastY; py++)
+	{
+		float centerY = py + 0.5f;
+		const __m128 row0 = _mm_set1_ps(edgeB[0] * centerY + edgeC[0]);
+		const __m128 row1 = _mm_set1_ps(edgeB[1] * centerY + edgeC[1]);
+		const __m128 row2 = _mm_set1_ps(edgeB[2] * centerY + edgeC[2]);
+		const __m128 rowDepth = _mm_set1_ps(depthB * centerY + depthC);
+
+		float* depthRow = &mDepth[py * mStride];
+		for (int32_t px = groupX; px <= lastX; px += 4)
+		{
+			__m128 centerX = _mm_add_ps(_mm_set1_ps(static_cast<float>(px)), laneOffsets);
+			__m128 inside = _mm_and_ps(
+				_mm_and_ps(
+					_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a0, centerX), row0), zero),
+					_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a1, centerX), row1), zero)),
+				_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a2, centerX), row2), zero));
+			if (_mm_movemask_ps(inside) == 0)
+			{
+				continue;
+			}
+
+			__m128 depth = _mm_add_ps(_mm_mul_ps(depthStepX, centerX), rowDepth);
+			__m128 previous = _mm_loadu_ps(depthRow + px);
+			__m128 nearest = _mm_min_ps(previous, depth);
+			_mm_storeu_ps(depthRow + px, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, previous)));
+		}
+	}
+#else
+	for (int32_t py = firstY; py <= lastY; py++)
+	{
+		float centerY = py + 0.5f;
+		float* depthRow = &mDepth[py * mStride];
+		for (int32_t px = firstX; px <= lastX; px++)
+		{
+			float centerX = px + 0.5f;
+			if (edgeA[0] * centerX + (edgeB[0] * centerY + edgeC[0]) >= 0.0f
+				&& edgeA[1] * centerX + (edgeB[1] * centerY + edgeC[1]) >= 0.0f
+				&& edgeA[2] * centerX + (edgeB[2] * centerY + edgeC[2]) >= 0.0f)
+			{
+				float depth = depthA * centerX + (depthB * centerY + depthC);
+				depthRow[px] = std::min(depthRow[px], depth);
+			}
+		}
+	}
+#endif
+}
+
+void OcclusionCuller::BuildHierarchy()
+{
+	for (size_t level = 1; level < mLevels.size(); level++)
+	{
+		const Level& below = mLevels[level - 1];
+		Level& current = mLevels[level];
+
+		// Level 0 keeps a single value per pixel
+		const float* belowMin = level == 1 ? mDepth.data() : below.Min.data();
+		const float* belowMax = level == 1 ? mDepth.data() : below.Max.data();
+		uint32_t belowStride = level == 1 ? mStride : below.Width;
+
+		for (uint32_t y = 0; y < current.Height; y++)
+		{
+			uint32_t y0 = 2 * y;
+			uint32_t y1 = std::min(y0 + 1, below.Height - 1);
+			for (uint32_t x = 0; x < current.Width; x++)
+			{
+				uint32_t x0 = 2 * x;
+				uint32_t x1 = std::min(x0 + 1, below.Width - 1);
+
+				current.Min[y * current.Width + x] = std::min(
+					std::min(belowMin[y0 * belowStride + x0], belowMin[y0 * belowStride + x1]),
+					std::min(belowMin[y1 * belowStride + x0], belowMin[y1 * belowStride + x1]));
+				current.Max[y * current.Width + x] = std::max(
+					std::max(belowMax[y0 * belowStride + x0], belowMax[y0 * belowStride + x1]),
+					std::max(belowMax[y1 * belowStride + x0], belowMax[y1 * belowStride + x1]));
+			}
+		}
+	}
+}
+
+bool OcclusionCuller::IsVisible(const Bounds& bounds, const Float4x4& world)
+{
+	mStats.ObjectsTested++;
+
+	Float4x4 worldViewProj = MatrixMultiply(world, mViewProj);
+
+	float minX = FLT_MAX;
+	float maxX = -FLT_MAX;
+	float minY = FLT_MAX;
+	float maxY = -FLT_MAX;
+	float nearestDepth = FLT_MAX;
+	for (uint32_t corner = 0; corner < 8; corner++)
+	{
+		Float4 p(
+			(corner & 1) != 0 ? bounds.Max.x : bounds.Min.x,
+			(corner & 2) != 0 ? bounds.Max.y : bounds.Min.y,
+			(corner & 4) != 0 ? bounds.Max.z : bounds.Min.z,
+			1.0f);
+		Float4 clip = Transform(p, worldViewProj);
+		if (!(clip.z >= 0.0f) || !(clip.w > 0.0f))
+		{
+			// Reaches in front of the near plane
+			return true;
+		}
+
+		float invW = 1.0f / clip.w;
+		float x = (clip.x * invW * 0.5f + 0.5f) * mWidth;
+		float y = (0.5f - clip.y * invW * 0.5f) * mHeight;
+		minX = std::min(minX, x);
+		maxX = std::max(maxX, x);
+		minY = std::min(minY, y);
+		maxY = std::max(maxY, y);
+		nearestDepth = std::min(nearestDepth, clip.z * invW);
+	}
+
+	if (maxX < 0.0f || minX >= mWidth || maxY < 0.0f || minY >= mHeight)
+	{
+		mStats.ObjectsOutsideView++;
+		return false;
+	}
+
+	// Every pixel the box touches, inclusive
+	int32_t rect[4] =
+	{
+		static_cast<int32_t>(std::max(minX, 0.0f)),
+		static_cast<int32_t>(std::max(minY, 0.0f)),
+		static_cast<int32_t>(std::min(maxX, static_cast<float>(mWidth - 1))),
+		static_cast<int32_t>(std::min(maxY, static_cast<float>(mHeight - 1)))
+	};
+
+	// Start from the first level where the box covers at most 2x2 texels
+	uint32_t level = 0;
+	while (level + 1 < mLevels.size()
+		&& ((rect[2] >> level) - (rect[0] >> level) > 1 || (rect[3] >> level) - (rect[1] >> level) > 1))
+	{
+		level++;
+	}
+
+	for (int32_t y = rect[1] >> level; y <= rect[3] >> level; y++)
+	{
+		for (int32_t x = rect[0] >> level; x <= rect[2] >> level; x++)
+		{
+			if (IsRegionVisible(level, x, y, rect, nearestDepth))
+			{
+				return true;
+			}
+		}
+	}
+
+	mStats.ObjectsOccluded++;
+	return false;
+}
+
+bool OcclusionCuller::IsRegionVisible(uint32_t level, uint32_t x, uint32_t y, const int32_t rect[4], float nearestDepth) const
+{
+	if (level == 0)
+	{
+		return nearestDepth <= mDepth[y * mStride + x];
+	}
+
+	const Level& current = mLevels[level];
+	uint32_t index = y * current.Width + x;
+	if (nearestDepth > current.Max[index])
+	{
+		// Behind everything in the texel
+		return false;
+	}
+	if (nearestDepth <= current.Min[index])
+	{
+		// In front of everything, and the texel overlaps the box
+		return true;
+	}
+
+	// Children of the texel that overlap the box
+	uint32_t below = level - 1;
+	uint32_t firstX = std::max(2 * x, static_cast<uint32_t>(rect[0]) >> below);
+	uint32_t lastX = std::min(2 * x + 1, static_cast<uint32_t>(rect[2]) >> below);
+	uint32_t firstY = std::max(2 * y, static_cast<uint32_t>(rect[1]) >> below);
+	uint32_t lastY = std::min(2 * y + 1, static_cast<uint32_t>(rect[3]) >> below);
+	for (uint32_t childY = firstY; childY <= lastY; childY++)
+	{
+		for (uint32_t childX = firstX; childX <= lastX; childX++)
+		{
+			if (IsRegionVisible(below, childX, childY, rect, nearestDepth))
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
@@ -0,0 +1,95 @@
+#ifndef OCCLUSIONCULLER_H
+#define OCCLUSIONCULLER_H
+
+#include "MathTypes.h"
+
+#include <cstdint>
+#include <vector>
+
+// Axis aligned box in model space
+struct Bounds
+{
+	Float3 Min;
+	Float3 Max;
+};
+
+Bounds ComputeBounds(const std::vector<Float3>& positions);
+
+// Simplified triangle list of an occluder. It should lie inside the mesh it
+// stands for, a coarser mesh that sticks out hides too much.
+struct OccluderMesh
+{
+	std::vector<Float3> Positions;
+	std::vector<uint32_t> Indices;
+};
+
+struct OcclusionStats
+{
+	uint64_t OccluderTriangles;		// Front facing and in front of the near plane
+	uint64_t ObjectsTested;
+	uint64_t ObjectsOccluded;
+	uint64_t ObjectsOutsideView;	// Projected outside the screen
+};
+
+// Coarse CPU depth buffer for culling objects before they are submitted.
+// A frame rasterizes the occluders with SSE2 into a small depth buffer,
+// builds a min/max hierarchy over it and then tests object bounds against
+// the hierarchy:
+//
+//	culler.BeginFrame(viewProj);
+//	culler.AddOccluder(wall, wallWorld);
+//	culler.BuildHierarchy();
+//	if (culler.IsVisible(bounds, world)) ...
+//
+// The test is conservative. Occluder triangles that cross the near plane
+// are dropped and bounds that do are visible.
+class OcclusionCuller
+{
+public:
+	OcclusionCuller(uint32_t width, uint32_t height);
+
+	void BeginFrame(const Float4x4& viewProj);
+	void AddOccluder(const OccluderMesh& mesh, const Float4x4& world);
+	// Call after the last occluder and before the first test
+	void BuildHierarchy();
+
+	// False if the box is behind the occluders or outside the screen
+	bool IsVisible(const Bounds& bounds, const Float4x4& world);
+
+	uint32_t Width() const { return mWidth; }
+	uint32_t Height() const { return mHeight; }
+	// Nearest occluder depth, 1 where nothing was drawn
+	float Depth(uint32_t x, uint32_t y) const { return mDepth[y * mStride + x]; }
+
+	const OcclusionStats& Stats() const { return mStats; }
+	void ResetStats();
+
+private:
+	// Every level halves the one below, level 0 is the depth buffer itself
+	struct Level
+	{
+		uint32_t Width;
+		uint32_t Height;
+		std::vector<float> Min;
+		std::vector<float> Max;
+	};
+
+	void RasterizeTriangle(const Float4& v0, const Float4& v1, const Float4& v2);
+
+	// Tests texel (x, y) of 'level' against the pixel rectangle
+	bool IsRegionVisible(uint32_t level, uint32_t x, uint32_t y, const int32_t rect[4], float nearestDepth) const;
+
+	uint32_t mWidth;
+	uint32_t mHeight;
+	uint32_t mStride;	// Width rounded up to four pixels
+
+	Float4x4 mViewProj;
+	std::vector<float> mDepth;
+	std::vector<Level> mLevels;	// Level 0 is empty, mDepth has its values
+
+	std::vector<Float4> mClipPositions;
+
+	OcclusionStats mStats;
+};
+
+#endif // OCCLUSIONCULLER_H
@@ -0,0 +1,96 @@
+#ifndef RENDERDEVICE_H
+#define RENDERDEVICE_H
+
+#include "RenderTypes.h"
+#include "DeviceContext.h"
+#include "VertexStreams.h"
+
+#include <cstdint>
+#include <vector>
+
+enum class BufferBinding : uint8_t
+{
+	Vertex,
+	Index
+};
+
+enum class BufferUsage : uint8_t
+{
+	Immutable,	// Filled at creation, never written again
+	Dynamic		// Rewritten by the CPU
+};
+
+// How a dynamic buffer is mapped, as D3D11_MAP_WRITE_DISCARD and
+// D3D11_MAP_WRITE_NO_OVERWRITE
+enum class MapMode : uint8_t
+{
+	Discard,		// The old contents are gone, the GPU may still read them
+	NoOverwrite		// Keeps the contents, only bytes no draw in flight reads are written
+};
+
+struct BufferDesc
+{
+	BufferBinding Binding;
+	BufferUsage Usage;
+	uint32_t ByteWidth;
+	const char* Owner;	// Subsystem the memory is accounted to, a literal or null
+};
+
+// Tells when the GPU has finished a frame. Signal is called after the
+// frame's commands were submitted, frame numbers only grow.
+class IFrameFence
+{
+public:
+	virtual ~IFrameFence() {}
+
+	virtual void Signal(uint64_t frame) = 0;
+	// The newest frame the GPU has finished, 0 for none
+	virtual uint64_t CompletedFrame() = 0;
+	// Blocks until 'frame' is finished
+	virtual void Wait(uint64_t frame) = 0;
+};
+
+// Creates the GPU objects of a scene. The D3D11 backend creates real
+// resources, the null backend only records what was asked for, so scenes
+// written against this interface run on machines without a GPU.
+class IRenderDevice
+{
+public:
+	virtual ~IRenderDevice() {}
+
+	virtual IDeviceContext& ImmediateContext() = 0;
+
+	// initialData holds desc.ByteWidth bytes, it may be null for dynamic buffers
+	virtual RenderBuffer* CreateBuffer(const BufferDesc& desc, const void* initialData) = 0;
+	virtual void ReleaseBuffer(RenderBuffer* buffer) = 0;
+
+	// Dynamic buffers only. The pointer is valid until UnmapBuffer, which
+	// must come before a draw reads the buffer.
+	virtual void* MapBuffer(RenderBuffer* buffer, MapMode mode) = 0;
+	virtual void UnmapBuffer(RenderBuffer* buffer) = 0;
+
+	virtual IFrameFence* CreateFrameFence() = 0;
+	virtual void ReleaseFrameFence(IFrameFence* fence) = 0;
+
+	// Returns null and reports the error if the effect can not be compiled
+	virtual RenderEffect* CreateEffect(const char* fileName) = 0;
+	virtual void ReleaseEffect(RenderEffect* effect) = 0;
+
+	// Passes and constants belong to the effect and are not released
+	virtual uint32_t PassCount(RenderEffect* effect, const char* technique) = 0;
+	virtual RenderPass* FindPass(RenderEffect* effect, const char* technique, uint32_t pass) = 0;
+	virtual RenderConstant* FindConstant(RenderEffect* effect, const char* name) = 0;
+
+	// The pass supplies the input signature the layout is validated against
+	virtual RenderInputLayout* CreateInputLayout(const std::vector<StreamElement>& elements, RenderPass* pass) = 0;
+	virtual void ReleaseInputLayout(RenderInputLayout* layout) = 0;
+};
+
+// Immutable buffer filled from 'data'
+inline RenderBuffer* CreateImmutableBuffer(IRenderDevice& device, BufferBinding binding, const void* data, uint32_t byteWidth, const char* owner = nullptr)
+{
+	BufferDesc desc = { binding, BufferUsage::Immutable, byteWidth, owner };
+	return device.CreateBuffer(desc, data);
+}
+
+#endif // RENDERDEVICE_H
@@ -0,0 +1,158 @@
+#include "RenderResources.h"
+#include "Log.h"
+
+RenderResources::RenderResources(IRenderDevice& device, uint32_t framesInFlight)
+	: mDevice(device)
+	, mFramesInFlight(framesInFlight)
+	, mFrame(0)
+	, mReleased(0)
+{
+}
+
+RenderResources::~RenderResources()
+{
+	Flush();
+}
+
+BufferHandle RenderResources::CreateBuffer(const BufferDesc& desc, const void* initialData)
+{
+	Entry<RenderBuffer> entry = { mDevice.CreateBuffer(desc, initialData), desc.Owner != nullptr ? desc.Owner : "Buffer" };
+	return mBuffers.Create(entry);
+}
+
+EffectHandle RenderResources::CreateEffect(const char* fileName)
+{
+	Entry<RenderEffect> entry = { mDevice.CreateEffect(fileName), fileName };
+	return mEffects.Create(entry);
+}
+
+InputLayoutHandle RenderResources::CreateInputLayout(const std::vector<StreamElement>& elements, RenderPass* pass, const char* name)
+{
+	Entry<RenderInputLayout> entry = { mDevice.CreateInputLayout(elements, pass), name };
+	return mInputLayouts.Create(entry);
+}
+
+RenderBuffer* RenderResources::Buffer(BufferHandle handle) const
+{
+	const Entry<RenderBuffer>* entry = mBuffers.Get(handle);
+	return entry != nullptr ? entry->Object : nullptr;
+}
+
+RenderEffect* RenderResources::Effect(EffectHandle handle) const
+{
+	const Entry<RenderEffect>* entry = mEffects.Get(handle);
+	return entry != nullptr ? entry->Object : nullptr;
+}
+
+RenderInputLayout* RenderResources::InputLayout(InputLayoutHandle handle) const
+{
+	const Entry<RenderInputLayout>* entry = mInputLayouts.Get(handle);
+	return entry != nullptr ? entry->Object : nullptr;
+}
+
+bool RenderResources::Destroy(BufferHandle handle)
+{
+	Entry<RenderBuffer> entry;
+	if (!mBuffers.Destroy(handle, entry))
+	{
+		return false;
+	}
+	Queue(Kind::Buffer, entry.Object);
+	return true;
+}
+
+bool RenderResources::Destroy(EffectHandle handle)
+{
+	Entry<RenderEffect> entry;
+	if (!mEffects.Destroy(handle, entry))
+	{
+		return false;
+	}
+	Queue(Kind::Effect, entry.Object);
+	return true;
+}
+
+bool RenderResources::Destroy(InputLayoutHandle handle)
+{
+	Entry<RenderInputLayout> entry;
+	if (!mInputLayouts.Destroy(handle, entry))
+	{
+		return false;
+	}
+	Queue(Kind::InputLayout, entry.Object);
+	return true;
+}
+
+void RenderResources::EndFrame()
+{
+	mFrame++;
+
+	// Destroyed during frame F, the GPU is done with it once frame
+	// F + framesInFlight has ended
+	size_t count = 0;
+	while (count < mPending.size() && mPending[count].Frame + mFramesInFlight <= mFrame)
+	{
+		count++;
+	}
+	Release(count);
+}
+
+void RenderResources::Flush()
+{
+	Release(mPending.size());
+}
+
+uint32_t RenderResources::LiveCount() const
+{
+	return mBuffers.LiveCount() + mEffects.LiveCount() + mInputLayouts.LiveCount();
+}
+
+uint32_t RenderResources::ReportLeaks() const
+{
+	mBuffers.ForEach([](BufferHandle handle, const Entry<RenderBuffer>& entry)
+	{
+		LogMessage("Leaked buffer " + std::to_string(handle.Index) + " of " + entry.Name + "\n");
+	});
+	mEffects.ForEach([](EffectHandle handle, const Entry<RenderEffect>& entry)
+	{
+		LogMessage("Leaked effect " + std::to_string(handle.Index) + " " + entry.Name + "\n");
+	});
+	mInputLayouts.ForEach([](InputLayoutHandle handle, const Entry<RenderInputLayout>& entry)
+	{
+		LogMessage("Leaked input layout " + std::to_string(handle.Index) + " " + entry.Name + "\n");
+	});
+	return LiveCount();
+}
+
+void RenderResources::Queue(Kind type, void* object)
+{
+	// A failed creation left nothing to release
+	if (object == nullptr)
+	{
+		return;
+	}
+	PendingRelease pending = { type, object, mFrame };
+	mPending.push_back(pending);
+}
+
+void RenderResources::Release(size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		const PendingRelease& pending = mPending[i];
+		switch (pending.Type)
+		{
+		case Kind::Buffer:
+			mDevice.ReleaseBuffer(static_cast<RenderBuffer*>(pending.Object));
+			break;
+		case Kind::Effect:
+			mDevice.ReleaseEffect(static_cast<RenderEffect*>(pending.Object));
+			break;
+		case Kind::InputLayout:
+			mDevice.ReleaseInputLayout(static_cast<RenderInputLayout*>(pending.Object));
+			break;
+		}
+	}
+	mPending.erase(mPending.begin(), mPending.begin() + count);
+	mReleased += count;
+}
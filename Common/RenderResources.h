@@ -0,0 +1,98 @@
+#ifndef RENDERRESOURCES_H
+#define RENDERRESOURCES_H
+
+#include "RenderDevice.h"
+#include "ResourceTable.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+typedef ResourceHandle<RenderBuffer> BufferHandle;
+typedef ResourceHandle<RenderEffect> EffectHandle;
+typedef ResourceHandle<RenderInputLayout> InputLayoutHandle;
+
+// The objects of an IRenderDevice behind generational handles. Destroy
+// stops a handle from resolving at once but only queues the object: the
+// GPU may still read it for the frames in flight. EndFrame releases, in one
+// batch, what was destroyed framesInFlight frames before, so a scene can
+// unload and reload while it draws.
+//
+// Whatever is still live when the owner shuts down is a leak, ReportLeaks
+// logs each one with its name.
+class RenderResources
+{
+public:
+	// The swap chain's default maximum frame latency
+	static const uint32_t DefaultFramesInFlight = 3;
+
+	explicit RenderResources(IRenderDevice& device, uint32_t framesInFlight = DefaultFramesInFlight);
+	// Flushes, live objects are left alone
+	~RenderResources();
+
+	BufferHandle CreateBuffer(const BufferDesc& desc, const void* initialData);
+	EffectHandle CreateEffect(const char* fileName);
+	InputLayoutHandle CreateInputLayout(const std::vector<StreamElement>& elements, RenderPass* pass, const char* name);
+
+	// Null for a stale or null handle, and when creating the object failed
+	RenderBuffer* Buffer(BufferHandle handle) const;
+	RenderEffect* Effect(EffectHandle handle) const;
+	RenderInputLayout* InputLayout(InputLayoutHandle handle) const;
+
+	// False for a stale or null handle
+	bool Destroy(BufferHandle handle);
+	bool Destroy(EffectHandle handle);
+	bool Destroy(InputLayoutHandle handle);
+
+	// Call once per frame after presenting
+	void EndFrame();
+	// Releases everything destroyed so far, once the GPU is idle
+	void Flush();
+
+	uint64_t Frame() const { return mFrame; }
+	uint32_t LiveCount() const;
+	uint32_t PendingCount() const { return static_cast<uint32_t>(mPending.size()); }
+	uint64_t ReleasedCount() const { return mReleased; }
+
+	// Logs every live object, returns how many there are
+	uint32_t ReportLeaks() const;
+
+private:
+	enum class Kind : uint8_t
+	{
+		Buffer,
+		Effect,
+		InputLayout
+	};
+
+	template<typename T>
+	struct Entry
+	{
+		T* Object;
+		std::string Name;
+	};
+
+	struct PendingRelease
+	{
+		Kind Type;
+		void* Object;
+		uint64_t Frame;		// Destroyed during this frame
+	};
+
+	RenderResources(const RenderResources&);
+	RenderResources& operator=(const RenderResources&);
+
+	void Queue(Kind type, void* object);
+	void Release(size_t count);
+
+	IRenderDevice& mDevice;
+	uint32_t mFramesInFlight;
+	uint64_t mFrame;
+	uint64_t mReleased;
+	ResourceTable<RenderBuffer, Entry<RenderBuffer>> mBuffers;
+	ResourceTable<RenderEffect, Entry<RenderEffect>> mEffects;
+	ResourceTable<RenderInputLayout, Entry<RenderInputLayout>> mInputLayouts;
+	std::vector<PendingRelease> mPending;	// In the order destroyed, so by frame
+};
+
+#endif // RENDERRESOURCES_H
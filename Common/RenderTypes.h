@@ -0,0 +1,31 @@
+#ifndef RENDERTYPES_H
+#define RENDERTYPES_H
+
+#include <cstdint>
+
+// Backend neutral names for GPU objects. They are never defined, a backend
+// casts its own objects to and from them (the D3D11 backend uses
+// ID3D11Buffer*, ID3D11InputLayout*, ID3DX11Effect*, ID3DX11EffectPass* and
+// ID3DX11EffectVariable*).
+struct RenderBuffer;
+struct RenderInputLayout;
+struct RenderEffect;
+struct RenderPass;
+struct RenderConstant;
+
+enum class PrimitiveTopology : uint8_t
+{
+	PointList,
+	LineList,
+	LineStrip,
+	TriangleList,
+	TriangleStrip
+};
+
+enum class IndexFormat : uint8_t
+{
+	UInt16,
+	UInt32
+};
+
+#endif // RENDERTYPES_H
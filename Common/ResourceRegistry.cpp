@@ -0,0 +1,168 @@
+#include "ResourceRegistry.h"
+#include "Log.h"
+
+#include <cassert>
+#include <cstdio>
+
+namespace
+{
+	const char* const unassigned = "Unassigned";
+
+	ResourceCategoryStats MakeCategory(const std::string& name)
+	{
+		ResourceCategoryStats category = { name, 0, 0, 0, 0, 0 };
+		return category;
+	}
+}
+
+ResourceRegistry::ResourceRegistry()
+	: mTotal(MakeCategory("Total"))
+	, mBudgetWarnings(0)
+{
+	mBindings[static_cast<size_t>(BufferBinding::Vertex)] = MakeCategory("Vertex");
+	mBindings[static_cast<size_t>(BufferBinding::Index)] = MakeCategory("Index");
+	mUsages[static_cast<size_t>(BufferUsage::Immutable)] = MakeCategory("Immutable");
+	mUsages[static_cast<size_t>(BufferUsage::Dynamic)] = MakeCategory("Dynamic");
+}
+
+void ResourceRegistry::SetBudget(const std::string& owner, uint64_t bytes)
+{
+	std::map<std::string, ResourceCategoryStats>::iterator found = mOwners.find(owner);
+	if (found == mOwners.end())
+	{
+		found = mOwners.insert(std::make_pair(owner, MakeCategory(owner))).first;
+	}
+	found->second.Budget = bytes;
+}
+
+void ResourceRegistry::SetTotalBudget(uint64_t bytes)
+{
+	mTotal.Budget = bytes;
+}
+
+void ResourceRegistry::AddBuffer(const RenderBuffer* buffer, const BufferDesc& desc)
+{
+	if (buffer == nullptr)
+	{
+		return;
+	}
+
+	Record record = { desc.Owner != nullptr ? desc.Owner : unassigned, desc.Binding, desc.Usage, desc.ByteWidth };
+	assert(mBuffers.find(buffer) == mBuffers.end() && "Buffer added twice");
+	mBuffers[buffer] = record;
+
+	std::map<std::string, ResourceCategoryStats>::iterator owner = mOwners.find(record.Owner);
+	if (owner == mOwners.end())
+	{
+		owner = mOwners.insert(std::make_pair(record.Owner, MakeCategory(record.Owner))).first;
+	}
+	Add(owner->second, record.ByteWidth);
+	Add(mTotal, record.ByteWidth);
+	Add(mBindings[static_cast<size_t>(record.Binding)], record.ByteWidth);
+	Add(mUsages[static_cast<size_t>(record.Usage)], record.ByteWidth);
+}
+
+void ResourceRegistry::RemoveBuffer(const RenderBuffer* buffer)
+{
+	std::unordered_map<const RenderBuffer*, Record>::iterator found = mBuffers.find(buffer);
+	if (found == mBuffers.end())
+	{
+		return;
+	}
+
+	const Record& record = found->second;
+	Remove(mOwners.find(record.Owner)->second, record.ByteWidth);
+	Remove(mTotal, record.ByteWidth);
+	Remove(mBindings[static_cast<size_t>(record.Binding)], record.ByteWidth);
+	Remove(mUsages[static_cast<size_t>(record.Usage)], record.ByteWidth);
+	mBuffers.erase(found);
+}
+
+const ResourceCategoryStats* ResourceRegistry::Owner(const std::string& owner) const
+{
+	std::map<std::string, ResourceCategoryStats>::const_iterator found = mOwners.find(owner);
+	return found != mOwners.end() ? &found->second : nullptr;
+}
+
+std::vector<ResourceCategoryStats> ResourceRegistry::Owners() const
+{
+	std::vector<ResourceCategoryStats> owners;
+	for (std::map<std::string, ResourceCategoryStats>::const_iterator i = mOwners.begin(); i != mOwners.end(); ++i)
+	{
+		owners.push_back(i->second);
+	}
+	return owners;
+}
+
+void ResourceRegistry::Add(ResourceCategoryStats& category, uint64_t bytes)
+{
+	bool wasOver = category.Budget != 0 && category.LiveBytes > category.Budget;
+	category.LiveCount++;
+	category.LiveBytes += bytes;
+	category.PeakBytes = category.LiveBytes > category.PeakBytes ? category.LiveBytes : category.PeakBytes;
+
+	// Once per crossing, not for every buffer created while over
+	if (category.Budget != 0 && category.LiveBytes > category.Budget && !wasOver)
+	{
+		category.OverBudget++;
+		mBudgetWarnings++;
+		LogMessage("Buffer memory of " + category.Name + " is " + FormatBytes(category.LiveBytes) + ", over its budget of " + FormatBytes(category.Budget) + "\n");
+	}
+}
+
+void ResourceRegistry::Remove(ResourceCategoryStats& category, uint64_t bytes)
+{
+	category.LiveCount--;
+	category.LiveBytes -= bytes;
+}
+
+std::string ResourceRegistry::Report() const
+{
+	std::string report;
+	char line[192];
+	std::vector<ResourceCategoryStats> owners = Owners();
+	owners.push_back(mTotal);
+	for (size_t i = 0; i < owners.size(); i++)
+	{
+		const ResourceCategoryStats& owner = owners[i];
+		std::string budget = owner.Budget != 0 ? FormatBytes(owner.Budget) : std::string("-");
+		snprintf(line, sizeof(line), "%-12s %4u buffers  %10s live  %10s peak  budget %10s%s\n"
+			, owner.Name.c_str()
+			, owner.LiveCount
+			, FormatBytes(owner.LiveBytes).c_str()
+			, FormatBytes(owner.PeakBytes).c_str()
+			, budget.c_str()
+			, owner.OverBudget != 0 ? "  over" : "");
+		report += line;
+	}
+
+	const ResourceCategoryStats& vertex = Binding(BufferBinding::Vertex);
+	const ResourceCategoryStats& index = Binding(BufferBinding::Index);
+	const ResourceCategoryStats& immutable = Usage(BufferUsage::Immutable);
+	const ResourceCategoryStats& dynamic = Usage(BufferUsage::Dynamic);
+	snprintf(line, sizeof(line), "             vertex %s, index %s, immutable %s, dynamic %s\n"
+		, FormatBytes(vertex.LiveBytes).c_str()
+		, FormatBytes(index.LiveBytes).c_str()
+		, FormatBytes(immutable.LiveBytes).c_str()
+		, FormatBytes(dynamic.LiveBytes).c_str());
+	report += line;
+	return report;
+}
+
+std::string FormatBytes(uint64_t bytes)
+{
+	char text[32];
+	if (bytes < 1024)
+	{
+		snprintf(text, sizeof(text), "%llu B", static_cast<unsigned long long>(bytes));
+	}
+	else if (bytes < 1024 * 1024)
+	{
+		snprintf(text, sizeof(text), "%.1f KB", bytes / 1024.0);
+	}
+	else
+	{
+		snprintf(text, sizeof(text), "%.2f MB", bytes / (1024.0 * 1024.0));
+	}
+	return text;
+}
@@ -0,0 +1,77 @@
+#ifndef RESOURCEREGISTRY_H
+#define RESOURCEREGISTRY_H
+
+#include "RenderDevice.h"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct ResourceCategoryStats
+{
+	std::string Name;
+	uint32_t LiveCount;
+	uint64_t LiveBytes;
+	uint64_t PeakBytes;		// Most live at once
+	uint64_t Budget;		// 0 for none
+	uint32_t OverBudget;	// Times a creation took it over the budget
+};
+
+// Every live GPU buffer with its size, binding, usage and owner. Keeps live
+// and peak bytes per owner, per binding and per usage, and warns through
+// LogMessage when a creation takes an owner or the total over its budget.
+// Buffers without an owner are accounted to "Unassigned".
+//
+// Independent of the backend, TrackingRenderDevice feeds it from any device.
+class ResourceRegistry
+{
+public:
+	ResourceRegistry();
+
+	// 0 removes the budget
+	void SetBudget(const std::string& owner, uint64_t bytes);
+	void SetTotalBudget(uint64_t bytes);
+
+	void AddBuffer(const RenderBuffer* buffer, const BufferDesc& desc);
+	void RemoveBuffer(const RenderBuffer* buffer);
+
+	const ResourceCategoryStats& Total() const { return mTotal; }
+	// Null if nothing was ever created for 'owner'
+	const ResourceCategoryStats* Owner(const std::string& owner) const;
+	const ResourceCategoryStats& Binding(BufferBinding binding) const { return mBindings[static_cast<size_t>(binding)]; }
+	const ResourceCategoryStats& Usage(BufferUsage usage) const { return mUsages[static_cast<size_t>(usage)]; }
+
+	// Sorted by name
+	std::vector<ResourceCategoryStats> Owners() const;
+	// Times any creation went over a budget
+	uint32_t BudgetWarnings() const { return mBudgetWarnings; }
+
+	// One line per owner and a line for the totals by binding and usage
+	std::string Report() const;
+
+private:
+	struct Record
+	{
+		std::string Owner;
+		BufferBinding Binding;
+		BufferUsage Usage;
+		uint32_t ByteWidth;
+	};
+
+	void Add(ResourceCategoryStats& category, uint64_t bytes);
+	void Remove(ResourceCategoryStats& category, uint64_t bytes);
+
+	std::unordered_map<const RenderBuffer*, Record> mBuffers;
+	std::map<std::string, ResourceCategoryStats> mOwners;
+	ResourceCategoryStats mTotal;
+	ResourceCategoryStats mBindings[2];
+	ResourceCategoryStats mUsages[2];
+	uint32_t mBudgetWarnings;
+};
+
+// Formats a byte count as B, KB or MB
+std::string FormatBytes(uint64_t bytes);
+
+#endif // RESOURCEREGISTRY_H
@@ -0,0 +1,139 @@
+#ifndef RESOURCETABLE_H
+#define RESOURCETABLE_H
+
+#include <cstdint>
+#include <vector>
+
+// Names a slot of a ResourceTable. The generation tells a handle to a slot
+// that was destroyed, and perhaps reused since, from a live one. Tag only
+// keeps handles of different tables apart. Generation 0 is the null handle.
+template<typename Tag>
+struct ResourceHandle
+{
+	uint32_t Index;
+	uint32_t Generation;
+
+	bool IsNull() const { return Generation == 0; }
+	bool operator==(const ResourceHandle& other) const { return Index == other.Index && Generation == other.Generation; }
+	bool operator!=(const ResourceHandle& other) const { return !(*this == other); }
+};
+
+// Values in slots that keep their index for as long as the table lives.
+// Destroying a value bumps its slot's generation, so every handle to it
+// stops resolving, and puts the slot on a free list for the next Create.
+template<typename Tag, typename T>
+class ResourceTable
+{
+public:
+	typedef ResourceHandle<Tag> Handle;
+
+	ResourceTable()
+		: mLiveCount(0)
+	{
+	}
+
+	Handle Create(const T& value);
+
+	// Null for a stale or null handle
+	T* Get(Handle handle);
+	const T* Get(Handle handle) const;
+	bool IsValid(Handle handle) const { return Get(handle) != nullptr; }
+
+	// Moves the value to 'value', false for a stale or null handle
+	bool Destroy(Handle handle, T& value);
+
+	uint32_t LiveCount() const { return mLiveCount; }
+	// Slots ever used, live or free
+	uint32_t SlotCount() const { return static_cast<uint32_t>(mSlots.size()); }
+
+	// Calls visit(handle, value) for every live value in slot order
+	template<typename Visitor>
+	void ForEach(const Visitor& visit) const;
+
+private:
+	struct Slot
+	{
+		T Value;
+		uint32_t Generation;	// Odd while live
+	};
+
+	std::vector<Slot> mSlots;
+	std::vector<uint32_t> mFree;
+	uint32_t mLiveCount;
+};
+
+template<typename Tag, typename T>
+typename ResourceTable<Tag, T>::Handle ResourceTable<Tag, T>::Create(const T& value)
+{
+	uint32_t index;
+	if (!mFree.empty())
+	{
+		index = mFree.back();
+		mFree.pop_back();
+	}
+	else
+	{
+		index = static_cast<uint32_t>(mSlots.size());
+		Slot slot = { T(), 0 };
+		mSlots.push_back(slot);
+	}
+
+	Slot& slot = mSlots[index];
+	slot.Value = value;
+	slot.Generation++;
+	mLiveCount++;
+
+	Handle handle = { index, slot.Generation };
+	return handle;
+}
+
+template<typename Tag, typename T>
+T* ResourceTable<Tag, T>::Get(Handle handle)
+{
+	if (handle.Index >= mSlots.size() || mSlots[handle.Index].Generation != handle.Generation || (handle.Generation & 1) == 0)
+	{
+		return nullptr;
+	}
+	return &mSlots[handle.Index].Value;
+}
+
+template<typename Tag, typename T>
+const T* ResourceTable<Tag, T>::Get(Handle handle) const
+{
+	return const_cast<ResourceTable*>(this)->Get(handle);
+}
+
+template<typename Tag, typename T>
+bool ResourceTable<Tag, T>::Destroy(Handle handle, T& value)
+{
+	T* live = Get(handle);
+	if (live == nullptr)
+	{
+		return false;
+	}
+
+	Slot& slot = mSlots[handle.Index];
+	value = *live;
+	slot.Value = T();
+	// Even until the next Create, skipping 0 when it wraps
+	slot.Generation = slot.Generation + 1 != 0 ? slot.Generation + 1 : 2;
+	mFree.push_back(handle.Index);
+	mLiveCount--;
+	return true;
+}
+
+template<typename Tag, typename T>
+template<typename Visitor>
+void ResourceTable<Tag, T>::ForEach(const Visitor& visit) const
+{
+	for (uint32_t i = 0; i < mSlots.size(); i++)
+	{
+		if ((mSlots[i].Generation & 1) != 0)
+		{
+			Handle handle = { i, mSlots[i].Generation };
+			visit(handle, mSlots[i].Value);
+		}
+	}
+}
+
+#endif // RESOURCETABLE_H
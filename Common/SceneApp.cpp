@@ -0,0 +1,212 @@
+#include "SceneApp.h"
+#include "Log.h"
+#include "AllocationCounter.h"
+
+#include <string>
+
+namespace
+{
+	uint32_t ToMouseButtons(WPARAM buttonState)
+	{
+		uint32_t buttons = 0;
+		if ((buttonState & MK_LBUTTON) != 0)
+		{
+			buttons |= MouseButtonLeft;
+		}
+		if ((buttonState & MK_RBUTTON) != 0)
+		{
+			buttons |= MouseButtonRight;
+		}
+		if ((buttonState & MK_MBUTTON) != 0)
+		{
+			buttons |= MouseButtonMiddle;
+		}
+		return buttons;
+	}
+
+	InputEvent MouseEvent(InputEventType type, WPARAM buttonState, int x, int y)
+	{
+		InputEvent event = { type, ToMouseButtons(buttonState), x, y, InputTimestamp() };
+		return event;
+	}
+
+	// A quarter of a second of steps at 60 Hz, longer frames drop the rest
+	const uint32_t maxStepsPerFrame = 15;
+
+#if defined(DEBUG) || defined(_DEBUG)
+	// Frames that may allocate while buffers and captions settle
+	const uint64_t allocationFreeAfter = 10;
+#endif
+}
+
+SceneApp::SceneApp(HINSTANCE hInstance, DemoScene& scene, float fixedStep)
+	: D3DApp(hInstance)
+	, mScene(scene)
+	, mSceneReady(false)
+	, mFrameCount(0)
+	, mFrameAllocationStart(0)
+	, mAllocationReported(false)
+{
+	mMainWndCaption = scene.Caption();
+	if (fixedStep > 0.0f)
+	{
+		mClock.reset(new FixedStepClock(fixedStep, maxStepsPerFrame));
+	}
+}
+
+SceneApp::~SceneApp()
+{
+	// Before D3DApp releases the device
+	if (mSceneReady)
+	{
+		mScene.Shutdown();
+	}
+}
+
+bool SceneApp::Init()
+{
+	mStartupTrace.Begin();
+	STARTUP_PHASE("Init");
+
+	{
+		STARTUP_PHASE("D3DApp::Init");
+		if (!D3DApp::Init())
+		{
+			return false;
+		}
+	}
+
+	mRenderDevice.reset(new D3D11RenderDevice(md3dDevice, md3dImmediateContext));
+	mRenderDevice->Context().SetTargets(mRenderTargetView, mDepthStencilView);
+	mTrackedDevice.reset(new TrackingRenderDevice(*mRenderDevice, mResources));
+
+	// Shutdown also releases what a failed Init created
+	mSceneReady = true;
+	{
+		STARTUP_PHASE("SceneInit");
+		if (!mScene.Init(*mTrackedDevice))
+		{
+			return false;
+		}
+	}
+
+	LogMessage(EffectCacheSummary(mRenderDevice->EffectStats()) + "\n");
+	LogMessage(mResources.Report());
+
+	// D3DApp::Init resized before the scene existed
+	mScene.OnResize(mClientWidth, mClientHeight);
+	return true;
+}
+
+void SceneApp::OnResize()
+{
+	D3DApp::OnResize();
+
+	if (mRenderDevice)
+	{
+		mRenderDevice->Context().SetTargets(mRenderTargetView, mDepthStencilView);
+	}
+	if (mSceneReady)
+	{
+		mScene.OnResize(mClientWidth, mClientHeight);
+	}
+}
+
+void SceneApp::UpdateScene(float dt)
+{
+	if (mStartupTrace.IsRunning())
+	{
+		EndStartupTrace();
+	}
+
+	PROFILE_SCOPE("UpdateScene");
+#if defined(DEBUG) || defined(_DEBUG)
+	mFrameAllocationStart = AllocationCount();
+#endif
+
+	if (!mClock)
+	{
+		DispatchInput(mInput, mScene);
+		mScene.UpdateScene(dt, mTimer.TotalTime());
+		return;
+	}
+
+	RunFixedSteps(*mClock, mScene, &mInput, dt);
+}
+
+void SceneApp::DrawScene()
+{
+	{
+		PROFILE_SCOPE("DrawScene");
+		mScene.DrawScene();
+
+#if defined(DEBUG) || defined(_DEBUG)
+		uint64_t allocations = AllocationCount() - mFrameAllocationStart;
+		if (allocations != 0 && mFrameCount >= allocationFreeAfter && !mAllocationReported)
+		{
+			LogMessage("Frame " + std::to_string(mFrameCount) + " made " + std::to_string(allocations) + " heap allocations in UpdateScene and DrawScene\n");
+			mAllocationReported = true;
+		}
+#endif
+		mFrameCount++;
+		mMainWndCaption = mScene.Caption();
+	}
+
+	{
+		PROFILE_SCOPE("Present");
+		HR(mSwapChain->Present(0, 0));
+	}
+
+	mProfiler.Collect();
+}
+
+void SceneApp::OnMouseDown(WPARAM buttonState, int x, int y)
+{
+	SetCapture(mhMainWnd);
+	mInput.Push(MouseEvent(InputEventType::MouseDown, buttonState, x, y));
+}
+
+void SceneApp::OnMouseUp(WPARAM buttonState, int x, int y)
+{
+	ReleaseCapture();
+	mInput.Push(MouseEvent(InputEventType::MouseUp, buttonState, x, y));
+}
+
+void SceneApp::OnMouseMove(WPARAM buttonState, int x, int y)
+{
+	mInput.Push(MouseEvent(InputEventType::MouseMove, buttonState, x, y));
+}
+
+void SceneApp::EndStartupTrace()
+{
+	mStartupTrace.End();
+	LogMessage(mStartupTrace.Report());
+	if (!mStartupTrace.WriteFoldedStacks("startup.folded"))
+	{
+		LogMessage("Could not write startup.folded\n");
+	}
+}
+
+LRESULT SceneApp::MsgProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
+{
+	bool wasPaused = mAppPaused;
+	if (msg == WM_KEYDOWN && wParam == 'P')
+	{
+		mProfiler.Collect();
+		LogMessage(mProfiler.Report());
+		LogMessage(mResources.Report());
+		if (!mProfiler.WriteChromeTrace("profile.json"))
+		{
+			LogMessage("Could not write profile.json\n");
+		}
+	}
+	LRESULT result = D3DApp::MsgProc(hwnd, msg, wParam, lParam);
+
+	// Nothing drains the queue while paused, what it took since is stale.
+	// Clear is for the consumer, which UpdateScene runs on this thread too.
+	if (wasPaused && !mAppPaused)
+	{
+		mInput.Clear();
+	}
+	return result;
+}
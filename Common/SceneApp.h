@@ -0,0 +1,71 @@
+#ifndef SCENEAPP_H
+#define SCENEAPP_H
+
+#include "d3dApp.h"
+#include "DemoScene.h"
+#include "D3D11RenderDevice.h"
+#include "TrackingRenderDevice.h"
+#include "FrameProfiler.h"
+#include "StartupTrace.h"
+#include "FixedStepClock.h"
+#include "InputQueue.h"
+
+#include <memory>
+
+// Runs a DemoScene in a window on D3D11. The window, swap chain and timer
+// come from D3DApp, everything else is up to the scene. Pressing P logs the
+// phase timings and writes the recent frames to profile.json as a Chrome trace.
+//
+// The scene's buffers are counted in Resources, whose budgets WinMain may set
+// before Init. The totals are logged after Init and with the timings.
+//
+// A StartupTrace runs from Init to the first update, so STARTUP_PHASE in the
+// scene and in WinMain after Init is part of it. The table is logged and the
+// phases are written to startup.folded for flame graphs.
+//
+// With a fixedStep the scene is updated in steps of that many seconds,
+// independent of the frame rate, and interpolated between them when drawn.
+// Without one every frame updates it once with the frame time.
+//
+// Mouse messages are queued and handed to the scene before each update, so
+// the scene's state only changes inside a simulation step.
+//
+// Debug builds count the heap allocations of UpdateScene and DrawScene and
+// log the first frame that makes any after the first few. They need
+// AllocationCounter.cpp linked in.
+class SceneApp : public D3DApp
+{
+public:
+	SceneApp(HINSTANCE hInstance, DemoScene& scene, float fixedStep = 0.0f);
+	~SceneApp();
+
+	bool Init();
+	void OnResize();
+	ResourceRegistry& Resources() { return mResources; }
+	void UpdateScene(float dt);
+	void DrawScene();
+
+	void OnMouseDown(WPARAM buttonState, int x, int y);
+	void OnMouseUp(WPARAM buttonState, int x, int y);
+	void OnMouseMove(WPARAM buttonState, int x, int y);
+
+	LRESULT MsgProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
+
+private:
+	void EndStartupTrace();
+
+	DemoScene& mScene;
+	ResourceRegistry mResources;
+	std::unique_ptr<D3D11RenderDevice> mRenderDevice;
+	std::unique_ptr<TrackingRenderDevice> mTrackedDevice;
+	bool mSceneReady;
+	FrameProfiler mProfiler;
+	StartupTrace mStartupTrace;
+	std::unique_ptr<FixedStepClock> mClock;
+	InputQueue mInput;
+	uint64_t mFrameCount;
+	uint64_t mFrameAllocationStart;
+	bool mAllocationReported;
+};
+
+#endif // SCENEAPP_H
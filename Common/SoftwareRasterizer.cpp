@@ -0,0 +1,648 @@
+#include "SoftwareRasterizer.h"
+#include "FrameProfiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOFTWARERASTERIZER_SSE2
+#include <emmintrin.h>
+#endif
+
+// Screen positions snap to 1/256 pixel, the subpixel precision of D3D11.
+// Edge values at pixel centers are then multiples of 1 / 256^2, and half of
+// that on top and left edges puts pixels exactly on them inside.
+static const float SubpixelSteps = 256.0f;
+static const double TopLeftBias = 0.5 / (256.0 * 256.0);
+
+// Rounds to a multiple of 1 / SubpixelSteps. Adding and subtracting 1.5 *
+// 2^23 rounds to an integer without a library call. Positions beyond 16384
+// pixels stay as they are.
+static inline float SnapToSubpixel(float value)
+{
+	const float roundingBias = 12582912.0f;
+	float steps = value * SubpixelSteps;
+	if (std::fabs(steps) < 4194304.0f)
+	{
+		steps = (steps + roundingBias) - roundingBias;
+	}
+	return steps / SubpixelSteps;
+}
+
+SoftwareRasterizer::SoftwareRasterizer(uint32_t threadCount)
+	: mWidth(0)
+	, mHeight(0)
+	, mStride(0)
+	, mTilesX(0)
+	, mTilesY(0)
+	, mGeneration(0)
+	, mBusyWorkers(0)
+	, mQuit(false)
+	, mNextTile(0)
+{
+	ResetStats();
+	for (uint32_t i = 1; i < threadCount; i++)
+	{
+		mWorkers.push_back(std::thread(&SoftwareRasterizer::WorkerLoop, this));
+	}
+}
+
+SoftwareRasterizer::~SoftwareRasterizer()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mQuit = true;
+	}
+	mWorkAvailable.notify_all();
+	for (size_t i = 0; i < mWorkers.size(); i++)
+	{
+		mWorkers[i].join();
+	}
+}
+
+void SoftwareRasterizer::Resize(uint32_t width, uint32_t height)
+{
+	mTriangles.clear();
+	mActiveTiles.clear();
+
+	mWidth = width;
+	mHeight = height;
+	mStride = (width + 3) & ~3u;
+	mTilesX = (width + TileSize - 1) / TileSize;
+	mTilesY = (height + TileSize - 1) / TileSize;
+
+	mColor.assign(mStride * mHeight, 0);
+	mDepth.assign(mStride * mHeight, 1.0f);
+	mBins.assign(mTilesX * mTilesY, std::vector<uint32_t>());
+	mTilePixels.assign(mTilesX * mTilesY, 0);
+}
+
+static uint32_t PackPixel(float r, float g, float b, float a)
+{
+	uint32_t red = static_cast<uint32_t>(Clamp(r, 0.0f, 1.0f) * 255.0f + 0.5f);
+	uint32_t green = static_cast<uint32_t>(Clamp(g, 0.0f, 1.0f) * 255.0f + 0.5f);
+	uint32_t blue = static_cast<uint32_t>(Clamp(b, 0.0f, 1.0f) * 255.0f + 0.5f);
+	uint32_t alpha = static_cast<uint32_t>(Clamp(a, 0.0f, 1.0f) * 255.0f + 0.5f);
+	return red | (green << 8) | (blue << 16) | (alpha << 24);
+}
+
+void SoftwareRasterizer::ClearColor(const Float4& color)
+{
+	Flush();
+	std::fill(mColor.begin(), mColor.end(), PackPixel(color.x, color.y, color.z, color.w));
+}
+
+void SoftwareRasterizer::ClearDepth(float depth)
+{
+	Flush();
+	std::fill(mDepth.begin(), mDepth.end(), Clamp(depth, 0.0f, 1.0f));
+}
+
+void SoftwareRasterizer::ResetStats()
+{
+	mStats.TrianglesSubmitted = 0;
+	mStats.TrianglesCulled = 0;
+	mStats.TrianglesRasterized = 0;
+	mStats.TileBins = 0;
+	mStats.PixelsWritten = 0;
+}
+
+void SoftwareRasterizer::DrawTriangles(const RasterVertex* vertices, const uint32_t* indices, uint32_t indexCount)
+{
+	for (uint32_t i = 0; i + 2 < indexCount; i += 3)
+	{
+		mStats.TrianglesSubmitted++;
+		ClipAndSetup(vertices[indices[i]], vertices[indices[i + 1]], vertices[indices[i + 2]]);
+	}
+}
+
+// Bits of the clip volume planes a clip space position is outside of
+static uint32_t OutCode(const Float4& p)
+{
+	return (p.x < -p.w ? 1 : 0)
+		| (p.x > p.w ? 2 : 0)
+		| (p.y < -p.w ? 4 : 0)
+		| (p.y > p.w ? 8 : 0)
+		| (p.z < 0.0f ? 16 : 0)
+		| (p.z > p.w ? 32 : 0);
+}
+
+static RasterVertex Lerp(const RasterVertex& a, const RasterVertex& b, float t)
+{
+	RasterVertex result;
+	result.Position = Float4(a.Position.x + (b.Position.x - a.Position.x) * t
+		, a.Position.y + (b.Position.y - a.Position.y) * t
+		, a.Position.z + (b.Position.z - a.Position.z) * t
+		, a.Position.w + (b.Position.w - a.Position.w) * t);
+	result.Color = Float4(a.Color.x + (b.Color.x - a.Color.x) * t
+		, a.Color.y + (b.Color.y - a.Color.y) * t
+		, a.Color.z + (b.Color.z - a.Color.z) * t
+		, a.Color.w + (b.Color.w - a.Color.w) * t);
+	return result;
+}
+
+void SoftwareRasterizer::ClipAndSetup(const RasterVertex& v0, const RasterVertex& v1, const RasterVertex& v2)
+{
+	uint32_t code0 = OutCode(v0.Position);
+	uint32_t code1 = OutCode(v1.Position);
+	uint32_t code2 = OutCode(v2.Position);
+
+	// All vertices outside the same plane
+	if ((code0 & code1 & code2) != 0)
+	{
+		mStats.TrianglesCulled++;
+		return;
+	}
+
+	// Only the near plane is clipped, the screen bounds and the depth test
+	// take care of the others
+	if (((code0 | code1 | code2) & 16) == 0)
+	{
+		SetupTriangle(v0, v1, v2);
+		return;
+	}
+
+	const RasterVertex* input[3] = { &v0, &v1, &v2 };
+	RasterVertex clipped[4];
+	uint32_t clippedCount = 0;
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		const RasterVertex& current = *input[i];
+		const RasterVertex& next = *input[(i + 1) % 3];
+		float currentZ = current.Position.z;
+		float nextZ = next.Position.z;
+
+		if (currentZ >= 0.0f)
+		{
+			clipped[clippedCount++] = current;
+		}
+		if ((currentZ >= 0.0f) != (nextZ >= 0.0f))
+		{
+			clipped[clippedCount++] = Lerp(current, next, currentZ / (currentZ - nextZ));
+		}
+	}
+
+	if (clippedCount < 3)
+	{
+		mStats.TrianglesCulled++;
+		return;
+	}
+	for (uint32_t i = 1; i + 1 < clippedCount; i++)
+	{
+		SetupTriangle(clipped[0], clipped[i], clipped[i + 1]);
+	}
+}
+
+void SoftwareRasterizer::SetupTriangle(const RasterVertex& v0, const RasterVertex& v1, const RasterVertex& v2)
+{
+	const RasterVertex* vertices[3] = { &v0, &v1, &v2 };
+
+	Triangle triangle;
+	float x[3];
+	float y[3];
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		const Float4& position = vertices[i]->Position;
+		float invW = 1.0f / position.w;
+
+		// Viewport covering the whole target, y points down, snapped to the
+		// subpixel grid
+		x[i] = SnapToSubpixel((position.x * invW * 0.5f + 0.5f) * mWidth);
+		y[i] = SnapToSubpixel((0.5f - position.y * invW * 0.5f) * mHeight);
+
+		triangle.Z[i] = position.z * invW;
+		triangle.InvW[i] = invW;
+		const Float4& color = vertices[i]->Color;
+		triangle.ColorOverW[i] = Float4(color.x * invW, color.y * invW, color.z * invW, color.w * invW);
+	}
+
+	// Positive for clockwise triangles on screen, the front faces
+	double area = (double(x[1]) - x[0]) * (double(y[2]) - y[0]) - (double(y[1]) - y[0]) * (double(x[2]) - x[0]);
+	if (!(area > 0.0))
+	{
+		mStats.TrianglesCulled++;
+		return;
+	}
+	triangle.InvArea = static_cast<float>(1.0 / area);
+
+	float minX = std::min(x[0], std::min(x[1], x[2]));
+	float maxX = std::max(x[0], std::max(x[1], x[2]));
+	float minY = std::min(y[0], std::min(y[1], y[2]));
+	float maxY = std::max(y[0], std::max(y[1], y[2]));
+
+	triangle.MinX = static_cast<int32_t>(std::floor(Clamp(minX, 0.0f, static_cast<float>(mWidth))));
+	triangle.MaxX = static_cast<int32_t>(std::ceil(Clamp(maxX, -1.0f, static_cast<float>(mWidth - 1))));
+	triangle.MinY = static_cast<int32_t>(std::floor(Clamp(minY, 0.0f, static_cast<float>(mHeight))));
+	triangle.MaxY = static_cast<int32_t>(std::ceil(Clamp(maxY, -1.0f, static_cast<float>(mHeight - 1))));
+	if (triangle.MinX > triangle.MaxX || triangle.MinY > triangle.MaxY)
+	{
+		mStats.TrianglesCulled++;
+		return;
+	}
+
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		uint32_t from = (i + 1) % 3;
+		uint32_t to = (i + 2) % 3;
+
+		// Neighbouring triangles walk a shared edge in opposite directions.
+		// Computing it in one fixed direction and negating gives both exactly
+		// opposite values at every pixel. On the subpixel grid and within
+		// 16384 pixels of the screen the doubles are also exact, so several
+		// edges meeting at a pixel center agree on which side it is and the
+		// fill rule alone decides it. No pixel is drawn twice or missed.
+		bool flip = x[from] > x[to] || (x[from] == x[to] && y[from] > y[to]);
+		uint32_t a = flip ? to : from;
+		uint32_t b = flip ? from : to;
+
+		double edgeA = double(y[a]) - y[b];
+		double edgeB = double(x[b]) - x[a];
+		double edgeC = -(edgeA * x[a] + edgeB * y[a]);
+		if (flip)
+		{
+			edgeA = -edgeA;
+			edgeB = -edgeB;
+			edgeC = -edgeC;
+		}
+
+		// Left edges go up, top edges go right on a clockwise triangle
+		bool topLeft = edgeA > 0.0 || (edgeA == 0.0 && edgeB > 0.0);
+
+		triangle.EdgeA[i] = edgeA;
+		triangle.EdgeB[i] = edgeB;
+		triangle.EdgeC[i] = edgeC + (topLeft ? TopLeftBias : 0.0);
+		triangle.InvEdgeA[i] = edgeA != 0.0 ? 1.0 / edgeA : 0.0;
+	}
+
+	uint32_t index = static_cast<uint32_t>(mTriangles.size());
+	mTriangles.push_back(triangle);
+	mStats.TrianglesRasterized++;
+
+	uint32_t tileMinX = triangle.MinX / TileSize;
+	uint32_t tileMaxX = triangle.MaxX / TileSize;
+	uint32_t tileMinY = triangle.MinY / TileSize;
+	uint32_t tileMaxY = triangle.MaxY / TileSize;
+	for (uint32_t ty = tileMinY; ty <= tileMaxY; ty++)
+	{
+		for (uint32_t tx = tileMinX; tx <= tileMaxX; tx++)
+		{
+			// Long thin triangles have big bounds but touch few of the tiles
+			// in them. Skip tiles that are completely outside an edge.
+			double tileLeft = tx * TileSize + 0.5;
+			double tileTop = ty * TileSize + 0.5;
+			double tileRight = tileLeft + (TileSize - 1);
+			double tileBottom = tileTop + (TileSize - 1);
+			bool outside = false;
+			for (uint32_t i = 0; i < 3 && !outside; i++)
+			{
+				double x = triangle.EdgeA[i] > 0.0 ? tileRight : tileLeft;
+				double y = triangle.EdgeB[i] > 0.0 ? tileBottom : tileTop;
+				outside = triangle.EdgeA[i] * x + (triangle.EdgeB[i] * y + triangle.EdgeC[i]) < 0.0;
+			}
+			if (outside)
+			{
+				continue;
+			}
+
+			uint32_t tile = ty * mTilesX + tx;
+			if (mBins[tile].empty())
+			{
+				mActiveTiles.push_back(tile);
+			}
+			mBins[tile].push_back(index);
+			mStats.TileBins++;
+		}
+	}
+}
+
+#if defined(SOFTWARERASTERIZER_SSE2)
+
+static inline __m128 Interpolate(__m128 e0, __m128 e1, __m128 e2, __m128 v0, __m128 v1, __m128 v2)
+{
+	return _mm_add_ps(_mm_add_ps(_mm_mul_ps(e0, v0), _mm_mul_ps(e1, v1)), _mm_mul_ps(e2, v2));
+}
+
+// Clamps to [0, 1] and converts to 0..255 in the low byte of each lane
+static inline __m128i ToUNorm8(__m128 value)
+{
+	value = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+	return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+}
+
+#endif
+
+bool SoftwareRasterizer::RowSpan(const Triangle& triangle, const double rowEdges[3], int32_t& first, int32_t& last)
+{
+	// Starts about where each edge crosses the row and steps to the exact
+	// first and last pixel inside it, so the pixels between need no edge
+	// tests. Along a row an edge value only rises or only falls.
+	for (uint32_t i = 0; i < 3 && first <= last; i++)
+	{
+		double a = triangle.EdgeA[i];
+		double row = rowEdges[i];
+		if (a == 0.0)
+		{
+			if (!(row > 0.0))
+			{
+				return false;
+			}
+			continue;
+		}
+
+		double crossing = -row * triangle.InvEdgeA[i] - 0.5;
+		if (a > 0.0)
+		{
+			int32_t x = static_cast<int32_t>(Clamp(crossing + 1.0, static_cast<double>(first), last + 1.0));
+			while (x <= last && !(a * (x + 0.5) + row > 0.0))
+			{
+				x++;
+			}
+			while (x > first && a * (x - 0.5) + row > 0.0)
+			{
+				x--;
+			}
+			first = x;
+		}
+		else
+		{
+			int32_t x = static_cast<int32_t>(Clamp(crossing, first - 1.0, static_cast<double>(last)));
+			while (x >= first && !(a * (x + 0.5) + row > 0.0))
+			{
+				x--;
+			}
+			while (x < last && a * (x + 1.5) + row > 0.0)
+			{
+				x++;
+			}
+			last = x;
+		}
+	}
+	return first <= last;
+}
+
+void SoftwareRasterizer::RasterizeTile(uint32_t tile)
+{
+	int32_t tileX = static_cast<int32_t>((tile % mTilesX) * TileSize);
+	int32_t tileY = static_cast<int32_t>((tile / mTilesX) * TileSize);
+	int32_t tileMaxX = std::min(tileX + static_cast<int32_t>(TileSize), static_cast<int32_t>(mWidth)) - 1;
+	int32_t tileMaxY = std::min(tileY + static_cast<int32_t>(TileSize), static_cast<int32_t>(mHeight)) - 1;
+
+	uint64_t pixels = 0;
+	const std::vector<uint32_t>& bin = mBins[tile];
+	for (size_t t = 0; t < bin.size(); t++)
+	{
+		const Triangle& triangle = mTriangles[bin[t]];
+
+		// Groups of four pixels start on a multiple of four. Tiles are a
+		// multiple of four wide so a group never reaches into the next tile.
+		// Rows only visit the span between the edges.
+		int32_t minX = std::max(triangle.MinX, tileX);
+		int32_t maxX = std::min(triangle.MaxX, tileMaxX);
+		int32_t minY = std::max(triangle.MinY, tileY);
+		int32_t maxY = std::min(triangle.MaxY, tileMaxY);
+
+#if defined(SOFTWARERASTERIZER_SSE2)
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 laneOffsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+		const __m128i laneIndices = _mm_set_epi32(3, 2, 1, 0);
+
+		// Broadcast once per triangle. The pixel stores could alias the
+		// triangle, so the compiler would otherwise reload these every group.
+		// Depth is interpolated with the edge values scaled by 1 / area, the
+		// scale cancels out of the perspective divide of the color.
+		__m128 edgeA[3];
+		__m128 depthScaled[3];
+		__m128 invW[3];
+		__m128 colorOverW[3][4];
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			edgeA[i] = _mm_set1_ps(static_cast<float>(triangle.EdgeA[i]));
+			depthScaled[i] = _mm_set1_ps(triangle.Z[i] * triangle.InvArea);
+			invW[i] = _mm_set1_ps(triangle.InvW[i]);
+			colorOverW[i][0] = _mm_set1_ps(triangle.ColorOverW[i].x);
+			colorOverW[i][1] = _mm_set1_ps(triangle.ColorOverW[i].y);
+			colorOverW[i][2] = _mm_set1_ps(triangle.ColorOverW[i].z);
+			colorOverW[i][3] = _mm_set1_ps(triangle.ColorOverW[i].w);
+		}
+
+		for (int32_t y = minY; y <= maxY; y++)
+		{
+			double pixelY = y + 0.5;
+			double rowEdges[3];
+			for (uint32_t i = 0; i < 3; i++)
+			{
+				rowEdges[i] = triangle.EdgeB[i] * pixelY + triangle.EdgeC[i];
+			}
+
+			int32_t first = minX;
+			int32_t last = maxX;
+			if (!RowSpan(triangle, rowEdges, first, last))
+			{
+				continue;
+			}
+
+			// The edge values only interpolate from here on, floats will do
+			__m128 rowE[3];
+			for (uint32_t i = 0; i < 3; i++)
+			{
+				rowE[i] = _mm_set1_ps(static_cast<float>(rowEdges[i]));
+			}
+			const __m128i spanBefore = _mm_set1_epi32(first - 1);
+			const __m128i spanAfter = _mm_set1_epi32(last + 1);
+
+			uint32_t* colorRow = &mColor[y * mStride];
+			float* depthRow = &mDepth[y * mStride];
+
+			for (int32_t x = first & ~3; x <= last; x += 4)
+			{
+				__m128i pixelIndex = _mm_add_epi32(_mm_set1_epi32(x), laneIndices);
+				__m128 inside = _mm_castsi128_ps(_mm_and_si128(_mm_cmpgt_epi32(pixelIndex, spanBefore), _mm_cmplt_epi32(pixelIndex, spanAfter)));
+
+				__m128 pixelX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffsets);
+				__m128 e0 = _mm_add_ps(_mm_mul_ps(edgeA[0], pixelX), rowE[0]);
+				__m128 e1 = _mm_add_ps(_mm_mul_ps(edgeA[1], pixelX), rowE[1]);
+				__m128 e2 = _mm_add_ps(_mm_mul_ps(edgeA[2], pixelX), rowE[2]);
+
+				__m128 z = Interpolate(e0, e1, e2, depthScaled[0], depthScaled[1], depthScaled[2]);
+
+				__m128 depth = _mm_loadu_ps(depthRow + x);
+				__m128 write = _mm_and_ps(inside, _mm_cmplt_ps(z, depth));
+				int writeMask = _mm_movemask_ps(write);
+				if (writeMask == 0)
+				{
+					continue;
+				}
+				_mm_storeu_ps(depthRow + x, _mm_or_ps(_mm_and_ps(write, z), _mm_andnot_ps(write, depth)));
+
+				__m128 w = _mm_div_ps(one, Interpolate(e0, e1, e2, invW[0], invW[1], invW[2]));
+
+				__m128i packed = ToUNorm8(_mm_mul_ps(Interpolate(e0, e1, e2, colorOverW[0][0], colorOverW[1][0], colorOverW[2][0]), w));
+				packed = _mm_or_si128(packed, _mm_slli_epi32(ToUNorm8(_mm_mul_ps(Interpolate(e0, e1, e2, colorOverW[0][1], colorOverW[1][1], colorOverW[2][1]), w)), 8));
+				packed = _mm_or_si128(packed, _mm_slli_epi32(ToUNorm8(_mm_mul_ps(Interpolate(e0, e1, e2, colorOverW[0][2], colorOverW[1][2], colorOverW[2][2]), w)), 16));
+				packed = _mm_or_si128(packed, _mm_slli_epi32(ToUNorm8(_mm_mul_ps(Interpolate(e0, e1, e2, colorOverW[0][3], colorOverW[1][3], colorOverW[2][3]), w)), 24));
+
+				__m128i writeBits = _mm_castps_si128(write);
+				__m128i color = _mm_loadu_si128(reinterpret_cast<const __m128i*>(colorRow + x));
+				color = _mm_or_si128(_mm_and_si128(writeBits, packed), _mm_andnot_si128(writeBits, color));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(colorRow + x), color);
+
+				pixels += (writeMask & 1) + ((writeMask >> 1) & 1) + ((writeMask >> 2) & 1) + ((writeMask >> 3) & 1);
+			}
+		}
+#else
+		for (int32_t y = minY; y <= maxY; y++)
+		{
+			double pixelY = y + 0.5;
+			double rowE[3];
+			for (uint32_t i = 0; i < 3; i++)
+			{
+				rowE[i] = triangle.EdgeB[i] * pixelY + triangle.EdgeC[i];
+			}
+
+			int32_t first = minX;
+			int32_t last = maxX;
+			if (!RowSpan(triangle, rowE, first, last))
+			{
+				continue;
+			}
+
+			uint32_t* colorRow = &mColor[y * mStride];
+			float* depthRow = &mDepth[y * mStride];
+
+			for (int32_t x = first; x <= last; x++)
+			{
+				double pixelX = x + 0.5;
+				float b0 = static_cast<float>(triangle.EdgeA[0] * pixelX + rowE[0]) * triangle.InvArea;
+				float b1 = static_cast<float>(triangle.EdgeA[1] * pixelX + rowE[1]) * triangle.InvArea;
+				float b2 = static_cast<float>(triangle.EdgeA[2] * pixelX + rowE[2]) * triangle.InvArea;
+
+				float z = b0 * triangle.Z[0] + b1 * triangle.Z[1] + b2 * triangle.Z[2];
+				if (!(z < depthRow[x]))
+				{
+					continue;
+				}
+				depthRow[x] = z;
+
+				float w = 1.0f / (b0 * triangle.InvW[0] + b1 * triangle.InvW[1] + b2 * triangle.InvW[2]);
+				const Float4& c0 = triangle.ColorOverW[0];
+				const Float4& c1 = triangle.ColorOverW[1];
+				const Float4& c2 = triangle.ColorOverW[2];
+				colorRow[x] = PackPixel((b0 * c0.x + b1 * c1.x + b2 * c2.x) * w
+					, (b0 * c0.y + b1 * c1.y + b2 * c2.y) * w
+					, (b0 * c0.z + b1 * c1.z + b2 * c2.z) * w
+					, (b0 * c0.w + b1 * c1.w + b2 * c2.w) * w);
+				pixels++;
+			}
+		}
+#endif
+	}
+	mTilePixels[tile] = pixels;
+}
+
+void SoftwareRasterizer::RasterizeTiles()
+{
+	PROFILE_SCOPE("RasterizeTiles");
+
+	// Threads take whole tiles, no two threads touch the same pixels
+	for (;;)
+	{
+		uint32_t next = mNextTile.fetch_add(1);
+		if (next >= mActiveTiles.size())
+		{
+			return;
+		}
+		RasterizeTile(mActiveTiles[next]);
+	}
+}
+
+void SoftwareRasterizer::WorkerLoop()
+{
+	uint64_t seenGeneration = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWorkAvailable.wait(lock, [&] { return mQuit || mGeneration != seenGeneration; });
+			if (mQuit)
+			{
+				return;
+			}
+			seenGeneration = mGeneration;
+		}
+
+		RasterizeTiles();
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mBusyWorkers--;
+		}
+		mWorkDone.notify_one();
+	}
+}
+
+void SoftwareRasterizer::Flush()
+{
+	PROFILE_SCOPE("RasterizerFlush");
+
+	if (mActiveTiles.empty())
+	{
+		mTriangles.clear();
+		return;
+	}
+
+	mNextTile.store(0);
+
+	// Waking the workers costs more than a tile or two
+	bool parallel = !mWorkers.empty() && mActiveTiles.size() > 1;
+	if (parallel)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mBusyWorkers = static_cast<uint32_t>(mWorkers.size());
+			mGeneration++;
+		}
+		mWorkAvailable.notify_all();
+	}
+
+	RasterizeTiles();
+
+	if (parallel)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mWorkDone.wait(lock, [&] { return mBusyWorkers == 0; });
+	}
+
+	for (size_t i = 0; i < mActiveTiles.size(); i++)
+	{
+		uint32_t tile = mActiveTiles[i];
+		mStats.PixelsWritten += mTilePixels[tile];
+		mBins[tile].clear();
+	}
+	mActiveTiles.clear();
+	mTriangles.clear();
+}
+
+bool SoftwareRasterizer::WritePpm(const std::string& fileName) const
+{
+	std::ofstream file(fileName, std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+
+	file << "P6\n" << mWidth << " " << mHeight << "\n255\n";
+	std::vector<uint8_t> row(mWidth * 3);
+	for (uint32_t y = 0; y < mHeight; y++)
+	{
+		for (uint32_t x = 0; x < mWidth; x++)
+		{
+			uint32_t pixel = Pixel(x, y);
+			row[x * 3 + 0] = static_cast<uint8_t>(pixel);
+			row[x * 3 + 1] = static_cast<uint8_t>(pixel >> 8);
+			row[x * 3 + 2] = static_cast<uint8_t>(pixel >> 16);
+		}
+		file.write(reinterpret_cast<const char*>(row.data()), row.size());
+	}
+	return static_cast<bool>(file);
+}
@@ -0,0 +1,136 @@
+#ifndef SOFTWARERASTERIZER_H
+#define SOFTWARERASTERIZER_H
+
+#include "MathTypes.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Output of the vertex stage: clip space position and the color the pixel
+// stage writes
+struct RasterVertex
+{
+	Float4 Position;
+	Float4 Color;
+};
+
+struct RasterStats
+{
+	uint64_t TrianglesSubmitted;
+	uint64_t TrianglesCulled;		// Back facing, degenerate or outside the view
+	uint64_t TrianglesRasterized;	// After near plane clipping
+	uint64_t TileBins;				// Triangle and tile pairs
+	uint64_t PixelsWritten;			// Passed the depth test
+};
+
+// CPU rasterizer with the D3D11 defaults the demos rely on: clockwise front
+// faces, back face culling, clipping to the near plane, depth test LESS with
+// writes, top-left fill rule and perspective correct color.
+//
+// Draws only set triangles up and sort them into screen tiles. Flush then
+// rasterizes the tiles in parallel. Each row finds its span of pixels with
+// exact edge tests on the 1/256 pixel grid, like the hardware, and fills it
+// four pixels at a time with SSE2. A tile keeps its triangles in draw order,
+// so the image does not depend on the thread count.
+class SoftwareRasterizer
+{
+public:
+	static const uint32_t TileSize = 64;
+
+	// threadCount includes the calling thread
+	explicit SoftwareRasterizer(uint32_t threadCount);
+	~SoftwareRasterizer();
+
+	void Resize(uint32_t width, uint32_t height);
+
+	// Like ClearRenderTargetView and ClearDepthStencilView. Triangles drawn
+	// before the clear are rasterized first.
+	void ClearColor(const Float4& color);
+	void ClearDepth(float depth);
+
+	// Triangle list, 'indices' point into 'vertices'
+	void DrawTriangles(const RasterVertex* vertices, const uint32_t* indices, uint32_t indexCount);
+
+	// Rasterizes everything drawn since the last flush
+	void Flush();
+
+	uint32_t Width() const { return mWidth; }
+	uint32_t Height() const { return mHeight; }
+	uint32_t ThreadCount() const { return static_cast<uint32_t>(mWorkers.size()) + 1; }
+
+	// R8G8B8A8 with red in the lowest byte, valid after Flush
+	uint32_t Pixel(uint32_t x, uint32_t y) const { return mColor[y * mStride + x]; }
+	float Depth(uint32_t x, uint32_t y) const { return mDepth[y * mStride + x]; }
+
+	// Binary PPM of the color buffer
+	bool WritePpm(const std::string& fileName) const;
+
+	const RasterStats& Stats() const { return mStats; }
+	void ResetStats();
+
+private:
+	struct Triangle
+	{
+		// Edge i is opposite vertex i. E(x, y) = A * x + (B * y + C) is
+		// positive inside. Exact for vertices on the subpixel grid, and C of
+		// top and left edges is biased so pixels on them come out positive.
+		double EdgeA[3];
+		double EdgeB[3];
+		double EdgeC[3];
+		double InvEdgeA[3];	// 0 for horizontal edges
+
+		float InvArea;
+		float Z[3];
+		float InvW[3];
+		Float4 ColorOverW[3];
+
+		// Inclusive pixel bounds, inside the screen
+		int32_t MinX;
+		int32_t MinY;
+		int32_t MaxX;
+		int32_t MaxY;
+	};
+
+	void ClipAndSetup(const RasterVertex& v0, const RasterVertex& v1, const RasterVertex& v2);
+	void SetupTriangle(const RasterVertex& v0, const RasterVertex& v1, const RasterVertex& v2);
+
+	// Narrows [first, last] to the pixels of a row inside the triangle
+	static bool RowSpan(const Triangle& triangle, const double rowEdges[3], int32_t& first, int32_t& last);
+	void RasterizeTile(uint32_t tile);
+	void RasterizeTiles();
+	void WorkerLoop();
+
+	uint32_t mWidth;
+	uint32_t mHeight;
+	uint32_t mStride;	// Width rounded up to four pixels
+	uint32_t mTilesX;
+	uint32_t mTilesY;
+
+	std::vector<uint32_t> mColor;
+	std::vector<float> mDepth;
+
+	// Set up triangles of the pending draws and their indices per tile
+	std::vector<Triangle> mTriangles;
+	std::vector<std::vector<uint32_t>> mBins;
+	std::vector<uint32_t> mActiveTiles;
+	std::vector<uint64_t> mTilePixels;
+
+	RasterStats mStats;
+
+	std::vector<std::thread> mWorkers;
+	std::mutex mMutex;
+	std::condition_variable mWorkAvailable;
+	std::condition_variable mWorkDone;
+	uint64_t mGeneration;
+	uint32_t mBusyWorkers;
+	bool mQuit;
+
+	std::atomic<uint32_t> mNextTile;
+};
+
+#endif // SOFTWARERASTERIZER_H
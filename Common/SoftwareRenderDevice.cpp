@@ -0,0 +1,258 @@
+#include "SoftwareRenderDevice.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+SoftwareDeviceContext::SoftwareDeviceContext(SoftwareRasterizer& rasterizer)
+	: mRasterizer(rasterizer)
+	, mInputLayout(nullptr)
+	, mPrimitiveTopology(PrimitiveTopology::TriangleList)
+	, mIndexBuffer(nullptr)
+	, mIndexFormat(IndexFormat::UInt32)
+	, mIndexOffset(0)
+	, mPipeline(Pipeline::None)
+	, mWorldViewProj(MatrixIdentity())
+{
+	for (uint32_t i = 0; i < MaxVertexBuffers; i++)
+	{
+		mVertexBuffers[i] = { nullptr, 0, 0 };
+	}
+}
+
+void SoftwareDeviceContext::ClearRenderTarget(const Float4& color)
+{
+	NullDeviceContext::ClearRenderTarget(color);
+	mRasterizer.ClearColor(color);
+}
+
+void SoftwareDeviceContext::ClearDepthStencil(float depth, uint8_t stencil)
+{
+	// There is no stencil buffer, none of the demos use one
+	NullDeviceContext::ClearDepthStencil(depth, stencil);
+	mRasterizer.ClearDepth(depth);
+}
+
+void SoftwareDeviceContext::SetInputLayout(RenderInputLayout* layout)
+{
+	NullDeviceContext::SetInputLayout(layout);
+	mInputLayout = NullRenderDevice::ToInputLayout(layout);
+}
+
+void SoftwareDeviceContext::SetPrimitiveTopology(PrimitiveTopology topology)
+{
+	NullDeviceContext::SetPrimitiveTopology(topology);
+	mPrimitiveTopology = topology;
+}
+
+void SoftwareDeviceContext::SetVertexBuffer(uint32_t slot, RenderBuffer* buffer, uint32_t stride, uint32_t offset)
+{
+	NullDeviceContext::SetVertexBuffer(slot, buffer, stride, offset);
+	if (slot < MaxVertexBuffers)
+	{
+		mVertexBuffers[slot] = { buffer, stride, offset };
+	}
+}
+
+void SoftwareDeviceContext::SetIndexBuffer(RenderBuffer* buffer, IndexFormat format, uint32_t offset)
+{
+	NullDeviceContext::SetIndexBuffer(buffer, format, offset);
+	mIndexBuffer = NullRenderDevice::ToBuffer(buffer);
+	mIndexFormat = format;
+	mIndexOffset = offset;
+}
+
+void SoftwareDeviceContext::SetConstants(RenderConstant* constant, const void* data, uint32_t size)
+{
+	NullDeviceContext::SetConstants(constant, data, size);
+
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < mConstants.size(); i++)
+	{
+		if (mConstants[i].Constant == constant)
+		{
+			mConstants[i].Data.assign(bytes, bytes + size);
+			return;
+		}
+	}
+	mConstants.push_back({ constant, std::vector<uint8_t>(bytes, bytes + size) });
+}
+
+void SoftwareDeviceContext::ApplyPass(RenderPass* pass)
+{
+	NullDeviceContext::ApplyPass(pass);
+
+	const NullRenderDevice::Pass* nullPass = NullRenderDevice::ToPass(pass);
+	if (nullPass->Technique == "ColorTech")
+	{
+		mPipeline = Pipeline::Color;
+	}
+	else if (nullPass->Technique == "NormalTech")
+	{
+		mPipeline = Pipeline::Normal;
+	}
+	else
+	{
+		mPipeline = Pipeline::None;
+	}
+
+	// gWorldViewProj of the pass's own effect
+	mWorldViewProj = MatrixIdentity();
+	for (size_t i = 0; i < mConstants.size(); i++)
+	{
+		const NullRenderDevice::Constant* constant = NullRenderDevice::ToConstant(mConstants[i].Constant);
+		if (constant->Owner == nullPass->Owner && constant->Name == "gWorldViewProj" && mConstants[i].Data.size() >= sizeof(Float4x4))
+		{
+			memcpy(&mWorldViewProj, mConstants[i].Data.data(), sizeof(Float4x4));
+			break;
+		}
+	}
+}
+
+const StreamElement* SoftwareDeviceContext::FindElement(const char* semantic) const
+{
+	for (size_t i = 0; i < mInputLayout->Elements.size(); i++)
+	{
+		if (strcmp(mInputLayout->Elements[i].Element.Semantic, semantic) == 0)
+		{
+			return &mInputLayout->Elements[i];
+		}
+	}
+	return nullptr;
+}
+
+bool SoftwareDeviceContext::FetchAttribute(const StreamElement& element, uint32_t vertex, Float4& value) const
+{
+	if (element.Stream >= MaxVertexBuffers)
+	{
+		return false;
+	}
+	const VertexBufferBinding& binding = mVertexBuffers[element.Stream];
+	const NullRenderDevice::Buffer* buffer = NullRenderDevice::ToBuffer(binding.Buffer);
+	if (buffer == nullptr)
+	{
+		return false;
+	}
+
+	uint64_t offset = binding.Offset + static_cast<uint64_t>(vertex) * binding.Stride + element.Element.Offset;
+	if (offset + VertexAttributeSize(element.Element.Format) > buffer->Data.size())
+	{
+		return false;
+	}
+	const uint8_t* data = buffer->Data.data() + offset;
+
+	// Missing components read as (0, 0, 0, 1) like the input assembler
+	float components[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+	if (element.Element.Format == VertexAttributeFormat::UNorm8x4)
+	{
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			components[i] = data[i] / 255.0f;
+		}
+	}
+	else
+	{
+		memcpy(components, data, VertexAttributeSize(element.Element.Format));
+	}
+	value = Float4(components[0], components[1], components[2], components[3]);
+	return true;
+}
+
+void SoftwareDeviceContext::DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex)
+{
+	NullDeviceContext::DrawIndexed(indexCount, startIndex, baseVertex);
+
+	if (mPrimitiveTopology != PrimitiveTopology::TriangleList || mPipeline == Pipeline::None
+		|| mInputLayout == nullptr || mIndexBuffer == nullptr || indexCount == 0)
+	{
+		return;
+	}
+
+	const StreamElement* position = FindElement("POSITION");
+	const StreamElement* attribute = FindElement(mPipeline == Pipeline::Color ? "COLOR" : "NORMAL");
+	if (position == nullptr || attribute == nullptr)
+	{
+		return;
+	}
+
+	uint32_t indexSize = mIndexFormat == IndexFormat::UInt16 ? 2 : 4;
+	uint64_t indexEnd = mIndexOffset + (static_cast<uint64_t>(startIndex) + indexCount) * indexSize;
+	if (indexEnd > mIndexBuffer->Data.size())
+	{
+		return;
+	}
+
+	// Only the vertices between the smallest and largest index go through the vertex stage
+	const uint8_t* indexData = mIndexBuffer->Data.data() + mIndexOffset + static_cast<uint64_t>(startIndex) * indexSize;
+	mIndices.resize(indexCount);
+	int64_t minVertex = INT64_MAX;
+	int64_t maxVertex = INT64_MIN;
+	for (uint32_t i = 0; i < indexCount; i++)
+	{
+		uint32_t index = 0;
+		if (indexSize == 2)
+		{
+			uint16_t index16;
+			memcpy(&index16, indexData + i * 2, 2);
+			index = index16;
+		}
+		else
+		{
+			memcpy(&index, indexData + i * 4, 4);
+		}
+
+		int64_t vertex = static_cast<int64_t>(index) + baseVertex;
+		minVertex = std::min(minVertex, vertex);
+		maxVertex = std::max(maxVertex, vertex);
+		mIndices[i] = index;
+	}
+	if (minVertex < 0)
+	{
+		return;
+	}
+
+	mVertices.resize(static_cast<size_t>(maxVertex - minVertex + 1));
+	for (size_t i = 0; i < mVertices.size(); i++)
+	{
+		uint32_t vertex = static_cast<uint32_t>(minVertex + i);
+
+		Float4 modelPosition;
+		Float4 value;
+		if (!FetchAttribute(*position, vertex, modelPosition) || !FetchAttribute(*attribute, vertex, value))
+		{
+			return;
+		}
+
+		RasterVertex& output = mVertices[i];
+		output.Position = Transform(Float4(modelPosition.x, modelPosition.y, modelPosition.z, 1.0f), mWorldViewProj);
+		if (mPipeline == Pipeline::Color)
+		{
+			output.Color = value;
+		}
+		else
+		{
+			output.Color = Float4(value.x * 0.5f + 0.5f, value.y * 0.5f + 0.5f, value.z * 0.5f + 0.5f, 1.0f);
+		}
+	}
+
+	// Indices relative to the first transformed vertex
+	uint32_t firstIndex = static_cast<uint32_t>(minVertex - baseVertex);
+	for (uint32_t i = 0; i < indexCount; i++)
+	{
+		mIndices[i] -= firstIndex;
+	}
+
+	mRasterizer.DrawTriangles(mVertices.data(), mIndices.data(), indexCount);
+}
+
+void SoftwareDeviceContext::EndFrame()
+{
+	mRasterizer.Flush();
+}
+
+SoftwareRenderDevice::SoftwareRenderDevice(uint32_t width, uint32_t height, uint32_t threadCount)
+	: mRasterizer(threadCount)
+	, mContext(mRasterizer)
+{
+	mRasterizer.Resize(width, height);
+}
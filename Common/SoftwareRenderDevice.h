@@ -0,0 +1,98 @@
+#ifndef SOFTWARERENDERDEVICE_H
+#define SOFTWARERENDERDEVICE_H
+
+#include "NullRenderDevice.h"
+#include "SoftwareRasterizer.h"
+
+#include <vector>
+
+// Null context that also draws. Runs the vertex stage of the book's effects
+// on the CPU and hands the triangles to a SoftwareRasterizer:
+//	ColorTech (color.fx)	outputs the COLOR attribute
+//	NormalTech (normal.fx)	outputs the NORMAL attribute mapped to [0, 1]
+// Both transform POSITION by gWorldViewProj. Like the effects framework the
+// constants of a pass are read when it is applied. Only triangle lists are
+// drawn, other topologies are counted and skipped.
+class SoftwareDeviceContext : public NullDeviceContext
+{
+public:
+	explicit SoftwareDeviceContext(SoftwareRasterizer& rasterizer);
+
+	void ClearRenderTarget(const Float4& color);
+	void ClearDepthStencil(float depth, uint8_t stencil);
+	void SetInputLayout(RenderInputLayout* layout);
+	void SetPrimitiveTopology(PrimitiveTopology topology);
+	void SetVertexBuffer(uint32_t slot, RenderBuffer* buffer, uint32_t stride, uint32_t offset);
+	void SetIndexBuffer(RenderBuffer* buffer, IndexFormat format, uint32_t offset);
+	void SetConstants(RenderConstant* constant, const void* data, uint32_t size);
+	void ApplyPass(RenderPass* pass);
+	void DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex);
+
+	// Finishes the frame, call where a window would present
+	void EndFrame();
+
+	static const uint32_t MaxVertexBuffers = 16;
+
+private:
+	enum class Pipeline
+	{
+		None,
+		Color,
+		Normal
+	};
+
+	struct VertexBufferBinding
+	{
+		RenderBuffer* Buffer;
+		uint32_t Stride;
+		uint32_t Offset;
+	};
+
+	struct ConstantValue
+	{
+		RenderConstant* Constant;
+		std::vector<uint8_t> Data;
+	};
+
+	// Element of the bound layout, or null
+	const StreamElement* FindElement(const char* semantic) const;
+	// Returns false if the vertex is outside the bound buffer
+	bool FetchAttribute(const StreamElement& element, uint32_t vertex, Float4& value) const;
+
+	SoftwareRasterizer& mRasterizer;
+
+	const NullRenderDevice::InputLayout* mInputLayout;
+	PrimitiveTopology mPrimitiveTopology;
+	VertexBufferBinding mVertexBuffers[MaxVertexBuffers];
+	const NullRenderDevice::Buffer* mIndexBuffer;
+	IndexFormat mIndexFormat;
+	uint32_t mIndexOffset;
+
+	std::vector<ConstantValue> mConstants;
+
+	Pipeline mPipeline;
+	Float4x4 mWorldViewProj;
+
+	// Reused between draws
+	std::vector<RasterVertex> mVertices;
+	std::vector<uint32_t> mIndices;
+};
+
+// Null device whose context rasterizes on the CPU into a width x height
+// target. threadCount includes the calling thread.
+class SoftwareRenderDevice : public NullRenderDevice
+{
+public:
+	SoftwareRenderDevice(uint32_t width, uint32_t height, uint32_t threadCount);
+
+	IDeviceContext& ImmediateContext() { return mContext; }
+	SoftwareDeviceContext& Context() { return mContext; }
+
+	SoftwareRasterizer& Rasterizer() { return mRasterizer; }
+
+private:
+	SoftwareRasterizer mRasterizer;
+	SoftwareDeviceContext mContext;
+};
+
+#endif // SOFTWARERENDERDEVICE_H
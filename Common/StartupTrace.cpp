@@ -0,0 +1,237 @@
+#include "StartupTrace.h"
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <ctime>
+#endif
+
+namespace
+{
+	std::atomic<uint64_t> fileBytesRead(0);
+
+	thread_local StartupTrace* currentTrace = nullptr;
+
+	const char* const rootName = "Startup";
+}
+
+void CountFileBytesRead(uint64_t bytes)
+{
+	fileBytesRead.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+uint64_t FileBytesRead()
+{
+	return fileBytesRead.load(std::memory_order_relaxed);
+}
+
+uint64_t ProcessCpuNanoseconds()
+{
+#ifdef _WIN32
+	FILETIME creation;
+	FILETIME exit;
+	FILETIME kernel;
+	FILETIME user;
+	if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+	{
+		return 0;
+	}
+	// 100 ns units
+	uint64_t kernelTime = (static_cast<uint64_t>(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime;
+	uint64_t userTime = (static_cast<uint64_t>(user.dwHighDateTime) << 32) | user.dwLowDateTime;
+	return (kernelTime + userTime) * 100;
+#else
+	timespec time;
+	if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time) != 0)
+	{
+		return 0;
+	}
+	return static_cast<uint64_t>(time.tv_sec) * 1000000000ull + static_cast<uint64_t>(time.tv_nsec);
+#endif
+}
+
+StartupTrace::StartupTrace()
+	: mRunning(false)
+{
+}
+
+StartupTrace::~StartupTrace()
+{
+	if (currentTrace == this)
+	{
+		currentTrace = nullptr;
+	}
+}
+
+StartupTrace* StartupTrace::Current()
+{
+	return currentTrace;
+}
+
+void StartupTrace::Begin()
+{
+	mPhases.clear();
+	mOpen.clear();
+	mOrigin = std::chrono::steady_clock::now();
+	mRunning = true;
+	currentTrace = this;
+	BeginPhase(rootName);
+}
+
+void StartupTrace::End()
+{
+	if (!mRunning)
+	{
+		return;
+	}
+	if (!mOpen.empty())
+	{
+		// Closes everything nested in it too
+		EndPhase(mOpen[0]);
+	}
+	mRunning = false;
+	if (currentTrace == this)
+	{
+		currentTrace = nullptr;
+	}
+}
+
+uint32_t StartupTrace::BeginPhase(const char* name)
+{
+	StartupPhaseRecord phase;
+	phase.Name = name;
+	phase.Parent = mOpen.empty() ? -1 : static_cast<int32_t>(mOpen.back());
+	phase.Depth = static_cast<uint32_t>(mOpen.size());
+	phase.StartNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - mOrigin).count());
+	// Start values until the phase ends
+	phase.WallNs = 0;
+	phase.CpuNs = ProcessCpuNanoseconds();
+	phase.Allocations = AllocationCount();
+	phase.AllocatedBytes = AllocatedBytes();
+	phase.FileBytes = FileBytesRead();
+
+	uint32_t index = static_cast<uint32_t>(mPhases.size());
+	mPhases.push_back(phase);
+	mOpen.push_back(index);
+	return index;
+}
+
+void StartupTrace::EndPhase(uint32_t index)
+{
+	uint64_t now = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - mOrigin).count());
+	uint64_t cpu = ProcessCpuNanoseconds();
+	uint64_t allocations = AllocationCount();
+	uint64_t allocatedBytes = AllocatedBytes();
+	uint64_t fileBytes = FileBytesRead();
+
+	// Phases left open inside it end with it
+	while (!mOpen.empty())
+	{
+		uint32_t open = mOpen.back();
+		mOpen.pop_back();
+
+		StartupPhaseRecord& phase = mPhases[open];
+		phase.WallNs = now - phase.StartNs;
+		phase.CpuNs = cpu - phase.CpuNs;
+		phase.Allocations = allocations - phase.Allocations;
+		phase.AllocatedBytes = allocatedBytes - phase.AllocatedBytes;
+		phase.FileBytes = fileBytes - phase.FileBytes;
+		if (open == index)
+		{
+			break;
+		}
+	}
+}
+
+std::vector<StartupTrace::PathTotals> StartupTrace::Totals() const
+{
+	std::vector<std::string> paths(mPhases.size());
+	std::vector<uint64_t> childWallNs(mPhases.size(), 0);
+	for (size_t i = 0; i < mPhases.size(); i++)
+	{
+		const StartupPhaseRecord& phase = mPhases[i];
+		paths[i] = phase.Parent < 0 ? std::string(phase.Name) : paths[phase.Parent] + ";" + phase.Name;
+		if (phase.Parent >= 0)
+		{
+			childWallNs[phase.Parent] += phase.WallNs;
+		}
+	}
+
+	std::vector<PathTotals> totals;
+	for (size_t i = 0; i < mPhases.size(); i++)
+	{
+		const StartupPhaseRecord& phase = mPhases[i];
+		size_t slot = 0;
+		while (slot < totals.size() && totals[slot].Path != paths[i])
+		{
+			slot++;
+		}
+		if (slot == totals.size())
+		{
+			PathTotals path = {};
+			path.Path = paths[i];
+			path.Depth = phase.Depth;
+			totals.push_back(path);
+		}
+
+		PathTotals& path = totals[slot];
+		path.Count++;
+		path.Inclusive.WallNs += phase.WallNs;
+		path.Inclusive.CpuNs += phase.CpuNs;
+		path.Inclusive.Allocations += phase.Allocations;
+		path.Inclusive.AllocatedBytes += phase.AllocatedBytes;
+		path.Inclusive.FileBytes += phase.FileBytes;
+		path.SelfWallNs += phase.WallNs > childWallNs[i] ? phase.WallNs - childWallNs[i] : 0;
+	}
+	return totals;
+}
+
+std::string StartupTrace::Report() const
+{
+	std::string report = "Startup phase                          wall ms   self ms    cpu ms    allocs   alloc KB    file KB\n";
+	std::vector<PathTotals> totals = Totals();
+	for (size_t i = 0; i < totals.size(); i++)
+	{
+		const PathTotals& path = totals[i];
+		size_t separator = path.Path.find_last_of(';');
+		std::string name = std::string(path.Depth * 2, ' ') + path.Path.substr(separator == std::string::npos ? 0 : separator + 1);
+		if (path.Count > 1)
+		{
+			name += " x" + std::to_string(path.Count);
+		}
+
+		char line[256];
+		snprintf(line, sizeof(line), "%-36s %9.2f %9.2f %9.2f %9llu %10.1f %10.1f\n"
+			, name.c_str()
+			, path.Inclusive.WallNs / 1e6
+			, path.SelfWallNs / 1e6
+			, path.Inclusive.CpuNs / 1e6
+			, static_cast<unsigned long long>(path.Inclusive.Allocations)
+			, path.Inclusive.AllocatedBytes / 1024.0
+			, path.Inclusive.FileBytes / 1024.0);
+		report += line;
+	}
+	return report;
+}
+
+bool StartupTrace::WriteFoldedStacks(const std::string& fileName) const
+{
+	FILE* file = fopen(fileName.c_str(), "w");
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	std::vector<PathTotals> totals = Totals();
+	for (size_t i = 0; i < totals.size(); i++)
+	{
+		// Flame graphs take whole samples, a phase shorter than 1 us still shows
+		uint64_t selfUs = (totals[i].SelfWallNs + 500) / 1000;
+		fprintf(file, "%s %llu\n", totals[i].Path.c_str(), static_cast<unsigned long long>(selfUs > 0 ? selfUs : 1));
+	}
+	return fclose(file) == 0;
+}
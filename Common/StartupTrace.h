@@ -0,0 +1,126 @@
+#ifndef STARTUPTRACE_H
+#define STARTUPTRACE_H
+
+#include "FrameProfiler.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Loaders report the bytes they read from files, the trace shows them per phase
+void CountFileBytesRead(uint64_t bytes);
+uint64_t FileBytesRead();
+
+// CPU time of all threads of the process
+uint64_t ProcessCpuNanoseconds();
+
+// A phase, inclusive of the phases nested in it
+struct StartupPhaseRecord
+{
+	const char* Name;
+	int32_t Parent;			// Index of the enclosing phase, -1 for the root
+	uint32_t Depth;
+	uint64_t StartNs;		// Since Begin
+	uint64_t WallNs;
+	uint64_t CpuNs;
+	uint64_t Allocations;
+	uint64_t AllocatedBytes;
+	uint64_t FileBytes;
+};
+
+// Records nested phases of application startup with their wall time, CPU
+// time, heap allocations and file bytes read:
+//
+//	StartupTrace trace;
+//	trace.Begin();
+//	...
+//	{
+//		STARTUP_PHASE("BuildFX");
+//		...
+//	}
+//	trace.End();
+//	LogMessage(trace.Report());
+//	trace.WriteFoldedStacks("startup.folded");
+//
+// Phases are recorded on the thread that called Begin and only while the
+// trace is running, STARTUP_PHASE elsewhere is only a PROFILE_SCOPE. Begin
+// opens a root phase named "Startup" that End closes. Allocations need
+// AllocationCounter.cpp linked in.
+class StartupTrace
+{
+public:
+	StartupTrace();
+	~StartupTrace();
+
+	void Begin();
+	void End();
+	bool IsRunning() const { return mRunning; }
+
+	// Index of the new phase
+	uint32_t BeginPhase(const char* name);
+	void EndPhase(uint32_t index);
+
+	// In the order they began
+	const std::vector<StartupPhaseRecord>& Phases() const { return mPhases; }
+
+	// A table of the phases merged by path, with inclusive and self times
+	std::string Report() const;
+
+	// Self wall time in microseconds per stack, "Startup;Init;BuildFX 1234",
+	// for flamegraph.pl, speedscope or inferno
+	bool WriteFoldedStacks(const std::string& fileName) const;
+
+	// The trace the calling thread records into, null if none is running
+	static StartupTrace* Current();
+
+private:
+	StartupTrace(const StartupTrace&);
+	StartupTrace& operator=(const StartupTrace&);
+
+	struct PathTotals
+	{
+		std::string Path;
+		uint32_t Depth;
+		uint32_t Count;
+		StartupPhaseRecord Inclusive;	// Summed, Name and Parent unused
+		uint64_t SelfWallNs;
+	};
+
+	// Phases with the same path merged, in the order their path first began
+	std::vector<PathTotals> Totals() const;
+
+	std::vector<StartupPhaseRecord> mPhases;
+	std::vector<uint32_t> mOpen;
+	std::chrono::steady_clock::time_point mOrigin;
+	bool mRunning;
+};
+
+class StartupPhase
+{
+public:
+	explicit StartupPhase(const char* name)
+		: mTrace(StartupTrace::Current())
+		, mIndex(mTrace != nullptr ? mTrace->BeginPhase(name) : 0)
+	{
+	}
+
+	~StartupPhase()
+	{
+		if (mTrace != nullptr)
+		{
+			mTrace->EndPhase(mIndex);
+		}
+	}
+
+private:
+	StartupPhase(const StartupPhase&);
+	StartupPhase& operator=(const StartupPhase&);
+
+	StartupTrace* mTrace;
+	uint32_t mIndex;
+};
+
+// A PROFILE_SCOPE that is also a phase of the running StartupTrace
+#define STARTUP_PHASE(name) PROFILE_SCOPE(name); StartupPhase PROFILE_CONCATENATE(startupPhase, __LINE__)(name)
+
+#endif // STARTUPTRACE_H
@@ -0,0 +1,214 @@
+#include "StateCache.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+
+const char* StateCallName(StateCall call)
+{
+	switch (call)
+	{
+	case StateCall::InputLayout: return "layout";
+	case StateCall::PrimitiveTopology: return "topology";
+	case StateCall::VertexBuffer: return "vb";
+	case StateCall::IndexBuffer: return "ib";
+	case StateCall::Constants: return "constants";
+	case StateCall::Pass: return "pass";
+	case StateCall::Draw: return "draw";
+	default: return "unknown";
+	}
+}
+
+//
+// StateCacheStats
+//
+
+uint32_t StateCacheStats::TotalIssued() const
+{
+	uint32_t total = 0;
+	for (int i = 0; i < static_cast<int>(StateCall::Count); i++)
+	{
+		total += Issued[i];
+	}
+	return total;
+}
+
+uint32_t StateCacheStats::TotalElided() const
+{
+	uint32_t total = 0;
+	for (int i = 0; i < static_cast<int>(StateCall::Count); i++)
+	{
+		total += Elided[i];
+	}
+	return total;
+}
+
+std::string StateCacheSummary(const StateCacheStats& stats)
+{
+	char summary[256];
+	FormatStateCacheSummary(stats, summary, sizeof(summary));
+	return summary;
+}
+
+void FormatStateCacheSummary(const StateCacheStats& stats, char* buffer, size_t size)
+{
+	// Only the calls the cache can drop
+	const StateCall filtered[] = { StateCall::InputLayout, StateCall::PrimitiveTopology,
+		StateCall::VertexBuffer, StateCall::IndexBuffer, StateCall::Pass };
+
+	size_t length = 0;
+	auto append = [&](int written)
+	{
+		length = written < 0 ? length : std::min(size - 1, length + written);
+	};
+
+	append(snprintf(buffer, size, "State: %u issued, %u elided (", stats.TotalIssued(), stats.TotalElided()));
+	for (size_t i = 0; i < sizeof(filtered) / sizeof(filtered[0]); i++)
+	{
+		int index = static_cast<int>(filtered[i]);
+		append(snprintf(buffer + length, size - length, "%s%s %u/%u", i > 0 ? " " : "", StateCallName(filtered[i]), stats.Issued[index], stats.Elided[index]));
+	}
+	append(snprintf(buffer + length, size - length, ")"));
+}
+
+//
+// StateCachedContext
+//
+
+StateCachedContext::StateCachedContext(IDeviceContext& context)
+	: mContext(context)
+	, mCurrent()
+	, mLast()
+{
+	Invalidate();
+}
+
+void StateCachedContext::Count(StateCall call, bool issued)
+{
+	if (issued)
+	{
+		mCurrent.Issued[static_cast<int>(call)]++;
+	}
+	else
+	{
+		mCurrent.Elided[static_cast<int>(call)]++;
+	}
+}
+
+void StateCachedContext::ClearRenderTarget(const Float4& color)
+{
+	mContext.ClearRenderTarget(color);
+}
+
+void StateCachedContext::ClearDepthStencil(float depth, uint8_t stencil)
+{
+	mContext.ClearDepthStencil(depth, stencil);
+}
+
+void StateCachedContext::SetInputLayout(RenderInputLayout* layout)
+{
+	bool issue = !mLayoutValid || mLayout != layout;
+	if (issue)
+	{
+		mContext.SetInputLayout(layout);
+		mLayout = layout;
+		mLayoutValid = true;
+	}
+	Count(StateCall::InputLayout, issue);
+}
+
+void StateCachedContext::SetPrimitiveTopology(PrimitiveTopology topology)
+{
+	bool issue = !mTopologyValid || mTopology != topology;
+	if (issue)
+	{
+		mContext.SetPrimitiveTopology(topology);
+		mTopology = topology;
+		mTopologyValid = true;
+	}
+	Count(StateCall::PrimitiveTopology, issue);
+}
+
+void StateCachedContext::SetVertexBuffer(uint32_t slot, RenderBuffer* buffer, uint32_t stride, uint32_t offset)
+{
+	assert(slot < MaxVertexBuffers && "Vertex buffer slot out of range");
+
+	VertexBufferBinding& binding = mVertexBuffers[slot];
+	uint32_t slotBit = 1u << slot;
+	bool issue = (mValidVertexBuffers & slotBit) == 0
+		|| binding.Buffer != buffer || binding.Stride != stride || binding.Offset != offset;
+	if (issue)
+	{
+		mContext.SetVertexBuffer(slot, buffer, stride, offset);
+		binding.Buffer = buffer;
+		binding.Stride = stride;
+		binding.Offset = offset;
+		mValidVertexBuffers |= slotBit;
+	}
+	Count(StateCall::VertexBuffer, issue);
+}
+
+void StateCachedContext::SetIndexBuffer(RenderBuffer* buffer, IndexFormat format, uint32_t offset)
+{
+	bool issue = !mIndexBufferValid
+		|| mIndexBuffer != buffer || mIndexFormat != format || mIndexOffset != offset;
+	if (issue)
+	{
+		mContext.SetIndexBuffer(buffer, format, offset);
+		mIndexBuffer = buffer;
+		mIndexFormat = format;
+		mIndexOffset = offset;
+		mIndexBufferValid = true;
+	}
+	Count(StateCall::IndexBuffer, issue);
+}
+
+void StateCachedContext::SetConstants(RenderConstant* constant, const void* data, uint32_t size)
+{
+	mContext.SetConstants(constant, data, size);
+	mPassDirty = true;
+	Count(StateCall::Constants, true);
+}
+
+void StateCachedContext::ApplyPass(RenderPass* pass)
+{
+	bool issue = mPassDirty || mPass != pass;
+	if (issue)
+	{
+		mContext.ApplyPass(pass);
+		mPass = pass;
+		mPassDirty = false;
+	}
+	Count(StateCall::Pass, issue);
+}
+
+void StateCachedContext::DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex)
+{
+	mContext.DrawIndexed(indexCount, startIndex, baseVertex);
+	Count(StateCall::Draw, true);
+}
+
+void StateCachedContext::Invalidate()
+{
+	mLayoutValid = false;
+	mLayout = nullptr;
+	mTopologyValid = false;
+	mTopology = PrimitiveTopology::TriangleList;
+	mValidVertexBuffers = 0;
+	for (uint32_t i = 0; i < MaxVertexBuffers; i++)
+	{
+		mVertexBuffers[i] = VertexBufferBinding();
+	}
+	mIndexBufferValid = false;
+	mIndexBuffer = nullptr;
+	mIndexFormat = IndexFormat::UInt32;
+	mIndexOffset = 0;
+	mPass = nullptr;
+	mPassDirty = true;
+}
+
+void StateCachedContext::BeginFrame()
+{
+	mLast = mCurrent;
+	mCurrent = StateCacheStats();
+}
@@ -0,0 +1,96 @@
+#ifndef STATECACHE_H
+#define STATECACHE_H
+
+#include "DeviceContext.h"
+
+#include <cstdint>
+#include <string>
+
+enum class StateCall
+{
+	InputLayout,
+	PrimitiveTopology,
+	VertexBuffer,
+	IndexBuffer,
+	Constants,
+	Pass,
+	Draw,
+	Count
+};
+
+const char* StateCallName(StateCall call);
+
+struct StateCacheStats
+{
+	uint32_t Issued[static_cast<int>(StateCall::Count)];
+	uint32_t Elided[static_cast<int>(StateCall::Count)];
+
+	uint32_t TotalIssued() const;
+	uint32_t TotalElided() const;
+};
+
+std::string StateCacheSummary(const StateCacheStats& stats);
+// The same into 'buffer' without allocating, truncated to fit
+void FormatStateCacheSummary(const StateCacheStats& stats, char* buffer, size_t size);
+
+// Sits in front of another context and drops calls that would bind state
+// which is already bound. Constants are always forwarded, but a pass is
+// re-applied after any constant change since applying the pass is what
+// uploads the effect constants. Anything that changes the real context
+// behind the cache's back must be followed by Invalidate.
+class StateCachedContext : public IDeviceContext
+{
+public:
+	static const uint32_t MaxVertexBuffers = 16;
+
+	explicit StateCachedContext(IDeviceContext& context);
+
+	void ClearRenderTarget(const Float4& color);
+	void ClearDepthStencil(float depth, uint8_t stencil);
+	void SetInputLayout(RenderInputLayout* layout);
+	void SetPrimitiveTopology(PrimitiveTopology topology);
+	void SetVertexBuffer(uint32_t slot, RenderBuffer* buffer, uint32_t stride, uint32_t offset);
+	void SetIndexBuffer(RenderBuffer* buffer, IndexFormat format, uint32_t offset);
+	void SetConstants(RenderConstant* constant, const void* data, uint32_t size);
+	void ApplyPass(RenderPass* pass);
+	void DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex);
+
+	// Forgets all bound state so the next call of every kind is issued
+	void Invalidate();
+
+	// Starts new counters, the previous frame stays in LastFrame
+	void BeginFrame();
+
+	const StateCacheStats& CurrentFrame() const { return mCurrent; }
+	const StateCacheStats& LastFrame() const { return mLast; }
+
+private:
+	struct VertexBufferBinding
+	{
+		RenderBuffer* Buffer;
+		uint32_t Stride;
+		uint32_t Offset;
+	};
+
+	void Count(StateCall call, bool issued);
+
+	IDeviceContext& mContext;
+
+	bool mLayoutValid;
+	RenderInputLayout* mLayout;
+	bool mTopologyValid;
+	PrimitiveTopology mTopology;
+	uint32_t mValidVertexBuffers;	// One bit per slot
+	VertexBufferBinding mVertexBuffers[MaxVertexBuffers];
+	bool mIndexBufferValid;
+	RenderBuffer* mIndexBuffer;
+	IndexFormat mIndexFormat;
+	uint32_t mIndexOffset;
+	RenderPass* mPass;
+	bool mPassDirty;
+
+	StateCacheStats mCurrent;
+	StateCacheStats mLast;
+};
+
+#endif // STATECACHE_H
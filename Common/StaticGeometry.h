@@ -0,0 +1,420 @@
+#ifndef STATICGEOMETRY_H
+#define STATICGEOMETRY_H
+
+#include "MathTypes.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// constexpr versions of the GeometryGenerator shapes. The generators return
+// fixed size arrays so small meshes can be baked into the executable:
+//
+//	static constexpr auto box = StaticGeometry::MakeBox(1.0f, 1.0f, 1.0f);
+//
+// They also work at runtime. Large grids and spheres can exceed the default
+// constexpr step limit of the compiler, generate those at runtime instead.
+
+namespace StaticGeometry
+{
+	constexpr float Pi = 3.1415926535f;
+
+	// Vertex layout matching GeometryGenerator::Vertex
+	struct MeshVertex
+	{
+		Float3 Position;
+		Float3 Normal;
+		Float3 TangentU;
+		Float2 TexC;
+	};
+
+	template<size_t VertexCount, size_t IndexCount>
+	struct StaticMesh
+	{
+		std::array<MeshVertex, VertexCount> Vertices;
+		std::array<uint32_t, IndexCount> Indices;
+	};
+
+	//
+	// Math usable in constant expressions
+	//
+
+	constexpr float Sqrt(float value)
+	{
+		if (value <= 0.0f)
+		{
+			return 0.0f;
+		}
+		float guess = value > 1.0f ? value : 1.0f;
+		for (int i = 0; i < 32; i++)
+		{
+			guess = 0.5f * (guess + value / guess);
+		}
+		return guess;
+	}
+
+	constexpr float Sin(float radians)
+	{
+		// Reduce to [-Pi, Pi] and evaluate the Taylor series
+		double x = radians;
+		const double twoPi = 6.283185307179586;
+		long long turns = static_cast<long long>(x / twoPi);
+		x -= static_cast<double>(turns) * twoPi;
+		if (x > 3.141592653589793)
+		{
+			x -= twoPi;
+		}
+		else if (x < -3.141592653589793)
+		{
+			x += twoPi;
+		}
+
+		double term = x;
+		double sum = x;
+		for (int n = 1; n < 12; n++)
+		{
+			term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+			sum += term;
+		}
+		return static_cast<float>(sum);
+	}
+
+	constexpr float Cos(float radians)
+	{
+		return Sin(radians + 0.5f * Pi);
+	}
+
+	constexpr Float3 Normalize(Float3 v)
+	{
+		float length = Sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+		return length > 0.0f ? Float3(v.x / length, v.y / length, v.z / length) : v;
+	}
+
+	//
+	// Generators
+	//
+
+	// Cube with one vertex per corner, suited for per-vertex colors.
+	// Vertex and index order matches the Box demo.
+	constexpr StaticMesh<8, 36> MakeCornerBox(float width, float height, float depth)
+	{
+		float w = 0.5f * width;
+		float h = 0.5f * height;
+		float d = 0.5f * depth;
+
+		StaticMesh<8, 36> mesh = {};
+		const Float3 corners[8] =
+		{
+			Float3(-w, -h, -d),
+			Float3(-w, +h, -d),
+			Float3(+w, +h, -d),
+			Float3(+w, -h, -d),
+			Float3(-w, -h, +d),
+			Float3(-w, +h, +d),
+			Float3(+w, +h, +d),
+			Float3(+w, -h, +d)
+		};
+		for (size_t i = 0; i < 8; i++)
+		{
+			mesh.Vertices[i].Position = corners[i];
+			mesh.Vertices[i].Normal = Normalize(corners[i]);
+		}
+
+		const uint32_t indices[36] =
+		{
+			// front face
+			0, 1, 2,
+			0, 2, 3,
+
+			// back face
+			4, 6, 5,
+			4, 7, 6,
+
+			// left face
+			4, 5, 1,
+			4, 1, 0,
+
+			// right face
+			3, 2, 6,
+			3, 6, 7,
+
+			// top face
+			1, 5, 6,
+			1, 6, 2,
+
+			// bottom face
+			4, 0, 3,
+			4, 3, 7
+		};
+		for (size_t i = 0; i < 36; i++)
+		{
+			mesh.Indices[i] = indices[i];
+		}
+		return mesh;
+	}
+
+	// Box with separate vertices for every face, same as GeometryGenerator::CreateBox
+	constexpr StaticMesh<24, 36> MakeBox(float width, float height, float depth)
+	{
+		float w = 0.5f * width;
+		float h = 0.5f * height;
+		float d = 0.5f * depth;
+
+		StaticMesh<24, 36> mesh = {};
+
+		// Per face: normal, tangent and the four corners
+		struct Face
+		{
+			Float3 Normal;
+			Float3 Tangent;
+			Float3 Corners[4];
+		};
+
+		const Face faces[6] =
+		{
+			// front
+			{ Float3(0, 0, -1), Float3(1, 0, 0), { Float3(-w, -h, -d), Float3(-w, +h, -d), Float3(+w, +h, -d), Float3(+w, -h, -d) } },
+			// back
+			{ Float3(0, 0, 1), Float3(-1, 0, 0), { Float3(-w, -h, +d), Float3(+w, -h, +d), Float3(+w, +h, +d), Float3(-w, +h, +d) } },
+			// top
+			{ Float3(0, 1, 0), Float3(1, 0, 0), { Float3(-w, +h, -d), Float3(-w, +h, +d), Float3(+w, +h, +d), Float3(+w, +h, -d) } },
+			// bottom
+			{ Float3(0, -1, 0), Float3(-1, 0, 0), { Float3(-w, -h, -d), Float3(+w, -h, -d), Float3(+w, -h, +d), Float3(-w, -h, +d) } },
+			// left
+			{ Float3(-1, 0, 0), Float3(0, 0, -1), { Float3(-w, -h, +d), Float3(-w, +h, +d), Float3(-w, +h, -d), Float3(-w, -h, -d) } },
+			// right
+			{ Float3(1, 0, 0), Float3(0, 0, 1), { Float3(+w, -h, -d), Float3(+w, +h, -d), Float3(+w, +h, +d), Float3(+w, -h, +d) } }
+		};
+
+		const Float2 texCoords[4] = { Float2(0, 1), Float2(0, 0), Float2(1, 0), Float2(1, 1) };
+
+		for (uint32_t f = 0; f < 6; f++)
+		{
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				MeshVertex& v = mesh.Vertices[f * 4 + c];
+				v.Position = faces[f].Corners[c];
+				v.Normal = faces[f].Normal;
+				v.TangentU = faces[f].Tangent;
+				v.TexC = texCoords[c];
+			}
+
+			uint32_t base = f * 4;
+			mesh.Indices[f * 6 + 0] = base + 0;
+			mesh.Indices[f * 6 + 1] = base + 1;
+			mesh.Indices[f * 6 + 2] = base + 2;
+			mesh.Indices[f * 6 + 3] = base + 0;
+			mesh.Indices[f * 6 + 4] = base + 2;
+			mesh.Indices[f * 6 + 5] = base + 3;
+		}
+		return mesh;
+	}
+
+	// Square based pyramid standing on the xz plane, apex on the y axis.
+	// Vertex and index order matches the Box demo.
+	constexpr StaticMesh<5, 18> MakePyramid(float baseWidth, float height)
+	{
+		float w = 0.5f * baseWidth;
+
+		StaticMesh<5, 18> mesh = {};
+		const Float3 positions[5] =
+		{
+			Float3(-w, 0.0f, +w),
+			Float3(+w, 0.0f, +w),
+			Float3(+w, 0.0f, -w),
+			Float3(-w, 0.0f, -w),
+			Float3(0.0f, height, 0.0f)
+		};
+		for (size_t i = 0; i < 5; i++)
+		{
+			mesh.Vertices[i].Position = positions[i];
+			mesh.Vertices[i].Normal = Normalize(Float3(positions[i].x, positions[i].y - 0.5f * height, positions[i].z));
+		}
+
+		const uint32_t indices[18] =
+		{
+			0, 2, 1,
+			2, 0, 3,
+
+			4, 0, 1,
+			4, 1, 2,
+			4, 2, 3,
+			4, 3, 0
+		};
+		for (size_t i = 0; i < 18; i++)
+		{
+			mesh.Indices[i] = indices[i];
+		}
+		return mesh;
+	}
+
+	// Tessellated grid on the xz plane, same layout as GeometryGenerator::CreateGrid.
+	// Rows go along z, Columns along x.
+	template<uint32_t Rows, uint32_t Columns>
+	constexpr StaticMesh<Rows * Columns, (Rows - 1) * (Columns - 1) * 6> MakeGrid(float width, float depth)
+	{
+		static_assert(Rows >= 2 && Columns >= 2, "Grid needs at least 2x2 vertices");
+
+		StaticMesh<Rows * Columns, (Rows - 1) * (Columns - 1) * 6> mesh = {};
+
+		float halfWidth = 0.5f * width;
+		float halfDepth = 0.5f * depth;
+		float dx = width / (Columns - 1);
+		float dz = depth / (Rows - 1);
+		float du = 1.0f / (Columns - 1);
+		float dv = 1.0f / (Rows - 1);
+
+		for (uint32_t i = 0; i < Rows; i++)
+		{
+			float z = halfDepth - i * dz;
+			for (uint32_t j = 0; j < Columns; j++)
+			{
+				MeshVertex& v = mesh.Vertices[i * Columns + j];
+				v.Position = Float3(-halfWidth + j * dx, 0.0f, z);
+				v.Normal = Float3(0.0f, 1.0f, 0.0f);
+				v.TangentU = Float3(1.0f, 0.0f, 0.0f);
+				v.TexC = Float2(j * du, i * dv);
+			}
+		}
+
+		uint32_t k = 0;
+		for (uint32_t i = 0; i < Rows - 1; i++)
+		{
+			for (uint32_t j = 0; j < Columns - 1; j++)
+			{
+				mesh.Indices[k + 0] = i * Columns + j;
+				mesh.Indices[k + 1] = i * Columns + j + 1;
+				mesh.Indices[k + 2] = (i + 1) * Columns + j;
+
+				mesh.Indices[k + 3] = (i + 1) * Columns + j;
+				mesh.Indices[k + 4] = i * Columns + j + 1;
+				mesh.Indices[k + 5] = (i + 1) * Columns + j + 1;
+				k += 6;
+			}
+		}
+		return mesh;
+	}
+
+	// UV sphere, same layout as GeometryGenerator::CreateSphere
+	template<uint32_t Slices, uint32_t Stacks>
+	constexpr StaticMesh<2 + (Stacks - 1) * (Slices + 1), Slices * 6 + (Stacks - 2) * Slices * 6> MakeSphere(float radius)
+	{
+		static_assert(Slices >= 3 && Stacks >= 2, "Sphere needs at least 3 slices and 2 stacks");
+
+		StaticMesh<2 + (Stacks - 1) * (Slices + 1), Slices * 6 + (Stacks - 2) * Slices * 6> mesh = {};
+
+		uint32_t v = 0;
+		mesh.Vertices[v].Position = Float3(0.0f, radius, 0.0f);
+		mesh.Vertices[v].Normal = Float3(0.0f, 1.0f, 0.0f);
+		mesh.Vertices[v].TangentU = Float3(1.0f, 0.0f, 0.0f);
+		mesh.Vertices[v].TexC = Float2(0.0f, 0.0f);
+		v++;
+
+		float phiStep = Pi / Stacks;
+		float thetaStep = 2.0f * Pi / Slices;
+
+		// Rings, the poles are not rings
+		for (uint32_t i = 1; i <= Stacks - 1; i++)
+		{
+			float phi = i * phiStep;
+			float sinPhi = Sin(phi);
+			float cosPhi = Cos(phi);
+
+			for (uint32_t j = 0; j <= Slices; j++)
+			{
+				float theta = j * thetaStep;
+				float sinTheta = Sin(theta);
+				float cosTheta = Cos(theta);
+
+				MeshVertex& vertex = mesh.Vertices[v++];
+				vertex.Position = Float3(radius * sinPhi * cosTheta, radius * cosPhi, radius * sinPhi * sinTheta);
+				vertex.Normal = Normalize(vertex.Position);
+				vertex.TangentU = Normalize(Float3(-radius * sinPhi * sinTheta, 0.0f, radius * sinPhi * cosTheta));
+				vertex.TexC = Float2(theta / (2.0f * Pi), phi / Pi);
+			}
+		}
+
+		mesh.Vertices[v].Position = Float3(0.0f, -radius, 0.0f);
+		mesh.Vertices[v].Normal = Float3(0.0f, -1.0f, 0.0f);
+		mesh.Vertices[v].TangentU = Float3(1.0f, 0.0f, 0.0f);
+		mesh.Vertices[v].TexC = Float2(0.0f, 1.0f);
+
+		uint32_t k = 0;
+
+		// Top cap
+		for (uint32_t i = 1; i <= Slices; i++)
+		{
+			mesh.Indices[k++] = 0;
+			mesh.Indices[k++] = i + 1;
+			mesh.Indices[k++] = i;
+		}
+
+		// Inner stacks
+		uint32_t baseIndex = 1;
+		uint32_t ringVertexCount = Slices + 1;
+		for (uint32_t i = 0; i < Stacks - 2; i++)
+		{
+			for (uint32_t j = 0; j < Slices; j++)
+			{
+				mesh.Indices[k++] = baseIndex + i * ringVertexCount + j;
+				mesh.Indices[k++] = baseIndex + i * ringVertexCount + j + 1;
+				mesh.Indices[k++] = baseIndex + (i + 1) * ringVertexCount + j;
+
+				mesh.Indices[k++] = baseIndex + (i + 1) * ringVertexCount + j;
+				mesh.Indices[k++] = baseIndex + i * ringVertexCount + j + 1;
+				mesh.Indices[k++] = baseIndex + (i + 1) * ringVertexCount + j + 1;
+			}
+		}
+
+		// Bottom cap
+		uint32_t southPoleIndex = v;
+		baseIndex = southPoleIndex - ringVertexCount;
+		for (uint32_t i = 0; i < Slices; i++)
+		{
+			mesh.Indices[k++] = southPoleIndex;
+			mesh.Indices[k++] = baseIndex + i;
+			mesh.Indices[k++] = baseIndex + i + 1;
+		}
+		return mesh;
+	}
+
+	// Copies positions into a vertex type with a Position member
+	template<typename PositionVertexType, size_t VertexCount, size_t IndexCount>
+	constexpr std::array<PositionVertexType, VertexCount> MakePositionVertices(const StaticMesh<VertexCount, IndexCount>& mesh)
+	{
+		std::array<PositionVertexType, VertexCount> vertices = {};
+		for (size_t i = 0; i < VertexCount; i++)
+		{
+			vertices[i].Position = mesh.Vertices[i].Position;
+		}
+		return vertices;
+	}
+
+	// Copies positions into a vertex type with a Position and Color member,
+	// taking the color of each vertex from 'colors'
+	template<typename ColorVertexType, size_t VertexCount, size_t IndexCount>
+	constexpr std::array<ColorVertexType, VertexCount> MakeColorVertices(const StaticMesh<VertexCount, IndexCount>& mesh, const std::array<Float4, VertexCount>& colors)
+	{
+		std::array<ColorVertexType, VertexCount> vertices = {};
+		for (size_t i = 0; i < VertexCount; i++)
+		{
+			vertices[i].Position = mesh.Vertices[i].Position;
+			vertices[i].Color = colors[i];
+		}
+		return vertices;
+	}
+
+	// Compile time checks of the generators
+	static_assert(MakeCornerBox(2.0f, 2.0f, 2.0f).Vertices[6].Position.x == 1.0f, "Corner box extents");
+	static_assert(MakeCornerBox(2.0f, 2.0f, 2.0f).Indices[35] == 7, "Corner box indices");
+	static_assert(MakeBox(1.0f, 1.0f, 1.0f).Indices[35] == 23, "Box indices");
+	static_assert(MakePyramid(2.0f, 2.0f).Vertices[4].Position.y == 2.0f, "Pyramid apex");
+	static_assert(MakeGrid<3, 4>(3.0f, 2.0f).Vertices.size() == 12, "Grid vertex count");
+	static_assert(MakeGrid<3, 4>(3.0f, 2.0f).Vertices[11].Position.x == 1.5f, "Grid extents");
+	static_assert(MakeGrid<3, 4>(3.0f, 2.0f).Indices[35] == 11, "Grid indices");
+	static_assert(MakeSphere<4, 3>(1.0f).Vertices.size() == 12, "Sphere vertex count");
+	static_assert(MakeSphere<4, 3>(1.0f).Indices[0] == 0 && MakeSphere<4, 3>(1.0f).Indices[47] == 10, "Sphere indices");
+	static_assert(Sin(0.5f * Pi) > 0.9999f && Cos(Pi) < -0.9999f, "constexpr trigonometry");
+}
+
+#endif // STATICGEOMETRY_H
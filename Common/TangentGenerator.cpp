@@ -0,0 +1,295 @@
+#include "TangentGenerator.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	const uint32_t triangleBatch = 1024;
+	const uint32_t vertexBatch = 2048;
+
+	// Corners of triangles whose texture coordinates are not mirrored
+	const uint8_t preservingFlag = 1;
+	const uint8_t degenerateFlag = 2;
+
+	template<typename T>
+	T Read(const void* base, uint32_t stride, uint32_t index)
+	{
+		T value;
+		memcpy(&value, static_cast<const uint8_t*>(base) + static_cast<size_t>(index) * stride, sizeof(value));
+		return value;
+	}
+
+	template<typename Function>
+	void ForRanges(JobSystem* jobs, uint32_t count, uint32_t batchSize, const Function& function)
+	{
+		if (jobs != nullptr)
+		{
+			jobs->ParallelFor(count, batchSize, function);
+		}
+		else
+		{
+			function(0, count);
+		}
+	}
+
+	Float3 Scale(const Float3& v, float s)
+	{
+		return Float3(v.x * s, v.y * s, v.z * s);
+	}
+
+	Float3 Add(const Float3& a, const Float3& b)
+	{
+		return Float3(a.x + b.x, a.y + b.y, a.z + b.z);
+	}
+
+	// v without its part along the unit vector n
+	Float3 ProjectOntoPlane(const Float3& v, const Float3& n)
+	{
+		return Subtract(v, Scale(n, Dot(n, v)));
+	}
+
+	// Any unit vector perpendicular to n
+	Float3 Perpendicular(const Float3& n)
+	{
+		Float3 axis = std::fabs(n.x) < 0.9f ? Float3(1.0f, 0.0f, 0.0f) : Float3(0.0f, 1.0f, 0.0f);
+		return Normalize3(ProjectOntoPlane(axis, n));
+	}
+
+	struct CornerTangent
+	{
+		Float3 Tangent;		// Projected onto the corner's normal plane and weighted by its angle
+		uint8_t Flags;
+	};
+
+	struct VertexTangents
+	{
+		Float4 Primary;
+		Float4 Secondary;
+		uint8_t PrimaryFlags;	// preservingFlag of the corners Primary is for
+		bool Split;
+	};
+}
+
+void GenerateTangents(const TangentInput& input, TangentFrames& frames, JobSystem* jobs)
+{
+	uint32_t triangleCount = input.IndexCount / 3;
+	uint32_t vertexCount = input.VertexCount;
+	std::vector<CornerTangent> corners(triangleCount * 3);
+
+	// Each triangle's dP/du, per corner in the plane of the corner's normal
+	ForRanges(jobs, triangleCount, triangleBatch, [&](uint32_t first, uint32_t end)
+	{
+		for (uint32_t triangle = first; triangle < end; triangle++)
+		{
+			const uint32_t* index = input.Indices + triangle * 3;
+			Float3 p[3];
+			Float2 t[3];
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				p[corner] = Read<Float3>(input.Positions, input.PositionStride, index[corner]);
+				t[corner] = Read<Float2>(input.TexCoords, input.TexCoordStride, index[corner]);
+			}
+
+			Float3 d1 = Subtract(p[1], p[0]);
+			Float3 d2 = Subtract(p[2], p[0]);
+			float s1 = t[1].x - t[0].x;
+			float t1 = t[1].y - t[0].y;
+			float s2 = t[2].x - t[0].x;
+			float t2 = t[2].y - t[0].y;
+			float area = s1 * t2 - s2 * t1;
+
+			// dP/du and dP/dv scaled by the texture area
+			Float3 dPdu = Subtract(Scale(d1, t2), Scale(d2, t1));
+			Float3 dPdv = Subtract(Scale(d2, s1), Scale(d1, s2));
+			bool degenerate = std::fabs(area) <= FLT_MIN || Dot(dPdu, dPdu) <= 0.0f;
+			if (!degenerate && area < 0.0f)
+			{
+				dPdu = Scale(dPdu, -1.0f);
+				dPdv = Scale(dPdv, -1.0f);
+			}
+			dPdu = Normalize3(dPdu);
+
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				CornerTangent& out = corners[triangle * 3 + corner];
+				if (degenerate)
+				{
+					out.Tangent = Float3();
+					out.Flags = degenerateFlag;
+					continue;
+				}
+
+				Float3 n = Read<Float3>(input.Normals, input.NormalStride, index[corner]);
+				Float3 tangent = Normalize3(ProjectOntoPlane(dPdu, n));
+				Float3 toNext = Normalize3(ProjectOntoPlane(Subtract(p[(corner + 1) % 3], p[corner]), n));
+				Float3 toPrevious = Normalize3(ProjectOntoPlane(Subtract(p[(corner + 2) % 3], p[corner]), n));
+				float angle = std::acos(Clamp(Dot(toNext, toPrevious), -1.0f, 1.0f));
+
+				out.Tangent = Scale(tangent, angle);
+				out.Flags = Dot(Cross(n, dPdu), dPdv) >= 0.0f ? preservingFlag : 0;
+			}
+		}
+	});
+
+	// Corners of each vertex in triangle order
+	std::vector<uint32_t> cornerStart(vertexCount + 1, 0);
+	for (uint32_t i = 0; i < triangleCount * 3; i++)
+	{
+		cornerStart[input.Indices[i] + 1]++;
+	}
+	for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+	{
+		cornerStart[vertex + 1] += cornerStart[vertex];
+	}
+	std::vector<uint32_t> vertexCorners(triangleCount * 3);
+	std::vector<uint32_t> fill(cornerStart.begin(), cornerStart.end() - 1);
+	for (uint32_t i = 0; i < triangleCount * 3; i++)
+	{
+		vertexCorners[fill[input.Indices[i]]++] = i;
+	}
+
+	// Sums per vertex and handedness, the handedness of the first corner keeps the vertex
+	std::vector<VertexTangents> vertices(vertexCount);
+	ForRanges(jobs, vertexCount, vertexBatch, [&](uint32_t first, uint32_t end)
+	{
+		for (uint32_t vertex = first; vertex < end; vertex++)
+		{
+			Float3 sums[2];
+			bool used[2] = { false, false };
+			int primary = -1;
+			for (uint32_t i = cornerStart[vertex]; i < cornerStart[vertex + 1]; i++)
+			{
+				const CornerTangent& corner = corners[vertexCorners[i]];
+				if ((corner.Flags & degenerateFlag) != 0)
+				{
+					continue;
+				}
+				int group = corner.Flags & preservingFlag;
+				primary = primary < 0 ? group : primary;
+				sums[group] = Add(sums[group], corner.Tangent);
+				used[group] = true;
+			}
+
+			Float3 n = Read<Float3>(input.Normals, input.NormalStride, vertex);
+			VertexTangents& out = vertices[vertex];
+			primary = primary < 0 ? 1 : primary;
+			int secondary = 1 - primary;
+			for (int group = 0; group < 2; group++)
+			{
+				float length = std::sqrt(Dot(sums[group], sums[group]));
+				Float3 tangent = length > 0.0f ? Scale(sums[group], 1.0f / length) : Perpendicular(n);
+				Float4 frame(tangent.x, tangent.y, tangent.z, group == 1 ? 1.0f : -1.0f);
+				if (group == primary)
+				{
+					out.Primary = frame;
+				}
+				else
+				{
+					out.Secondary = frame;
+				}
+			}
+			out.PrimaryFlags = static_cast<uint8_t>(primary);
+			out.Split = used[primary] && used[secondary];
+		}
+	});
+
+	// Split vertices in vertex order
+	std::vector<uint32_t> splitIndex(vertexCount, ~0u);
+	frames.SourceVertices.resize(vertexCount);
+	for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+	{
+		frames.SourceVertices[vertex] = vertex;
+	}
+	for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+	{
+		if (vertices[vertex].Split)
+		{
+			splitIndex[vertex] = static_cast<uint32_t>(frames.SourceVertices.size());
+			frames.SourceVertices.push_back(vertex);
+		}
+	}
+	frames.SplitVertices = static_cast<uint32_t>(frames.SourceVertices.size()) - vertexCount;
+
+	frames.Tangents.resize(frames.SourceVertices.size());
+	for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+	{
+		frames.Tangents[vertex] = vertices[vertex].Primary;
+		if (splitIndex[vertex] != ~0u)
+		{
+			frames.Tangents[splitIndex[vertex]] = vertices[vertex].Secondary;
+		}
+	}
+
+	frames.Indices.resize(triangleCount * 3);
+	std::vector<uint32_t> degenerate(triangleCount, 0);
+	ForRanges(jobs, triangleCount, triangleBatch, [&](uint32_t first, uint32_t end)
+	{
+		for (uint32_t i = first * 3; i < end * 3; i++)
+		{
+			uint32_t vertex = input.Indices[i];
+			uint8_t flags = corners[i].Flags;
+			bool secondary = (flags & degenerateFlag) == 0 && (flags & preservingFlag) != vertices[vertex].PrimaryFlags;
+			frames.Indices[i] = secondary && splitIndex[vertex] != ~0u ? splitIndex[vertex] : vertex;
+		}
+		for (uint32_t triangle = first; triangle < end; triangle++)
+		{
+			degenerate[triangle] = (corners[triangle * 3].Flags & degenerateFlag) != 0 ? 1 : 0;
+		}
+	});
+
+	frames.DegenerateTriangles = 0;
+	for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+	{
+		frames.DegenerateTriangles += degenerate[triangle];
+	}
+}
+
+uint32_t GenerateTangents(MeshGenerator::MeshData& meshData, JobSystem* jobs)
+{
+	if (meshData.Vertices.empty())
+	{
+		return 0;
+	}
+
+	const StaticGeometry::MeshVertex& first = meshData.Vertices[0];
+	uint32_t stride = sizeof(StaticGeometry::MeshVertex);
+	TangentInput input = { &first.Position, stride, &first.Normal, stride, &first.TexC, stride
+		, static_cast<uint32_t>(meshData.Vertices.size()), meshData.Indices.data(), static_cast<uint32_t>(meshData.Indices.size()) };
+	TangentFrames frames;
+	GenerateTangents(input, frames, jobs);
+
+	std::vector<StaticGeometry::MeshVertex> vertices(frames.SourceVertices.size());
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		vertices[i] = meshData.Vertices[frames.SourceVertices[i]];
+		vertices[i].TangentU = Float3(frames.Tangents[i].x, frames.Tangents[i].y, frames.Tangents[i].z);
+	}
+	meshData.Vertices.swap(vertices);
+	meshData.Indices.swap(frames.Indices);
+	return frames.SplitVertices;
+}
+
+void ComputeSphericalTexCoords(const std::vector<Float3>& positions, std::vector<Float2>& texCoords)
+{
+	Float3 min(FLT_MAX, FLT_MAX, FLT_MAX);
+	Float3 max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (size_t i = 0; i < positions.size(); i++)
+	{
+		min = Float3(std::min(min.x, positions[i].x), std::min(min.y, positions[i].y), std::min(min.z, positions[i].z));
+		max = Float3(std::max(max.x, positions[i].x), std::max(max.y, positions[i].y), std::max(max.z, positions[i].z));
+	}
+	Float3 center = Scale(Add(min, max), 0.5f);
+
+	texCoords.resize(positions.size());
+	for (size_t i = 0; i < positions.size(); i++)
+	{
+		Float3 d = Normalize3(Subtract(positions[i], center));
+		float u = std::atan2(d.z, d.x) / (2.0f * MathPi) + 0.5f;
+		float v = std::acos(Clamp(d.y, -1.0f, 1.0f)) / MathPi;
+		texCoords[i] = Float2(u, v);
+	}
+}
@@ -0,0 +1,66 @@
+#ifndef TANGENTGENERATOR_H
+#define TANGENTGENERATOR_H
+
+#include "MathTypes.h"
+#include "MeshGenerator.h"
+
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+// Vertex attributes by pointer and stride, so any vertex format can be read
+struct TangentInput
+{
+	const void* Positions;		// Float3
+	uint32_t PositionStride;
+	const void* Normals;		// Float3, unit length
+	uint32_t NormalStride;
+	const void* TexCoords;		// Float2
+	uint32_t TexCoordStride;
+	uint32_t VertexCount;
+	const uint32_t* Indices;
+	uint32_t IndexCount;
+};
+
+struct TangentFrames
+{
+	// Per output vertex. w is the bitangent's sign: B = w * cross(N, T).
+	std::vector<Float4> Tangents;
+	// Input vertex of each output vertex. The first VertexCount are the
+	// input vertices themselves, the split ones follow.
+	std::vector<uint32_t> SourceVertices;
+	// The input's triangles, with the corners that were split off renumbered
+	std::vector<uint32_t> Indices;
+	uint32_t SplitVertices;
+	uint32_t DegenerateTriangles;	// Zero area in texture space, they add nothing
+};
+
+// Per-vertex tangent frames from texture coordinates, the way MikkTSpace
+// builds them: each triangle's dP/du is projected onto the plane of each
+// corner's normal and weighted by the corner angle, and the corners of a
+// vertex are summed separately for triangles with mirrored and unmirrored
+// texture coordinates. A vertex used by both gets a second, split vertex.
+//
+// MikkTSpace takes the handedness from the sign of the texture area and
+// expects counter-clockwise triangles. Here it comes from dP/dv, which gives
+// the same result there and the right one for the book's clockwise meshes.
+// Vertices with equal attributes are not welded, each index is its own
+// vertex. Vertices of degenerate triangles only get a tangent perpendicular
+// to the normal.
+//
+// Triangles and then vertices are processed in parallel on 'jobs', or on
+// the calling thread without it. Every vertex is summed in triangle order by
+// one thread, so the result is the same for any number of threads.
+void GenerateTangents(const TangentInput& input, TangentFrames& frames, JobSystem* jobs = nullptr);
+
+// Replaces TangentU and splits the vertices that need it. The book's vertex
+// has no handedness, mirrored texture coordinates need the w of TangentFrames.
+// Returns the number of split vertices.
+uint32_t GenerateTangents(MeshGenerator::MeshData& meshData, JobSystem* jobs = nullptr);
+
+// Longitude and latitude around the center of the positions' bounds, for
+// loaded meshes without texture coordinates
+void ComputeSphericalTexCoords(const std::vector<Float3>& positions, std::vector<Float2>& texCoords);
+
+#endif // TANGENTGENERATOR_H
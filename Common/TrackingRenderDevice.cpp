@@ -0,0 +1,21 @@
+#include "TrackingRenderDevice.h"
+
+TrackingRenderDevice::TrackingRenderDevice(IRenderDevice& device, ResourceRegistry& registry)
+	: mDevice(device)
+	, mRegistry(registry)
+{
+}
+
+RenderBuffer* TrackingRenderDevice::CreateBuffer(const BufferDesc& desc, const void* initialData)
+{
+	RenderBuffer* buffer = mDevice.CreateBuffer(desc, initialData);
+	mRegistry.AddBuffer(buffer, desc);
+	return buffer;
+}
+
+void TrackingRenderDevice::ReleaseBuffer(RenderBuffer* buffer)
+{
+	// Before the device may hand the address out again
+	mRegistry.RemoveBuffer(buffer);
+	mDevice.ReleaseBuffer(buffer);
+}
@@ -0,0 +1,43 @@
+#ifndef TRACKINGRENDERDEVICE_H
+#define TRACKINGRENDERDEVICE_H
+
+#include "RenderDevice.h"
+#include "ResourceRegistry.h"
+
+// Forwards everything to another device and records the buffers it creates
+// and releases in a ResourceRegistry, so the accounting works the same on
+// every backend.
+class TrackingRenderDevice : public IRenderDevice
+{
+public:
+	TrackingRenderDevice(IRenderDevice& device, ResourceRegistry& registry);
+
+	IDeviceContext& ImmediateContext() { return mDevice.ImmediateContext(); }
+
+	RenderBuffer* CreateBuffer(const BufferDesc& desc, const void* initialData);
+	void ReleaseBuffer(RenderBuffer* buffer);
+
+	void* MapBuffer(RenderBuffer* buffer, MapMode mode) { return mDevice.MapBuffer(buffer, mode); }
+	void UnmapBuffer(RenderBuffer* buffer) { mDevice.UnmapBuffer(buffer); }
+
+	IFrameFence* CreateFrameFence() { return mDevice.CreateFrameFence(); }
+	void ReleaseFrameFence(IFrameFence* fence) { mDevice.ReleaseFrameFence(fence); }
+
+	RenderEffect* CreateEffect(const char* fileName) { return mDevice.CreateEffect(fileName); }
+	void ReleaseEffect(RenderEffect* effect) { mDevice.ReleaseEffect(effect); }
+
+	uint32_t PassCount(RenderEffect* effect, const char* technique) { return mDevice.PassCount(effect, technique); }
+	RenderPass* FindPass(RenderEffect* effect, const char* technique, uint32_t pass) { return mDevice.FindPass(effect, technique, pass); }
+	RenderConstant* FindConstant(RenderEffect* effect, const char* name) { return mDevice.FindConstant(effect, name); }
+
+	RenderInputLayout* CreateInputLayout(const std::vector<StreamElement>& elements, RenderPass* pass) { return mDevice.CreateInputLayout(elements, pass); }
+	void ReleaseInputLayout(RenderInputLayout* layout) { mDevice.ReleaseInputLayout(layout); }
+
+	ResourceRegistry& Registry() { return mRegistry; }
+
+private:
+	IRenderDevice& mDevice;
+	ResourceRegistry& mRegistry;
+};
+
+#endif // TRACKINGRENDERDEVICE_H
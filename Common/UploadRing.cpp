@@ -0,0 +1,186 @@
+#include "UploadRing.h"
+#include "ResourceRegistry.h"
+
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+
+namespace
+{
+	uint64_t RoundUp(uint64_t value, uint64_t multiple)
+	{
+		return (value + multiple - 1) / multiple * multiple;
+	}
+}
+
+UploadRing::UploadRing(IRenderDevice& device, IFrameFence& fence, BufferBinding binding, uint32_t capacity,
+	uint32_t maxFramesInFlight, const char* owner)
+	: mDevice(device)
+	, mFence(fence)
+	, mBuffer(nullptr)
+	, mCapacity(capacity)
+	, mMaxFramesInFlight(maxFramesInFlight > 0 ? maxFramesInFlight : 1)
+	, mMapped(nullptr)
+	, mHead(0)
+	, mTail(0)
+	, mFrameStart(0)
+	, mFrame(1)
+	, mStats()
+{
+	BufferDesc desc = { binding, BufferUsage::Dynamic, capacity, owner };
+	mBuffer = mDevice.CreateBuffer(desc, nullptr);
+	mFrames.reserve(mMaxFramesInFlight);
+}
+
+UploadRing::~UploadRing()
+{
+	Unmap();
+	mDevice.ReleaseBuffer(mBuffer);
+}
+
+UploadAllocation UploadRing::Allocate(uint32_t size, uint32_t alignment)
+{
+	UploadAllocation allocation = { mBuffer, 0, nullptr };
+	if (mBuffer == nullptr || size == 0 || size > mCapacity)
+	{
+		mStats.Overflows += size > 0 ? 1 : 0;
+		return allocation;
+	}
+	alignment = alignment > 0 ? alignment : 1;
+
+	// Nothing in flight and nothing written this frame, start over
+	bool discard = false;
+	if (mMapped == nullptr && mHead == mFrameStart)
+	{
+		Retire();
+		if (mTail == mHead)
+		{
+			discard = true;
+			mHead = RoundUp(mHead, mCapacity);
+			mTail = mHead;
+			mFrameStart = mHead;
+		}
+	}
+
+	uint64_t start;
+	for (;;)
+	{
+		uint64_t offset = mHead % mCapacity;
+		uint64_t aligned = RoundUp(offset, alignment);
+		// Wraps to offset 0, which every alignment allows
+		start = aligned + size <= mCapacity ? mHead + (aligned - offset) : mHead + (mCapacity - offset);
+		if (start + size - mTail <= mCapacity)
+		{
+			break;
+		}
+
+		Retire();
+		if (start + size - mTail <= mCapacity)
+		{
+			break;
+		}
+		if (mFrames.empty())
+		{
+			// The current frame alone has filled the ring
+			mStats.Overflows++;
+			return allocation;
+		}
+		WaitForOldestFrame();
+	}
+
+	if (mMapped == nullptr)
+	{
+		mMapped = static_cast<uint8_t*>(mDevice.MapBuffer(mBuffer, discard ? MapMode::Discard : MapMode::NoOverwrite));
+		if (mMapped == nullptr)
+		{
+			mStats.Overflows++;
+			return allocation;
+		}
+		mStats.Discards += discard ? 1 : 0;
+	}
+
+	mStats.Wraps += start / mCapacity != mHead / mCapacity ? 1 : 0;
+	mStats.PaddingBytes += start - mHead;
+	mStats.Allocations++;
+	mHead = start + size;
+
+	allocation.Offset = static_cast<uint32_t>(start % mCapacity);
+	allocation.Data = mMapped + allocation.Offset;
+	return allocation;
+}
+
+void UploadRing::Unmap()
+{
+	if (mMapped != nullptr)
+	{
+		mDevice.UnmapBuffer(mBuffer);
+		mMapped = nullptr;
+	}
+}
+
+void UploadRing::EndFrame()
+{
+	Unmap();
+
+	uint64_t frameBytes = mHead - mFrameStart;
+	mStats.FrameBytes = frameBytes;
+	mStats.PeakFrameBytes = frameBytes > mStats.PeakFrameBytes ? frameBytes : mStats.PeakFrameBytes;
+	mStats.TotalBytes += frameBytes;
+	mStats.Frames++;
+
+	// A frame without allocations holds no space
+	if (mHead != mFrameStart)
+	{
+		Retire();
+		if (mFrames.size() == mMaxFramesInFlight)
+		{
+			WaitForOldestFrame();
+		}
+		FrameMark mark = { mFrame, mHead };
+		mFrames.push_back(mark);
+	}
+	mFence.Signal(mFrame);
+	mFrame++;
+	mFrameStart = mHead;
+}
+
+void UploadRing::Retire()
+{
+	uint64_t completed = mFence.CompletedFrame();
+	size_t retired = 0;
+	while (retired < mFrames.size() && mFrames[retired].Frame <= completed)
+	{
+		mTail = mFrames[retired].End;
+		retired++;
+	}
+	mFrames.erase(mFrames.begin(), mFrames.begin() + retired);
+
+	// All done, the current frame's bytes are the only ones in use
+	if (mFrames.empty())
+	{
+		mTail = mFrameStart;
+	}
+}
+
+void UploadRing::WaitForOldestFrame()
+{
+	assert(!mFrames.empty());
+	auto start = std::chrono::steady_clock::now();
+	mFence.Wait(mFrames.front().Frame);
+	mStats.StallMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	mStats.Stalls++;
+	Retire();
+}
+
+std::string UploadRingSummary(const UploadRingStats& stats)
+{
+	char summary[192];
+	snprintf(summary, sizeof(summary), "Upload: %s/frame (peak %s), %u stalls (%.2f ms), %u wraps, %u overflows"
+		, FormatBytes(stats.FrameBytes).c_str()
+		, FormatBytes(stats.PeakFrameBytes).c_str()
+		, stats.Stalls
+		, stats.StallMs
+		, stats.Wraps
+		, stats.Overflows);
+	return summary;
+}
@@ -0,0 +1,98 @@
+#ifndef UPLOADRING_H
+#define UPLOADRING_H
+
+#include "RenderDevice.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Where an allocation went. Data is null if it did not fit.
+struct UploadAllocation
+{
+	RenderBuffer* Buffer;
+	uint32_t Offset;		// Bytes from the start of Buffer, for SetVertexBuffer
+	uint8_t* Data;
+};
+
+struct UploadRingStats
+{
+	uint64_t FrameBytes;		// Allocated in the last finished frame
+	uint64_t PeakFrameBytes;
+	uint64_t TotalBytes;
+	uint64_t PaddingBytes;		// Skipped for alignment and at the end of the ring
+	uint64_t Allocations;
+	uint32_t Overflows;			// Allocations that did not fit at all
+	uint32_t Stalls;			// Waits for the GPU to finish a frame
+	double StallMs;
+	uint32_t Wraps;
+	uint32_t Discards;
+	uint64_t Frames;
+};
+
+// Per-frame data streamed through one large dynamic buffer. Allocations are
+// handed out in order and wrap around the end. Each EndFrame signals a
+// fence, and space comes back when the GPU has finished the frame that
+// used it. While the ring is empty it starts over at offset 0 with a
+// Discard map, every other map is NoOverwrite.
+//
+// If the GPU is still reading the space an allocation needs, the ring waits
+// for the oldest frame in flight, which is counted as a stall. A ring that
+// stalls is too small for framesInFlight frames of data. An allocation the
+// current frame has no room for even with nothing in flight overflows.
+//
+// Frame data goes through Allocate, then Unmap before the draws that read
+// it, then EndFrame after them.
+class UploadRing
+{
+public:
+	UploadRing(IRenderDevice& device, IFrameFence& fence, BufferBinding binding, uint32_t capacity,
+		uint32_t maxFramesInFlight = 3, const char* owner = nullptr);
+	~UploadRing();
+
+	// 'alignment' may be any size, a vertex stride for example
+	UploadAllocation Allocate(uint32_t size, uint32_t alignment = 1);
+	void Unmap();
+	void EndFrame();
+
+	RenderBuffer* Buffer() const { return mBuffer; }
+	uint32_t Capacity() const { return mCapacity; }
+	// Bytes still in use by frames in flight and the current frame
+	uint32_t UsedBytes() const { return static_cast<uint32_t>(mHead - mTail); }
+	uint32_t FramesInFlight() const { return static_cast<uint32_t>(mFrames.size()); }
+	const UploadRingStats& Stats() const { return mStats; }
+
+private:
+	struct FrameMark
+	{
+		uint64_t Frame;
+		uint64_t End;	// Ring position after the frame's last allocation
+	};
+
+	UploadRing(const UploadRing&);
+	UploadRing& operator=(const UploadRing&);
+
+	void Retire();
+	void WaitForOldestFrame();
+
+	IRenderDevice& mDevice;
+	IFrameFence& mFence;
+	RenderBuffer* mBuffer;
+	uint32_t mCapacity;
+	uint32_t mMaxFramesInFlight;
+	uint8_t* mMapped;
+
+	// Positions only grow, the offset in the buffer is position % capacity
+	uint64_t mHead;			// Next free byte
+	uint64_t mTail;			// Oldest byte a frame in flight uses
+	uint64_t mFrameStart;
+	uint64_t mFrame;
+	std::vector<FrameMark> mFrames;		// Oldest first
+
+	UploadRingStats mStats;
+};
+
+// "Upload: 40.0 KB/frame (peak 40.0 KB), 0 stalls, 12 wraps, 0 overflows"
+std::string UploadRingSummary(const UploadRingStats& stats);
+
+#endif // UPLOADRING_H
@@ -0,0 +1,209 @@
+#include "VertexCacheOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// The modelled LRU cache, bigger than the real one so the order also suits bigger caches
+	const uint32_t modelCacheSize = 32;
+	const uint32_t valenceTableSize = 32;
+
+	struct ScoreTables
+	{
+		float Cache[modelCacheSize];
+		float Valence[valenceTableSize];
+
+		ScoreTables()
+		{
+			// The last triangle's vertices score the same, whatever order it drew them in
+			for (uint32_t position = 0; position < modelCacheSize; position++)
+			{
+				float age = position < 3 ? 0.0f : static_cast<float>(position - 3) / (modelCacheSize - 3);
+				Cache[position] = position < 3 ? 0.75f : std::pow(1.0f - age, 1.5f);
+			}
+			// Vertices with few triangles left are finished first, so they leave no lone triangles behind
+			Valence[0] = 0.0f;
+			for (uint32_t valence = 1; valence < valenceTableSize; valence++)
+			{
+				Valence[valence] = 2.0f / std::sqrt(static_cast<float>(valence));
+			}
+		}
+	};
+
+	const ScoreTables& Tables()
+	{
+		static const ScoreTables tables;
+		return tables;
+	}
+
+	float VertexScore(int32_t cachePosition, uint32_t activeTriangles)
+	{
+		if (activeTriangles == 0)
+		{
+			return -1.0f;
+		}
+		const ScoreTables& tables = Tables();
+		float score = cachePosition >= 0 ? tables.Cache[cachePosition] : 0.0f;
+		return score + (activeTriangles < valenceTableSize ? tables.Valence[activeTriangles] : 2.0f / std::sqrt(static_cast<float>(activeTriangles)));
+	}
+}
+
+void OptimizeVertexCache(uint32_t* indices, uint32_t indexCount, uint32_t vertexCount)
+{
+	uint32_t triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	// Triangles of each vertex, the first activeTriangles of them are not emitted yet
+	std::vector<uint32_t> triangleStart(vertexCount + 1, 0);
+	for (uint32_t i = 0; i < triangleCount * 3; i++)
+	{
+		triangleStart[indices[i] + 1]++;
+	}
+	for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+	{
+		triangleStart[vertex + 1] += triangleStart[vertex];
+	}
+	std::vector<uint32_t> vertexTriangles(triangleCount * 3);
+	std::vector<uint32_t> activeTriangles(vertexCount, 0);
+	for (uint32_t i = 0; i < triangleCount * 3; i++)
+	{
+		uint32_t vertex = indices[i];
+		vertexTriangles[triangleStart[vertex] + activeTriangles[vertex]++] = i / 3;
+	}
+
+	std::vector<int32_t> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+	{
+		vertexScores[vertex] = VertexScore(-1, activeTriangles[vertex]);
+	}
+
+	std::vector<uint8_t> emitted(triangleCount, 0);
+	std::vector<uint32_t> output(triangleCount * 3);
+	uint32_t cache[modelCacheSize + 3];
+	uint32_t cacheCount = 0;
+	uint32_t nextUnemitted = 0;
+	uint32_t best = ~0u;
+
+	for (uint32_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+	{
+		// Nothing in the cache has triangles left. Forsyth takes the best
+		// scoring triangle of all, the input order is nearly as good and linear.
+		if (best == ~0u)
+		{
+			while (emitted[nextUnemitted] != 0)
+			{
+				nextUnemitted++;
+			}
+			best = nextUnemitted;
+		}
+
+		const uint32_t* corners = indices + best * 3;
+		emitted[best] = 1;
+		for (uint32_t corner = 0; corner < 3; corner++)
+		{
+			uint32_t vertex = corners[corner];
+			output[emittedCount * 3 + corner] = vertex;
+
+			uint32_t* triangles = &vertexTriangles[triangleStart[vertex]];
+			uint32_t* last = triangles + activeTriangles[vertex] - 1;
+			std::iter_swap(std::find(triangles, last, best), last);
+			activeTriangles[vertex]--;
+		}
+
+		// The triangle's vertices move to the front, the rest keep their order
+		uint32_t newCache[modelCacheSize + 3];
+		uint32_t newCount = 0;
+		for (uint32_t corner = 0; corner < 3; corner++)
+		{
+			if (std::find(newCache, newCache + newCount, corners[corner]) == newCache + newCount)
+			{
+				newCache[newCount++] = corners[corner];
+			}
+		}
+		for (uint32_t i = 0; i < cacheCount; i++)
+		{
+			uint32_t vertex = cache[i];
+			if (vertex != corners[0] && vertex != corners[1] && vertex != corners[2])
+			{
+				newCache[newCount++] = vertex;
+			}
+		}
+		for (uint32_t i = modelCacheSize; i < newCount; i++)
+		{
+			cachePosition[newCache[i]] = -1;
+			vertexScores[newCache[i]] = VertexScore(-1, activeTriangles[newCache[i]]);
+		}
+		cacheCount = std::min(newCount, modelCacheSize);
+		for (uint32_t i = 0; i < cacheCount; i++)
+		{
+			cache[i] = newCache[i];
+			cachePosition[cache[i]] = static_cast<int32_t>(i);
+			vertexScores[cache[i]] = VertexScore(static_cast<int32_t>(i), activeTriangles[cache[i]]);
+		}
+
+		// Only triangles of cached vertices changed enough to be next
+		best = ~0u;
+		float bestScore = -1.0f;
+		for (uint32_t i = 0; i < cacheCount; i++)
+		{
+			uint32_t vertex = cache[i];
+			const uint32_t* triangles = &vertexTriangles[triangleStart[vertex]];
+			for (uint32_t j = 0; j < activeTriangles[vertex]; j++)
+			{
+				const uint32_t* candidate = indices + triangles[j] * 3;
+				float score = vertexScores[candidate[0]] + vertexScores[candidate[1]] + vertexScores[candidate[2]];
+				if (score > bestScore)
+				{
+					bestScore = score;
+					best = triangles[j];
+				}
+			}
+		}
+	}
+
+	std::copy(output.begin(), output.end(), indices);
+}
+
+uint32_t OptimizeVertexFetch(uint32_t* indices, uint32_t indexCount, uint32_t vertexCount, std::vector<uint32_t>& remap)
+{
+	remap.assign(vertexCount, ~0u);
+	uint32_t used = 0;
+	for (uint32_t i = 0; i < indexCount; i++)
+	{
+		uint32_t& vertex = remap[indices[i]];
+		if (vertex == ~0u)
+		{
+			vertex = used++;
+		}
+		indices[i] = vertex;
+	}
+	return used;
+}
+
+float AverageCacheMissRatio(const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize)
+{
+	uint32_t triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+	{
+		return 0.0f;
+	}
+
+	// A vertex is cached while fewer than cacheSize misses came after its own
+	std::vector<uint32_t> missedAt(vertexCount, 0);
+	uint32_t misses = 0;
+	for (uint32_t i = 0; i < triangleCount * 3; i++)
+	{
+		uint32_t& time = missedAt[indices[i]];
+		if (time == 0 || misses + 1 - time > cacheSize)
+		{
+			misses++;
+			time = misses;
+		}
+	}
+	return static_cast<float>(misses) / triangleCount;
+}
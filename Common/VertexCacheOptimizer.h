@@ -0,0 +1,25 @@
+#ifndef VERTEXCACHEOPTIMIZER_H
+#define VERTEXCACHEOPTIMIZER_H
+
+#include <cstdint>
+#include <vector>
+
+// Reorders the triangles of an indexed triangle list for the post-transform
+// vertex cache, with Tom Forsyth's linear speed method: each triangle is
+// scored by how recently its vertices were used and how many triangles
+// they have left, and the best one next to the last is emitted. The result
+// suits any cache size up to about 32 entries.
+void OptimizeVertexCache(uint32_t* indices, uint32_t indexCount, uint32_t vertexCount);
+
+// Numbers the vertices in the order the indices first use them and rewrites
+// the indices, so the vertex fetch walks the buffer forwards. 'remap'
+// receives the new index of each old vertex, ~0 for unused ones, which are
+// dropped. Returns the number of used vertices.
+uint32_t OptimizeVertexFetch(uint32_t* indices, uint32_t indexCount, uint32_t vertexCount, std::vector<uint32_t>& remap);
+
+// Average cache misses per triangle with a FIFO cache of 'cacheSize'
+// vertices, the way most GPUs cache. 3 is the worst, about 0.5 the best for
+// a regular mesh.
+float AverageCacheMissRatio(const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize = 16);
+
+#endif // VERTEXCACHEOPTIMIZER_H
@@ -0,0 +1,146 @@
+#ifndef VERTEXFORMAT_H
+#define VERTEXFORMAT_H
+
+#include "MathTypes.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_WIN32)
+#include <d3d11.h>
+#include <DirectXMath.h>
+#endif
+
+// Describes the attributes of a vertex struct so that strides, byte offsets
+// and input layouts are derived from the struct instead of typed by hand.
+//
+// Usage:
+//	template<> struct VertexFormat<MyVertex>
+//	{
+//		static constexpr std::array<VertexElement, 2> Elements =
+//		{{
+//			VERTEX_ELEMENT(MyVertex, Position, "POSITION"),
+//			VERTEX_ELEMENT(MyVertex, Color, "COLOR")
+//		}};
+//	};
+
+enum class VertexAttributeFormat
+{
+	Float2,
+	Float3,
+	Float4,
+	UNorm8x4
+};
+
+constexpr uint32_t VertexAttributeSize(VertexAttributeFormat format)
+{
+	return format == VertexAttributeFormat::Float2 ? 8
+		: format == VertexAttributeFormat::Float3 ? 12
+		: format == VertexAttributeFormat::Float4 ? 16
+		: 4;
+}
+
+// Maps a member type to its attribute format
+template<typename T> struct VertexAttributeTraits;
+
+template<> struct VertexAttributeTraits<Float2> { static constexpr VertexAttributeFormat Format = VertexAttributeFormat::Float2; };
+template<> struct VertexAttributeTraits<Float3> { static constexpr VertexAttributeFormat Format = VertexAttributeFormat::Float3; };
+template<> struct VertexAttributeTraits<Float4> { static constexpr VertexAttributeFormat Format = VertexAttributeFormat::Float4; };
+
+#if defined(_WIN32)
+template<> struct VertexAttributeTraits<DirectX::XMFLOAT2> { static constexpr VertexAttributeFormat Format = VertexAttributeFormat::Float2; };
+template<> struct VertexAttributeTraits<DirectX::XMFLOAT3> { static constexpr VertexAttributeFormat Format = VertexAttributeFormat::Float3; };
+template<> struct VertexAttributeTraits<DirectX::XMFLOAT4> { static constexpr VertexAttributeFormat Format = VertexAttributeFormat::Float4; };
+#endif
+
+struct VertexElement
+{
+	const char* Semantic;
+	uint32_t SemanticIndex;
+	VertexAttributeFormat Format;
+	uint32_t Offset;
+};
+
+#define VERTEX_ELEMENT(VertexType, Member, Semantic) \
+	VertexElement{ Semantic, 0, VertexAttributeTraits<decltype(VertexType::Member)>::Format, static_cast<uint32_t>(offsetof(VertexType, Member)) }
+
+// Specialize for every vertex struct that is uploaded to the GPU
+template<typename V> struct VertexFormat;
+
+template<typename V>
+constexpr uint32_t VertexStride()
+{
+	return static_cast<uint32_t>(sizeof(V));
+}
+
+template<typename V>
+constexpr size_t VertexElementCount()
+{
+	return VertexFormat<V>::Elements.size();
+}
+
+// True when the elements are in member order, do not overlap and fill the
+// whole struct. Use in a static_assert next to each VertexFormat.
+template<typename V>
+constexpr bool VertexFormatIsTight()
+{
+	uint32_t end = 0;
+	for (size_t i = 0; i < VertexFormat<V>::Elements.size(); i++)
+	{
+		const VertexElement& element = VertexFormat<V>::Elements[i];
+		if (element.Offset != end)
+		{
+			return false;
+		}
+		end = element.Offset + VertexAttributeSize(element.Format);
+	}
+	return end == VertexStride<V>();
+}
+
+template<typename V>
+constexpr int FindVertexElement(const char* semantic)
+{
+	for (size_t i = 0; i < VertexFormat<V>::Elements.size(); i++)
+	{
+		const char* a = VertexFormat<V>::Elements[i].Semantic;
+		const char* b = semantic;
+		while (*a != '\0' && *a == *b)
+		{
+			a++;
+			b++;
+		}
+		if (*a == *b)
+		{
+			return static_cast<int>(i);
+		}
+	}
+	return -1;
+}
+
+#if defined(_WIN32)
+
+constexpr DXGI_FORMAT ToDXGIFormat(VertexAttributeFormat format)
+{
+	return format == VertexAttributeFormat::Float2 ? DXGI_FORMAT_R32G32_FLOAT
+		: format == VertexAttributeFormat::Float3 ? DXGI_FORMAT_R32G32B32_FLOAT
+		: format == VertexAttributeFormat::Float4 ? DXGI_FORMAT_R32G32B32A32_FLOAT
+		: DXGI_FORMAT_R8G8B8A8_UNORM;
+}
+
+// Input element descriptions for vertex struct V bound to input slot 'slot'
+template<typename V>
+constexpr std::array<D3D11_INPUT_ELEMENT_DESC, VertexFormat<V>::Elements.size()> InputElementDescs(UINT slot)
+{
+	std::array<D3D11_INPUT_ELEMENT_DESC, VertexFormat<V>::Elements.size()> descs = {};
+	for (size_t i = 0; i < descs.size(); i++)
+	{
+		const VertexElement& element = VertexFormat<V>::Elements[i];
+		descs[i] = { element.Semantic, element.SemanticIndex, ToDXGIFormat(element.Format), slot, element.Offset, D3D11_INPUT_PER_VERTEX_DATA, 0 };
+	}
+	return descs;
+}
+
+#endif
+
+#endif // VERTEXFORMAT_H
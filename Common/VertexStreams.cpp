@@ -0,0 +1,254 @@
+#include "VertexStreams.h"
+
+#include <chrono>
+#include <cstring>
+
+namespace
+{
+	bool IsPosition(const VertexElement& element)
+	{
+		return strcmp(element.Semantic, "POSITION") == 0 && element.SemanticIndex == 0;
+	}
+
+	// Lays the elements out in the streams of 'layout', keeping their order
+	void AssignStreams(const VertexElement* elements, size_t elementCount, StreamLayout layout
+		, std::vector<StreamElement>& streamElements, std::vector<VertexStream>& streams)
+	{
+		int positionIndex = -1;
+		for (size_t i = 0; i < elementCount; i++)
+		{
+			if (IsPosition(elements[i]))
+			{
+				positionIndex = static_cast<int>(i);
+				break;
+			}
+		}
+
+		streamElements.resize(elementCount);
+		streams.clear();
+
+		for (size_t i = 0; i < elementCount; i++)
+		{
+			uint32_t stream = 0;
+			if (layout == StreamLayout::Split)
+			{
+				stream = static_cast<uint32_t>(i);
+			}
+			else if (layout == StreamLayout::PositionAndAttributes && positionIndex >= 0)
+			{
+				stream = static_cast<int>(i) == positionIndex ? 0 : 1;
+			}
+
+			if (stream >= streams.size())
+			{
+				streams.resize(stream + 1);
+				streams[stream].Stride = 0;
+			}
+
+			streamElements[i].Element = elements[i];
+			streamElements[i].Element.Offset = streams[stream].Stride;
+			streamElements[i].Stream = stream;
+			streams[stream].Stride += VertexAttributeSize(elements[i].Format);
+		}
+	}
+
+	const uint8_t* ElementData(const VertexStreamSet& set, size_t element, uint32_t vertex)
+	{
+		const StreamElement& streamElement = set.Elements[element];
+		const VertexStream& stream = set.Streams[streamElement.Stream];
+		return &stream.Data[vertex * stream.Stride + streamElement.Element.Offset];
+	}
+}
+
+const char* StreamLayoutName(StreamLayout layout)
+{
+	switch (layout)
+	{
+	case StreamLayout::Interleaved: return "Interleaved";
+	case StreamLayout::Split: return "Split";
+	case StreamLayout::PositionAndAttributes: return "PositionAndAttributes";
+	}
+	return "Unknown";
+}
+
+int VertexStreamSet::FindElement(const char* semantic) const
+{
+	for (size_t i = 0; i < Elements.size(); i++)
+	{
+		if (strcmp(Elements[i].Element.Semantic, semantic) == 0)
+		{
+			return static_cast<int>(i);
+		}
+	}
+	return -1;
+}
+
+size_t VertexStreamSet::SizeInBytes() const
+{
+	size_t size = 0;
+	for (size_t i = 0; i < Streams.size(); i++)
+	{
+		size += Streams[i].Data.size();
+	}
+	return size;
+}
+
+VertexStreamSet BuildVertexStreams(const void* vertices, uint32_t vertexCount, uint32_t stride
+	, const VertexElement* elements, size_t elementCount, StreamLayout layout)
+{
+	VertexStreamSet set;
+	set.Layout = layout;
+	set.VertexCount = vertexCount;
+	AssignStreams(elements, elementCount, layout, set.Elements, set.Streams);
+
+	for (size_t s = 0; s < set.Streams.size(); s++)
+	{
+		set.Streams[s].Data.resize(static_cast<size_t>(set.Streams[s].Stride) * vertexCount);
+	}
+
+	const uint8_t* source = static_cast<const uint8_t*>(vertices);
+	for (uint32_t v = 0; v < vertexCount; v++)
+	{
+		for (size_t e = 0; e < elementCount; e++)
+		{
+			const StreamElement& target = set.Elements[e];
+			VertexStream& stream = set.Streams[target.Stream];
+			memcpy(&stream.Data[v * stream.Stride + target.Element.Offset]
+				, source + v * stride + elements[e].Offset
+				, VertexAttributeSize(elements[e].Format));
+		}
+	}
+	return set;
+}
+
+VertexStreamSet ConvertVertexStreams(const VertexStreamSet& source, StreamLayout layout)
+{
+	std::vector<VertexElement> elements(source.Elements.size());
+	for (size_t e = 0; e < elements.size(); e++)
+	{
+		elements[e] = source.Elements[e].Element;
+	}
+
+	VertexStreamSet set;
+	set.Layout = layout;
+	set.VertexCount = source.VertexCount;
+	AssignStreams(elements.data(), elements.size(), layout, set.Elements, set.Streams);
+
+	for (size_t s = 0; s < set.Streams.size(); s++)
+	{
+		set.Streams[s].Data.resize(static_cast<size_t>(set.Streams[s].Stride) * set.VertexCount);
+	}
+
+	for (uint32_t v = 0; v < set.VertexCount; v++)
+	{
+		for (size_t e = 0; e < set.Elements.size(); e++)
+		{
+			const StreamElement& target = set.Elements[e];
+			VertexStream& stream = set.Streams[target.Stream];
+			memcpy(&stream.Data[v * stream.Stride + target.Element.Offset]
+				, ElementData(source, e, v)
+				, VertexAttributeSize(target.Element.Format));
+		}
+	}
+	return set;
+}
+
+void GatherVertexStreams(const VertexStreamSet& source, void* vertices, uint32_t stride
+	, const VertexElement* elements, size_t elementCount)
+{
+	uint8_t* target = static_cast<uint8_t*>(vertices);
+	for (size_t e = 0; e < elementCount; e++)
+	{
+		int sourceElement = source.FindElement(elements[e].Semantic);
+		if (sourceElement < 0)
+		{
+			continue;
+		}
+		uint32_t size = VertexAttributeSize(elements[e].Format);
+		for (uint32_t v = 0; v < source.VertexCount; v++)
+		{
+			memcpy(target + v * stride + elements[e].Offset, ElementData(source, sourceElement, v), size);
+		}
+	}
+}
+
+PositionPassStats RunPositionOnlyPass(const VertexStreamSet& streams, const float viewProj[16], uint32_t iterations)
+{
+	PositionPassStats stats = {};
+
+	int position = streams.FindElement("POSITION");
+	if (position < 0 || streams.VertexCount == 0 || iterations == 0)
+	{
+		return stats;
+	}
+
+	const StreamElement& element = streams.Elements[position];
+	const VertexStream& stream = streams.Streams[element.Stream];
+	const uint8_t* data = &stream.Data[element.Element.Offset];
+	const uint32_t stride = stream.Stride;
+	const float* m = viewProj;
+
+	// Cache lines the pass has to pull in
+	const uint64_t lineSize = 64;
+	uint64_t lastLine = ~0ull;
+	for (uint32_t v = 0; v < streams.VertexCount; v++)
+	{
+		uint64_t first = (static_cast<uint64_t>(v) * stride + element.Element.Offset) / lineSize;
+		uint64_t last = (static_cast<uint64_t>(v) * stride + element.Element.Offset + 11) / lineSize;
+		for (uint64_t line = first; line <= last; line++)
+		{
+			if (line != lastLine)
+			{
+				stats.BytesFetched += lineSize;
+				lastLine = line;
+			}
+		}
+	}
+	stats.BytesUseful = 12ull * streams.VertexCount;
+
+	uint32_t inside = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < iterations; i++)
+	{
+		inside = 0;
+		for (uint32_t v = 0; v < streams.VertexCount; v++)
+		{
+			float p[3];
+			memcpy(p, data + static_cast<size_t>(v) * stride, sizeof(p));
+
+			float x = p[0] * m[0] + p[1] * m[4] + p[2] * m[8] + m[12];
+			float y = p[0] * m[1] + p[1] * m[5] + p[2] * m[9] + m[13];
+			float z = p[0] * m[2] + p[1] * m[6] + p[2] * m[10] + m[14];
+			float w = p[0] * m[3] + p[1] * m[7] + p[2] * m[11] + m[15];
+
+			bool visible = x >= -w && x <= w && y >= -w && y <= w && z >= 0.0f && z <= w;
+			inside += visible ? 1 : 0;
+		}
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	stats.MillisecondsPerPass = std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+	stats.VerticesInside = inside;
+	return stats;
+}
+
+#if defined(_WIN32)
+
+std::vector<D3D11_INPUT_ELEMENT_DESC> InputElementDescs(const std::vector<StreamElement>& elements)
+{
+	std::vector<D3D11_INPUT_ELEMENT_DESC> descs(elements.size());
+	for (size_t i = 0; i < descs.size(); i++)
+	{
+		const StreamElement& element = elements[i];
+		descs[i] = { element.Element.Semantic, element.Element.SemanticIndex, ToDXGIFormat(element.Element.Format)
+			, element.Stream, element.Element.Offset, D3D11_INPUT_PER_VERTEX_DATA, 0 };
+	}
+	return descs;
+}
+
+std::vector<D3D11_INPUT_ELEMENT_DESC> InputElementDescs(const VertexStreamSet& streams)
+{
+	return InputElementDescs(streams.Elements);
+}
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef VERTEXSTREAMS_H
+#define VERTEXSTREAMS_H
+
+#include "VertexFormat.h"
+
+#include <cstdint>
+#include <vector>
+
+// How the attributes of a mesh are distributed over vertex buffers
+enum class StreamLayout
+{
+	Interleaved,			// One stream with every attribute
+	Split,					// One stream per attribute
+	PositionAndAttributes	// Positions alone, the other attributes interleaved
+};
+
+const char* StreamLayoutName(StreamLayout layout);
+
+// Attribute of a stream set. Offset is relative to the start of a vertex
+// in its own stream.
+struct StreamElement
+{
+	VertexElement Element;
+	uint32_t Stream;
+};
+
+struct VertexStream
+{
+	std::vector<uint8_t> Data;
+	uint32_t Stride;
+};
+
+// Vertex data of one mesh in one of the stream layouts
+struct VertexStreamSet
+{
+	StreamLayout Layout;
+	uint32_t VertexCount;
+	std::vector<StreamElement> Elements;
+	std::vector<VertexStream> Streams;
+
+	// Index into Elements, or -1
+	int FindElement(const char* semantic) const;
+	size_t SizeInBytes() const;
+};
+
+// Splits interleaved vertices described by 'elements' into the requested layout
+VertexStreamSet BuildVertexStreams(const void* vertices, uint32_t vertexCount, uint32_t stride
+	, const VertexElement* elements, size_t elementCount, StreamLayout layout);
+
+template<typename V>
+VertexStreamSet BuildVertexStreams(const V* vertices, uint32_t vertexCount, StreamLayout layout)
+{
+	return BuildVertexStreams(vertices, vertexCount, VertexStride<V>()
+		, VertexFormat<V>::Elements.data(), VertexFormat<V>::Elements.size(), layout);
+}
+
+// Elements of V in one interleaved stream
+template<typename V>
+std::vector<StreamElement> InterleavedElements()
+{
+	std::vector<StreamElement> elements;
+	for (size_t i = 0; i < VertexFormat<V>::Elements.size(); i++)
+	{
+		elements.push_back({ VertexFormat<V>::Elements[i], 0 });
+	}
+	return elements;
+}
+
+// Converts between layouts, attribute order is kept
+VertexStreamSet ConvertVertexStreams(const VertexStreamSet& source, StreamLayout layout);
+
+// Writes the vertices back into one interleaved array of 'stride' bytes per
+// vertex using the attribute offsets of 'elements'
+void GatherVertexStreams(const VertexStreamSet& source, void* vertices, uint32_t stride
+	, const VertexElement* elements, size_t elementCount);
+
+// Result of a simulated position only pass (depth prepass, culling)
+struct PositionPassStats
+{
+	uint64_t BytesFetched;		// Whole cache lines touched in the position stream
+	uint64_t BytesUseful;		// Position bytes actually used
+	double MillisecondsPerPass;
+	uint32_t VerticesInside;	// Vertices inside the clip volume, keeps the work alive
+};
+
+// Transforms every position by the row major 'viewProj' and tests it against
+// the clip volume 'iterations' times
+PositionPassStats RunPositionOnlyPass(const VertexStreamSet& streams, const float viewProj[16], uint32_t iterations);
+
+#if defined(_WIN32)
+
+// Input elements with the stream index as input slot
+std::vector<D3D11_INPUT_ELEMENT_DESC> InputElementDescs(const std::vector<StreamElement>& elements);
+std::vector<D3D11_INPUT_ELEMENT_DESC> InputElementDescs(const VertexStreamSet& streams);
+
+#endif
+
+#endif // VERTEXSTREAMS_H
@@ -0,0 +1,113 @@
+#include "ArenaBenchmark.h"
+#include "AllocationCounter.h"
+#include "FrameArena.h"
+#include "MathTypes.h"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+	const uint32_t benchmarkFrames = 2000;
+	const uint32_t arraysPerFrame = 64;
+
+	// The same sizes every frame, 8 to 256 matrices
+	uint32_t ArraySize(uint32_t index)
+	{
+		return 8 + (index * 37) % 249;
+	}
+
+	uint32_t CheckArena()
+	{
+		uint32_t failures = 0;
+		FrameArena arena(1024, 2);
+
+		arena.BeginFrame();
+		uint64_t first = arena.Frame();
+		FrameSpan<Float4x4> matrices = arena.AllocateArray<Float4x4>(8);
+		failures += (reinterpret_cast<uintptr_t>(matrices.Data()) & 15) == 0 ? 0 : 1;
+		failures += arena.UsedBytes() == 8 * sizeof(Float4x4) ? 0 : 1;
+
+		// Does not fit, comes from the heap and is counted
+		FrameSpan<Float4x4> large = arena.AllocateArray<Float4x4>(64);
+		failures += large.Data() != nullptr && arena.OverflowCount() == 1 ? 0 : 1;
+
+		arena.BeginFrame();
+		failures += arena.IsLive(first) ? 0 : 1;
+		failures += arena.UsedBytes() == 0 ? 0 : 1;
+		arena.BeginFrame();
+		failures += arena.IsLive(first) ? 1 : 0;
+		failures += arena.PeakBytes() == 8 * sizeof(Float4x4) + 64 * sizeof(Float4x4) ? 0 : 1;
+
+		if (failures > 0)
+		{
+			printf("%u frame arena checks failed\n", failures);
+		}
+		return failures;
+	}
+
+	float UseMatrices(Float4x4* matrices, uint32_t count, uint32_t frame)
+	{
+		float sum = 0.0f;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			matrices[i] = MatrixTranslation(static_cast<float>(frame), static_cast<float>(i), 0.0f);
+			sum += matrices[i].m[3][1];
+		}
+		return sum;
+	}
+}
+
+uint32_t RunArenaBenchmark()
+{
+	uint32_t failures = CheckArena();
+
+	size_t bytesPerFrame = 0;
+	for (uint32_t i = 0; i < arraysPerFrame; i++)
+	{
+		bytesPerFrame += ArraySize(i) * sizeof(Float4x4) + 16;
+	}
+
+	float sink = 0.0f;
+
+	FrameArena arena(bytesPerFrame, 2);
+	AllocationScope arenaAllocations;
+	auto arenaStart = std::chrono::steady_clock::now();
+	for (uint32_t frame = 0; frame < benchmarkFrames; frame++)
+	{
+		arena.BeginFrame();
+		for (uint32_t i = 0; i < arraysPerFrame; i++)
+		{
+			FrameSpan<Float4x4> matrices = arena.AllocateArray<Float4x4>(ArraySize(i));
+			sink += UseMatrices(matrices.Data(), matrices.Size(), frame);
+		}
+	}
+	auto arenaEnd = std::chrono::steady_clock::now();
+	uint64_t arenaCount = arenaAllocations.Allocations();
+
+	AllocationScope vectorAllocations;
+	auto vectorStart = std::chrono::steady_clock::now();
+	for (uint32_t frame = 0; frame < benchmarkFrames; frame++)
+	{
+		for (uint32_t i = 0; i < arraysPerFrame; i++)
+		{
+			std::vector<Float4x4> matrices(ArraySize(i));
+			sink += UseMatrices(matrices.data(), static_cast<uint32_t>(matrices.size()), frame);
+		}
+	}
+	auto vectorEnd = std::chrono::steady_clock::now();
+	uint64_t vectorCount = vectorAllocations.Allocations();
+
+	double arenaUs = std::chrono::duration<double, std::micro>(arenaEnd - arenaStart).count() / benchmarkFrames;
+	double vectorUs = std::chrono::duration<double, std::micro>(vectorEnd - vectorStart).count() / benchmarkFrames;
+	printf("%u arrays, %zu bytes per frame (checksum %.0f)\n", arraysPerFrame, bytesPerFrame, sink);
+	printf("FrameArena   %8.2f us/frame  %6.2f heap allocations/frame  %llu overflows\n"
+		, arenaUs
+		, static_cast<double>(arenaCount) / benchmarkFrames
+		, static_cast<unsigned long long>(arena.OverflowCount()));
+	printf("std::vector  %8.2f us/frame  %6.2f heap allocations/frame\n", vectorUs, static_cast<double>(vectorCount) / benchmarkFrames);
+
+	failures += arenaCount == 0 && arena.OverflowCount() == 0 ? 0 : 1;
+	return failures;
+}
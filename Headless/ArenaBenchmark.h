@@ -0,0 +1,11 @@
+#ifndef ARENABENCHMARK_H
+#define ARENABENCHMARK_H
+
+#include <cstdint>
+
+// Checks FrameArena's lifetimes and overflow, then times a frame's worth of
+// transient arrays from the arena against std::vector allocated every frame.
+// Returns the number of failed checks.
+uint32_t RunArenaBenchmark();
+
+#endif // ARENABENCHMARK_H
@@ -0,0 +1,408 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+namespace
+{
+	bool ParseButtons(const std::string& text, uint32_t& buttons)
+	{
+		buttons = 0;
+		if (text == "-")
+		{
+			return true;
+		}
+		for (size_t i = 0; i < text.size(); i++)
+		{
+			switch (text[i])
+			{
+			case 'l': buttons |= MouseButtonLeft; break;
+			case 'r': buttons |= MouseButtonRight; break;
+			case 'm': buttons |= MouseButtonMiddle; break;
+			default: return false;
+			}
+		}
+		return true;
+	}
+
+	// Reads the numbers of a JSON document into a map keyed by their path.
+	// Enough for the files WriteBenchmarkJson writes, not a general parser.
+	class FlatJsonReader
+	{
+	public:
+		FlatJsonReader(const std::string& text, std::map<std::string, double>& values)
+			: mText(text)
+			, mPosition(0)
+			, mValues(values)
+		{
+		}
+
+		bool Read()
+		{
+			if (!ReadValue(""))
+			{
+				return false;
+			}
+			SkipSpace();
+			return mPosition == mText.size();
+		}
+
+	private:
+		void SkipSpace()
+		{
+			while (mPosition < mText.size() && isspace(static_cast<unsigned char>(mText[mPosition])))
+			{
+				mPosition++;
+			}
+		}
+
+		bool Consume(char c)
+		{
+			SkipSpace();
+			if (mPosition < mText.size() && mText[mPosition] == c)
+			{
+				mPosition++;
+				return true;
+			}
+			return false;
+		}
+
+		bool ReadString(std::string& text)
+		{
+			if (!Consume('"'))
+			{
+				return false;
+			}
+			text.clear();
+			while (mPosition < mText.size() && mText[mPosition] != '"')
+			{
+				if (mText[mPosition] == '\\' && mPosition + 1 < mText.size())
+				{
+					mPosition++;
+				}
+				text += mText[mPosition++];
+			}
+			return Consume('"');
+		}
+
+		bool ReadValue(const std::string& path)
+		{
+			SkipSpace();
+			if (mPosition >= mText.size())
+			{
+				return false;
+			}
+
+			char c = mText[mPosition];
+			if (c == '{')
+			{
+				mPosition++;
+				if (Consume('}'))
+				{
+					return true;
+				}
+				do
+				{
+					std::string key;
+					if (!ReadString(key) || !Consume(':') || !ReadValue(path.empty() ? key : path + "." + key))
+					{
+						return false;
+					}
+				} while (Consume(','));
+				return Consume('}');
+			}
+			if (c == '[')
+			{
+				// Elements have no path
+				mPosition++;
+				if (Consume(']'))
+				{
+					return true;
+				}
+				do
+				{
+					if (!ReadValue(std::string()))
+					{
+						return false;
+					}
+				} while (Consume(','));
+				return Consume(']');
+			}
+			if (c == '"')
+			{
+				std::string ignored;
+				return ReadString(ignored);
+			}
+			if (mText.compare(mPosition, 4, "true") == 0 || mText.compare(mPosition, 4, "null") == 0)
+			{
+				mPosition += 4;
+				return true;
+			}
+			if (mText.compare(mPosition, 5, "false") == 0)
+			{
+				mPosition += 5;
+				return true;
+			}
+
+			const char* start = mText.c_str() + mPosition;
+			char* end = nullptr;
+			double value = strtod(start, &end);
+			if (end == start)
+			{
+				return false;
+			}
+			mPosition += end - start;
+			if (!path.empty())
+			{
+				mValues[path] = value;
+			}
+			return true;
+		}
+
+		const std::string& mText;
+		size_t mPosition;
+		std::map<std::string, double>& mValues;
+	};
+
+	// Smaller differences are timer noise whatever the percentage
+	const double minimumRegressionUs = 1.0;
+
+	void WriteStats(FILE* file, const char* name, const TimingStats& stats)
+	{
+		fprintf(file, "\"%s\": {\"mean\": %.3f, \"min\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f}"
+			, name, stats.Mean, stats.Min, stats.P50, stats.P90, stats.P99, stats.Max);
+	}
+
+	void WriteSamples(FILE* file, const char* name, const std::vector<double>& samples)
+	{
+		fprintf(file, "\"%s\": [", name);
+		for (size_t i = 0; i < samples.size(); i++)
+		{
+			fprintf(file, "%s%.3f", i == 0 ? "" : ",", samples[i]);
+		}
+		fprintf(file, "]");
+	}
+}
+
+//
+// InputScript
+//
+
+InputScript::InputScript()
+	: mNext(0)
+{
+}
+
+bool InputScript::Load(const std::string& fileName)
+{
+	std::ifstream file(fileName.c_str());
+	if (!file)
+	{
+		return false;
+	}
+
+	mEvents.clear();
+	mNext = 0;
+
+	std::string line;
+	while (std::getline(file, line))
+	{
+		size_t first = line.find_first_not_of(" \t\r");
+		if (first == std::string::npos || line[first] == '#')
+		{
+			continue;
+		}
+
+		std::istringstream fields(line);
+		Event event;
+		std::string type;
+		std::string buttons;
+		if (!(fields >> event.Frame >> type >> buttons >> event.X >> event.Y) || !ParseButtons(buttons, event.Buttons))
+		{
+			return false;
+		}
+
+		if (type == "down")
+		{
+			event.Type = EventType::Down;
+		}
+		else if (type == "up")
+		{
+			event.Type = EventType::Up;
+		}
+		else if (type == "move")
+		{
+			event.Type = EventType::Move;
+		}
+		else
+		{
+			return false;
+		}
+		mEvents.push_back(event);
+	}
+
+	std::stable_sort(mEvents.begin(), mEvents.end(), [](const Event& a, const Event& b) { return a.Frame < b.Frame; });
+	return true;
+}
+
+InputScript InputScript::Orbit(uint32_t frames, int width, int height)
+{
+	InputScript script;
+	if (frames < 4)
+	{
+		return script;
+	}
+
+	int x = width / 2;
+	int y = height / 2;
+	uint32_t half = frames / 2;
+
+	script.mEvents.push_back({ 0, EventType::Down, MouseButtonLeft, x, y });
+	for (uint32_t frame = 1; frame < half - 1; frame++)
+	{
+		x += 3;
+		y += (frame & 1);
+		script.mEvents.push_back({ frame, EventType::Move, MouseButtonLeft, x, y });
+	}
+	script.mEvents.push_back({ half - 1, EventType::Up, 0, x, y });
+
+	script.mEvents.push_back({ half, EventType::Down, MouseButtonRight, x, y });
+	for (uint32_t frame = half + 1; frame < frames - 1; frame++)
+	{
+		y += 1;
+		script.mEvents.push_back({ frame, EventType::Move, MouseButtonRight, x, y });
+	}
+	script.mEvents.push_back({ frames - 1, EventType::Up, 0, x, y });
+	return script;
+}
+
+void InputScript::Play(uint32_t frame, InputQueue& queue)
+{
+	for (; mNext < mEvents.size() && mEvents[mNext].Frame <= frame; mNext++)
+	{
+		const Event& event = mEvents[mNext];
+		InputEvent input = { InputEventType::MouseMove, event.Buttons, event.X, event.Y, InputTimestamp() };
+		switch (event.Type)
+		{
+		case EventType::Down: input.Type = InputEventType::MouseDown; break;
+		case EventType::Up: input.Type = InputEventType::MouseUp; break;
+		case EventType::Move: input.Type = InputEventType::MouseMove; break;
+		}
+		queue.Push(input);
+	}
+}
+
+//
+// Results
+//
+
+TimingStats ComputeTimingStats(const std::vector<double>& samples)
+{
+	TimingStats stats = {};
+	if (samples.empty())
+	{
+		return stats;
+	}
+
+	std::vector<double> sorted(samples);
+	std::sort(sorted.begin(), sorted.end());
+
+	// Nearest rank
+	auto percentile = [&sorted](double fraction)
+	{
+		size_t rank = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+		return sorted[std::min(sorted.size() - 1, rank == 0 ? 0 : rank - 1)];
+	};
+
+	double sum = 0.0;
+	for (size_t i = 0; i < sorted.size(); i++)
+	{
+		sum += sorted[i];
+	}
+	stats.Mean = sum / sorted.size();
+	stats.Min = sorted.front();
+	stats.P50 = percentile(0.5);
+	stats.P90 = percentile(0.9);
+	stats.P99 = percentile(0.99);
+	stats.Max = sorted.back();
+	return stats;
+}
+
+bool WriteBenchmarkJson(const std::string& fileName, const std::vector<BenchmarkResult>& results, uint32_t frames, float dt)
+{
+	FILE* file = fopen(fileName.c_str(), "w");
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	fprintf(file, "{\n\"frames\": %u,\n\"dt\": %.6f,\n\"scenes\": {", frames, dt);
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const BenchmarkResult& result = results[i];
+		fprintf(file, "%s\n\"%s\": {\n", i == 0 ? "" : ",", result.Scene.c_str());
+		WriteStats(file, "update", ComputeTimingStats(result.UpdateUs));
+		fprintf(file, ",\n");
+		WriteStats(file, "draw", ComputeTimingStats(result.DrawUs));
+		fprintf(file, ",\n");
+		WriteSamples(file, "updateSamples", result.UpdateUs);
+		fprintf(file, ",\n");
+		WriteSamples(file, "drawSamples", result.DrawUs);
+		fprintf(file, "\n}");
+	}
+	fprintf(file, "\n}\n}\n");
+	return fclose(file) == 0;
+}
+
+bool ReadBenchmarkJson(const std::string& fileName, std::map<std::string, double>& values)
+{
+	std::ifstream file(fileName.c_str(), std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+	std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	FlatJsonReader reader(text, values);
+	return reader.Read();
+}
+
+uint32_t CompareWithBaseline(const std::vector<BenchmarkResult>& results, const std::map<std::string, double>& baseline, double thresholdPercent)
+{
+	uint32_t regressions = 0;
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const BenchmarkResult& result = results[i];
+		const char* phases[2] = { "update", "draw" };
+		const std::vector<double>* samples[2] = { &result.UpdateUs, &result.DrawUs };
+		for (int phase = 0; phase < 2; phase++)
+		{
+			auto found = baseline.find("scenes." + result.Scene + "." + phases[phase] + ".p50");
+			double current = ComputeTimingStats(*samples[phase]).P50;
+			if (found == baseline.end())
+			{
+				printf("%-9s %-6s p50 %10.3f us, not in the baseline\n", result.Scene.c_str(), phases[phase], current);
+				continue;
+			}
+
+			double previous = found->second;
+			double change = previous > 0.0 ? 100.0 * (current - previous) / previous : 0.0;
+			bool regressed = change > thresholdPercent && current - previous > minimumRegressionUs;
+			printf("%-9s %-6s p50 %10.3f us, baseline %10.3f us  %+7.1f%%%s\n"
+				, result.Scene.c_str()
+				, phases[phase]
+				, current
+				, previous
+				, change
+				, regressed ? "  REGRESSION" : "");
+			regressions += regressed ? 1 : 0;
+		}
+	}
+	return regressions;
+}
@@ -0,0 +1,91 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "DemoScene.h"
+#include "InputQueue.h"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// Mouse input replayed into a scene at fixed frames, so runs that move the
+// camera stay comparable. A script file has one event per line:
+//
+//	# frame event buttons x y
+//	0 down l 400 300
+//	1 move l 404 300
+//	60 up l 640 300
+//
+// 'event' is down, up or move, 'buttons' any of l, r and m or - for none.
+class InputScript
+{
+public:
+	InputScript();
+
+	// False if the file is missing or a line does not parse
+	bool Load(const std::string& fileName);
+
+	// Orbits with the left button for the first half of the frames, then
+	// zooms with the right button, starting from the center of the window
+	static InputScript Orbit(uint32_t frames, int width, int height);
+
+	// Queues the events of 'frame', frames must not go back
+	void Play(uint32_t frame, InputQueue& queue);
+	void Rewind() { mNext = 0; }
+
+	size_t EventCount() const { return mEvents.size(); }
+
+private:
+	enum class EventType
+	{
+		Down,
+		Up,
+		Move
+	};
+
+	struct Event
+	{
+		uint32_t Frame;
+		EventType Type;
+		uint32_t Buttons;	// MouseButton flags
+		int X;
+		int Y;
+	};
+
+	std::vector<Event> mEvents;	// Sorted by frame
+	size_t mNext;
+};
+
+// Distribution of per-frame times in microseconds
+struct TimingStats
+{
+	double Mean;
+	double Min;
+	double P50;
+	double P90;
+	double P99;
+	double Max;
+};
+
+TimingStats ComputeTimingStats(const std::vector<double>& samples);
+
+struct BenchmarkResult
+{
+	std::string Scene;
+	std::vector<double> UpdateUs;	// UpdateScene per frame
+	std::vector<double> DrawUs;		// DrawScene and, when rasterizing, the end of the frame
+};
+
+// {"frames": N, "dt": s, "scenes": {"<scene>": {"update": {...}, "draw": {...}, "updateSamples": [...], "drawSamples": [...]}}}
+bool WriteBenchmarkJson(const std::string& fileName, const std::vector<BenchmarkResult>& results, uint32_t frames, float dt);
+
+// Numbers of a results file by path, e.g. "scenes.box.draw.p50". Arrays are skipped.
+bool ReadBenchmarkJson(const std::string& fileName, std::map<std::string, double>& values);
+
+// Prints the median update and draw times next to the baseline's and returns
+// how many are more than thresholdPercent and at least a microsecond slower.
+// Scenes missing from the baseline are reported and not counted.
+uint32_t CompareWithBaseline(const std::vector<BenchmarkResult>& results, const std::map<std::string, double>& baseline, double thresholdPercent);
+
+#endif // BENCHMARK_H
@@ -0,0 +1,311 @@
+#include "BvhCheck.h"
+#include "MeshBvh.h"
+#include "MeshGenerator.h"
+#include "SkullModel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+	struct Mesh
+	{
+		std::vector<Float3> Positions;
+		std::vector<uint32_t> Indices;
+	};
+
+	uint32_t Check(bool passed, const char* what)
+	{
+		if (!passed)
+		{
+			printf("Failed: %s\n", what);
+			return 1;
+		}
+		return 0;
+	}
+
+	void ToMesh(const MeshGenerator::MeshData& data, Mesh& mesh)
+	{
+		mesh.Positions.clear();
+		for (size_t i = 0; i < data.Vertices.size(); i++)
+		{
+			mesh.Positions.push_back(data.Vertices[i].Position);
+		}
+		mesh.Indices = data.Indices;
+	}
+
+	void Build(MeshBvh& bvh, const Mesh& mesh)
+	{
+		bvh.Build(mesh.Positions.data(), sizeof(Float3), static_cast<uint32_t>(mesh.Positions.size()), mesh.Indices.data(), static_cast<uint32_t>(mesh.Indices.size()));
+	}
+
+	Float3 Lerp(const Float3& a, const Float3& b, float t)
+	{
+		return Float3(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t);
+	}
+
+	// From a sphere around the mesh towards a point in its bounds, or in any direction
+	std::vector<Ray> RandomRays(const MeshBvh& bvh, uint32_t count, uint32_t seed)
+	{
+		std::mt19937 random(seed);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		std::normal_distribution<float> normal(0.0f, 1.0f);
+
+		Float3 min = bvh.BoundsMin();
+		Float3 max = bvh.BoundsMax();
+		Float3 center = Lerp(min, max, 0.5f);
+		Float3 size = Subtract(max, min);
+		float radius = std::sqrt(Dot(size, size));
+
+		std::vector<Ray> rays(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			Float3 onSphere = Normalize3(Float3(normal(random), normal(random), normal(random)));
+			Float3 origin(center.x + onSphere.x * radius, center.y + onSphere.y * radius, center.z + onSphere.z * radius);
+			Float3 direction;
+			if (i % 4 != 3)
+			{
+				Float3 target(min.x + size.x * unit(random), min.y + size.y * unit(random), min.z + size.z * unit(random));
+				direction = Normalize3(Subtract(target, origin));
+			}
+			else
+			{
+				direction = Normalize3(Float3(normal(random), normal(random), normal(random)));
+			}
+			rays[i].Origin = origin;
+			rays[i].Direction = direction;
+		}
+		return rays;
+	}
+
+	// The eye the skull demo starts with
+	Float4x4 SkullViewProj(float width, float height)
+	{
+		float theta = 1.5f * MathPi;
+		float phi = 0.25f * MathPi;
+		float radius = 20.0f;
+		Float3 eye(radius * sinf(phi) * cosf(theta), radius * sinf(phi) * sinf(theta), radius * cosf(phi));
+		Float4x4 view = MatrixLookAtLH(eye, Float3(0.0f, 3.0f, 0.0f), Float3(0.0f, 1.0f, 0.0f));
+		Float4x4 proj = MatrixPerspectiveFovLH(0.25f * MathPi, width / height, 1.0f, 1000.0f);
+		return MatrixMultiply(view, proj);
+	}
+
+	uint32_t CheckKnownHits()
+	{
+		uint32_t failures = 0;
+		MeshGenerator::MeshData box;
+		MeshGenerator::CreateBox(2.0f, 2.0f, 2.0f, box);
+		Mesh mesh;
+		ToMesh(box, mesh);
+		MeshBvh bvh;
+		Build(bvh, mesh);
+		failures += Check(bvh.TriangleCount() == 12 && !bvh.IsEmpty(), "the box does not have 12 triangles");
+
+		Ray ray = { Float3(0.2f, 0.3f, -5.0f), Float3(0.0f, 0.0f, 1.0f) };
+		RayHit hit;
+		bool found = bvh.Intersect(ray, hit);
+		failures += Check(found && std::fabs(hit.Distance - 4.0f) < 1e-5f, "the ray does not hit the box's front at 4");
+		if (found)
+		{
+			// The hit point from the barycentrics is where the ray is
+			const uint32_t* corners = &mesh.Indices[hit.Triangle * 3];
+			Float3 p0 = mesh.Positions[corners[0]];
+			Float3 e1 = Subtract(mesh.Positions[corners[1]], p0);
+			Float3 e2 = Subtract(mesh.Positions[corners[2]], p0);
+			Float3 point(p0.x + e1.x * hit.U + e2.x * hit.V, p0.y + e1.y * hit.U + e2.y * hit.V, p0.z + e1.z * hit.U + e2.z * hit.V);
+			failures += Check(std::fabs(point.x - 0.2f) < 1e-5f && std::fabs(point.y - 0.3f) < 1e-5f && std::fabs(point.z + 1.0f) < 1e-5f, "the barycentrics are not the hit point");
+		}
+		failures += Check(!bvh.Intersect(ray, hit, 3.5f), "a hit beyond maxDistance counts");
+
+		// From inside the far face is the nearest
+		Ray inside = { Float3(0.0f, 0.0f, 0.0f), Float3(0.0f, 0.0f, 1.0f) };
+		failures += Check(bvh.Intersect(inside, hit) && std::fabs(hit.Distance - 1.0f) < 1e-5f, "a ray from inside does not hit the back face");
+		Ray away = { Float3(0.0f, 0.0f, -5.0f), Float3(0.0f, 0.0f, -1.0f) };
+		failures += Check(!bvh.Intersect(away, hit), "a ray pointing away hits");
+		Ray past = { Float3(3.0f, 0.0f, -5.0f), Float3(0.0f, 0.0f, 1.0f) };
+		failures += Check(!bvh.Intersect(past, hit), "a ray past the box hits");
+
+		MeshBvh empty;
+		failures += Check(!empty.Intersect(ray, hit) && empty.IsEmpty(), "an empty BVH hits");
+
+		// Many triangles in the same spot still build and hit
+		Mesh stacked;
+		stacked.Positions.push_back(Float3(-1.0f, -1.0f, 0.0f));
+		stacked.Positions.push_back(Float3(0.0f, 1.0f, 0.0f));
+		stacked.Positions.push_back(Float3(1.0f, -1.0f, 0.0f));
+		for (uint32_t i = 0; i < 1000; i++)
+		{
+			stacked.Indices.push_back(0);
+			stacked.Indices.push_back(1);
+			stacked.Indices.push_back(2);
+		}
+		MeshBvh same;
+		Build(same, stacked);
+		failures += Check(same.Intersect(ray, hit) && std::fabs(hit.Distance - 5.0f) < 1e-5f && same.Depth() < 128, "identical triangles do not build");
+
+		Float4x4 viewProj = SkullViewProj(800.0f, 600.0f);
+		Float4x4 product = MatrixMultiply(viewProj, MatrixInverse(viewProj));
+		float error = 0.0f;
+		for (int row = 0; row < 4; row++)
+		{
+			for (int column = 0; column < 4; column++)
+			{
+				error = std::max(error, std::fabs(product.m[row][column] - (row == column ? 1.0f : 0.0f)));
+			}
+		}
+		failures += Check(error < 1e-4f, "MatrixInverse is not the inverse");
+		return failures;
+	}
+
+	uint32_t CheckScreenRays()
+	{
+		uint32_t failures = 0;
+		const float width = 800.0f;
+		const float height = 600.0f;
+		Float4x4 viewProj = SkullViewProj(width, height);
+
+		std::mt19937 random(7);
+		std::uniform_real_distribution<float> coordinate(-4.0f, 4.0f);
+		float worst = 0.0f;
+		for (uint32_t i = 0; i < 1000; i++)
+		{
+			// A point in view, projected to a pixel, is on that pixel's ray
+			Float3 point(coordinate(random), coordinate(random) + 3.0f, coordinate(random));
+			Float4 clip = Transform(Float4(point.x, point.y, point.z, 1.0f), viewProj);
+			float x = (clip.x / clip.w * 0.5f + 0.5f) * width;
+			float y = (0.5f - clip.y / clip.w * 0.5f) * height;
+			Ray ray = ScreenPointToRay(x, y, width, height, viewProj);
+
+			Float3 toPoint = Subtract(point, ray.Origin);
+			float along = Dot(toPoint, ray.Direction);
+			Float3 closest(ray.Origin.x + ray.Direction.x * along, ray.Origin.y + ray.Direction.y * along, ray.Origin.z + ray.Direction.z * along);
+			Float3 miss = Subtract(point, closest);
+			worst = std::max(worst, std::sqrt(Dot(miss, miss)) / along);
+		}
+		failures += Check(worst < 1e-4f, "ScreenPointToRay misses the projected points");
+		return failures;
+	}
+
+	uint32_t CheckAgainstBruteForce(const MeshBvh& bvh, const std::vector<Ray>& rays)
+	{
+		uint32_t hits = 0;
+		uint32_t mismatches = 0;
+		for (size_t i = 0; i < rays.size(); i++)
+		{
+			RayHit fast = {};
+			RayHit slow = {};
+			bool fastFound = bvh.Intersect(rays[i], fast);
+			bool slowFound = bvh.IntersectBruteForce(rays[i], slow);
+			// Rays through a shared edge may name either triangle, the distance is the same
+			if (fastFound != slowFound || (fastFound && std::fabs(fast.Distance - slow.Distance) > 1e-5f * std::max(1.0f, slow.Distance)))
+			{
+				if (mismatches == 0)
+				{
+					printf("Ray %u: BVH %s %.6f, brute force %s %.6f\n", static_cast<uint32_t>(i), fastFound ? "hit" : "miss", fast.Distance, slowFound ? "hit" : "miss", slow.Distance);
+				}
+				mismatches++;
+			}
+			hits += slowFound ? 1 : 0;
+		}
+		printf("%u random rays, %u hits, %u differ from brute force\n", static_cast<uint32_t>(rays.size()), hits, mismatches);
+		return Check(mismatches == 0 && hits > 0 && hits < rays.size(), "the BVH and brute force differ");
+	}
+
+	double RaysPerSecond(const MeshBvh& bvh, const std::vector<Ray>& rays, bool bruteForce, uint32_t& hits)
+	{
+		hits = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < rays.size(); i++)
+		{
+			RayHit hit;
+			bool found = bruteForce ? bvh.IntersectBruteForce(rays[i], hit) : bvh.Intersect(rays[i], hit);
+			hits += found ? 1 : 0;
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		return seconds > 0.0 ? rays.size() / seconds : 0.0;
+	}
+
+	void Benchmark(const Mesh& mesh, const char* name)
+	{
+		MeshBvh bvh;
+		const uint32_t builds = 5;
+		auto start = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < builds; i++)
+		{
+			Build(bvh, mesh);
+		}
+		double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / builds;
+		printf("%s: %u triangles, build %.2f ms, %u nodes, %u leaves, depth %u, %.2f MB\n"
+			, name
+			, bvh.TriangleCount()
+			, buildMs
+			, bvh.NodeCount()
+			, bvh.LeafCount()
+			, bvh.Depth()
+			, bvh.MemoryBytes() / (1024.0 * 1024.0));
+
+		// The demo's camera, one ray per pixel as the mouse would move over it
+		const uint32_t width = 400;
+		const uint32_t height = 300;
+		Float4x4 viewProj = SkullViewProj(static_cast<float>(width), static_cast<float>(height));
+		std::vector<Ray> screen;
+		screen.reserve(width * height);
+		for (uint32_t y = 0; y < height; y++)
+		{
+			for (uint32_t x = 0; x < width; x++)
+			{
+				screen.push_back(ScreenPointToRay(x + 0.5f, y + 0.5f, static_cast<float>(width), static_cast<float>(height), viewProj));
+			}
+		}
+		std::vector<Ray> random = RandomRays(bvh, 200000, 11);
+		std::vector<Ray> fewRandom(random.begin(), random.begin() + 200);
+
+		uint32_t screenHits;
+		uint32_t randomHits;
+		uint32_t bruteHits;
+		double screenRate = RaysPerSecond(bvh, screen, false, screenHits);
+		double randomRate = RaysPerSecond(bvh, random, false, randomHits);
+		double bruteRate = RaysPerSecond(bvh, fewRandom, true, bruteHits);
+		printf("Screen rays: %.2f M rays/s (%u of %u hit)\n", screenRate / 1e6, screenHits, static_cast<uint32_t>(screen.size()));
+		printf("Random rays: %.2f M rays/s (%u of %u hit)\n", randomRate / 1e6, randomHits, static_cast<uint32_t>(random.size()));
+		printf("Brute force: %.0f rays/s, %.0f times slower, %.2f ms per pick\n", bruteRate, bruteRate > 0.0 ? randomRate / bruteRate : 0.0, bruteRate > 0.0 ? 1000.0 / bruteRate : 0.0);
+	}
+}
+
+uint32_t RunBvhCheck(const std::string& skullModel)
+{
+	uint32_t failures = CheckKnownHits();
+	failures += CheckScreenRays();
+
+	Mesh mesh;
+	const char* name = "Skull";
+	SkullModel skull;
+	if (LoadSkullModel(skullModel, skull))
+	{
+		mesh.Positions.swap(skull.Positions);
+		mesh.Indices.swap(skull.Indices);
+	}
+	else
+	{
+		printf("Could not load %s, using a sphere\n", skullModel.c_str());
+		MeshGenerator::MeshData sphere;
+		MeshGenerator::CreateSphere(5.0f, 175, 175, sphere);
+		ToMesh(sphere, mesh);
+		name = "Sphere";
+	}
+
+	MeshBvh bvh;
+	Build(bvh, mesh);
+	failures += CheckAgainstBruteForce(bvh, RandomRays(bvh, 20000, 3));
+	Benchmark(mesh, name);
+
+	if (failures > 0)
+	{
+		printf("%u BVH checks failed\n", failures);
+	}
+	return failures;
+}
@@ -0,0 +1,14 @@
+#ifndef BVHCHECK_H
+#define BVHCHECK_H
+
+#include <cstdint>
+#include <string>
+
+// Checks MeshBvh against known hits and, on random rays, against testing
+// every triangle, and ScreenPointToRay against projected points. Times the
+// build and rays per second through the BVH and by brute force on the skull
+// model, or on a sphere of as many triangles if the file is missing.
+// Returns the number of failed checks.
+uint32_t RunBvhCheck(const std::string& skullModel);
+
+#endif // BVHCHECK_H
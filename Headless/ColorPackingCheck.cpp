@@ -0,0 +1,248 @@
+#include "ColorPackingCheck.h"
+#include "ColorPacking.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace
+{
+	struct TestValue
+	{
+		float Value;
+		uint8_t Expected;
+	};
+
+	uint32_t Check(bool passed, const char* what)
+	{
+		if (!passed)
+		{
+			printf("Failed: %s\n", what);
+			return 1;
+		}
+		return 0;
+	}
+
+	uint32_t FloatBits(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	// Round to nearest even of value * 255 as a float product, written
+	// without nearbyint so it does not share the code it checks
+	uint8_t Reference(float value)
+	{
+		if (!(value > 0.0f))
+		{
+			return 0;
+		}
+		if (value >= 1.0f)
+		{
+			return 255;
+		}
+		float scaled = value * 255.0f;
+		float whole = std::floor(scaled);
+		float fraction = scaled - whole;
+		uint32_t result = static_cast<uint32_t>(whole);
+		if (fraction > 0.5f || (fraction == 0.5f && (result & 1) != 0))
+		{
+			result++;
+		}
+		return static_cast<uint8_t>(result);
+	}
+
+	void AddNeighbours(std::vector<TestValue>& values, float center, uint32_t& ties)
+	{
+		float below = center;
+		float above = center;
+		for (int i = 0; i < 4; i++)
+		{
+			below = std::nextafter(below, -1.0f);
+			above = std::nextafter(above, 2.0f);
+		}
+		for (float v = below; v <= above; v = std::nextafter(v, 2.0f))
+		{
+			float scaled = v * 255.0f;
+			if (scaled - std::floor(scaled) == 0.5f)
+			{
+				ties++;
+			}
+			values.push_back({ v, Reference(v) });
+		}
+	}
+
+	// Every k/255 and (k + 1/2)/255 with four floats either side, a quarter
+	// of the way between the boundaries, and the values outside [0, 1]
+	std::vector<TestValue> MakeValues(uint32_t& ties)
+	{
+		std::vector<TestValue> values;
+		ties = 0;
+		for (uint32_t k = 0; k < 256; k++)
+		{
+			AddNeighbours(values, k / 255.0f, ties);
+			values.push_back({ k / 255.0f, static_cast<uint8_t>(k) });
+			if (k < 255)
+			{
+				AddNeighbours(values, (k + 0.5f) / 255.0f, ties);
+				values.push_back({ (k + 0.25f) / 255.0f, static_cast<uint8_t>(k) });
+				values.push_back({ (k + 0.75f) / 255.0f, static_cast<uint8_t>(k + 1) });
+			}
+		}
+
+		const float inf = std::numeric_limits<float>::infinity();
+		const float nan = std::numeric_limits<float>::quiet_NaN();
+		const float low[] = { -0.0f, -std::numeric_limits<float>::denorm_min(), -1e-7f, -0.5f, -1.0f, -1e30f, -inf, nan, -nan };
+		const float high[] = { std::nextafter(1.0f, 2.0f), 1.5f, 2.0f, 255.0f, 1e30f, inf };
+		for (float v : low)
+		{
+			values.push_back({ v, 0 });
+		}
+		for (float v : high)
+		{
+			values.push_back({ v, 255 });
+		}
+		values.push_back({ std::numeric_limits<float>::denorm_min(), 0 });
+		return values;
+	}
+
+	uint8_t Channel(const ColorRGBA8& color, uint32_t channel)
+	{
+		const uint8_t bytes[] = { color.r, color.g, color.b, color.a };
+		return bytes[channel];
+	}
+
+	uint32_t CheckValues()
+	{
+		uint32_t failures = 0;
+		uint32_t ties = 0;
+		std::vector<TestValue> values = MakeValues(ties);
+
+		// The values fill the channels in order, so each one is tested in every
+		// channel position and in both the SIMD body and the scalar tail
+		uint32_t mismatches = 0;
+		for (uint32_t shift = 0; shift < 4; shift++)
+		{
+			size_t colorCount = (values.size() + shift + 3) / 4;
+			std::vector<Float4> colors(colorCount, Float4(0.0f, 0.0f, 0.0f, 0.0f));
+			float* channels = &colors[0].x;
+			for (size_t i = 0; i < values.size(); i++)
+			{
+				channels[i + shift] = values[i].Value;
+			}
+
+			std::vector<ColorRGBA8> packed(colorCount);
+			PackColors(colors.data(), packed.data(), colorCount);
+
+			for (size_t i = 0; i < values.size(); i++)
+			{
+				size_t index = (i + shift) / 4;
+				uint32_t channel = static_cast<uint32_t>((i + shift) % 4);
+				uint8_t single = Channel(PackColor(colors[index]), channel);
+				uint8_t bulk = Channel(packed[index], channel);
+				if (single != values[i].Expected || bulk != values[i].Expected)
+				{
+					if (mismatches < 8)
+					{
+						printf("%.9g (%08x) packs to %u and %u, expected %u\n", values[i].Value, FloatBits(values[i].Value), single, bulk, values[i].Expected);
+					}
+					mismatches++;
+				}
+			}
+		}
+		failures += Check(mismatches == 0, "colors do not pack to the nearest even k/255");
+		failures += Check(ties > 0, "no exact ties were tested");
+
+		printf("Color packing: %zu values with %u exact ties checked in every channel\n", values.size(), ties);
+		return failures;
+	}
+
+
+	// Colors inside vertices of 16, 28 and 44 bytes, at aligned and unaligned
+	// addresses, packed into targets of 4, 8 and 16 bytes. Every count up to 37
+	// covers the SIMD body with each tail length. Bytes between the targets
+	// must stay untouched.
+	uint32_t CheckStrided()
+	{
+		std::mt19937 random(29);
+		std::uniform_real_distribution<float> inRange(-0.25f, 1.25f);
+		const float specials[] = { std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::infinity(),
+			-std::numeric_limits<float>::infinity(), 0.5f / 255.0f, 1.5f / 255.0f, -0.0f, 1.0f };
+
+		const size_t maxCount = 37;
+		const size_t sourceStrides[] = { 16, 28, 44 };
+		const size_t targetStrides[] = { 4, 8, 16 };
+		const size_t sourceOffsets[] = { 0, 4, 9 };
+		const size_t targetOffsets[] = { 0, 1, 12 };
+		const uint8_t untouched = 0xcd;
+
+		uint32_t mismatches = 0;
+		uint32_t overwrites = 0;
+		uint32_t runs = 0;
+		for (size_t sourceStride : sourceStrides)
+		{
+			for (size_t sourceOffset : sourceOffsets)
+			{
+				std::vector<uint8_t> source(sourceOffset + maxCount * sourceStride);
+				for (size_t i = 0; i < source.size() / sizeof(float); i++)
+				{
+					float value = random() % 8 == 0 ? specials[random() % 7] : inRange(random);
+					memcpy(&source[i * sizeof(float)], &value, sizeof(value));
+				}
+
+				for (size_t targetStride : targetStrides)
+				{
+					for (size_t targetOffset : targetOffsets)
+					{
+						for (size_t count = 0; count <= maxCount; count++)
+						{
+							std::vector<uint8_t> target(targetOffset + maxCount * targetStride + 16, untouched);
+							PackColors(&source[sourceOffset], sourceStride, &target[targetOffset], targetStride, count);
+							runs++;
+
+							for (size_t i = 0; i < count; i++)
+							{
+								Float4 color;
+								memcpy(&color, &source[sourceOffset + i * sourceStride], sizeof(color));
+								ColorRGBA8 expected = PackColor(color);
+								if (memcmp(&target[targetOffset + i * targetStride], &expected, sizeof(expected)) != 0)
+								{
+									mismatches++;
+								}
+							}
+							for (size_t b = 0; b < target.size(); b++)
+							{
+								bool isColor = b >= targetOffset && (b - targetOffset) % targetStride < sizeof(ColorRGBA8) && (b - targetOffset) / targetStride < count;
+								if (!isColor && target[b] != untouched)
+								{
+									overwrites++;
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+
+		uint32_t failures = Check(mismatches == 0, "PackColors differs from PackColor on strided colors");
+		failures += Check(overwrites == 0, "PackColors writes outside its target colors");
+		printf("Color packing: %u strided runs of 0 to %zu colors match PackColor\n", runs, maxCount);
+		return failures;
+	}
+}
+
+uint32_t RunColorPackingCheck()
+{
+	uint32_t failures = CheckValues();
+	failures += CheckStrided();
+
+	if (failures > 0)
+	{
+		printf("%u color packing checks failed\n", failures);
+	}
+	return failures;
+}
@@ -0,0 +1,12 @@
+#ifndef COLORPACKINGCHECK_H
+#define COLORPACKINGCHECK_H
+
+#include <cstdint>
+
+// Checks PackColor and PackColors on and around every k/255 boundary and
+// the ties between them, on out of range values, NaN and infinities, and
+// that PackColors matches PackColor for every count up to 37 with strided
+// and unaligned source and target. Returns the number of failed checks.
+uint32_t RunColorPackingCheck();
+
+#endif // COLORPACKINGCHECK_H
@@ -0,0 +1,143 @@
+#include "CommandBenchmark.h"
+#include "CommandBuffer.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+	const uint32_t partitionCount = 64;
+	const uint32_t drawsPerPartition = 500;
+	// Commands a partition records, its state and three per draw
+	const uint32_t commandsPerPartition = 4 + drawsPerPartition * 3;
+
+	uint32_t Check(bool passed, const char* what)
+	{
+		if (!passed)
+		{
+			printf("Failed: %s\n", what);
+			return 1;
+		}
+		return 0;
+	}
+
+	// Stand-ins for the backend's objects, the null context never looks at them
+	template<typename T>
+	T* FakeObject(uintptr_t id)
+	{
+		return reinterpret_cast<T*>(id * 16);
+	}
+
+	// Counts like the null context and checks that draw i arrives i-th
+	class OrderedContext : public NullDeviceContext
+	{
+	public:
+		OrderedContext() : OutOfOrder(0) {}
+
+		void DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex)
+		{
+			OutOfOrder += startIndex != DrawCount ? 1 : 0;
+			NullDeviceContext::DrawIndexed(indexCount, startIndex, baseVertex);
+		}
+
+		uint64_t OutOfOrder;
+	};
+
+	// Like ShapesScene, the state first so partitions replay in any context
+	void RecordPartition(uint32_t partition, CommandBuffer& commands)
+	{
+		commands.SetInputLayout(FakeObject<RenderInputLayout>(1));
+		commands.SetPrimitiveTopology(PrimitiveTopology::TriangleList);
+		commands.SetVertexBuffer(0, FakeObject<RenderBuffer>(2), 32, 0);
+		commands.SetIndexBuffer(FakeObject<RenderBuffer>(3), IndexFormat::UInt32, 0);
+
+		Float4x4 viewProj = MatrixMultiply(MatrixLookAtLH(Float3(0.0f, 10.0f, -20.0f), Float3(), Float3(0.0f, 1.0f, 0.0f))
+			, MatrixPerspectiveFovLH(0.8f, 1.5f, 1.0f, 1000.0f));
+		for (uint32_t i = 0; i < drawsPerPartition; i++)
+		{
+			uint32_t draw = partition * drawsPerPartition + i;
+			Float4x4 worldViewProj = MatrixMultiply(MatrixTranslation(static_cast<float>(draw % 100), 0.0f, static_cast<float>(draw / 100)), viewProj);
+			commands.SetConstants(FakeObject<RenderConstant>(4), &worldViewProj, sizeof(worldViewProj));
+			commands.ApplyPass(FakeObject<RenderPass>(5));
+			// The start index is the draw's place in the frame
+			commands.DrawIndexed(36, draw, 0);
+		}
+	}
+
+	double MillisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+uint32_t RunCommandBenchmark(uint32_t maxThreads)
+{
+	// Powers of two below the maximum, then the maximum
+	std::vector<uint32_t> threadCounts;
+	for (uint32_t threads = 1; threads < maxThreads; threads *= 2)
+	{
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(std::max(1u, maxThreads));
+
+	const uint64_t drawCount = static_cast<uint64_t>(partitionCount) * drawsPerPartition;
+	printf("%u partitions of %u draws, %u commands each\n", partitionCount, drawsPerPartition, commandsPerPartition);
+	printf("%-8s %12s %14s %10s %8s %12s\n", "threads", "record ms", "M commands/s", "MB/s", "speedup", "replay ms");
+
+	uint32_t failures = 0;
+	double singleThreadMs = 0.0;
+	for (uint32_t threads : threadCounts)
+	{
+		JobSystem jobs(threads);
+		ParallelCommandRecorder recorder(partitionCount, &jobs);
+
+		// Best of a few, the first also grows the buffers and wakes the workers
+		double recordMs = 0.0;
+		for (int run = 0; run < 6; run++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			recorder.Record(RecordPartition);
+			double ms = MillisecondsSince(start);
+			recordMs = run == 0 ? ms : std::min(recordMs, ms);
+		}
+		singleThreadMs = threads == 1 ? recordMs : singleThreadMs;
+
+		size_t bytes = 0;
+		uint32_t commands = 0;
+		for (uint32_t i = 0; i < recorder.PartitionCount(); i++)
+		{
+			bytes += recorder.Partition(i).SizeInBytes();
+			commands += recorder.Partition(i).CommandCount();
+		}
+
+		OrderedContext context;
+		auto start = std::chrono::steady_clock::now();
+		recorder.Replay(context);
+		double replayMs = MillisecondsSince(start);
+
+		printf("%-8u %12.3f %14.2f %10.0f %7.2fx %12.3f\n", threads, recordMs
+			, commands / (recordMs * 1e3), bytes / (recordMs * 1e3), singleThreadMs / recordMs, replayMs);
+
+		failures += Check(commands == partitionCount * commandsPerPartition && context.CallCount == commands, "a command was lost");
+		failures += Check(context.DrawCount == drawCount && context.IndexCount == drawCount * 36 && context.TriangleCount == drawCount * 12
+			, "the replayed draws are not the recorded ones");
+		failures += Check(context.ConstantBytes == drawCount * sizeof(Float4x4), "the replayed constants are not the recorded ones");
+		failures += Check(context.OutOfOrder == 0, "the draws were replayed out of partition order");
+	}
+
+	// The same stream without a job system
+	ParallelCommandRecorder serial(partitionCount, nullptr);
+	serial.Record(RecordPartition);
+	OrderedContext context;
+	serial.Replay(context);
+	failures += Check(serial.ThreadCount() == 1 && context.DrawCount == drawCount && context.OutOfOrder == 0, "recording without a job system differs");
+
+	if (failures > 0)
+	{
+		printf("%u command recording checks failed\n", failures);
+	}
+	return failures;
+}
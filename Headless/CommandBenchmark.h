@@ -0,0 +1,13 @@
+#ifndef COMMANDBENCHMARK_H
+#define COMMANDBENCHMARK_H
+
+#include <cstdint>
+
+// Records a frame of draws in partitions with ParallelCommandRecorder on 1
+// up to 'maxThreads' threads and replays it onto a NullDeviceContext.
+// Checks the replayed call, draw and constant counts and that the draws
+// arrive in partition order, and prints the recording throughput per
+// thread count. Returns the number of failed checks.
+uint32_t RunCommandBenchmark(uint32_t maxThreads);
+
+#endif // COMMANDBENCHMARK_H
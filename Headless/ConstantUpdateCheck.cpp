@@ -0,0 +1,183 @@
+#include "ConstantUpdateCheck.h"
+#include "ConstantData.h"
+#include "MathTypes.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+	// Never dereferenced, the uploader only records them
+	RenderConstant* FakeConstant(uintptr_t id)
+	{
+		return reinterpret_cast<RenderConstant*>(id * 16);
+	}
+
+	uint32_t Check(bool passed, const char* what)
+	{
+		if (!passed)
+		{
+			printf("Failed: %s\n", what);
+			return 1;
+		}
+		return 0;
+	}
+
+	// The blocks of a scene with a time, a camera and two objects
+	struct Blocks
+	{
+		ConstantBlock* Time;
+		ConstantBlock* ViewProj;
+		ConstantBlock* First;
+		ConstantBlock* Second;
+	};
+
+	Blocks AddBlocks(ConstantUpdater& updater)
+	{
+		Blocks blocks;
+		blocks.Time = updater.AddBlock(FakeConstant(1), sizeof(float), UpdateFrequency::PerFrame);
+		blocks.ViewProj = updater.AddBlock(FakeConstant(2), sizeof(Float4x4), UpdateFrequency::PerView);
+		blocks.First = updater.AddBlock(FakeConstant(3), sizeof(Float4x4), UpdateFrequency::PerObject);
+		blocks.Second = updater.AddBlock(FakeConstant(4), sizeof(Float4x4), UpdateFrequency::PerObject);
+		return blocks;
+	}
+
+	// The uploads of one frame in order
+	uint32_t CheckUploads(const RecordingConstantUploader& uploader, const std::vector<const ConstantBlock*>& expected, const char* frame)
+	{
+		bool same = uploader.Records.size() == expected.size();
+		for (size_t i = 0; same && i < expected.size(); i++)
+		{
+			same = uploader.Records[i].Constant == expected[i]->Constant() && uploader.Records[i].Size == expected[i]->Size();
+		}
+		std::string what = std::string(frame) + ": the uploads are not the changed blocks in commit order";
+		return Check(same, what.c_str());
+	}
+
+	uint32_t CheckStats(const ConstantUploadStats& stats, uint64_t frameBytes, uint64_t viewBytes, uint64_t objectBytes
+		, uint64_t skippedBytes, uint32_t uploads, uint32_t skippedUploads, const char* frame)
+	{
+		bool same = stats.BytesUploaded[static_cast<int>(UpdateFrequency::PerFrame)] == frameBytes
+			&& stats.BytesUploaded[static_cast<int>(UpdateFrequency::PerView)] == viewBytes
+			&& stats.BytesUploaded[static_cast<int>(UpdateFrequency::PerObject)] == objectBytes
+			&& stats.TotalBytesUploaded() == frameBytes + viewBytes + objectBytes
+			&& stats.BytesSkipped == skippedBytes
+			&& stats.Uploads == uploads
+			&& stats.SkippedUploads == skippedUploads;
+		if (!same)
+		{
+			printf("%s: %s, %u uploads, %u skipped\n", frame, ConstantUploadSummary(stats).c_str(), stats.Uploads, stats.SkippedUploads);
+		}
+		std::string what = std::string(frame) + ": the byte counters are wrong";
+		return Check(same, what.c_str());
+	}
+
+	Float4x4 Translation(float x)
+	{
+		return MatrixTranslation(x, 0.0f, 0.0f);
+	}
+
+	uint32_t CheckFrames()
+	{
+		uint32_t failures = 0;
+		ConstantUpdater updater;
+		RecordingConstantUploader uploader;
+		Blocks blocks = AddBlocks(updater);
+
+		float time = 0.0f;
+		Float4x4 viewProj = MatrixPerspectiveFovLH(0.8f, 1.5f, 1.0f, 1000.0f);
+		Float4x4 first = Translation(1.0f);
+		Float4x4 second = Translation(2.0f);
+
+		// Frame 0: blocks start dirty, even when set to zeros
+		updater.BeginFrame();
+		blocks.Time->Set(time);
+		blocks.ViewProj->Set(viewProj);
+		blocks.First->Set(first);
+		blocks.Second->Set(second);
+		updater.Commit(uploader);
+		failures += CheckUploads(uploader, { blocks.Time, blocks.ViewProj, blocks.First, blocks.Second }, "frame 0");
+		failures += CheckStats(updater.CurrentFrame(), 4, 64, 128, 0, 4, 0, "frame 0");
+		failures += Check(ConstantUploadSummary(updater.CurrentFrame()) == "Constants: 196 B/frame (4 frame, 64 view, 128 object), 0 B skipped", "frame 0: the summary is wrong");
+		failures += Check(!blocks.Time->IsDirty() && !blocks.ViewProj->IsDirty() && !blocks.First->IsDirty() && !blocks.Second->IsDirty(), "frame 0: committed blocks are still dirty");
+
+		// Frame 1: the same values again, nothing is uploaded
+		uploader.Clear();
+		updater.BeginFrame();
+		blocks.Time->Set(time);
+		blocks.ViewProj->Set(viewProj);
+		blocks.First->Set(first);
+		blocks.Second->Set(second);
+		updater.Commit(uploader);
+		failures += CheckUploads(uploader, {}, "frame 1");
+		failures += CheckStats(updater.CurrentFrame(), 0, 0, 0, 196, 0, 4, "frame 1");
+		failures += CheckStats(updater.LastFrame(), 4, 64, 128, 0, 4, 0, "frame 1, last frame");
+
+		// Frame 2: time advances and one object moves, committed per object
+		// before its draw as the scenes do
+		uploader.Clear();
+		updater.BeginFrame();
+		time += 1.0f / 60.0f;
+		first = Translation(1.5f);
+		blocks.Time->Set(time);
+		updater.Commit(blocks.Time, uploader);
+		blocks.ViewProj->Set(viewProj);
+		updater.Commit(blocks.ViewProj, uploader);
+		blocks.First->Set(first);
+		updater.Commit(blocks.First, uploader);
+		blocks.Second->Set(second);
+		updater.Commit(blocks.Second, uploader);
+		failures += CheckUploads(uploader, { blocks.Time, blocks.First }, "frame 2");
+		failures += CheckStats(updater.CurrentFrame(), 4, 0, 64, 128, 2, 2, "frame 2");
+
+		// Frame 3: the camera moves, the time is the same but marked dirty
+		// as after a device reset, the objects stay
+		uploader.Clear();
+		updater.BeginFrame();
+		viewProj = MatrixMultiply(Translation(0.25f), viewProj);
+		blocks.ViewProj->Set(viewProj);
+		blocks.Time->MarkDirty();
+		blocks.First->Set(first);
+		blocks.Second->Set(second);
+		updater.Commit(uploader);
+		failures += CheckUploads(uploader, { blocks.Time, blocks.ViewProj }, "frame 3");
+		failures += CheckStats(updater.CurrentFrame(), 4, 64, 0, 128, 2, 2, "frame 3");
+		failures += Check(memcmp(blocks.ViewProj->Data(), &viewProj, sizeof(viewProj)) == 0, "frame 3: the shadow copy does not hold the last value");
+
+		// Frame 4: one block drawn twice, as Box draws the cube and the
+		// pyramid through one per-object block. Only a change uploads.
+		uploader.Clear();
+		updater.BeginFrame();
+		blocks.First->Set(second);
+		updater.Commit(blocks.First, uploader);
+		blocks.First->Set(second);
+		updater.Commit(blocks.First, uploader);
+		blocks.First->Set(first);
+		updater.Commit(blocks.First, uploader);
+		failures += CheckUploads(uploader, { blocks.First, blocks.First }, "frame 4");
+		failures += CheckStats(updater.CurrentFrame(), 0, 0, 128, 64, 2, 1, "frame 4");
+
+		// Frame 5: nothing is set or committed
+		uploader.Clear();
+		updater.BeginFrame();
+		failures += CheckUploads(uploader, {}, "frame 5");
+		failures += CheckStats(updater.CurrentFrame(), 0, 0, 0, 0, 0, 0, "frame 5");
+		failures += CheckStats(updater.LastFrame(), 0, 0, 128, 64, 2, 1, "frame 5, last frame");
+
+		printf("Constant updates: 6 frames of per-frame, per-view and per-object blocks upload as expected\n");
+		return failures;
+	}
+}
+
+uint32_t RunConstantUpdateCheck()
+{
+	uint32_t failures = CheckFrames();
+
+	if (failures > 0)
+	{
+		printf("%u constant update checks failed\n", failures);
+	}
+	return failures;
+}
@@ -0,0 +1,13 @@
+#ifndef CONSTANTUPDATECHECK_H
+#define CONSTANTUPDATECHECK_H
+
+#include <cstdint>
+
+// Drives a ConstantUpdater with per-frame, per-view and per-object blocks
+// through a RecordingConstantUploader for several frames and checks the
+// exact uploads of each: unchanged blocks are skipped, each frequency is
+// committed only when it changed, and the bytes uploaded and skipped per
+// frame are counted right. Returns the number of failed checks.
+uint32_t RunConstantUpdateCheck();
+
+#endif // CONSTANTUPDATECHECK_H
@@ -0,0 +1,330 @@
+#include "CookCheck.h"
+#include "AllocationCounter.h"
+#include "CookedMesh.h"
+#include "JobSystem.h"
+#include "MeshGenerator.h"
+#include "SkullModel.h"
+#include "../AssetCooker/Cooker.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace
+{
+	uint32_t Check(bool passed, const char* what)
+	{
+		if (!passed)
+		{
+			printf("Failed: %s\n", what);
+			return 1;
+		}
+		return 0;
+	}
+
+	void WriteText(const std::filesystem::path& path, const char* text)
+	{
+		std::ofstream file(path.string().c_str());
+		file << text;
+	}
+
+	std::string ReadBytes(const std::filesystem::path& path)
+	{
+		std::ifstream file(path.string().c_str(), std::ios::binary);
+		return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	// A compressed file whose header claims more vertices or indices than its
+	// data can hold is rejected without allocating for them
+	uint32_t CheckDamagedCounts(const std::filesystem::path& cooked, const std::filesystem::path& damaged)
+	{
+		const size_t countOffsets[] = { offsetof(CookedMeshHeader, VertexCount), offsetof(CookedMeshHeader, IndexCount) };
+		const uint32_t hugeCount = 0x7FFFFFFF;
+		uint32_t failures = 0;
+		for (size_t offset : countOffsets)
+		{
+			std::string bytes = ReadBytes(cooked);
+			memcpy(&bytes[offset], &hugeCount, sizeof(hugeCount));
+			std::ofstream(damaged.string().c_str(), std::ios::binary).write(bytes.data(), bytes.size());
+
+			CookedMesh mesh;
+			AllocationScope read;
+			bool loaded = ReadCookedMesh(damaged.string(), mesh);
+			failures += Check(!loaded && read.Bytes() < bytes.size() * 2, "a compressed mesh with a damaged count was allocated for");
+		}
+		return failures;
+	}
+
+	struct CookedCorner
+	{
+		CookedVertex Vertex;
+
+		bool operator<(const CookedCorner& other) const { return memcmp(&Vertex, &other.Vertex, sizeof(Vertex)) < 0; }
+		bool operator==(const CookedCorner& other) const { return memcmp(&Vertex, &other.Vertex, sizeof(Vertex)) == 0; }
+	};
+
+	struct CookedTriangle
+	{
+		CookedCorner Corners[3];
+		uint32_t Vertices[3];	// Where the corners are in the mesh, not compared
+
+		bool operator<(const CookedTriangle& other) const
+		{
+			return std::lexicographical_compare(Corners, Corners + 3, other.Corners, other.Corners + 3);
+		}
+		bool operator==(const CookedTriangle& other) const { return std::equal(Corners, Corners + 3, other.Corners); }
+	};
+
+	// Each triangle starting at its smallest corner, so the winding is kept, in sorted order
+	std::vector<CookedTriangle> SortedTriangles(const CookedMesh& mesh)
+	{
+		std::vector<CookedTriangle> triangles(mesh.Indices.size() / 3);
+		for (size_t i = 0; i < triangles.size(); i++)
+		{
+			CookedCorner corners[3];
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				corners[corner].Vertex = mesh.Vertices[mesh.Indices[i * 3 + corner]];
+			}
+			uint32_t first = static_cast<uint32_t>(std::min_element(corners, corners + 3) - corners);
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				triangles[i].Corners[corner] = corners[(first + corner) % 3];
+				triangles[i].Vertices[corner] = mesh.Indices[i * 3 + (first + corner) % 3];
+			}
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+
+	// The source quantized the same way but in its own order. The cooked mesh
+	// must hold the same triangles. Sorted the same way, equal triangles pair
+	// each cooked vertex with the source vertices it was cooked from, and the
+	// cooked vertices decoded with the header read back must be within half a
+	// step of those.
+	uint32_t CheckRoundTrip(const char* name, const std::vector<Float3>& positions, const std::vector<Float3>& normals,
+		const std::vector<Float2>& texCoords, const std::vector<uint32_t>& indices, const std::filesystem::path& cookedPath)
+	{
+		CookedMesh cooked;
+		if (!ReadCookedMesh(cookedPath.string(), cooked))
+		{
+			printf("Failed: could not read %s\n", cookedPath.string().c_str());
+			return 1;
+		}
+		CookedMesh source;
+		QuantizeMesh(positions, normals, texCoords, indices, cooked.Header.PositionBits, source);
+
+		std::vector<CookedTriangle> cookedTriangles = SortedTriangles(cooked);
+		std::vector<CookedTriangle> sourceTriangles = SortedTriangles(source);
+		if (cookedTriangles != sourceTriangles)
+		{
+			printf("Failed: the cooked triangles differ from the source's\n");
+			return 1;
+		}
+
+		// The cooker rounds to the nearest step in double and this decodes in
+		// double, so beyond half a step only double rounding is left
+		const CookedMeshHeader& header = cooked.Header;
+		const double positionTolerance = 0.5 + 1e-6;
+
+		double positionError = 0.0;
+		float normalError = 0.0f;
+		float texCoordError = 0.0f;
+		std::vector<bool> matched(cooked.Vertices.size(), false);
+		for (size_t i = 0; i < cookedTriangles.size(); i++)
+		{
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				uint32_t cookedIndex = cookedTriangles[i].Vertices[corner];
+				uint32_t sourceIndex = sourceTriangles[i].Vertices[corner];
+				const CookedVertex& vertex = cooked.Vertices[cookedIndex];
+				matched[cookedIndex] = true;
+
+				const float* offset = &header.PositionOffset.x;
+				const float* scale = &header.PositionScale.x;
+				const float* position = &positions[sourceIndex].x;
+				for (uint32_t axis = 0; axis < 3; axis++)
+				{
+					if (scale[axis] > 0.0f)
+					{
+						double decoded = static_cast<double>(offset[axis]) + vertex.Position[axis] * static_cast<double>(scale[axis]);
+						positionError = std::max(positionError, std::fabs(decoded - position[axis]) / scale[axis]);
+					}
+				}
+				normalError = std::max(normalError, 1.0f - Dot(DecodeNormal(vertex), Normalize3(normals[sourceIndex])));
+				if (!texCoords.empty())
+				{
+					Float2 t = DecodeTexCoord(header, vertex);
+					texCoordError = std::max(texCoordError, std::max(std::fabs(t.x - texCoords[sourceIndex].x), std::fabs(t.y - texCoords[sourceIndex].y)));
+				}
+			}
+		}
+		printf("%s: %u vertices, largest errors %.4f position steps, %.2e normal cosine, %.2e texture coordinate\n"
+			, name, header.VertexCount, positionError, normalError, texCoordError);
+
+		uint32_t failures = Check(std::count(matched.begin(), matched.end(), false) == 0, "a cooked vertex is in no triangle of the source");
+		failures += Check(positionError <= positionTolerance, "a cooked position is off by more than half a step");
+		failures += Check(normalError < 1.5e-6f, "a normal is off by more than 0.1 degrees");
+		failures += Check(texCoordError < 1e-4f, "a texture coordinate is off by more than 1e-4");
+		return failures;
+	}
+
+	double MillisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	uint32_t CheckShape(const char* name, const MeshGenerator::MeshData& mesh, const std::filesystem::path& cookedPath)
+	{
+		std::vector<Float3> positions(mesh.Vertices.size());
+		std::vector<Float3> normals(mesh.Vertices.size());
+		std::vector<Float2> texCoords(mesh.Vertices.size());
+		for (size_t i = 0; i < mesh.Vertices.size(); i++)
+		{
+			positions[i] = mesh.Vertices[i].Position;
+			normals[i] = mesh.Vertices[i].Normal;
+			texCoords[i] = mesh.Vertices[i].TexC;
+		}
+		return CheckRoundTrip(name, positions, normals, texCoords, mesh.Indices, cookedPath);
+	}
+
+	uint32_t Count(const AssetCooker& cooker, CookResult result)
+	{
+		return static_cast<uint32_t>(std::count(cooker.Results().begin(), cooker.Results().end(), result));
+	}
+
+	void PrintRun(const char* what, const CookStats& stats)
+	{
+		printf("%-22s %s\n", what, CookSummary(stats).c_str());
+	}
+}
+
+uint32_t RunCookCheck(const std::string& skullModel, uint32_t threads)
+{
+	std::filesystem::path root = std::filesystem::temp_directory_path() / "HeadlessCook";
+	std::filesystem::path assets = root / "Assets";
+	std::filesystem::path output = root / "Cooked";
+	std::error_code error;
+	std::filesystem::remove_all(root, error);
+	std::filesystem::create_directories(assets / "Shapes", error);
+
+	WriteText(assets / "Shapes" / "sphere.shape", "# The shapes scene's sphere\nsphere 0.5 20 20\n");
+	WriteText(assets / "Shapes" / "cylinder.shape", "cylinder 0.5 0.3 3 20 20\n");
+	WriteText(assets / "grid.shape", "grid 160 160 50 50\n");
+	WriteText(assets / "box.shape", "box 1 1 1\n");
+	WriteText(assets / "notes.txt", "Not a model\n");
+	uint32_t assetCount = 4;
+	bool hasSkull = std::filesystem::copy_file(skullModel, assets / "skull.txt", error);
+	if (hasSkull)
+	{
+		assetCount++;
+	}
+	else
+	{
+		printf("Could not copy %s, cooking only the shapes\n", skullModel.c_str());
+	}
+
+	uint32_t failures = 0;
+	JobSystem jobs(std::max(1u, threads));
+	CookSettings settings = { 16, true, true };
+	AssetCooker cooker(assets.string(), output.string(), settings);
+
+	CookStats stats = cooker.Run(&jobs);
+	PrintRun("First run:", stats);
+	failures += Check(stats.Cooked == assetCount && stats.Failed == 0, "the first run did not cook every asset");
+
+	stats = cooker.Run(&jobs);
+	PrintRun("Unchanged:", stats);
+	failures += Check(stats.UpToDate == assetCount && stats.Cooked == 0, "an unchanged asset was cooked again");
+
+	std::vector<CookedAsset> manifest;
+	failures += Check(ReadManifest(cooker.ManifestPath(), manifest) && manifest.size() == assetCount, "the manifest does not list every asset");
+
+	// Same size, other content
+	WriteText(assets / "box.shape", "box 2 1 1\n");
+	stats = cooker.Run(&jobs);
+	PrintRun("One source changed:", stats);
+	failures += Check(stats.Cooked == 1 && stats.UpToDate == assetCount - 1, "changing one source did not cook just that one");
+
+	// A damaged output is cooked again even though the manifest is current
+	std::filesystem::resize_file(output / "box.cmesh", 200, error);
+	stats = cooker.Run(&jobs);
+	failures += Check(stats.Cooked == 1 && Count(cooker, CookResult::Cooked) == 1, "a truncated output was not cooked again");
+
+	std::filesystem::remove(assets / "box.shape", error);
+	stats = cooker.Run(&jobs);
+	PrintRun("One source removed:", stats);
+	failures += Check(stats.Removed == 1 && !std::filesystem::exists(output / "box.cmesh"), "the output of a removed source was kept");
+	assetCount--;
+
+	// The same files however many threads cook them
+	std::string parallelSkull = hasSkull ? ReadBytes(output / "skull.cmesh") : std::string();
+	std::string parallelSphere = ReadBytes(output / "Shapes" / "sphere.cmesh");
+	stats = cooker.Run(nullptr, true);
+	PrintRun("Forced, one thread:", stats);
+	failures += Check(stats.Cooked == assetCount, "-force did not cook every asset");
+	failures += Check(ReadBytes(output / "Shapes" / "sphere.cmesh") == parallelSphere
+		&& (!hasSkull || ReadBytes(output / "skull.cmesh") == parallelSkull), "the output depends on the thread count");
+
+	for (size_t i = 0; i < cooker.Manifest().size(); i++)
+	{
+		const CookedAsset& asset = cooker.Manifest()[i];
+		printf("%-22s %6u vertices, %6.1f KB, ACMR %.2f -> %.2f, %.2f ms\n", asset.Source.c_str(), asset.Vertices
+			, asset.CookedBytes / 1024.0, asset.MissRatioBefore, asset.MissRatioAfter, asset.CookMs);
+		failures += Check(asset.MissRatioAfter <= asset.MissRatioBefore, "the vertex cache order misses more");
+	}
+
+	MeshGenerator::MeshData sphere;
+	MeshGenerator::CreateSphere(0.5f, 20, 20, sphere);
+	failures += CheckShape("Sphere", sphere, output / "Shapes" / "sphere.cmesh");
+	MeshGenerator::MeshData grid;
+	MeshGenerator::CreateGrid(160.0f, 160.0f, 50, 50, grid);
+	failures += CheckShape("Grid", grid, output / "grid.cmesh");
+	failures += CheckDamagedCounts(output / "grid.cmesh", root / "damaged.cmesh");
+
+	SkullModel skull;
+	if (hasSkull && LoadSkullModel(skullModel, skull))
+	{
+		failures += CheckRoundTrip("Skull", skull.Positions, skull.Normals, std::vector<Float2>(), skull.Indices, output / "skull.cmesh");
+
+		auto start = std::chrono::steady_clock::now();
+		LoadSkullModel(skullModel, skull);
+		double textMs = MillisecondsSince(start);
+		start = std::chrono::steady_clock::now();
+		CookedMesh cooked;
+		ReadCookedMesh((output / "skull.cmesh").string(), cooked);
+		std::vector<Float3> positions(cooked.Vertices.size());
+		std::vector<Float3> normals(cooked.Vertices.size());
+		for (size_t i = 0; i < cooked.Vertices.size(); i++)
+		{
+			positions[i] = DecodePosition(cooked.Header, cooked.Vertices[i]);
+			normals[i] = DecodeNormal(cooked.Vertices[i]);
+		}
+		double cookedMs = MillisecondsSince(start);
+		printf("Loading the skull: text %.2f ms, %.0f KB, cooked and decoded %.2f ms, %.0f KB\n"
+			, textMs, std::filesystem::file_size(skullModel, error) / 1024.0
+			, cookedMs, std::filesystem::file_size(output / "skull.cmesh", error) / 1024.0);
+	}
+
+	// A new setting cooks everything again, and these files are uncompressed
+	CookSettings coarser = { 12, true, false };
+	AssetCooker coarse(assets.string(), output.string(), coarser);
+	stats = coarse.Run(&jobs);
+	PrintRun("Settings changed:", stats);
+	failures += Check(stats.Cooked == assetCount && stats.UpToDate == 0, "changing the settings did not cook every asset");
+	failures += CheckShape("Sphere, 12 bits", sphere, output / "Shapes" / "sphere.cmesh");
+
+	std::filesystem::remove_all(root, error);
+	if (failures > 0)
+	{
+		printf("%u cook checks failed\n", failures);
+	}
+	return failures;
+}
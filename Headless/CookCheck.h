@@ -0,0 +1,17 @@
+#ifndef COOKCHECK_H
+#define COOKCHECK_H
+
+#include <cstdint>
+#include <string>
+
+// Cooks generated shapes and the skull model in a temporary directory and
+// checks that unchanged assets are skipped, that a changed source or
+// setting cooks again and that removed sources lose their output. Checks
+// that the cooked meshes are the sources' triangles in another order with
+// the vertices within the quantization error, that the vertex cache order
+// misses less, and that cooking on 'threads' threads writes the same
+// files. Prints the load time of the skull as text and cooked. Returns the
+// number of failed checks.
+uint32_t RunCookCheck(const std::string& skullModel, uint32_t threads);
+
+#endif // COOKCHECK_H
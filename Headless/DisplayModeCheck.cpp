@@ -0,0 +1,151 @@
+#include "DisplayModeCheck.h"
+#include "DisplayModeTable.h"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+namespace
+{
+	// Two outputs of a desktop GPU and the WARP adapter, which has none, in
+	// the order DXGI listed them. The second output repeats its modes with
+	// centered and stretched scaling.
+	const char* const recordedModes =
+		"DisplayModeTable 1\n"
+		"format 28\n"
+		"adapter 4318 7170 0 161 8589934592 7036874418149376 NVIDIA GeForce GTX 1080\n"
+		"output \\\\.\\DISPLAY1\n"
+		"mode 640 480 60 1 0 0\n"
+		"mode 800 600 60 1 0 0\n"
+		"mode 1280 720 60 1 0 0\n"
+		"mode 1280 1024 60 1 0 0\n"
+		"mode 1920 1080 60000 1001 0 0\n"
+		"mode 1920 1080 60 1 0 0\n"
+		"mode 1920 1080 144000 1000 0 0\n"
+		"mode 1920 1080 120 1 0 0\n"
+		"mode 2560 1440 60 1 0 0\n"
+		"mode 2560 1440 165 1 0 0\n"
+		"output \\\\.\\DISPLAY2\n"
+		"mode 1024 768 75 1 0 1\n"
+		"mode 1024 768 75 1 0 2\n"
+		"mode 1680 1050 59954 1000 0 1\n"
+		"mode 1680 1050 59954 1000 0 2\n"
+		"# no outputs, it only renders\n"
+		"adapter 5140 140 0 0 0 0 Microsoft Basic Render Driver\n";
+
+	std::string Describe(const DisplayMode* mode)
+	{
+		return mode != nullptr ? FormatDisplayMode(*mode) : std::string("none");
+	}
+
+	uint32_t ExpectMode(const DisplayModeTable& table, uint32_t output, uint32_t width, uint32_t height, double hz, const char* expected)
+	{
+		std::string found = Describe(table.FindBestMode(output, width, height, hz));
+		if (found != expected)
+		{
+			printf("Best mode of output %u for %ux%u @ %.2f Hz: %s, expected %s\n", output, width, height, hz, found.c_str(), expected);
+			return 1;
+		}
+		return 0;
+	}
+}
+
+uint32_t RunDisplayModeCheck()
+{
+	std::error_code error;
+	std::filesystem::path root = std::filesystem::temp_directory_path(error) / "DisplayModeCheck";
+	std::filesystem::create_directories(root, error);
+	std::string recorded = (root / "recorded.txt").string();
+	std::string saved = (root / "saved.txt").string();
+
+	FILE* file = fopen(recorded.c_str(), "w");
+	if (file == nullptr)
+	{
+		printf("Could not write %s\n", recorded.c_str());
+		return 1;
+	}
+	fputs(recordedModes, file);
+	fclose(file);
+
+	uint32_t failures = 0;
+	DisplayModeTable table;
+	if (!table.Load(recorded))
+	{
+		printf("Could not load the recorded modes\n");
+		return 1;
+	}
+	failures += table.Format() == 28 && table.Adapters().size() == 2 && table.Outputs().size() == 2 ? 0 : 1;
+	failures += table.Adapters()[1].OutputCount == 0 && table.Outputs()[1].Name == "\\\\.\\DISPLAY2" ? 0 : 1;
+
+	failures += ExpectMode(table, 0, 1920, 1080, 60.0, "1920x1080 @ 60.00 Hz");
+	failures += ExpectMode(table, 0, 1920, 1080, 59.94, "1920x1080 @ 59.94 Hz");
+	failures += ExpectMode(table, 0, 1920, 1080, 240.0, "1920x1080 @ 144.00 Hz");
+	failures += ExpectMode(table, 0, 1920, 1080, 130.0, "1920x1080 @ 120.00 Hz");
+	failures += ExpectMode(table, 0, 1920, 1080, 0.0, "1920x1080 @ 59.94 Hz");
+	// Not listed: the next wider mode that is tall enough
+	failures += ExpectMode(table, 0, 1280, 800, 60.0, "1280x1024 @ 60.00 Hz");
+	failures += ExpectMode(table, 0, 1000, 700, 60.0, "1280x720 @ 60.00 Hz");
+	failures += ExpectMode(table, 0, 3840, 2160, 60.0, "2560x1440 @ 60.00 Hz");
+	failures += ExpectMode(table, 0, 3840, 2160, 200.0, "2560x1440 @ 165.00 Hz");
+	failures += ExpectMode(table, 0, 320, 200, 60.0, "640x480 @ 60.00 Hz");
+	failures += ExpectMode(table, 1, 800, 600, 60.0, "1024x768 @ 75.00 Hz");
+	failures += ExpectMode(table, 1, 1680, 1050, 60.0, "1680x1050 @ 59.95 Hz");
+	// Equal modes keep the listed order, centered before stretched
+	const DisplayMode* centered = table.FindBestMode(1, 1024, 768, 75.0);
+	failures += centered != nullptr && centered->Scaling == 1 ? 0 : 1;
+
+	// The saved cache loads to the same table
+	DisplayModeTable reloaded;
+	failures += table.Save(saved) && reloaded.Load(saved) ? 0 : 1;
+	failures += reloaded.Fingerprint() == table.Fingerprint() ? 0 : 1;
+	failures += ExpectMode(reloaded, 0, 1920, 1080, 59.94, "1920x1080 @ 59.94 Hz");
+
+	// Another monitor or driver does not match the cache
+	DisplayModeTable hardware(28);
+	for (size_t i = 0; i < table.Adapters().size(); i++)
+	{
+		hardware.AddAdapter(table.Adapters()[i]);
+		for (uint32_t j = 0; j < table.Adapters()[i].OutputCount; j++)
+		{
+			hardware.AddOutput(table.Outputs()[table.Adapters()[i].FirstOutput + j].Name);
+		}
+	}
+	failures += hardware.Fingerprint() == table.Fingerprint() ? 0 : 1;
+	DisplayAdapterInfo newDriver = table.Adapters()[0];
+	newDriver.DriverVersion++;
+	DisplayModeTable updated(28);
+	updated.AddAdapter(newDriver);
+	updated.AddOutput(table.Outputs()[0].Name);
+	updated.AddOutput(table.Outputs()[1].Name);
+	updated.AddAdapter(table.Adapters()[1]);
+	failures += updated.Fingerprint() != table.Fingerprint() ? 0 : 1;
+	hardware.AddOutput("\\\\.\\DISPLAY3");
+	failures += hardware.Fingerprint() != table.Fingerprint() ? 0 : 1;
+
+	file = fopen(saved.c_str(), "a");
+	if (file != nullptr)
+	{
+		fputs("mode 1920 1080 sixty\n", file);
+		fclose(file);
+	}
+	failures += reloaded.Load(saved) || !reloaded.Outputs().empty() ? 1 : 0;
+
+	const uint32_t queries = 1000000;
+	uint32_t checksum = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < queries; i++)
+	{
+		const DisplayMode* mode = table.FindBestMode(0, 640 + (i & 2047), 480 + (i & 1023), 50.0 + (i & 127));
+		checksum += mode->Width;
+	}
+	double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / queries;
+	printf("%zu adapters, %zu outputs, FindBestMode %.1f ns/query (checksum %u)\n", table.Adapters().size(), table.Outputs().size(), ns, checksum);
+
+	std::filesystem::remove_all(root, error);
+	if (failures > 0)
+	{
+		printf("%u display mode checks failed\n", failures);
+	}
+	return failures;
+}
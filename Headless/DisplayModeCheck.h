@@ -0,0 +1,11 @@
+#ifndef DISPLAYMODECHECK_H
+#define DISPLAYMODECHECK_H
+
+#include <cstdint>
+
+// Loads a recorded DXGI mode list into a DisplayModeTable, checks best mode
+// queries, the saved cache and its fingerprint, and times the queries.
+// Returns the number of failed checks.
+uint32_t RunDisplayModeCheck();
+
+#endif // DISPLAYMODECHECK_H
@@ -0,0 +1,182 @@
+#include "EffectCacheCheck.h"
+#include "EffectCache.h"
+#include "AllocationCounter.h"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <thread>
+
+namespace
+{
+	// Roughly what fxc takes for the book's small effects
+	const std::chrono::milliseconds compileTime(25);
+
+	// Bytecode is the flags, defines and source, an effect containing
+	// "error" does not compile
+	class StubCompiler : public IEffectCompiler
+	{
+	public:
+		StubCompiler() : Compiles(0) {}
+
+		std::string Name() const { return "stub 1"; }
+
+		bool Compile(const std::string& fileName, const std::string& source, const std::vector<EffectDefine>& defines,
+			uint32_t flags, std::vector<uint8_t>& bytecode, std::string& errors)
+		{
+			Compiles++;
+			std::this_thread::sleep_for(compileTime);
+			if (source.find("error") != std::string::npos)
+			{
+				errors = fileName + "(1,1): error X3000: syntax error";
+				return false;
+			}
+
+			std::string text = std::to_string(flags);
+			for (size_t i = 0; i < defines.size(); i++)
+			{
+				text += " " + defines[i].Name + "=" + defines[i].Value;
+			}
+			text += "\n" + source;
+			bytecode.assign(text.begin(), text.end());
+			return true;
+		}
+
+		uint32_t Compiles;
+	};
+
+	void WriteText(const std::filesystem::path& path, const char* text)
+	{
+		FILE* file = fopen(path.string().c_str(), "wb");
+		if (file != nullptr)
+		{
+			fputs(text, file);
+			fclose(file);
+		}
+	}
+
+	// Overwrites 'size' bytes at 'offset' of an existing file, or appends them at -1
+	void PatchFile(const std::string& fileName, long offset, const void* data, size_t size)
+	{
+		FILE* file = fopen(fileName.c_str(), "r+b");
+		if (file != nullptr)
+		{
+			fseek(file, offset < 0 ? 0 : offset, offset < 0 ? SEEK_END : SEEK_SET);
+			fwrite(data, size, 1, file);
+			fclose(file);
+		}
+	}
+
+	// Loads 'fileName' and checks whether it came from the cache
+	uint32_t Expect(EffectCache& cache, StubCompiler& compiler, const std::string& fileName, const std::vector<EffectDefine>& defines,
+		uint32_t flags, bool hit, const char* what)
+	{
+		uint32_t compilesBefore = compiler.Compiles;
+		std::vector<uint8_t> bytecode;
+		std::string errors;
+		bool loaded = cache.Load(fileName, defines, flags, bytecode, errors);
+		bool compiled = compiler.Compiles != compilesBefore;
+		if (!loaded || compiled == hit || bytecode.empty())
+		{
+			printf("%s: expected a %s\n", what, hit ? "hit" : "miss");
+			return 1;
+		}
+		return 0;
+	}
+}
+
+uint32_t RunEffectCacheCheck()
+{
+	std::error_code error;
+	std::filesystem::path root = std::filesystem::temp_directory_path(error) / "EffectCacheCheck";
+	std::filesystem::remove_all(root, error);
+	std::filesystem::create_directories(root / "FX", error);
+	std::string cacheDirectory = (root / "FXCache").string();
+
+	WriteText(root / "FX" / "common.fxh", "float4x4 gWorldViewProj;\n");
+	WriteText(root / "FX" / "color.fx", "#include \"common.fxh\"\ntechnique11 ColorTech {}\n");
+	WriteText(root / "FX" / "normal.fx", "  #  include <common.fxh>\ntechnique11 NormalTech {}\n");
+	WriteText(root / "FX" / "broken.fx", "technique11 { error }\n");
+
+	std::string color = (root / "FX" / "color.fx").string();
+	std::string normal = (root / "FX" / "normal.fx").string();
+	std::vector<EffectDefine> none;
+	const uint32_t flags = 1;
+	uint32_t failures = 0;
+
+	StubCompiler compiler;
+	std::vector<uint8_t> coldColor;
+	{
+		EffectCache cache(compiler, cacheDirectory);
+		std::string errors;
+		cache.Load(color, none, flags, coldColor, errors);
+		failures += Expect(cache, compiler, normal, none, flags, false, "Cold normal.fx");
+		failures += cache.Stats().Misses == 2 && compiler.Compiles == 2 ? 0 : 1;
+		printf("Cold launch  %s\n", EffectCacheSummary(cache.Stats()).c_str());
+	}
+
+	{
+		// A new cache is a new launch
+		EffectCache cache(compiler, cacheDirectory);
+		std::vector<uint8_t> warmColor;
+		std::string errors;
+		cache.Load(color, none, flags, warmColor, errors);
+		failures += Expect(cache, compiler, normal, none, flags, true, "Warm normal.fx");
+		failures += cache.Stats().Hits == 2 && warmColor == coldColor ? 0 : 1;
+		printf("Warm launch  %s\n", EffectCacheSummary(cache.Stats()).c_str());
+	}
+
+	EffectCache cache(compiler, cacheDirectory);
+	failures += Expect(cache, compiler, color, none, flags | 2, false, "Other flags");
+	std::vector<EffectDefine> defines(1);
+	defines[0].Name = "FOG";
+	defines[0].Value = "1";
+	failures += Expect(cache, compiler, color, defines, flags, false, "New define");
+	failures += Expect(cache, compiler, color, defines, flags, true, "Same define");
+	defines[0].Value = "0";
+	failures += Expect(cache, compiler, color, defines, flags, false, "Other define value");
+
+	// Both include it
+	WriteText(root / "FX" / "common.fxh", "float4x4 gWorld;\nfloat4x4 gWorldViewProj;\n");
+	failures += Expect(cache, compiler, color, none, flags, false, "Changed include");
+	failures += Expect(cache, compiler, normal, none, flags, false, "Changed include");
+	failures += Expect(cache, compiler, normal, none, flags, true, "Stored again");
+
+	// Cut short, as by a crash while writing without the rename
+	std::filesystem::resize_file(cache.BlobPath(cache.Key(normal, none, flags)), 20, error);
+	failures += Expect(cache, compiler, normal, none, flags, false, "Truncated blob");
+	failures += Expect(cache, compiler, normal, none, flags, true, "Replaced blob");
+
+	// A damaged size must be rejected before it is allocated
+	const uint32_t hugeSize = 0x7FFFFFFF;
+	PatchFile(cache.BlobPath(cache.Key(normal, none, flags)), sizeof(uint32_t), &hugeSize, sizeof(hugeSize));
+	AllocationScope damagedLoad;
+	failures += Expect(cache, compiler, normal, none, flags, false, "Damaged blob size");
+	failures += damagedLoad.Bytes() < (1u << 20) ? 0 : 1;
+	failures += Expect(cache, compiler, normal, none, flags, true, "Replaced blob");
+
+	PatchFile(cache.BlobPath(cache.Key(normal, none, flags)), -1, "tail", 4);
+	failures += Expect(cache, compiler, normal, none, flags, false, "Blob with bytes after it");
+	failures += Expect(cache, compiler, normal, none, flags, true, "Replaced blob");
+
+	std::string broken = (root / "FX" / "broken.fx").string();
+	std::vector<uint8_t> bytecode;
+	std::string errors;
+	uint32_t failed = cache.Stats().Failures;
+	bool loaded = cache.Load(broken, none, flags, bytecode, errors);
+	failures += !loaded && !errors.empty() && cache.Stats().Failures == failed + 1 ? 0 : 1;
+	failures += std::filesystem::exists(cache.BlobPath(cache.Key(broken, none, flags))) ? 1 : 0;
+	failures += cache.Load((root / "FX" / "missing.fx").string(), none, flags, bytecode, errors) ? 1 : 0;
+
+	StubCompiler uncachedCompiler;
+	EffectCache uncached(uncachedCompiler, "");
+	failures += Expect(uncached, uncachedCompiler, color, none, flags, false, "Without a directory");
+	failures += Expect(uncached, uncachedCompiler, color, none, flags, false, "Without a directory");
+
+	std::filesystem::remove_all(root, error);
+	if (failures > 0)
+	{
+		printf("%u effect cache checks failed\n", failures);
+	}
+	return failures;
+}
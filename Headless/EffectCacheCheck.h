@@ -0,0 +1,13 @@
+#ifndef EFFECTCACHECHECK_H
+#define EFFECTCACHECHECK_H
+
+#include <cstdint>
+
+// Runs EffectCache over effects in a temporary directory with a stub
+// compiler that takes a fixed time: a cold and a warm launch, then changed
+// flags, defines and includes, a damaged blob and an effect that does not
+// compile. Prints the hit rate and time saved of the launches and returns
+// the number of failed checks.
+uint32_t RunEffectCacheCheck();
+
+#endif // EFFECTCACHECHECK_H
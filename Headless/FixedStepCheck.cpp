@@ -0,0 +1,179 @@
+#include "FixedStepCheck.h"
+#include "FixedStepClock.h"
+#include "InputQueue.h"
+#include "NullRenderDevice.h"
+#include "../Chap6_box/BoxScene.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace
+{
+	const float step = 1.0f / 60.0f;
+	const uint32_t checkedSteps = 600;
+
+	struct RenderRate
+	{
+		const char* Name;
+		double FrameSeconds;	// 0 for jittered frames
+	};
+
+	// Deterministic frame times between 2 and 50 ms
+	double JitteredFrame(uint32_t& seed)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		return 0.002 + 0.048 * (seed >> 8) / static_cast<double>(1 << 24);
+	}
+
+	bool SameState(const BoxScene::SimulationState& a, const BoxScene::SimulationState& b)
+	{
+		return memcmp(&a, &b, sizeof(a)) == 0;
+	}
+
+	// The box after 'steps' updates, one per step
+	BoxScene::SimulationState ReferenceState(uint64_t steps)
+	{
+		BoxScene scene(StreamLayout::Interleaved);
+		for (uint64_t i = 1; i <= steps; i++)
+		{
+			scene.UpdateScene(step, static_cast<float>(i * static_cast<double>(step)));
+		}
+		return scene.State();
+	}
+
+	// Writes down what RunFixedSteps calls, in order
+	class RecordingScene : public DemoScene
+	{
+	public:
+		bool Init(IRenderDevice&) { return true; }
+		void Shutdown() {}
+		void OnResize(int, int) {}
+		void DrawScene() {}
+		const std::string& Caption() const { return Calls; }
+
+		void UpdateScene(float dt, float totalTime)
+		{
+			// Exact step times print as the step number
+			double stepNumber = totalTime / static_cast<double>(step);
+			bool exact = dt == step && totalTime == static_cast<float>(std::round(stepNumber) * static_cast<double>(step));
+			Append("update %.0f%s", stepNumber, exact ? "" : " (inexact)");
+		}
+
+		void Interpolate(float alpha) { Append("alpha %.2f", alpha); }
+		void OnMouseDown(uint32_t, int x, int) { Append("down %d", x); }
+		void OnMouseMove(uint32_t, int x, int) { Append("move %d", x); }
+
+		std::string Calls;
+
+	private:
+		template<typename... Args>
+		void Append(const char* format, Args... args)
+		{
+			char call[64];
+			snprintf(call, sizeof(call), format, args...);
+			Calls += Calls.empty() ? call : std::string(", ") + call;
+		}
+	};
+
+	InputEvent MouseEvent(InputEventType type, int x)
+	{
+		InputEvent event = { type, MouseButtonLeft, x, 0, InputTimestamp() };
+		return event;
+	}
+
+	// Input is handed out before a step and waits for one, each step gets
+	// its exact time and every frame ends interpolated
+	uint32_t CheckStepOrder()
+	{
+		FixedStepClock clock(step, 1000);
+		RecordingScene scene;
+		InputQueue input;
+
+		input.Push(MouseEvent(InputEventType::MouseDown, 1));
+		RunFixedSteps(clock, scene, &input, 2.5 * step);
+		input.Push(MouseEvent(InputEventType::MouseMove, 2));
+		RunFixedSteps(clock, scene, &input, 0.25 * step);
+		RunFixedSteps(clock, scene, &input, 0.25 * step);
+
+		const char* expected = "down 1, update 1, update 2, alpha 0.50, alpha 0.75, move 2, update 3, alpha 0.00";
+		if (scene.Calls != expected)
+		{
+			printf("Step order: %s\n  expected: %s\n", scene.Calls.c_str(), expected);
+			return 1;
+		}
+		return 0;
+	}
+}
+
+uint32_t RunFixedStepCheck()
+{
+	uint32_t failures = CheckStepOrder();
+
+	const RenderRate rates[] =
+	{
+		{ "24 Hz", 1.0 / 24.0 },
+		{ "60 Hz", 1.0 / 60.0 },
+		{ "75 Hz", 1.0 / 75.0 },
+		{ "144 Hz", 1.0 / 144.0 },
+		{ "240 Hz", 1.0 / 240.0 },
+		{ "jittered", 0.0 }
+	};
+
+	for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++)
+	{
+		NullRenderDevice device;
+		BoxScene scene(StreamLayout::Interleaved);
+		if (!scene.Init(device))
+		{
+			printf("%-9s Init failed\n", rates[r].Name);
+			failures++;
+			continue;
+		}
+		scene.OnResize(800, 600);
+
+		// Never capped here, every frame must be simulated in full. The frames
+		// run through the same code as SceneApp's.
+		FixedStepClock clock(step, 1000);
+		uint32_t seed = 1;
+		uint32_t frames = 0;
+		uint32_t idleFrames = 0;
+		uint32_t mostSteps = 0;
+
+		while (clock.StepCount() < checkedSteps)
+		{
+			double frameSeconds = rates[r].FrameSeconds > 0.0 ? rates[r].FrameSeconds : JitteredFrame(seed);
+			uint32_t steps = RunFixedSteps(clock, scene, nullptr, frameSeconds);
+			scene.DrawScene();
+
+			frames++;
+			idleFrames += steps == 0 ? 1 : 0;
+			mostSteps = steps > mostSteps ? steps : mostSteps;
+		}
+		BoxScene::SimulationState state = scene.State();
+		scene.Shutdown();
+
+		bool same = SameState(state, ReferenceState(clock.StepCount()));
+		failures += same ? 0 : 1;
+		printf("%-9s %5u frames, %4u without a step, up to %u steps a frame  %s\n"
+			, rates[r].Name
+			, frames
+			, idleFrames
+			, mostSteps
+			, same ? "same state" : "DIFFERENT STATE");
+	}
+
+	// A 1 s hitch runs at most 15 steps and drops the rest but keeps the fraction
+	FixedStepClock capped(step, 15);
+	uint32_t cappedSteps = capped.Advance(1.0 + 0.5 * step);
+	bool capOk = cappedSteps == 15 && capped.Alpha() > 0.49f && capped.Alpha() < 0.51f;
+	failures += capOk ? 0 : 1;
+	printf("1 s frame: %u steps, %.3f s dropped, alpha %.2f  %s\n", cappedSteps, capped.DroppedSeconds(), capped.Alpha(), capOk ? "ok" : "WRONG");
+
+	if (failures > 0)
+	{
+		printf("%u fixed step checks failed\n", failures);
+	}
+	return failures;
+}
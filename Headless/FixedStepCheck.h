@@ -0,0 +1,14 @@
+#ifndef FIXEDSTEPCHECK_H
+#define FIXEDSTEPCHECK_H
+
+#include <cstdint>
+
+// Runs the box scene through RunFixedSteps, as SceneApp does, with a 60 Hz
+// FixedStepClock at several render rates, steady and jittered, and checks
+// that its simulation state is bit for bit the same as updating it once per
+// step. Checks the order of input, steps and interpolation on a recording
+// scene, and that a long frame is capped. Returns the number of failed
+// checks.
+uint32_t RunFixedStepCheck();
+
+#endif // FIXEDSTEPCHECK_H
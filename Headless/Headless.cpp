@@ -0,0 +1,883 @@
+// Runs the demo scenes on the null render device, without a window or GPU,
+// and reports the CPU cost of a frame and what it submitted. With
+// -device raster the frames are also drawn by the software rasterizer.
+//
+// -scene occlusion checks the occlusion culler against a scene with known
+// results and fails the run if they differ.
+//
+// Headless [-scene box|shapes|hills|waves|skull|init|occlusion|all] [-frames N] [-width W] [-height H] [-skull path]
+//          [-device null|raster] [-threads N] [-image prefix] [-profile prefix]
+//          [-startup prefix] [-warmup N] [-input orbit|script] [-json file] [-baseline file] [-threshold percent] [-noalloc]
+//          [-budget KB] [-reload N] [-floatcolors]
+// Headless -jobs [-threads N]
+// Headless -fixedstep
+// Headless -arena
+// Headless -inputqueue
+// Headless -effectcache
+// Headless -displaymodes
+// Headless -resources
+// Headless -resourcetable
+// Headless -uploadring
+// Headless -bvh [-skull path]
+// Headless -tangents [-threads N] [-skull path]
+// Headless -cook [-threads N] [-skull path]
+// Headless -meshcodec [-skull path]
+// Headless -streams
+// Headless -commands [-threads N]
+// Headless -colorpacking
+// Headless -constants
+// Headless -statecache
+// Headless -profiler
+// Headless -staticgeometry
+// Headless -raster [-threads N]
+//
+// -profile prints per-phase timings and writes <prefix><scene>.json, a
+// Chrome trace of the last frames. -startup prints the phases of each
+// scene's Init with their wall and CPU time, allocations and file bytes
+// read, and writes them to <prefix><scene>.folded for flame graphs.
+//
+// Every frame advances the scenes by 1/60 s. -input replays mouse input, a
+// built-in orbit or a script file (see InputScript), so camera movement is
+// the same in every run. -json writes the per-frame update and draw times,
+// -baseline compares the medians with an earlier -json file and exits with
+// 2 if any is more than -threshold percent (default 10) slower.
+//
+// -jobs checks the job system and measures its scheduling cost and scaling
+// up to -threads threads instead of running scenes. The scenes share a job
+// system with -threads threads.
+//
+// -fixedstep checks that the box scene reaches the same state on a fixed
+// simulation step at any render rate.
+//
+// Every scene reports the heap allocations of its measured frames, -noalloc
+// fails a scene that makes any. -arena checks FrameArena and compares it
+// with allocating std::vectors every frame.
+//
+// Mouse input reaches the scenes through an InputQueue as in the windowed
+// demos. -inputqueue checks the queue against a producer thread and prints
+// the latency from enqueue to consumption.
+//
+// -effectcache checks the compiled effect cache with a stub compiler.
+// -displaymodes checks DisplayModeTable against a recorded DXGI mode list.
+//
+// The scenes create their buffers through a TrackingRenderDevice and print
+// the ResourceRegistry's totals per owner. -budget fails a scene whose
+// buffers exceed that many KB. -resources checks the registry.
+//
+// The skull scene holds its objects by handle and releases them a few
+// frames after they are destroyed. -reload N reloads its model every N
+// frames, outside the update and draw timings. -resourcetable checks
+// handle reuse, deferred release and leak reports and times them.
+//
+// The box, shapes and hills scenes pack their vertex colors to RGBA8,
+// -floatcolors keeps them as four floats.
+//
+// -scene waves is the hills scene with its terrain rewritten every frame
+// through an UploadRing, and prints the bytes streamed and the stalls.
+// -uploadring checks the ring's wrap-around, stall and overflow handling.
+//
+// The skull scene picks the triangle under the mouse through a MeshBvh.
+// -bvh checks the BVH against brute force and times its build and rays
+// per second on the -skull model.
+//
+// -tangents checks the tangent frame generator on the generated meshes and
+// with mirrored texture coordinates, and that the skull's tangents are the
+// same on 1 to -threads threads, and prints its throughput.
+//
+// -cook runs AssetCooker on generated shapes and the -skull model in a
+// temporary directory: unchanged assets are skipped, changed ones cooked
+// again, and the cooked meshes hold the source triangles within the
+// quantization error.
+//
+// -meshcodec checks that MeshCodec round-trips and rejects damaged streams,
+// and prints its compression and decode speed on the -skull model.
+//
+// -streams times a position only pass over a million vertex mesh with every
+// attribute in each vertex stream layout.
+//
+// -commands records draws in partitions with ParallelCommandRecorder on 1 up
+// to -threads threads, replays them onto a null context and checks the calls
+// that arrive.
+//
+// -colorpacking checks PackColor and PackColors at the k/255 rounding
+// boundaries, out of range, and the SIMD path against the scalar one.
+//
+// -constants drives ConstantUpdater through a RecordingConstantUploader for
+// several frames and checks the uploads and byte counts of every frame.
+//
+// -statecache checks which calls StateCachedContext drops and issues against
+// a counting context, and times submission through it against direct calls.
+//
+// -profiler records events on a second thread faster than a FrameProfiler
+// collects them and checks that none is read torn or lost without counting.
+//
+// -staticgeometry times generating the box demo's meshes and a 20x20 sphere
+// at runtime against copying them baked by StaticGeometry.
+//
+// -raster checks SoftwareRasterizer at 640x480 and 333x211: the top-left fill
+// rule, a jittered grid writing every pixel once, equal depth redraws, culling
+// and the near plane split, and that 1 and N threads give the same image.
+
+#include "NullRenderDevice.h"
+#include "FrameProfiler.h"
+#include "StartupTrace.h"
+#include "AllocationCounter.h"
+#include "SoftwareRenderDevice.h"
+#include "OcclusionScene.h"
+#include "Benchmark.h"
+#include "JobBenchmark.h"
+#include "FixedStepCheck.h"
+#include "ArenaBenchmark.h"
+#include "InputQueueCheck.h"
+#include "EffectCacheCheck.h"
+#include "DisplayModeCheck.h"
+#include "ResourceCheck.h"
+#include "ResourceTableCheck.h"
+#include "UploadRingCheck.h"
+#include "BvhCheck.h"
+#include "TangentCheck.h"
+#include "CookCheck.h"
+#include "MeshCodecCheck.h"
+#include "StreamBenchmark.h"
+#include "CommandBenchmark.h"
+#include "ColorPackingCheck.h"
+#include "ConstantUpdateCheck.h"
+#include "StateCacheCheck.h"
+#include "ProfilerCheck.h"
+#include "StaticGeometryBenchmark.h"
+#include "RasterCheck.h"
+#include "TrackingRenderDevice.h"
+#include "JobSystem.h"
+#include "../Chap4/InitScene.h"
+#include "../Chap6_box/BoxScene.h"
+#include "../Chap6_hills/HillsScene.h"
+#include "../Chap6_shapes/ShapesScene.h"
+#include "../Chap6_skull/SkullScene.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct HeadlessOptions
+{
+	std::string Scene;
+	uint32_t Frames;
+	int Width;
+	int Height;
+	std::string SkullModel;
+	bool Rasterize;
+	uint32_t Threads;
+	std::string ImagePrefix;	// Writes <prefix><scene>.ppm after the last frame
+	std::string ProfilePrefix;	// Writes <prefix><scene>.json after the last frame
+	std::string StartupPrefix;	// Writes <prefix><scene>.folded after Init
+	uint32_t WarmupFrames;		// Run before the measured frames
+	std::string InputName;		// Empty, orbit or a script file
+	InputScript Input;
+	std::string JsonFile;
+	std::string BaselineFile;
+	double ThresholdPercent;
+	bool NoAllocations;			// Fails a scene whose measured frames allocate
+	uint64_t BufferBudget;		// Bytes, 0 for none
+	uint32_t ReloadInterval;	// Frames between skull reloads, 0 for none
+	bool PackedColors;			// RGBA8 vertex colors in box, shapes and hills
+	bool JobBenchmark;
+	bool FixedStepCheck;
+	bool ArenaBenchmark;
+	bool InputQueueCheck;
+	bool EffectCacheCheck;
+	bool DisplayModeCheck;
+	bool ResourceCheck;
+	bool ResourceTableCheck;
+	bool UploadRingCheck;
+	bool BvhCheck;
+	bool TangentCheck;
+	bool CookCheck;
+	bool MeshCodecCheck;
+	bool StreamBenchmark;
+	bool CommandBenchmark;
+	bool ColorPackingCheck;
+	bool ConstantUpdateCheck;
+	bool StateCacheCheck;
+	bool ProfilerCheck;
+	bool StaticGeometryBenchmark;
+	bool RasterCheck;
+	JobSystem* Jobs;
+};
+
+// Fixed time step so every run does the same work
+static const float frameTime = 1.0f / 60.0f;
+
+static std::unique_ptr<DemoScene> CreateScene(const std::string& name, const HeadlessOptions& options)
+{
+	if (name == "box")
+	{
+		return std::unique_ptr<DemoScene>(new BoxScene(StreamLayout::Interleaved, options.PackedColors));
+	}
+	if (name == "shapes")
+	{
+		return std::unique_ptr<DemoScene>(new ShapesScene(options.Jobs, options.PackedColors));
+	}
+	if (name == "hills")
+	{
+		return std::unique_ptr<DemoScene>(new HillsScene(options.Jobs, false, options.PackedColors));
+	}
+	if (name == "waves")
+	{
+		return std::unique_ptr<DemoScene>(new HillsScene(options.Jobs, true, options.PackedColors));
+	}
+	if (name == "skull")
+	{
+		return std::unique_ptr<DemoScene>(new SkullScene(options.SkullModel.c_str()));
+	}
+	if (name == "init")
+	{
+		return std::unique_ptr<DemoScene>(new InitScene());
+	}
+	if (name == "occlusion")
+	{
+		return std::unique_ptr<DemoScene>(new OcclusionScene());
+	}
+	return nullptr;
+}
+
+// Returns false if the scene could not be created or initialized
+static bool RunScene(const std::string& name, const HeadlessOptions& options, BenchmarkResult& result)
+{
+	std::unique_ptr<DemoScene> scene = CreateScene(name, options);
+	if (!scene)
+	{
+		fprintf(stderr, "Unknown scene %s\n", name.c_str());
+		return false;
+	}
+
+	std::unique_ptr<NullRenderDevice> device;
+	NullDeviceContext* context = nullptr;
+	SoftwareRenderDevice* software = nullptr;
+	if (options.Rasterize)
+	{
+		software = new SoftwareRenderDevice(options.Width, options.Height, options.Threads);
+		device.reset(software);
+		context = &software->Context();
+	}
+	else
+	{
+		device.reset(new NullRenderDevice());
+		context = &device->Context();
+	}
+
+	ResourceRegistry resources;
+	resources.SetTotalBudget(options.BufferBudget);
+	TrackingRenderDevice tracked(*device, resources);
+
+	// Sees the scopes of this scene only
+	std::unique_ptr<FrameProfiler> profiler;
+	if (!options.ProfilePrefix.empty())
+	{
+		profiler.reset(new FrameProfiler());
+	}
+
+	StartupTrace startup;
+	if (!options.StartupPrefix.empty())
+	{
+		startup.Begin();
+	}
+
+	bool ready = false;
+	{
+		STARTUP_PHASE("Init");
+		ready = scene->Init(tracked);
+	}
+
+	if (startup.IsRunning())
+	{
+		startup.End();
+		printf("%s", startup.Report().c_str());
+		std::string fileName = options.StartupPrefix + name + ".folded";
+		if (!startup.WriteFoldedStacks(fileName))
+		{
+			fprintf(stderr, "Could not write %s\n", fileName.c_str());
+		}
+	}
+	if (ready)
+	{
+		scene->OnResize(options.Width, options.Height);
+
+		InputScript input = options.Input;
+		input.Rewind();
+		InputQueue inputQueue;
+
+		float totalTime = 0.0f;
+		uint64_t drawsBefore = 0;
+		uint64_t trianglesBefore = 0;
+		uint64_t constantBytesBefore = 0;
+		auto start = std::chrono::steady_clock::now();
+
+		result.Scene = name;
+		result.UpdateUs.reserve(options.Frames);
+		result.DrawUs.reserve(options.Frames);
+		uint64_t allocations = 0;
+		uint32_t allocatingFrames = 0;
+		SkullScene* skull = dynamic_cast<SkullScene*>(scene.get());
+		uint32_t reloads = 0;
+
+		for (uint32_t frame = 0; frame < options.WarmupFrames + options.Frames; frame++)
+		{
+			if (frame == options.WarmupFrames)
+			{
+				drawsBefore = context->DrawCount;
+				trianglesBefore = context->TriangleCount;
+				constantBytesBefore = context->ConstantBytes;
+				if (software != nullptr)
+				{
+					software->Rasterizer().ResetStats();
+				}
+				if (profiler)
+				{
+					profiler->ResetHistograms();
+				}
+				start = std::chrono::steady_clock::now();
+			}
+
+			input.Play(frame, inputQueue);
+			totalTime += frameTime;
+
+			if (skull != nullptr && options.ReloadInterval > 0 && frame > 0 && frame % options.ReloadInterval == 0)
+			{
+				reloads += skull->ReloadModel() ? 1 : 0;
+			}
+
+			AllocationScope frameAllocations;
+			auto updateStart = std::chrono::steady_clock::now();
+			{
+				PROFILE_SCOPE("UpdateScene");
+				DispatchInput(inputQueue, *scene);
+				scene->UpdateScene(frameTime, totalTime);
+			}
+			auto drawStart = std::chrono::steady_clock::now();
+			{
+				PROFILE_SCOPE("DrawScene");
+				scene->DrawScene();
+			}
+			if (software != nullptr)
+			{
+				PROFILE_SCOPE("EndFrame");
+				software->Context().EndFrame();
+			}
+			auto drawEnd = std::chrono::steady_clock::now();
+
+			if (frame >= options.WarmupFrames)
+			{
+				uint64_t frameCount = frameAllocations.Allocations();
+				allocations += frameCount;
+				allocatingFrames += frameCount != 0 ? 1 : 0;
+
+				result.UpdateUs.push_back(std::chrono::duration<double, std::micro>(drawStart - updateStart).count());
+				result.DrawUs.push_back(std::chrono::duration<double, std::micro>(drawEnd - drawStart).count());
+			}
+			if (profiler)
+			{
+				profiler->Collect();
+			}
+		}
+		auto end = std::chrono::steady_clock::now();
+
+		double frames = static_cast<double>(options.Frames);
+		double ms = std::chrono::duration<double, std::milli>(end - start).count();
+		double triangles = (context->TriangleCount - trianglesBefore) / frames;
+
+		printf("%-7s %u frames  %.4f ms/frame  draws %.1f  triangles %.0f  constant bytes %.0f  buffer bytes %llu\n"
+			, name.c_str()
+			, options.Frames
+			, ms / frames
+			, (context->DrawCount - drawsBefore) / frames
+			, triangles
+			, (context->ConstantBytes - constantBytesBefore) / frames
+			, static_cast<unsigned long long>(device->BufferBytes));
+
+		if (software != nullptr)
+		{
+			const RasterStats& raster = software->Rasterizer().Stats();
+			printf("        raster %ux%u, %u threads  %.2f M triangles/s  rasterized %.0f  culled %.0f  pixels %.0f\n"
+				, options.Width
+				, options.Height
+				, software->Rasterizer().ThreadCount()
+				, ms > 0.0 ? triangles * frames / ms / 1000.0 : 0.0
+				, raster.TrianglesRasterized / frames
+				, raster.TrianglesCulled / frames
+				, raster.PixelsWritten / frames);
+
+			if (!options.ImagePrefix.empty())
+			{
+				std::string fileName = options.ImagePrefix + name + ".ppm";
+				if (!software->Rasterizer().WritePpm(fileName))
+				{
+					fprintf(stderr, "Could not write %s\n", fileName.c_str());
+				}
+			}
+		}
+		printf("        %s\n", scene->Caption().c_str());
+		printf("%s", resources.Report().c_str());
+		HillsScene* hills = dynamic_cast<HillsScene*>(scene.get());
+		if (hills != nullptr && hills->Upload() != nullptr)
+		{
+			printf("        %s\n", UploadRingSummary(hills->Upload()->Stats()).c_str());
+		}
+		if (reloads > 0)
+		{
+			printf("        %u reloads  %llu objects released  %u waiting for frames in flight\n"
+				, reloads
+				, static_cast<unsigned long long>(skull->Resources()->ReleasedCount())
+				, skull->Resources()->PendingCount());
+		}
+
+		TimingStats update = ComputeTimingStats(result.UpdateUs);
+		TimingStats draw = ComputeTimingStats(result.DrawUs);
+		printf("        update p50 %.2f us  p99 %.2f us   draw p50 %.2f us  p99 %.2f us   heap allocations %.2f/frame in %u frames\n"
+			, update.P50
+			, update.P99
+			, draw.P50
+			, draw.P99
+			, allocations / frames
+			, allocatingFrames);
+
+		if (options.NoAllocations && allocations > 0)
+		{
+			fprintf(stderr, "%s: %llu heap allocations in %u frames\n", name.c_str(), static_cast<unsigned long long>(allocations), allocatingFrames);
+			ready = false;
+		}
+
+		if (resources.BudgetWarnings() > 0)
+		{
+			fprintf(stderr, "%s: peak buffer memory %s over the budget of %s\n", name.c_str(), FormatBytes(resources.Total().PeakBytes).c_str(), FormatBytes(options.BufferBudget).c_str());
+			ready = false;
+		}
+
+		if (profiler)
+		{
+			printf("%s", profiler->Report().c_str());
+			std::string fileName = options.ProfilePrefix + name + ".json";
+			if (!profiler->WriteChromeTrace(fileName))
+			{
+				fprintf(stderr, "Could not write %s\n", fileName.c_str());
+			}
+		}
+
+		OcclusionScene* occlusion = dynamic_cast<OcclusionScene*>(scene.get());
+		if (occlusion != nullptr && occlusion->Mismatches() > 0)
+		{
+			fprintf(stderr, "%s: %u unexpected occlusion results\n", name.c_str(), occlusion->Mismatches());
+			ready = false;
+		}
+	}
+	else
+	{
+		fprintf(stderr, "%s failed to initialize\n", name.c_str());
+	}
+
+	// Shutdown also releases whatever a failed Init created
+	scene->Shutdown();
+	return ready;
+}
+
+int main(int argc, char** argv)
+{
+	HeadlessOptions options;
+	options.Scene = "all";
+	options.Frames = 1000;
+	options.Width = 800;
+	options.Height = 600;
+	options.SkullModel = "Models/skull.txt";
+	options.Rasterize = false;
+	options.Threads = std::max(1u, std::thread::hardware_concurrency());
+	options.WarmupFrames = 0;
+	options.ThresholdPercent = 10.0;
+	options.NoAllocations = false;
+	options.BufferBudget = 0;
+	options.ReloadInterval = 0;
+	options.PackedColors = true;
+	options.JobBenchmark = false;
+	options.FixedStepCheck = false;
+	options.ArenaBenchmark = false;
+	options.InputQueueCheck = false;
+	options.EffectCacheCheck = false;
+	options.DisplayModeCheck = false;
+	options.ResourceCheck = false;
+	options.ResourceTableCheck = false;
+	options.UploadRingCheck = false;
+	options.BvhCheck = false;
+	options.TangentCheck = false;
+	options.CookCheck = false;
+	options.MeshCodecCheck = false;
+	options.StreamBenchmark = false;
+	options.CommandBenchmark = false;
+	options.ColorPackingCheck = false;
+	options.ConstantUpdateCheck = false;
+	options.StateCacheCheck = false;
+	options.ProfilerCheck = false;
+	options.StaticGeometryBenchmark = false;
+	options.RasterCheck = false;
+	options.Jobs = nullptr;
+
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "-scene") == 0 && hasValue)
+		{
+			options.Scene = argv[++i];
+		}
+		else if (strcmp(argv[i], "-frames") == 0 && hasValue)
+		{
+			options.Frames = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+		}
+		else if (strcmp(argv[i], "-width") == 0 && hasValue)
+		{
+			options.Width = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-height") == 0 && hasValue)
+		{
+			options.Height = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-skull") == 0 && hasValue)
+		{
+			options.SkullModel = argv[++i];
+		}
+		else if (strcmp(argv[i], "-device") == 0 && hasValue)
+		{
+			options.Rasterize = strcmp(argv[++i], "raster") == 0;
+		}
+		else if (strcmp(argv[i], "-threads") == 0 && hasValue)
+		{
+			options.Threads = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+		}
+		else if (strcmp(argv[i], "-image") == 0 && hasValue)
+		{
+			options.ImagePrefix = argv[++i];
+		}
+		else if (strcmp(argv[i], "-profile") == 0 && hasValue)
+		{
+			options.ProfilePrefix = argv[++i];
+		}
+		else if (strcmp(argv[i], "-startup") == 0 && hasValue)
+		{
+			options.StartupPrefix = argv[++i];
+		}
+		else if (strcmp(argv[i], "-warmup") == 0 && hasValue)
+		{
+			options.WarmupFrames = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+		}
+		else if (strcmp(argv[i], "-input") == 0 && hasValue)
+		{
+			options.InputName = argv[++i];
+		}
+		else if (strcmp(argv[i], "-json") == 0 && hasValue)
+		{
+			options.JsonFile = argv[++i];
+		}
+		else if (strcmp(argv[i], "-baseline") == 0 && hasValue)
+		{
+			options.BaselineFile = argv[++i];
+		}
+		else if (strcmp(argv[i], "-threshold") == 0 && hasValue)
+		{
+			options.ThresholdPercent = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-noalloc") == 0)
+		{
+			options.NoAllocations = true;
+		}
+		else if (strcmp(argv[i], "-budget") == 0 && hasValue)
+		{
+			options.BufferBudget = strtoull(argv[++i], nullptr, 10) * 1024;
+		}
+		else if (strcmp(argv[i], "-reload") == 0 && hasValue)
+		{
+			options.ReloadInterval = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+		}
+		else if (strcmp(argv[i], "-floatcolors") == 0)
+		{
+			options.PackedColors = false;
+		}
+		else if (strcmp(argv[i], "-jobs") == 0)
+		{
+			options.JobBenchmark = true;
+		}
+		else if (strcmp(argv[i], "-fixedstep") == 0)
+		{
+			options.FixedStepCheck = true;
+		}
+		else if (strcmp(argv[i], "-arena") == 0)
+		{
+			options.ArenaBenchmark = true;
+		}
+		else if (strcmp(argv[i], "-inputqueue") == 0)
+		{
+			options.InputQueueCheck = true;
+		}
+		else if (strcmp(argv[i], "-effectcache") == 0)
+		{
+			options.EffectCacheCheck = true;
+		}
+		else if (strcmp(argv[i], "-displaymodes") == 0)
+		{
+			options.DisplayModeCheck = true;
+		}
+		else if (strcmp(argv[i], "-resources") == 0)
+		{
+			options.ResourceCheck = true;
+		}
+		else if (strcmp(argv[i], "-resourcetable") == 0)
+		{
+			options.ResourceTableCheck = true;
+		}
+		else if (strcmp(argv[i], "-uploadring") == 0)
+		{
+			options.UploadRingCheck = true;
+		}
+		else if (strcmp(argv[i], "-bvh") == 0)
+		{
+			options.BvhCheck = true;
+		}
+		else if (strcmp(argv[i], "-tangents") == 0)
+		{
+			options.TangentCheck = true;
+		}
+		else if (strcmp(argv[i], "-cook") == 0)
+		{
+			options.CookCheck = true;
+		}
+		else if (strcmp(argv[i], "-meshcodec") == 0)
+		{
+			options.MeshCodecCheck = true;
+		}
+		else if (strcmp(argv[i], "-streams") == 0)
+		{
+			options.StreamBenchmark = true;
+		}
+		else if (strcmp(argv[i], "-commands") == 0)
+		{
+			options.CommandBenchmark = true;
+		}
+		else if (strcmp(argv[i], "-colorpacking") == 0)
+		{
+			options.ColorPackingCheck = true;
+		}
+		else if (strcmp(argv[i], "-constants") == 0)
+		{
+			options.ConstantUpdateCheck = true;
+		}
+		else if (strcmp(argv[i], "-statecache") == 0)
+		{
+			options.StateCacheCheck = true;
+		}
+		else if (strcmp(argv[i], "-profiler") == 0)
+		{
+			options.ProfilerCheck = true;
+		}
+		else if (strcmp(argv[i], "-staticgeometry") == 0)
+		{
+			options.StaticGeometryBenchmark = true;
+		}
+		else if (strcmp(argv[i], "-raster") == 0)
+		{
+			options.RasterCheck = true;
+		}
+		else
+		{
+			fprintf(stderr, "Usage: %s [-scene box|shapes|hills|waves|skull|init|occlusion|all] [-frames N] [-width W] [-height H] [-skull path]"
+				" [-device null|raster] [-threads N] [-image prefix] [-profile prefix] [-startup prefix]"
+				" [-warmup N] [-input orbit|script] [-json file] [-baseline file] [-threshold percent] [-noalloc] [-budget KB] [-reload N] [-floatcolors]\n"
+				"       %s -jobs [-threads N]\n"
+				"       %s -fixedstep\n"
+				"       %s -arena\n"
+				"       %s -inputqueue\n"
+				"       %s -effectcache\n"
+				"       %s -displaymodes\n"
+				"       %s -resources\n"
+				"       %s -resourcetable\n"
+				"       %s -uploadring\n"
+				"       %s -bvh [-skull path]\n"
+				"       %s -tangents [-threads N] [-skull path]\n"
+				"       %s -cook [-threads N] [-skull path]\n"
+				"       %s -meshcodec [-skull path]\n"
+				"       %s -streams\n"
+				"       %s -commands [-threads N]\n"
+				"       %s -colorpacking\n"
+				"       %s -constants\n"
+				"       %s -statecache\n"
+				"       %s -profiler\n"
+				"       %s -staticgeometry\n"
+				"       %s -raster [-threads N]\n", argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0]);
+			return 1;
+		}
+	}
+
+	if (options.Frames == 0 || options.Width <= 0 || options.Height <= 0 || options.Threads == 0)
+	{
+		fprintf(stderr, "Frames, width, height and threads must be positive\n");
+		return 1;
+	}
+
+	if (options.JobBenchmark)
+	{
+		return RunJobBenchmark(options.Threads) == 0 ? 0 : 1;
+	}
+	if (options.FixedStepCheck)
+	{
+		return RunFixedStepCheck() == 0 ? 0 : 1;
+	}
+	if (options.ArenaBenchmark)
+	{
+		return RunArenaBenchmark() == 0 ? 0 : 1;
+	}
+	if (options.InputQueueCheck)
+	{
+		return RunInputQueueCheck() == 0 ? 0 : 1;
+	}
+	if (options.EffectCacheCheck)
+	{
+		return RunEffectCacheCheck() == 0 ? 0 : 1;
+	}
+	if (options.DisplayModeCheck)
+	{
+		return RunDisplayModeCheck() == 0 ? 0 : 1;
+	}
+	if (options.ResourceCheck)
+	{
+		return RunResourceCheck() == 0 ? 0 : 1;
+	}
+	if (options.ResourceTableCheck)
+	{
+		return RunResourceTableCheck() == 0 ? 0 : 1;
+	}
+	if (options.UploadRingCheck)
+	{
+		return RunUploadRingCheck() == 0 ? 0 : 1;
+	}
+	if (options.BvhCheck)
+	{
+		return RunBvhCheck(options.SkullModel) == 0 ? 0 : 1;
+	}
+	if (options.TangentCheck)
+	{
+		return RunTangentCheck(options.SkullModel, options.Threads) == 0 ? 0 : 1;
+	}
+
+	if (options.CookCheck)
+	{
+		return RunCookCheck(options.SkullModel, options.Threads) == 0 ? 0 : 1;
+	}
+	if (options.MeshCodecCheck)
+	{
+		return RunMeshCodecCheck(options.SkullModel) == 0 ? 0 : 1;
+	}
+	if (options.StreamBenchmark)
+	{
+		return RunStreamBenchmark() == 0 ? 0 : 1;
+	}
+	if (options.CommandBenchmark)
+	{
+		return RunCommandBenchmark(options.Threads) == 0 ? 0 : 1;
+	}
+	if (options.ColorPackingCheck)
+	{
+		return RunColorPackingCheck() == 0 ? 0 : 1;
+	}
+	if (options.ConstantUpdateCheck)
+	{
+		return RunConstantUpdateCheck() == 0 ? 0 : 1;
+	}
+	if (options.StateCacheCheck)
+	{
+		return RunStateCacheCheck() == 0 ? 0 : 1;
+	}
+	if (options.ProfilerCheck)
+	{
+		return RunProfilerCheck() == 0 ? 0 : 1;
+	}
+	if (options.StaticGeometryBenchmark)
+	{
+		return RunStaticGeometryBenchmark() == 0 ? 0 : 1;
+	}
+	if (options.RasterCheck)
+	{
+		return RunRasterCheck(options.Threads) == 0 ? 0 : 1;
+	}
+
+	JobSystem jobs(options.Threads);
+	options.Jobs = &jobs;
+
+	if (options.InputName == "orbit")
+	{
+		options.Input = InputScript::Orbit(options.WarmupFrames + options.Frames, options.Width, options.Height);
+	}
+	else if (!options.InputName.empty() && !options.Input.Load(options.InputName))
+	{
+		fprintf(stderr, "Could not read the input script %s\n", options.InputName.c_str());
+		return 1;
+	}
+
+	// Read first so a bad baseline fails before the run
+	std::map<std::string, double> baseline;
+	if (!options.BaselineFile.empty() && !ReadBenchmarkJson(options.BaselineFile, baseline))
+	{
+		fprintf(stderr, "Could not read the baseline %s\n", options.BaselineFile.c_str());
+		return 1;
+	}
+
+	std::vector<std::string> scenes;
+	if (options.Scene == "all")
+	{
+		scenes = { "init", "box", "shapes", "hills", "waves", "skull", "occlusion" };
+	}
+	else
+	{
+		scenes.push_back(options.Scene);
+	}
+
+	if (!options.ProfilePrefix.empty())
+	{
+		// Before any profiler exists so the measuring scopes are not reported
+		double scope = FrameProfiler::MeasureScopeOverhead(1000000);
+		double timestamp = FrameProfiler::MeasureTimestampCost(1000000);
+		printf("profiler overhead %.2f ns/scope, %.2f ns of it reading the clock twice\n", scope, 2.0 * timestamp);
+	}
+
+	int failures = 0;
+	std::vector<BenchmarkResult> results;
+	for (size_t i = 0; i < scenes.size(); i++)
+	{
+		BenchmarkResult result;
+		if (RunScene(scenes[i], options, result))
+		{
+			results.push_back(result);
+		}
+		else
+		{
+			failures++;
+		}
+	}
+
+	if (!options.JsonFile.empty() && !WriteBenchmarkJson(options.JsonFile, results, options.Frames, frameTime))
+	{
+		fprintf(stderr, "Could not write %s\n", options.JsonFile.c_str());
+		failures++;
+	}
+
+	if (!options.BaselineFile.empty())
+	{
+		uint32_t regressions = CompareWithBaseline(results, baseline, options.ThresholdPercent);
+		if (regressions > 0)
+		{
+			printf("%u regressions over %.1f%%\n", regressions, options.ThresholdPercent);
+			return 2;
+		}
+	}
+	return failures == 0 ? 0 : 1;
+}
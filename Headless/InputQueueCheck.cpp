@@ -0,0 +1,178 @@
+#include "InputQueueCheck.h"
+#include "InputQueue.h"
+#include "Benchmark.h"
+
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	const uint32_t streamEvents = 1000000;
+	const uint32_t dragCount = 4000;
+	const uint32_t movesPerDrag = 100;
+
+	InputEvent MakeEvent(InputEventType type, uint32_t buttons, int x)
+	{
+		InputEvent event = { type, buttons, x, 0, InputTimestamp() };
+		return event;
+	}
+
+	// Retries until there is room, so the consumer must see every event
+	void PushAll(InputQueue& queue, const InputEvent& event, uint64_t& fullCount)
+	{
+		while (!queue.Push(event))
+		{
+			fullCount++;
+			std::this_thread::yield();
+		}
+	}
+
+	double LatencyUs(const InputEvent& event)
+	{
+		return (InputTimestamp() - event.Timestamp) / 1000.0;
+	}
+
+	void PrintLatency(const char* name, const std::vector<double>& latencies)
+	{
+		TimingStats stats = ComputeTimingStats(latencies);
+		printf("%-10s latency p50 %.2f us  p99 %.2f us  max %.2f us\n", name, stats.P50, stats.P99, stats.Max);
+	}
+
+	// A stream of moves, every one of them must arrive in order through Pop
+	uint32_t CheckStream()
+	{
+		InputQueue queue;
+		uint64_t fullCount = 0;
+		std::thread producer([&queue, &fullCount]()
+		{
+			for (uint32_t i = 0; i < streamEvents; i++)
+			{
+				PushAll(queue, MakeEvent(InputEventType::MouseMove, MouseButtonLeft, static_cast<int>(i)), fullCount);
+			}
+		});
+
+		std::vector<double> latencies;
+		latencies.reserve(streamEvents);
+		uint32_t received = 0;
+		uint32_t outOfOrder = 0;
+		while (received < streamEvents)
+		{
+			InputEvent event;
+			if (!queue.Pop(event))
+			{
+				std::this_thread::yield();
+				continue;
+			}
+			latencies.push_back(LatencyUs(event));
+			outOfOrder += event.X == static_cast<int>(received) ? 0 : 1;
+			received++;
+		}
+		producer.join();
+
+		InputEvent extra;
+		uint32_t failures = outOfOrder > 0 || queue.Pop(extra) ? 1 : 0;
+		printf("Stream: %u events, %u out of order, queue full %llu times\n", received, outOfOrder, static_cast<unsigned long long>(fullCount));
+		PrintLatency("Pop", latencies);
+		return failures;
+	}
+
+	// Drags of many moves drained in batches: the moves of a batch collapse
+	// but every down and up arrives, with the drag's last move before the up
+	uint32_t CheckCoalescing()
+	{
+		InputQueue queue;
+		uint64_t fullCount = 0;
+		std::thread producer([&queue, &fullCount]()
+		{
+			int x = 0;
+			for (uint32_t drag = 0; drag < dragCount; drag++)
+			{
+				uint32_t buttons = (drag & 1) != 0 ? MouseButtonRight : MouseButtonLeft;
+				PushAll(queue, MakeEvent(InputEventType::MouseDown, buttons, x), fullCount);
+				for (uint32_t i = 0; i < movesPerDrag; i++)
+				{
+					PushAll(queue, MakeEvent(InputEventType::MouseMove, buttons, ++x), fullCount);
+				}
+				PushAll(queue, MakeEvent(InputEventType::MouseUp, 0, x), fullCount);
+			}
+		});
+
+		std::vector<double> latencies;
+		latencies.reserve(dragCount * (movesPerDrag + 2));
+		uint32_t downs = 0;
+		uint32_t ups = 0;
+		uint32_t moves = 0;
+		uint32_t errors = 0;
+		int lastX = 0;
+		bool dragging = false;
+		while (ups < dragCount)
+		{
+			uint32_t handled = queue.Drain([&](const InputEvent& event)
+			{
+				latencies.push_back(LatencyUs(event));
+				switch (event.Type)
+				{
+				case InputEventType::MouseDown:
+					errors += dragging || event.X != lastX ? 1 : 0;
+					dragging = true;
+					downs++;
+					break;
+				case InputEventType::MouseMove:
+					errors += !dragging || event.X <= lastX ? 1 : 0;
+					lastX = event.X;
+					moves++;
+					break;
+				case InputEventType::MouseUp:
+					// The drag's last move was never coalesced away
+					errors += !dragging || event.X != lastX ? 1 : 0;
+					dragging = false;
+					ups++;
+					break;
+				}
+			});
+			if (handled == 0)
+			{
+				std::this_thread::yield();
+			}
+		}
+		producer.join();
+
+		uint32_t failures = errors > 0 || downs != dragCount || lastX != static_cast<int>(dragCount * movesPerDrag) ? 1 : 0;
+		printf("Coalesced: %u drags, %u of %u moves handed out, %u errors, queue full %llu times\n"
+			, ups, moves, dragCount * movesPerDrag, errors, static_cast<unsigned long long>(fullCount));
+		PrintLatency("Drain", latencies);
+		return failures;
+	}
+
+	// Without a consumer the queue takes Capacity events and drops the rest,
+	// Clear empties it as a resumed app does
+	uint32_t CheckFull()
+	{
+		InputQueue queue;
+		uint32_t accepted = 0;
+		for (uint32_t i = 0; i < InputQueue::Capacity + 10; i++)
+		{
+			accepted += queue.Push(MakeEvent(InputEventType::MouseMove, 0, static_cast<int>(i))) ? 1 : 0;
+		}
+
+		InputEvent event;
+		bool firstKept = queue.Pop(event) && event.X == 0;
+		bool roomAgain = queue.Push(MakeEvent(InputEventType::MouseMove, 0, 0));
+		bool cleared = queue.Clear() == InputQueue::Capacity && !queue.Pop(event);
+		bool usedAfterClear = queue.Push(MakeEvent(InputEventType::MouseDown, 0, 7)) && queue.Pop(event) && event.X == 7 && !queue.Pop(event);
+		return accepted == InputQueue::Capacity && queue.DroppedCount() == 10 && firstKept && roomAgain && cleared && usedAfterClear ? 0 : 1;
+	}
+}
+
+uint32_t RunInputQueueCheck()
+{
+	uint32_t failures = CheckFull();
+	failures += CheckStream();
+	failures += CheckCoalescing();
+	if (failures > 0)
+	{
+		printf("%u input queue checks failed\n", failures);
+	}
+	return failures;
+}
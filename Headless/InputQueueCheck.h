@@ -0,0 +1,13 @@
+#ifndef INPUTQUEUECHECK_H
+#define INPUTQUEUECHECK_H
+
+#include <cstdint>
+
+// Pushes input events into an InputQueue from a producer thread as fast as
+// it can while the main thread consumes them, checks that none are lost or
+// reordered and that coalescing keeps every button event and the last move
+// before it, then prints the latency from Push to consumption. Returns the
+// number of failed checks.
+uint32_t RunInputQueueCheck();
+
+#endif // INPUTQUEUECHECK_H
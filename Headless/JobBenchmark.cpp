@@ -0,0 +1,165 @@
+#include "JobBenchmark.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+	const uint32_t stageCount = 4;
+	const uint32_t jobsPerStage = 64;
+
+	// Every job of a stage checks that the whole previous stage has run
+	struct StageJob
+	{
+		std::atomic<uint32_t>* Finished;	// Per stage
+		std::atomic<uint32_t>* Errors;
+		uint32_t Stage;
+	};
+
+	void RunStageJob(void* data)
+	{
+		StageJob& job = *static_cast<StageJob*>(data);
+		if (job.Stage > 0 && job.Finished[job.Stage - 1].load() != jobsPerStage)
+		{
+			job.Errors->fetch_add(1);
+		}
+		job.Finished[job.Stage].fetch_add(1);
+	}
+
+	void EmptyJob(void*)
+	{
+	}
+
+	uint32_t CheckDependencies(JobSystem& jobs)
+	{
+		std::atomic<uint32_t> finished[stageCount];
+		std::atomic<uint32_t> errors(0);
+		for (uint32_t i = 0; i < stageCount; i++)
+		{
+			finished[i] = 0;
+		}
+
+		std::vector<StageJob> stageJobs(stageCount * jobsPerStage);
+		JobCounter counters[stageCount];
+		for (uint32_t stage = 0; stage < stageCount; stage++)
+		{
+			for (uint32_t i = 0; i < jobsPerStage; i++)
+			{
+				StageJob& job = stageJobs[stage * jobsPerStage + i];
+				job.Finished = finished;
+				job.Errors = &errors;
+				job.Stage = stage;
+				jobs.Run(&RunStageJob, &job, &counters[stage], stage > 0 ? &counters[stage - 1] : nullptr);
+			}
+		}
+		jobs.Wait(counters[stageCount - 1]);
+
+		uint32_t failures = errors.load() == 0 ? 0 : 1;
+		failures += finished[stageCount - 1].load() == jobsPerStage ? 0 : 1;
+		return failures;
+	}
+
+	uint32_t CheckParallelFor(JobSystem& jobs)
+	{
+		std::vector<uint32_t> hits(100003, 0);
+		jobs.ParallelFor(static_cast<uint32_t>(hits.size()), 97, [&hits](uint32_t first, uint32_t end)
+		{
+			for (uint32_t i = first; i < end; i++)
+			{
+				hits[i]++;
+			}
+		});
+
+		for (size_t i = 0; i < hits.size(); i++)
+		{
+			if (hits[i] != 1)
+			{
+				return 1;
+			}
+		}
+		return 0;
+	}
+
+	double NanosecondsPerJob(JobSystem& jobs, uint32_t jobCount)
+	{
+		JobCounter counter;
+		auto start = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < jobCount; i++)
+		{
+			jobs.Run(&EmptyJob, nullptr, &counter);
+		}
+		jobs.Wait(counter);
+		auto end = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::nano>(end - start).count() / jobCount;
+	}
+
+	double ParallelForMilliseconds(JobSystem& jobs, std::vector<float>& values)
+	{
+		auto start = std::chrono::steady_clock::now();
+		jobs.ParallelFor(static_cast<uint32_t>(values.size()), 1024, [&values](uint32_t first, uint32_t end)
+		{
+			for (uint32_t i = first; i < end; i++)
+			{
+				float x = static_cast<float>(i);
+				for (int k = 0; k < 16; k++)
+				{
+					x = sqrtf(x + 1.0f) * 3.0f;
+				}
+				values[i] = x;
+			}
+		});
+		auto end = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	}
+}
+
+uint32_t RunJobBenchmark(uint32_t maxThreads)
+{
+	uint32_t failures = 0;
+	std::vector<float> values(1 << 20);
+	double singleThreadMs = 0.0;
+
+	// Powers of two below the maximum, then the maximum
+	std::vector<uint32_t> threadCounts;
+	for (uint32_t threads = 1; threads < maxThreads; threads *= 2)
+	{
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(std::max(1u, maxThreads));
+
+	printf("%-8s %12s %14s %8s %10s\n", "threads", "ns/job", "for ms", "speedup", "steals");
+	for (uint32_t threads : threadCounts)
+	{
+		JobSystem jobs(threads);
+		failures += CheckDependencies(jobs);
+		failures += CheckParallelFor(jobs);
+
+		double perJob = NanosecondsPerJob(jobs, 100000);
+		// Best of a few, the first also wakes the workers
+		double forMs = 0.0;
+		for (int run = 0; run < 5; run++)
+		{
+			double ms = ParallelForMilliseconds(jobs, values);
+			forMs = run == 0 ? ms : std::min(forMs, ms);
+		}
+		singleThreadMs = threads == 1 ? forMs : singleThreadMs;
+
+		printf("%-8u %12.1f %14.3f %7.2fx %10llu\n"
+			, threads
+			, perJob
+			, forMs
+			, singleThreadMs / forMs
+			, static_cast<unsigned long long>(jobs.StealCount()));
+	}
+
+	if (failures > 0)
+	{
+		printf("%u job system checks failed\n", failures);
+	}
+	return failures;
+}
@@ -0,0 +1,12 @@
+#ifndef JOBBENCHMARK_H
+#define JOBBENCHMARK_H
+
+#include <cstdint>
+
+// Checks that jobs run after their dependencies and that ParallelFor covers
+// every index, then measures the cost of scheduling an empty job and how a
+// compute bound ParallelFor scales from 1 to maxThreads threads. Returns the
+// number of failed checks.
+uint32_t RunJobBenchmark(uint32_t maxThreads);
+
+#endif // JOBBENCHMARK_H
@@ -0,0 +1,339 @@
+#include "MeshCodecCheck.h"
+#include "CookedMesh.h"
+#include "MeshCodec.h"
+#include "MeshGenerator.h"
+#include "SkullModel.h"
+#include "VertexCacheOptimizer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#ifdef HEADLESS_ZLIB
+#include <zlib.h>
+#endif
+
+namespace
+{
+	// Bytes after the decoded data that must survive every decode
+	const uint32_t guardBytes = 16;
+	const uint8_t guardValue = 0xCD;
+
+	uint32_t Check(bool passed, const char* what)
+	{
+		if (!passed)
+		{
+			printf("Failed: %s\n", what);
+			return 1;
+		}
+		return 0;
+	}
+
+	bool GuardIntact(const std::vector<uint8_t>& buffer, size_t used)
+	{
+		return std::all_of(buffer.begin() + used, buffer.end(), [](uint8_t value) { return value == guardValue; });
+	}
+
+	// Also checks that the stream's size allows the count
+	bool VerticesRoundTrip(const std::vector<uint8_t>& vertices, uint32_t vertexCount, uint32_t vertexSize)
+	{
+		std::vector<uint8_t> data;
+		EncodeVertexBuffer(vertices.data(), vertexCount, vertexSize, data);
+		std::vector<uint8_t> decoded(vertices.size() + guardBytes, guardValue);
+		return MaxVertexCount(data.size(), vertexSize) >= vertexCount
+			&& DecodeVertexBuffer(decoded.data(), vertexCount, vertexSize, data.data(), data.size())
+			&& std::equal(vertices.begin(), vertices.end(), decoded.begin()) && GuardIntact(decoded, vertices.size());
+	}
+
+	bool IndicesRoundTrip(const std::vector<uint32_t>& indices)
+	{
+		std::vector<uint8_t> data;
+		EncodeIndexBuffer(indices.data(), static_cast<uint32_t>(indices.size()), data);
+		std::vector<uint8_t> decoded(indices.size() * sizeof(uint32_t) + guardBytes, guardValue);
+		return MaxIndexCount(data.size()) >= indices.size()
+			&& DecodeIndexBuffer(reinterpret_cast<uint32_t*>(decoded.data()), static_cast<uint32_t>(indices.size()), data.data(), data.size())
+			&& (indices.empty() || memcmp(indices.data(), decoded.data(), indices.size() * sizeof(uint32_t)) == 0)
+			&& GuardIntact(decoded, indices.size() * sizeof(uint32_t));
+	}
+
+	// Noise, zero, slowly changing and mostly small with a few jumps, at
+	// sizes around the 16 vertex groups and the blocks. Zeros pack the
+	// tightest, up to the count the stream size allows.
+	uint32_t CheckEdgeCases()
+	{
+		std::mt19937 random(7);
+		const uint32_t vertexSizes[] = { 4, 8, 12, 16, 20, 24, 32, 44, 64, 128, 256 };
+		const uint32_t counts[] = { 0, 1, 15, 16, 17, 255, 256, 257, 1000, 4099 };
+		uint32_t failures = 0;
+		for (uint32_t vertexSize : vertexSizes)
+		{
+			for (uint32_t count : counts)
+			{
+				for (uint32_t pattern = 0; pattern < 4; pattern++)
+				{
+					std::vector<uint8_t> vertices(static_cast<size_t>(count) * vertexSize);
+					for (size_t i = 0; i < vertices.size(); i++)
+					{
+						uint32_t vertex = static_cast<uint32_t>(i / vertexSize);
+						switch (pattern)
+						{
+						case 0: vertices[i] = static_cast<uint8_t>(random()); break;
+						case 1: vertices[i] = 0; break;
+						case 2: vertices[i] = static_cast<uint8_t>(vertex + random() % 3); break;
+						default: vertices[i] = static_cast<uint8_t>(random() % 16 == 0 ? random() : vertex); break;
+						}
+					}
+					if (!VerticesRoundTrip(vertices, count, vertexSize))
+					{
+						printf("Failed: %u vertices of %u bytes, pattern %u, did not round-trip\n", count, vertexSize, pattern);
+						failures++;
+					}
+				}
+			}
+		}
+
+		const uint32_t indexCounts[] = { 0, 3, 15, 16, 17, 255, 256, 257, 3000, 100000 };
+		for (uint32_t count : indexCounts)
+		{
+			for (uint32_t pattern = 0; pattern < 4; pattern++)
+			{
+				std::vector<uint32_t> indices(count);
+				for (uint32_t i = 0; i < count; i++)
+				{
+					switch (pattern)
+					{
+					case 0: indices[i] = static_cast<uint32_t>(random()); break;
+					case 1: indices[i] = i / 3; break;
+					case 2: indices[i] = 0; break;
+					default: indices[i] = i % 3 != 0 ? indices[i - 1] + random() % 41 - 20 : i; break;
+					}
+				}
+				if (!IndicesRoundTrip(indices))
+				{
+					printf("Failed: %u indices, pattern %u, did not round-trip\n", count, pattern);
+					failures++;
+				}
+			}
+		}
+		return failures;
+	}
+
+	// Every cut of the stream, a wrong count or vertex size and another version fail
+	uint32_t CheckDamagedStreams()
+	{
+		const uint32_t vertexCount = 300;
+		const uint32_t vertexSize = 24;
+		std::vector<uint8_t> vertices(vertexCount * vertexSize);
+		std::vector<uint32_t> indices(900);
+		std::mt19937 random(11);
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			vertices[i] = static_cast<uint8_t>(i / vertexSize * (i % 4) + random() % 8);
+		}
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			indices[i] = random() % 4 == 0 ? random() % vertexCount : static_cast<uint32_t>(i / 3);
+		}
+		std::vector<uint8_t> vertexData;
+		std::vector<uint8_t> indexData;
+		EncodeVertexBuffer(vertices.data(), vertexCount, vertexSize, vertexData);
+		EncodeIndexBuffer(indices.data(), static_cast<uint32_t>(indices.size()), indexData);
+
+		std::vector<uint8_t> decoded(vertices.size() + guardBytes, guardValue);
+		uint32_t* decodedIndices = reinterpret_cast<uint32_t*>(decoded.data());
+		bool cutAccepted = false;
+		for (size_t size = 0; size < vertexData.size(); size++)
+		{
+			cutAccepted = cutAccepted || DecodeVertexBuffer(decoded.data(), vertexCount, vertexSize, vertexData.data(), size);
+		}
+		for (size_t size = 0; size < indexData.size(); size++)
+		{
+			cutAccepted = cutAccepted || DecodeIndexBuffer(decodedIndices, static_cast<uint32_t>(indices.size()), indexData.data(), size);
+		}
+		uint32_t failures = Check(!cutAccepted, "a truncated stream was decoded");
+		failures += Check(GuardIntact(decoded, vertices.size()), "a truncated stream was decoded past the destination");
+
+		// Counts within the same group of 16 read the same stream, these end elsewhere
+		failures += Check(!DecodeVertexBuffer(decoded.data(), vertexCount - 16, vertexSize, vertexData.data(), vertexData.size())
+			&& !DecodeVertexBuffer(decoded.data(), vertexCount, vertexSize - 4, vertexData.data(), vertexData.size())
+			&& !DecodeVertexBuffer(decoded.data(), vertexCount, 6, vertexData.data(), vertexData.size())
+			&& !DecodeIndexBuffer(decodedIndices, static_cast<uint32_t>(indices.size()) - 16, indexData.data(), indexData.size())
+			, "a stream was decoded with the wrong count or vertex size");
+		failures += Check(!DecodeVertexBuffer(decoded.data(), vertexCount, vertexSize, indexData.data(), indexData.size())
+			&& !DecodeIndexBuffer(decodedIndices, static_cast<uint32_t>(indices.size()), vertexData.data(), vertexData.size())
+			, "an index stream was decoded as vertices or the other way around");
+
+		// Random damage may decode to other values but never past the destination
+		for (uint32_t trial = 0; trial < 2000; trial++)
+		{
+			std::vector<uint8_t> damaged = trial % 2 == 0 ? vertexData : indexData;
+			damaged[1 + random() % (damaged.size() - 1)] ^= static_cast<uint8_t>(1 + random() % 255);
+			if (trial % 2 == 0)
+			{
+				DecodeVertexBuffer(decoded.data(), vertexCount, vertexSize, damaged.data(), damaged.size());
+			}
+			else
+			{
+				DecodeIndexBuffer(decodedIndices, static_cast<uint32_t>(indices.size()), damaged.data(), damaged.size());
+			}
+		}
+		failures += Check(GuardIntact(decoded, vertices.size()), "a damaged stream was decoded past the destination");
+		return failures;
+	}
+
+	template<typename Function>
+	double BestMilliseconds(Function function)
+	{
+		double best = 0.0;
+		for (uint32_t run = 0; run < 200; run++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			function();
+			double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			best = run == 0 ? ms : std::min(best, ms);
+		}
+		return best;
+	}
+
+	double GigabytesPerSecond(size_t bytes, double ms)
+	{
+		return ms > 0.0 ? bytes / (ms * 1e6) : 0.0;
+	}
+
+	void PrintZlib(const uint8_t* raw, size_t rawBytes)
+	{
+#ifdef HEADLESS_ZLIB
+		std::vector<uint8_t> packed(compressBound(static_cast<uLong>(rawBytes)));
+		uLongf packedBytes = static_cast<uLongf>(packed.size());
+		compress2(packed.data(), &packedBytes, raw, static_cast<uLong>(rawBytes), Z_BEST_COMPRESSION);
+		std::vector<uint8_t> unpacked(rawBytes);
+		double ms = BestMilliseconds([&]()
+		{
+			uLongf unpackedBytes = static_cast<uLongf>(unpacked.size());
+			uncompress(unpacked.data(), &unpackedBytes, packed.data(), packedBytes);
+		});
+		printf("  zlib %8lu B %5.2fx %6.2f GB/s", static_cast<unsigned long>(packedBytes)
+			, static_cast<double>(rawBytes) / packedBytes, GigabytesPerSecond(rawBytes, ms));
+#else
+		(void)raw;
+		(void)rawBytes;
+#endif
+	}
+
+	uint32_t MeasureVertices(const char* name, const void* vertices, uint32_t vertexCount, uint32_t vertexSize)
+	{
+		size_t rawBytes = static_cast<size_t>(vertexCount) * vertexSize;
+		std::vector<uint8_t> data;
+		EncodeVertexBuffer(vertices, vertexCount, vertexSize, data);
+		std::vector<uint8_t> decoded(rawBytes + guardBytes, guardValue);
+		bool valid = DecodeVertexBuffer(decoded.data(), vertexCount, vertexSize, data.data(), data.size())
+			&& memcmp(decoded.data(), vertices, rawBytes) == 0 && GuardIntact(decoded, rawBytes);
+		double ms = BestMilliseconds([&]() { DecodeVertexBuffer(decoded.data(), vertexCount, vertexSize, data.data(), data.size()); });
+
+		printf("%-28s %8zu B  codec %8zu B %5.2fx %6.2f GB/s", name, rawBytes, data.size()
+			, static_cast<double>(rawBytes) / data.size(), GigabytesPerSecond(rawBytes, ms));
+		PrintZlib(static_cast<const uint8_t*>(vertices), rawBytes);
+		printf("\n");
+		return Check(valid, "the vertices did not round-trip");
+	}
+
+	uint32_t MeasureIndices(const char* name, const std::vector<uint32_t>& indices, uint32_t indexSize)
+	{
+		uint32_t indexCount = static_cast<uint32_t>(indices.size());
+		std::vector<uint8_t> data;
+		EncodeIndexBuffer(indices.data(), indexCount, data);
+		std::vector<uint32_t> decoded(indexCount);
+		bool valid = DecodeIndexBuffer(decoded.data(), indexCount, data.data(), data.size()) && decoded == indices;
+		double ms = BestMilliseconds([&]() { DecodeIndexBuffer(decoded.data(), indexCount, data.data(), data.size()); });
+
+		std::vector<uint16_t> narrow(indices.begin(), indices.end());
+		const uint8_t* stored = indexSize == 2 ? reinterpret_cast<const uint8_t*>(narrow.data()) : reinterpret_cast<const uint8_t*>(indices.data());
+		size_t rawBytes = static_cast<size_t>(indexCount) * indexSize;
+		// zlib gets the indices as the cooked file would store them uncompressed, the
+		// speed is of the 32-bit indices the decoder writes
+		printf("%-28s %8zu B  codec %8zu B %5.2fx %6.2f GB/s", name, rawBytes, data.size()
+			, static_cast<double>(rawBytes) / data.size(), GigabytesPerSecond(indexCount * sizeof(uint32_t), ms));
+		PrintZlib(stored, rawBytes);
+		printf(", %.2f codec bytes per triangle\n", data.size() * 3.0 / std::max(1u, indexCount));
+		return Check(valid, "the indices did not round-trip");
+	}
+
+	struct FloatVertex
+	{
+		Float3 Position;
+		Float3 Normal;
+	};
+}
+
+uint32_t RunMeshCodecCheck(const std::string& skullModel)
+{
+	uint32_t failures = CheckEdgeCases();
+	failures += CheckDamagedStreams();
+
+	SkullModel skull;
+	const char* name = "Skull";
+	if (!LoadSkullModel(skullModel, skull))
+	{
+		printf("Could not load %s, using a sphere\n", skullModel.c_str());
+		MeshGenerator::MeshData sphere;
+		MeshGenerator::CreateSphere(5.0f, 175, 175, sphere);
+		skull = SkullModel();
+		for (size_t i = 0; i < sphere.Vertices.size(); i++)
+		{
+			skull.Positions.push_back(sphere.Vertices[i].Position);
+			skull.Normals.push_back(sphere.Vertices[i].Normal);
+		}
+		skull.Indices = sphere.Indices;
+		name = "Sphere";
+	}
+	uint32_t vertexCount = static_cast<uint32_t>(skull.Positions.size());
+	uint32_t indexCount = static_cast<uint32_t>(skull.Indices.size());
+	printf("%s: %u vertices, %u triangles%s\n", name, vertexCount, indexCount / 3
+#ifdef HEADLESS_ZLIB
+		, ", zlib at level 9"
+#else
+		, ", built without HEADLESS_ZLIB so no zlib comparison"
+#endif
+	);
+
+	// As the model file has them
+	std::vector<FloatVertex> floats(vertexCount);
+	for (uint32_t i = 0; i < vertexCount; i++)
+	{
+		floats[i].Position = skull.Positions[i];
+		floats[i].Normal = skull.Normals[i];
+	}
+	failures += MeasureVertices("Float vertices, source", floats.data(), vertexCount, sizeof(FloatVertex));
+	CookedMesh cooked;
+	QuantizeMesh(skull.Positions, skull.Normals, std::vector<Float2>(), skull.Indices, 16, cooked);
+	failures += MeasureVertices("Cooked vertices, source", cooked.Vertices.data(), vertexCount, sizeof(CookedVertex));
+	failures += MeasureIndices("Indices, source", skull.Indices, cooked.Header.IndexSize);
+
+	// As AssetCooker stores them
+	std::vector<uint32_t> indices = skull.Indices;
+	OptimizeVertexCache(indices.data(), indexCount, vertexCount);
+	std::vector<uint32_t> remap;
+	uint32_t usedCount = OptimizeVertexFetch(indices.data(), indexCount, vertexCount, remap);
+	std::vector<Float3> positions(usedCount);
+	std::vector<Float3> normals(usedCount);
+	for (uint32_t i = 0; i < vertexCount; i++)
+	{
+		if (remap[i] != ~0u)
+		{
+			positions[remap[i]] = skull.Positions[i];
+			normals[remap[i]] = skull.Normals[i];
+		}
+	}
+	QuantizeMesh(positions, normals, std::vector<Float2>(), indices, 16, cooked);
+	failures += MeasureVertices("Cooked vertices, optimized", cooked.Vertices.data(), usedCount, sizeof(CookedVertex));
+	failures += MeasureIndices("Indices, optimized", indices, cooked.Header.IndexSize);
+
+	if (failures > 0)
+	{
+		printf("%u mesh codec checks failed\n", failures);
+	}
+	return failures;
+}
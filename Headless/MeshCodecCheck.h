@@ -0,0 +1,17 @@
+#ifndef MESHCODECCHECK_H
+#define MESHCODECCHECK_H
+
+#include <cstdint>
+#include <string>
+
+// Round-trips MeshCodec on random and generated buffers of every vertex
+// size and at block boundaries, and checks that damaged or truncated
+// streams are rejected without writing past the destination. Round-trips
+// the skull model, or a sphere if the file is missing, quantized as
+// AssetCooker stores it and as float vertices, and prints the compression
+// ratio and decode speed of each buffer. Built with HEADLESS_ZLIB (and
+// -lz) it prints zlib's at its best level for comparison. Returns the
+// number of failed checks.
+uint32_t RunMeshCodecCheck(const std::string& skullModel);
+
+#endif // MESHCODECCHECK_H
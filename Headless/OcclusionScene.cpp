@@ -0,0 +1,220 @@
+#include "OcclusionScene.h"
+#include "MeshGenerator.h"
+#include "VertexFormat.h"
+#include "VertexStreams.h"
+#include "Log.h"
+
+#include <chrono>
+#include <cstdio>
+
+struct OcclusionVertex
+{
+	Float3	Position;
+	Float4	Color;
+};
+
+template<> struct VertexFormat<OcclusionVertex>
+{
+	static constexpr std::array<VertexElement, 2> Elements =
+	{{
+		VERTEX_ELEMENT(OcclusionVertex, Position, "POSITION"),
+		VERTEX_ELEMENT(OcclusionVertex, Color, "COLOR")
+	}};
+};
+
+static_assert(VertexFormatIsTight<OcclusionVertex>(), "OcclusionVertex has padding");
+
+static const uint32_t occlusionWidth = 256;
+static const uint32_t occlusionHeight = 128;
+
+OcclusionScene::OcclusionScene()
+	: mDevice(nullptr)
+	, mVertexBuffer(nullptr)
+	, mIndexBuffer(nullptr)
+	, mVertexStride(VertexStride<OcclusionVertex>())
+	, mFX(nullptr)
+	, mPass(nullptr)
+	, mfxWorldViewProj(nullptr)
+	, mInputLayout(nullptr)
+	, mBoxIndexCount(0)
+	, mSphereIndexCount(0)
+	, mSphereIndexOffset(0)
+	, mSphereVertexOffset(0)
+	, mOcclusion(occlusionWidth, occlusionHeight)
+	, mMismatches(0)
+	, mFrames(0)
+	, mCullMilliseconds(0.0)
+	, mCaption("Occlusion Test")
+{
+	// 8 x 4 wall standing on y = 0, the camera looks at it from z = -10
+	mWallWorld = MatrixMultiply(MatrixScaling(8.0f, 4.0f, 0.5f), MatrixTranslation(0.0f, 2.0f, 0.0f));
+	mView = MatrixLookAtLH(Float3(0.0f, 2.0f, -10.0f), Float3(0.0f, 2.0f, 0.0f), Float3(0.0f, 1.0f, 0.0f));
+	mProj = MatrixIdentity();
+	mViewProj = MatrixIdentity();
+
+	// Unit spheres, radius 0.5
+	mObjects =
+	{
+		{ "behind the middle", Float3(0.0f, 2.0f, 5.0f), Expected::Occluded },
+		{ "behind low left", Float3(-2.0f, 1.0f, 8.0f), Expected::Occluded },
+		{ "behind high right", Float3(2.0f, 3.0f, 3.0f), Expected::Occluded },
+		{ "far behind", Float3(0.0f, 1.0f, 20.0f), Expected::Occluded },
+		{ "above", Float3(0.0f, 6.0f, 5.0f), Expected::Visible },
+		{ "beside", Float3(8.0f, 2.0f, 5.0f), Expected::Visible },
+		{ "in front", Float3(0.0f, 2.0f, -5.0f), Expected::Visible },
+		{ "peeking past the edge", Float3(5.0f, 2.0f, 2.0f), Expected::Visible },
+		{ "left of the view", Float3(-30.0f, 2.0f, 5.0f), Expected::OutsideView }
+	};
+	mVisible.assign(mObjects.size(), true);
+}
+
+bool OcclusionScene::Init(IRenderDevice& device)
+{
+	mDevice = &device;
+
+	MeshGenerator::MeshData box;
+	MeshGenerator::MeshData sphere;
+	MeshGenerator::CreateBox(1.0f, 1.0f, 1.0f, box);
+	MeshGenerator::CreateSphere(0.5f, 20, 20, sphere);
+
+	mBoxIndexCount = static_cast<uint32_t>(box.Indices.size());
+	mSphereIndexCount = static_cast<uint32_t>(sphere.Indices.size());
+	mSphereIndexOffset = mBoxIndexCount;
+	mSphereVertexOffset = static_cast<uint32_t>(box.Vertices.size());
+
+	std::vector<OcclusionVertex> vertices;
+	for (size_t i = 0; i < box.Vertices.size(); i++)
+	{
+		OcclusionVertex vertex = { box.Vertices[i].Position, Float4(0.5f, 0.5f, 0.5f, 1.0f) };
+		vertices.push_back(vertex);
+	}
+	std::vector<Float3> spherePositions;
+	for (size_t i = 0; i < sphere.Vertices.size(); i++)
+	{
+		OcclusionVertex vertex = { sphere.Vertices[i].Position, Float4(1.0f, 0.8f, 0.2f, 1.0f) };
+		vertices.push_back(vertex);
+		spherePositions.push_back(sphere.Vertices[i].Position);
+	}
+	std::vector<uint32_t> indices(box.Indices);
+	indices.insert(indices.end(), sphere.Indices.begin(), sphere.Indices.end());
+
+	// The wall is its own occluder
+	mWallOccluder.Indices = box.Indices;
+	for (size_t i = 0; i < box.Vertices.size(); i++)
+	{
+		mWallOccluder.Positions.push_back(box.Vertices[i].Position);
+	}
+	mSphereBounds = ComputeBounds(spherePositions);
+
+	mVertexBuffer = CreateImmutableBuffer(device, BufferBinding::Vertex, &vertices[0], mVertexStride * static_cast<uint32_t>(vertices.size()), "Occlusion");
+	mIndexBuffer = CreateImmutableBuffer(device, BufferBinding::Index, &indices[0], sizeof(uint32_t) * static_cast<uint32_t>(indices.size()), "Occlusion");
+
+	mFX = device.CreateEffect("FX/color.fx");
+	if (mFX == nullptr)
+	{
+		return false;
+	}
+	mPass = device.FindPass(mFX, "ColorTech", 0);
+	mfxWorldViewProj = device.FindConstant(mFX, "gWorldViewProj");
+	mInputLayout = device.CreateInputLayout(InterleavedElements<OcclusionVertex>(), mPass);
+	return true;
+}
+
+void OcclusionScene::Shutdown()
+{
+	mDevice->ReleaseBuffer(mVertexBuffer);
+	mDevice->ReleaseBuffer(mIndexBuffer);
+	mDevice->ReleaseInputLayout(mInputLayout);
+	mDevice->ReleaseEffect(mFX);
+	mVertexBuffer = nullptr;
+	mIndexBuffer = nullptr;
+	mInputLayout = nullptr;
+	mFX = nullptr;
+}
+
+void OcclusionScene::OnResize(int width, int height)
+{
+	mProj = MatrixPerspectiveFovLH(0.25f * MathPi, static_cast<float>(width) / height, 1.0f, 1000.0f);
+	mViewProj = MatrixMultiply(mView, mProj);
+}
+
+void OcclusionScene::UpdateScene(float, float)
+{
+}
+
+void OcclusionScene::DrawScene()
+{
+	auto start = std::chrono::steady_clock::now();
+
+	mOcclusion.BeginFrame(mViewProj);
+	mOcclusion.AddOccluder(mWallOccluder, mWallWorld);
+	mOcclusion.BuildHierarchy();
+
+	uint32_t occluded = 0;
+	uint32_t outside = 0;
+	for (size_t i = 0; i < mObjects.size(); i++)
+	{
+		const Float3& p = mObjects[i].Position;
+		uint64_t outsideBefore = mOcclusion.Stats().ObjectsOutsideView;
+		mVisible[i] = mOcclusion.IsVisible(mSphereBounds, MatrixTranslation(p.x, p.y, p.z));
+
+		Expected result = Expected::Visible;
+		if (!mVisible[i])
+		{
+			bool isOutside = mOcclusion.Stats().ObjectsOutsideView != outsideBefore;
+			result = isOutside ? Expected::OutsideView : Expected::Occluded;
+			outside += isOutside ? 1 : 0;
+			occluded += isOutside ? 0 : 1;
+		}
+
+		if (result != mObjects[i].Result)
+		{
+			if (mMismatches == 0)
+			{
+				LogMessage(std::string("Occlusion test: unexpected result for the sphere ") + mObjects[i].Name + "\n");
+			}
+			mMismatches++;
+		}
+	}
+
+	auto end = std::chrono::steady_clock::now();
+	mCullMilliseconds += std::chrono::duration<double, std::milli>(end - start).count();
+	mFrames++;
+
+	IDeviceContext& context = mDevice->ImmediateContext();
+	context.ClearRenderTarget(Float4(0.0f, 0.0f, 0.0f, 1.0f));
+	context.ClearDepthStencil(1.0f, 0);
+	context.SetInputLayout(mInputLayout);
+	context.SetPrimitiveTopology(PrimitiveTopology::TriangleList);
+	context.SetVertexBuffer(0, mVertexBuffer, mVertexStride, 0);
+	context.SetIndexBuffer(mIndexBuffer, IndexFormat::UInt32, 0);
+
+	DrawMesh(mWallWorld, mBoxIndexCount, 0, 0);
+	for (size_t i = 0; i < mObjects.size(); i++)
+	{
+		if (mVisible[i])
+		{
+			const Float3& p = mObjects[i].Position;
+			DrawMesh(MatrixTranslation(p.x, p.y, p.z), mSphereIndexCount, mSphereIndexOffset, mSphereVertexOffset);
+		}
+	}
+
+	char caption[160];
+	snprintf(caption, sizeof(caption), "Occlusion Test  occluded %u, outside %u, visible %u of %u  mismatches %u  cull %.4f ms/frame"
+		, occluded
+		, outside
+		, static_cast<uint32_t>(mObjects.size()) - occluded - outside
+		, static_cast<uint32_t>(mObjects.size())
+		, mMismatches
+		, mCullMilliseconds / mFrames);
+	mCaption = caption;
+}
+
+void OcclusionScene::DrawMesh(const Float4x4& world, uint32_t indexCount, uint32_t indexOffset, uint32_t vertexOffset)
+{
+	IDeviceContext& context = mDevice->ImmediateContext();
+	Float4x4 worldViewProj = MatrixMultiply(world, mViewProj);
+	context.SetConstants(mfxWorldViewProj, &worldViewProj, sizeof(worldViewProj));
+	context.ApplyPass(mPass);
+	context.DrawIndexed(indexCount, indexOffset, vertexOffset);
+}
@@ -0,0 +1,81 @@
+#ifndef OCCLUSIONSCENE_H
+#define OCCLUSIONSCENE_H
+
+#include "DemoScene.h"
+#include "OcclusionCuller.h"
+
+#include <string>
+#include <vector>
+
+// Fixed camera looking at a wall with spheres around it whose occlusion is
+// known. Every frame culls the spheres, compares the result with the
+// expected one and draws the wall and what survived. The caption has the
+// counts and the average cost of the culling.
+class OcclusionScene : public DemoScene
+{
+public:
+	OcclusionScene();
+
+	bool Init(IRenderDevice& device);
+	void Shutdown();
+
+	void OnResize(int width, int height);
+	void UpdateScene(float dt, float totalTime);
+	void DrawScene();
+
+	const std::string& Caption() const { return mCaption; }
+
+	// Object results that differed from the expected ones, over all frames
+	uint32_t Mismatches() const { return mMismatches; }
+
+private:
+	enum class Expected
+	{
+		Visible,
+		Occluded,
+		OutsideView
+	};
+
+	struct TestObject
+	{
+		const char* Name;
+		Float3 Position;
+		Expected Result;
+	};
+
+	void DrawMesh(const Float4x4& world, uint32_t indexCount, uint32_t indexOffset, uint32_t vertexOffset);
+
+	IRenderDevice* mDevice;
+
+	RenderBuffer* mVertexBuffer;
+	RenderBuffer* mIndexBuffer;
+	uint32_t mVertexStride;
+	RenderEffect* mFX;
+	RenderPass* mPass;
+	RenderConstant* mfxWorldViewProj;
+	RenderInputLayout* mInputLayout;
+
+	uint32_t mBoxIndexCount;
+	uint32_t mSphereIndexCount;
+	uint32_t mSphereIndexOffset;
+	uint32_t mSphereVertexOffset;
+
+	OcclusionCuller mOcclusion;
+	OccluderMesh mWallOccluder;
+	Bounds mSphereBounds;
+	std::vector<TestObject> mObjects;
+	std::vector<bool> mVisible;
+
+	Float4x4 mWallWorld;
+	Float4x4 mView;
+	Float4x4 mProj;
+	Float4x4 mViewProj;
+
+	uint32_t mMismatches;
+	uint32_t mFrames;
+	double mCullMilliseconds;
+
+	std::string mCaption;
+};
+
+#endif // OCCLUSIONSCENE_H
@@ -0,0 +1,112 @@
+#include "ProfilerCheck.h"
+#include "FrameProfiler.h"
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	uint32_t Check(bool passed, const char* what)
+	{
+		if (!passed)
+		{
+			printf("Failed: %s\n", what);
+			return 1;
+		}
+		return 0;
+	}
+
+	const PhaseStats* FindPhase(const std::vector<PhaseStats>& phases, const char* name)
+	{
+		for (size_t i = 0; i < phases.size(); i++)
+		{
+			if (phases[i].Name == name)
+			{
+				return &phases[i];
+			}
+		}
+		return nullptr;
+	}
+
+	// Even events last 100 ticks and odd ones 300, starting far apart, so an
+	// event put together from two slots has a duration neither has
+	uint32_t CheckWrapAround()
+	{
+		const uint64_t eventCount = 4000000;
+		FrameProfiler profiler;
+		std::atomic<bool> done(false);
+
+		std::thread writer([&]()
+		{
+			ProfileThreadBuffer& buffer = CurrentProfileBuffer();
+			for (uint64_t i = 0; i < eventCount; i++)
+			{
+				uint64_t start = i << 20;
+				if ((i & 1) == 0)
+				{
+					buffer.Record("ProfilerCheckEven", start, start + 100);
+				}
+				else
+				{
+					buffer.Record("ProfilerCheckOdd", start, start + 300);
+				}
+			}
+			done.store(true, std::memory_order_release);
+		});
+
+		uint32_t collections = 0;
+		while (!done.load(std::memory_order_acquire))
+		{
+			profiler.Collect();
+			collections++;
+		}
+		writer.join();
+		profiler.Collect();
+
+		std::vector<PhaseStats> phases = profiler.Phases();
+		const PhaseStats* even = FindPhase(phases, "ProfilerCheckEven");
+		const PhaseStats* odd = FindPhase(phases, "ProfilerCheckOdd");
+		uint64_t collected = (even != nullptr ? even->Count : 0) + (odd != nullptr ? odd->Count : 0);
+
+		uint32_t failures = Check(phases.size() == 2 && even != nullptr && odd != nullptr, "the events are not in their two phases");
+		failures += Check(collected + profiler.LostEvents() == eventCount, "events are neither collected nor counted as lost");
+		if (even != nullptr && odd != nullptr)
+		{
+			// The tick rate is calibrated on every Collect, so allow it to drift by half
+			failures += Check(even->MaxUs < odd->MinUs && odd->MaxUs < 2.0 * odd->MinUs, "a collected event was torn or overwritten");
+		}
+		printf("Profiler: %llu events on a second thread, %u collections, %llu collected, %llu lost\n"
+			, static_cast<unsigned long long>(eventCount), collections
+			, static_cast<unsigned long long>(collected), static_cast<unsigned long long>(profiler.LostEvents()));
+		return failures;
+	}
+
+	uint32_t CheckNames()
+	{
+		// Separate arrays, as the same literal in two files can be
+		static const char first[] = "ProfilerCheckName";
+		static const char second[] = "ProfilerCheckName";
+
+		FrameProfiler profiler;
+		CurrentProfileBuffer().Record(first, 0, 10);
+		CurrentProfileBuffer().Record(second, 0, 10);
+		profiler.Collect();
+
+		std::vector<PhaseStats> phases = profiler.Phases();
+		return Check(phases.size() == 1 && phases[0].Count == 2, "equal names from different literals are separate phases");
+	}
+}
+
+uint32_t RunProfilerCheck()
+{
+	uint32_t failures = CheckWrapAround();
+	failures += CheckNames();
+
+	if (failures > 0)
+	{
+		printf("%u profiler checks failed\n", failures);
+	}
+	return failures;
+}
@@ -0,0 +1,13 @@
+#ifndef PROFILERCHECK_H
+#define PROFILERCHECK_H
+
+#include <cstdint>
+
+// Records events on a second thread much faster than a FrameProfiler
+// collects them, so the ring wraps while it is copied, and checks that
+// every event is either collected intact or counted as lost. Also checks
+// that equal names from different literals are one phase. Returns the
+// number of failed checks.
+uint32_t RunProfilerCheck();
+
+#endif // PROFILERCHECK_H
@@ -0,0 +1,380 @@
+#include "RasterCheck.h"
+#include "SoftwareRasterizer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+	uint32_t Check(bool passed, const char* what)
+	{
+		if (!passed)
+		{
+			printf("Failed: %s\n", what);
+			return 1;
+		}
+		return 0;
+	}
+
+	// Triangles given in pixels, clockwise on screen
+	struct ScreenMesh
+	{
+		std::vector<Float2> Points;
+		std::vector<uint32_t> Indices;
+	};
+
+	// Inverse of the rasterizer's viewport transform for w = 1
+	Float4 ClipPosition(const Float2& point, float z, uint32_t width, uint32_t height)
+	{
+		float x = static_cast<float>(point.x * 2.0 / width - 1.0);
+		float y = static_cast<float>(1.0 - point.y * 2.0 / height);
+		return Float4(x, y, z, 1.0f);
+	}
+
+	// A column whose pixel centers the viewport transform hits exactly, the
+	// one nearest the middle. Returns false if there is none.
+	bool ExactCenterColumn(uint32_t width, uint32_t& column, float& clipX)
+	{
+		for (uint32_t distance = 0; distance < width; distance++)
+		{
+			uint32_t candidates[2] = { width / 2 + distance, width / 2 - std::min(distance, width / 2) };
+			for (uint32_t c : candidates)
+			{
+				float x = static_cast<float>((2.0 * c + 1.0) / width - 1.0);
+				if (c < width && (x * 0.5f + 0.5f) * width == c + 0.5f)
+				{
+					column = c;
+					clipX = x;
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	bool ExactCenterRow(uint32_t height, uint32_t& row, float& clipY)
+	{
+		for (uint32_t distance = 0; distance < height; distance++)
+		{
+			uint32_t candidates[2] = { height / 2 + distance, height / 2 - std::min(distance, height / 2) };
+			for (uint32_t r : candidates)
+			{
+				float y = static_cast<float>(1.0 - (2.0 * r + 1.0) / height);
+				if (r < height && (0.5f - y * 0.5f) * height == r + 0.5f)
+				{
+					row = r;
+					clipY = y;
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	// Cells over the whole screen whose inner corners move by up to a pixel in
+	// half pixel steps, so many edges pass through pixel centers. Each cell is
+	// split along a random diagonal.
+	ScreenMesh JitteredGrid(uint32_t width, uint32_t height, uint32_t seed)
+	{
+		const uint32_t cellsX = 37;
+		const uint32_t cellsY = 23;
+		std::mt19937 random(seed);
+		std::uniform_int_distribution<int> jitter(-2, 2);
+
+		ScreenMesh mesh;
+		for (uint32_t j = 0; j <= cellsY; j++)
+		{
+			for (uint32_t i = 0; i <= cellsX; i++)
+			{
+				float x = static_cast<float>(i * width / cellsX);
+				float y = static_cast<float>(j * height / cellsY);
+				if (i > 0 && i < cellsX)
+				{
+					x += jitter(random) * 0.5f;
+				}
+				if (j > 0 && j < cellsY)
+				{
+					y += jitter(random) * 0.5f;
+				}
+				mesh.Points.push_back(Float2(x, y));
+			}
+		}
+
+		for (uint32_t j = 0; j < cellsY; j++)
+		{
+			for (uint32_t i = 0; i < cellsX; i++)
+			{
+				uint32_t topLeft = j * (cellsX + 1) + i;
+				uint32_t topRight = topLeft + 1;
+				uint32_t bottomLeft = topLeft + cellsX + 1;
+				uint32_t bottomRight = bottomLeft + 1;
+				if (random() & 1)
+				{
+					mesh.Indices.insert(mesh.Indices.end(), { topLeft, topRight, bottomRight, topLeft, bottomRight, bottomLeft });
+				}
+				else
+				{
+					mesh.Indices.insert(mesh.Indices.end(), { topLeft, topRight, bottomLeft, topRight, bottomRight, bottomLeft });
+				}
+			}
+		}
+		return mesh;
+	}
+
+	// Every triangle gets its own vertices at depth 'nearestZ' + 'zStep' *
+	// (triangles - index), so later triangles are in front of earlier ones
+	void DrawSeparated(SoftwareRasterizer& raster, const ScreenMesh& mesh, float nearestZ, float zStep, const Float4& color, bool reversed)
+	{
+		uint32_t triangleCount = static_cast<uint32_t>(mesh.Indices.size() / 3);
+		std::vector<RasterVertex> vertices;
+		std::vector<uint32_t> indices;
+		for (uint32_t t = 0; t < triangleCount; t++)
+		{
+			float z = nearestZ + zStep * (triangleCount - t);
+			for (uint32_t k = 0; k < 3; k++)
+			{
+				const Float2& point = mesh.Points[mesh.Indices[t * 3 + (reversed ? 2 - k : k)]];
+				RasterVertex vertex = { ClipPosition(point, z, raster.Width(), raster.Height()), color };
+				vertices.push_back(vertex);
+				indices.push_back(static_cast<uint32_t>(indices.size()));
+			}
+		}
+		raster.DrawTriangles(vertices.data(), indices.data(), static_cast<uint32_t>(indices.size()));
+	}
+
+	void Begin(SoftwareRasterizer& raster)
+	{
+		raster.ClearColor(Float4(0.0f, 0.0f, 0.0f, 0.0f));
+		raster.ClearDepth(1.0f);
+		raster.Flush();
+		raster.ResetStats();
+	}
+
+	bool SameImage(const SoftwareRasterizer& a, const SoftwareRasterizer& b)
+	{
+		for (uint32_t y = 0; y < a.Height(); y++)
+		{
+			for (uint32_t x = 0; x < a.Width(); x++)
+			{
+				if (a.Pixel(x, y) != b.Pixel(x, y) || a.Depth(x, y) != b.Depth(x, y))
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	uint32_t WrittenPixels(const SoftwareRasterizer& raster)
+	{
+		uint32_t written = 0;
+		for (uint32_t y = 0; y < raster.Height(); y++)
+		{
+			for (uint32_t x = 0; x < raster.Width(); x++)
+			{
+				written += raster.Pixel(x, y) != 0 ? 1 : 0;
+			}
+		}
+		return written;
+	}
+
+	// Four quads meeting at a pixel center. The shared column and row belong
+	// to the quads whose left and top edges they are.
+	uint32_t CheckTopLeft(SoftwareRasterizer& raster)
+	{
+		uint32_t width = raster.Width();
+		uint32_t height = raster.Height();
+		uint32_t column = 0;
+		uint32_t row = 0;
+		float splitX = 0.0f;
+		float splitY = 0.0f;
+		uint32_t failures = 0;
+		failures += Check(ExactCenterColumn(width, column, splitX) && ExactCenterRow(height, row, splitY)
+			, "no pixel center is exactly representable in clip space");
+		if (failures != 0)
+		{
+			return failures;
+		}
+
+		const float xs[3] = { -1.0f, splitX, 1.0f };
+		const float ys[3] = { 1.0f, splitY, -1.0f };
+		const Float4 colors[4] = { Float4(1.0f, 0.0f, 0.0f, 1.0f), Float4(0.0f, 1.0f, 0.0f, 1.0f)
+			, Float4(0.0f, 0.0f, 1.0f, 1.0f), Float4(1.0f, 1.0f, 1.0f, 1.0f) };
+		std::vector<RasterVertex> vertices;
+		std::vector<uint32_t> indices;
+		for (uint32_t quad = 0; quad < 4; quad++)
+		{
+			uint32_t qx = quad & 1;
+			uint32_t qy = quad >> 1;
+			uint32_t first = static_cast<uint32_t>(vertices.size());
+			for (uint32_t corner = 0; corner < 4; corner++)
+			{
+				// Top left, top right, bottom right, bottom left
+				uint32_t cx = qx + ((corner == 1 || corner == 2) ? 1 : 0);
+				uint32_t cy = qy + (corner >= 2 ? 1 : 0);
+				RasterVertex vertex = { Float4(xs[cx], ys[cy], 0.5f, 1.0f), colors[quad] };
+				vertices.push_back(vertex);
+			}
+			indices.insert(indices.end(), { first, first + 1, first + 2, first, first + 2, first + 3 });
+		}
+
+		Begin(raster);
+		raster.DrawTriangles(vertices.data(), indices.data(), static_cast<uint32_t>(indices.size()));
+		raster.Flush();
+
+		const uint32_t packed[4] = { 0xff0000ffu, 0xff00ff00u, 0xffff0000u, 0xffffffffu };
+		bool exact = true;
+		for (uint32_t y = 0; y < height; y++)
+		{
+			for (uint32_t x = 0; x < width; x++)
+			{
+				uint32_t quad = (x >= column ? 1 : 0) + (y >= row ? 2 : 0);
+				exact = exact && raster.Pixel(x, y) == packed[quad];
+			}
+		}
+		failures += Check(exact, "pixels on the shared edges do not go to the right and bottom quads");
+		failures += Check(raster.Stats().PixelsWritten == uint64_t(width) * height, "the quads do not write every pixel once");
+		return failures;
+	}
+
+	// Later triangles are nearer, so a pixel covered twice is written twice
+	// and PixelsWritten only matches with exactly one triangle per pixel
+	uint32_t CheckCoverage(SoftwareRasterizer& raster, const ScreenMesh& grid)
+	{
+		uint32_t failures = 0;
+		uint64_t pixels = uint64_t(raster.Width()) * raster.Height();
+		float zStep = 0.5f / (grid.Indices.size() / 3);
+
+		Begin(raster);
+		DrawSeparated(raster, grid, 0.25f, zStep, Float4(1.0f, 0.0f, 0.0f, 1.0f), false);
+		raster.Flush();
+		failures += Check(raster.Stats().PixelsWritten == pixels && WrittenPixels(raster) == pixels
+			, "the jittered grid does not write every pixel exactly once");
+
+		// The same triangles again, with every pixel at the depth it already has
+		std::vector<uint32_t> before(pixels);
+		for (uint32_t y = 0; y < raster.Height(); y++)
+		{
+			for (uint32_t x = 0; x < raster.Width(); x++)
+			{
+				before[y * raster.Width() + x] = raster.Pixel(x, y);
+			}
+		}
+		raster.ResetStats();
+		DrawSeparated(raster, grid, 0.25f, zStep, Float4(0.0f, 1.0f, 0.0f, 1.0f), false);
+		raster.Flush();
+		bool unchanged = true;
+		for (uint32_t y = 0; y < raster.Height(); y++)
+		{
+			for (uint32_t x = 0; x < raster.Width(); x++)
+			{
+				unchanged = unchanged && raster.Pixel(x, y) == before[y * raster.Width() + x];
+			}
+		}
+		failures += Check(raster.Stats().PixelsWritten == 0 && unchanged, "a redraw at equal depth writes pixels");
+		return failures;
+	}
+
+	uint32_t CheckCulling(SoftwareRasterizer& raster, const ScreenMesh& grid)
+	{
+		Begin(raster);
+		DrawSeparated(raster, grid, 0.0f, 0.0f, Float4(1.0f, 1.0f, 1.0f, 1.0f), true);
+		raster.Flush();
+		const RasterStats& stats = raster.Stats();
+		return Check(stats.TrianglesCulled == stats.TrianglesSubmitted && stats.TrianglesRasterized == 0
+			&& stats.PixelsWritten == 0 && WrittenPixels(raster) == 0, "counter-clockwise triangles are drawn");
+	}
+
+	// One triangle whose depth rises left to right and crosses 0 at
+	// 'nearX' of the width. Nothing left of there may be written.
+	uint32_t CheckNearPlane(SoftwareRasterizer& raster, float nearX, uint64_t expectedTriangles, const char* what)
+	{
+		uint32_t width = raster.Width();
+		uint32_t height = raster.Height();
+		const Float2 points[3] = { Float2(0.1f * width, 0.9f * height), Float2(0.5f * width, 0.1f * height), Float2(0.9f * width, 0.9f * height) };
+		RasterVertex vertices[3];
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			float z = points[i].x / width - nearX;
+			vertices[i] = { ClipPosition(points[i], z, width, height), Float4(1.0f, 1.0f, 0.0f, 1.0f) };
+		}
+		const uint32_t indices[3] = { 0, 1, 2 };
+
+		Begin(raster);
+		raster.DrawTriangles(vertices, indices, 3);
+		raster.Flush();
+
+		bool clipped = true;
+		for (uint32_t y = 0; y < height; y++)
+		{
+			for (uint32_t x = 0; x < width; x++)
+			{
+				if (raster.Pixel(x, y) != 0)
+				{
+					clipped = clipped && x + 1.5f >= nearX * width && raster.Depth(x, y) >= -1e-4f;
+				}
+			}
+		}
+		const RasterStats& stats = raster.Stats();
+		return Check(stats.TrianglesSubmitted == 1 && stats.TrianglesRasterized == expectedTriangles
+			&& stats.PixelsWritten > 0 && clipped, what);
+	}
+
+	// Two overlapping grids with random colors and depths, crossing the near
+	// plane in places
+	void DrawRandomScene(SoftwareRasterizer& raster, const ScreenMesh& first, const ScreenMesh& second)
+	{
+		std::mt19937 random(7);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		Begin(raster);
+		for (const ScreenMesh* mesh : { &first, &second })
+		{
+			std::vector<RasterVertex> vertices;
+			for (const Float2& point : mesh->Points)
+			{
+				RasterVertex vertex = { ClipPosition(point, unit(random) * 1.1f - 0.1f, raster.Width(), raster.Height())
+					, Float4(unit(random), unit(random), unit(random), 1.0f) };
+				vertices.push_back(vertex);
+			}
+			raster.DrawTriangles(vertices.data(), mesh->Indices.data(), static_cast<uint32_t>(mesh->Indices.size()));
+		}
+		raster.Flush();
+	}
+}
+
+uint32_t RunRasterCheck(uint32_t maxThreads)
+{
+	uint32_t failures = 0;
+	const uint32_t sizes[2][2] = { { 640, 480 }, { 333, 211 } };
+	SoftwareRasterizer single(1);
+	SoftwareRasterizer parallel(std::max(maxThreads, 4u));
+	for (const uint32_t* size : sizes)
+	{
+		printf("%ux%u with 1 and %u threads\n", size[0], size[1], parallel.ThreadCount());
+		ScreenMesh grid = JitteredGrid(size[0], size[1], 1);
+		ScreenMesh other = JitteredGrid(size[0], size[1], 2);
+		single.Resize(size[0], size[1]);
+		parallel.Resize(size[0], size[1]);
+
+		for (SoftwareRasterizer* raster : { &single, &parallel })
+		{
+			failures += CheckTopLeft(*raster);
+			failures += CheckCoverage(*raster, grid);
+			failures += CheckCulling(*raster, grid);
+			failures += CheckNearPlane(*raster, 0.3f, 2, "a triangle with one vertex behind the near plane is not split in two");
+			failures += CheckNearPlane(*raster, 0.7f, 1, "a triangle with two vertices behind the near plane is not cut to one");
+		}
+
+		DrawRandomScene(single, grid, other);
+		DrawRandomScene(parallel, grid, other);
+		failures += Check(single.Stats().PixelsWritten > 0 && SameImage(single, parallel), "the image depends on the thread count");
+	}
+
+	if (failures > 0)
+	{
+		printf("%u raster checks failed\n", failures);
+	}
+	return failures;
+}
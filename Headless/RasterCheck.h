@@ -0,0 +1,14 @@
+#ifndef RASTERCHECK_H
+#define RASTERCHECK_H
+
+#include <cstdint>
+
+// Checks SoftwareRasterizer at 640x480 and 333x211: the top-left fill rule
+// on edges through pixel centers, a jittered grid of triangles covering
+// every pixel exactly once, redraws at equal depth writing nothing, culling
+// of counter-clockwise triangles and splitting at the near plane. Each case
+// runs with 1 and with maxThreads (at least 4) threads and the two images
+// must match. Returns the number of failed checks.
+uint32_t RunRasterCheck(uint32_t maxThreads);
+
+#endif // RASTERCHECK_H
@@ -0,0 +1,12 @@
+#ifndef RESOURCECHECK_H
+#define RESOURCECHECK_H
+
+#include <cstdint>
+
+// Creates and releases buffers through a TrackingRenderDevice over the null
+// device and checks the ResourceRegistry's totals, peaks and budget
+// warnings against the null device's own counters. Returns the number of
+// failed checks.
+uint32_t RunResourceCheck();
+
+#endif // RESOURCECHECK_H
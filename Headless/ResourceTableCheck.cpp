@@ -0,0 +1,194 @@
+#include "ResourceTableCheck.h"
+#include "NullRenderDevice.h"
+#include "RenderResources.h"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+	struct Item;
+	typedef ResourceTable<Item, uint32_t> ItemTable;
+
+	uint32_t Check(bool passed, const char* what)
+	{
+		if (!passed)
+		{
+			printf("Failed: %s\n", what);
+			return 1;
+		}
+		return 0;
+	}
+
+	uint32_t CheckHandles()
+	{
+		uint32_t failures = 0;
+		ItemTable table;
+		ItemTable::Handle none = {};
+		failures += Check(table.Get(none) == nullptr, "the null handle resolves");
+
+		ItemTable::Handle first = table.Create(7);
+		failures += Check(table.Get(first) != nullptr && *table.Get(first) == 7, "a new handle resolves to its value");
+
+		uint32_t value = 0;
+		failures += Check(table.Destroy(first, value) && value == 7, "destroy returns the value");
+		failures += Check(table.Get(first) == nullptr, "a destroyed handle resolves");
+		failures += Check(!table.Destroy(first, value), "a handle is destroyed twice");
+
+		ItemTable::Handle second = table.Create(8);
+		failures += Check(second.Index == first.Index && second.Generation != first.Generation, "the slot is not reused with a new generation");
+		failures += Check(table.Get(first) == nullptr && *table.Get(second) == 8, "a stale handle resolves to the slot's new value");
+
+		ItemTable::Handle outside = { 100, 1 };
+		failures += Check(table.Get(outside) == nullptr, "a handle past the table resolves");
+
+		// Indices stay put while others come and go
+		std::vector<ItemTable::Handle> handles;
+		for (uint32_t i = 0; i < 1000; i++)
+		{
+			handles.push_back(table.Create(i));
+		}
+		for (uint32_t i = 0; i < 1000; i += 2)
+		{
+			table.Destroy(handles[i], value);
+		}
+		for (uint32_t i = 0; i < 1000; i += 2)
+		{
+			handles[i] = table.Create(i + 1000);
+		}
+		bool stable = table.SlotCount() == 1001 && table.LiveCount() == 1001;
+		for (uint32_t i = 0; i < 1000; i++)
+		{
+			const uint32_t* live = table.Get(handles[i]);
+			stable = stable && live != nullptr && *live == (i % 2 == 0 ? i + 1000 : i);
+		}
+		failures += Check(stable, "slots move or values mix up under reuse");
+
+		uint32_t visited = 0;
+		table.ForEach([&visited](ItemTable::Handle, uint32_t) { visited++; });
+		failures += Check(visited == table.LiveCount(), "ForEach misses live values");
+		return failures;
+	}
+
+	uint32_t CheckDeferredRelease()
+	{
+		uint32_t failures = 0;
+		NullRenderDevice device;
+		{
+			RenderResources resources(device, 3);
+			std::vector<uint8_t> data(256);
+			BufferDesc desc = { BufferBinding::Vertex, BufferUsage::Immutable, 256, "Check" };
+			BufferHandle buffer = resources.CreateBuffer(desc, data.data());
+			EffectHandle effect = resources.CreateEffect("FX/color.fx");
+			RenderPass* pass = device.FindPass(resources.Effect(effect), "ColorTech", 0);
+			InputLayoutHandle layout = resources.CreateInputLayout(std::vector<StreamElement>(), pass, "Empty");
+			failures += Check(resources.Buffer(buffer) != nullptr && device.BufferCount == 1, "the buffer is not created");
+
+			// Released after the third frame end, not before
+			resources.EndFrame();
+			failures += Check(resources.Destroy(buffer) && resources.Buffer(buffer) == nullptr, "a destroyed buffer still resolves");
+			failures += Check(!resources.Destroy(buffer), "a buffer is destroyed twice");
+			resources.EndFrame();
+			resources.EndFrame();
+			failures += Check(device.BufferCount == 1 && resources.PendingCount() == 1, "the buffer is released while in flight");
+			resources.EndFrame();
+			failures += Check(device.BufferCount == 0 && resources.PendingCount() == 0, "the buffer is not released after three frames");
+
+			// Two objects left live are reported and stay with the device
+			failures += Check(resources.ReportLeaks() == 2, "the leaks are not reported");
+			resources.Destroy(effect);
+			resources.Destroy(layout);
+			failures += Check(device.EffectCount == 1 && device.InputLayoutCount == 1, "objects are released before the frame ends");
+			resources.Flush();
+			failures += Check(device.EffectCount == 0 && device.InputLayoutCount == 0, "Flush does not release");
+			failures += Check(resources.ReportLeaks() == 0 && resources.ReleasedCount() == 3, "objects are lost");
+		}
+		return failures;
+	}
+
+	double NanosecondsSince(std::chrono::steady_clock::time_point start, uint32_t count)
+	{
+		return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / count;
+	}
+
+	// Create and destroy in waves of 'live' objects, like streaming in and out
+	void Benchmark()
+	{
+		const uint32_t live = 4096;
+		const uint32_t rounds = 64;
+		const uint32_t count = live * rounds;
+
+		ItemTable table;
+		std::vector<ItemTable::Handle> handles(live);
+		uint32_t value = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (uint32_t round = 0; round < rounds; round++)
+		{
+			for (uint32_t i = 0; i < live; i++)
+			{
+				handles[i] = table.Create(i);
+			}
+			for (uint32_t i = 0; i < live; i++)
+			{
+				table.Destroy(handles[i], value);
+			}
+		}
+		double tableNs = NanosecondsSince(start, count);
+
+		NullRenderDevice device;
+		std::vector<RenderBuffer*> buffers(live);
+		BufferDesc desc = { BufferBinding::Vertex, BufferUsage::Dynamic, 64, "Benchmark" };
+		start = std::chrono::steady_clock::now();
+		for (uint32_t round = 0; round < rounds; round++)
+		{
+			for (uint32_t i = 0; i < live; i++)
+			{
+				buffers[i] = device.CreateBuffer(desc, nullptr);
+			}
+			for (uint32_t i = 0; i < live; i++)
+			{
+				device.ReleaseBuffer(buffers[i]);
+			}
+		}
+		double deviceNs = NanosecondsSince(start, count);
+
+		std::vector<BufferHandle> bufferHandles(live);
+		start = std::chrono::steady_clock::now();
+		{
+			RenderResources resources(device);
+			for (uint32_t round = 0; round < rounds; round++)
+			{
+				for (uint32_t i = 0; i < live; i++)
+				{
+					bufferHandles[i] = resources.CreateBuffer(desc, nullptr);
+				}
+				for (uint32_t i = 0; i < live; i++)
+				{
+					resources.Destroy(bufferHandles[i]);
+				}
+				resources.EndFrame();
+			}
+		}
+		double resourcesNs = NanosecondsSince(start, count);
+
+		printf("Create and destroy: table %.1f ns, null device %.1f ns, through RenderResources %.1f ns (%.1f M/s)\n"
+			, tableNs
+			, deviceNs
+			, resourcesNs
+			, resourcesNs > 0.0 ? 1000.0 / resourcesNs : 0.0);
+	}
+}
+
+uint32_t RunResourceTableCheck()
+{
+	uint32_t failures = CheckHandles();
+	failures += CheckDeferredRelease();
+	Benchmark();
+
+	if (failures > 0)
+	{
+		printf("%u resource table checks failed\n", failures);
+	}
+	return failures;
+}
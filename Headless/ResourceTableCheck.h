@@ -0,0 +1,11 @@
+#ifndef RESOURCETABLECHECK_H
+#define RESOURCETABLECHECK_H
+
+#include <cstdint>
+
+// Checks ResourceTable handle reuse and stale handle detection, the
+// deferred release of RenderResources on the null device and its leak
+// report, and times create and destroy. Returns the number of failed checks.
+uint32_t RunResourceTableCheck();
+
+#endif // RESOURCETABLECHECK_H
@@ -0,0 +1,38 @@
+#include "SkullModel.h"
+
+#include <fstream>
+
+bool LoadSkullModel(const std::string& fileName, SkullModel& model)
+{
+	std::ifstream file(fileName);
+	std::string word;
+	uint32_t vertexCount = 0;
+	uint32_t triangleCount = 0;
+	file >> word >> vertexCount >> word >> triangleCount;
+	while (file >> word && word != "{")
+	{
+	}
+
+	model.Positions.resize(vertexCount);
+	model.Normals.resize(vertexCount);
+	for (uint32_t i = 0; i < vertexCount; i++)
+	{
+		Float3& p = model.Positions[i];
+		Float3& n = model.Normals[i];
+		file >> p.x >> p.y >> p.z >> n.x >> n.y >> n.z;
+	}
+	while (file >> word && word != "{")
+	{
+	}
+
+	model.Indices.resize(triangleCount * 3);
+	for (uint32_t i = 0; i < triangleCount * 3; i++)
+	{
+		file >> model.Indices[i];
+		if (model.Indices[i] >= vertexCount)
+		{
+			return false;
+		}
+	}
+	return file && vertexCount > 0 && triangleCount > 0;
+}
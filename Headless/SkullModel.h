@@ -0,0 +1,21 @@
+#ifndef SKULLMODEL_H
+#define SKULLMODEL_H
+
+#include "MathTypes.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The book's skull.txt for the checks that need mesh data but no device
+struct SkullModel
+{
+	std::vector<Float3> Positions;
+	std::vector<Float3> Normals;
+	std::vector<uint32_t> Indices;
+};
+
+// False if the file is missing or has no triangles
+bool LoadSkullModel(const std::string& fileName, SkullModel& model);
+
+#endif // SKULLMODEL_H
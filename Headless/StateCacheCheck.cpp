@@ -0,0 +1,287 @@
+#include "StateCacheCheck.h"
+#include "StateCache.h"
+#include "MathTypes.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+namespace
+{
+	uint32_t Check(bool passed, const char* what)
+	{
+		if (!passed)
+		{
+			printf("Failed: %s\n", what);
+			return 1;
+		}
+		return 0;
+	}
+
+	// Stand-ins for the backend's objects, the null context never looks at them
+	template<typename T>
+	T* FakeObject(uintptr_t id)
+	{
+		return reinterpret_cast<T*>(id * 16);
+	}
+
+	// Counts the calls of each kind that reach it and keeps the last vertex
+	// and index buffer bindings
+	class CountingContext : public NullDeviceContext
+	{
+	public:
+		CountingContext() : Calls(), LastStride(0), LastOffset(0), LastFormat(IndexFormat::UInt32) {}
+
+		void SetInputLayout(RenderInputLayout* layout)
+		{
+			Calls[static_cast<int>(StateCall::InputLayout)]++;
+			NullDeviceContext::SetInputLayout(layout);
+		}
+
+		void SetPrimitiveTopology(PrimitiveTopology topology)
+		{
+			Calls[static_cast<int>(StateCall::PrimitiveTopology)]++;
+			NullDeviceContext::SetPrimitiveTopology(topology);
+		}
+
+		void SetVertexBuffer(uint32_t slot, RenderBuffer* buffer, uint32_t stride, uint32_t offset)
+		{
+			Calls[static_cast<int>(StateCall::VertexBuffer)]++;
+			LastStride = stride;
+			LastOffset = offset;
+			NullDeviceContext::SetVertexBuffer(slot, buffer, stride, offset);
+		}
+
+		void SetIndexBuffer(RenderBuffer* buffer, IndexFormat format, uint32_t offset)
+		{
+			Calls[static_cast<int>(StateCall::IndexBuffer)]++;
+			LastFormat = format;
+			NullDeviceContext::SetIndexBuffer(buffer, format, offset);
+		}
+
+		void SetConstants(RenderConstant* constant, const void* data, uint32_t size)
+		{
+			Calls[static_cast<int>(StateCall::Constants)]++;
+			NullDeviceContext::SetConstants(constant, data, size);
+		}
+
+		void ApplyPass(RenderPass* pass)
+		{
+			Calls[static_cast<int>(StateCall::Pass)]++;
+			NullDeviceContext::ApplyPass(pass);
+		}
+
+		void DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex)
+		{
+			Calls[static_cast<int>(StateCall::Draw)]++;
+			NullDeviceContext::DrawIndexed(indexCount, startIndex, baseVertex);
+		}
+
+		uint32_t Reached(StateCall call) const { return Calls[static_cast<int>(call)]; }
+
+		uint32_t Calls[static_cast<int>(StateCall::Count)];
+		uint32_t LastStride;
+		uint32_t LastOffset;
+		IndexFormat LastFormat;
+	};
+
+	RenderInputLayout* const layout = FakeObject<RenderInputLayout>(1);
+	RenderBuffer* const vertexBuffer = FakeObject<RenderBuffer>(2);
+	RenderBuffer* const indexBuffer = FakeObject<RenderBuffer>(3);
+	RenderConstant* const constant = FakeObject<RenderConstant>(4);
+	RenderPass* const pass = FakeObject<RenderPass>(5);
+	RenderPass* const otherPass = FakeObject<RenderPass>(6);
+
+	void BindAll(IDeviceContext& context)
+	{
+		context.SetInputLayout(layout);
+		context.SetPrimitiveTopology(PrimitiveTopology::TriangleList);
+		context.SetVertexBuffer(0, vertexBuffer, 32, 0);
+		context.SetIndexBuffer(indexBuffer, IndexFormat::UInt32, 0);
+		context.ApplyPass(pass);
+	}
+
+	// One call of 'call' reached the context since 'before', and no other
+	bool OnlyReached(const CountingContext& context, const CountingContext& before, StateCall call)
+	{
+		for (int i = 0; i < static_cast<int>(StateCall::Count); i++)
+		{
+			uint32_t expected = before.Calls[i] + (i == static_cast<int>(call) ? 1 : 0);
+			if (context.Calls[i] != expected)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool NothingReached(const CountingContext& context, const CountingContext& before)
+	{
+		return std::equal(context.Calls, context.Calls + static_cast<int>(StateCall::Count), before.Calls);
+	}
+
+	uint32_t CheckElision()
+	{
+		uint32_t failures = 0;
+		CountingContext counting;
+		StateCachedContext cache(counting);
+
+		BindAll(cache);
+		cache.DrawIndexed(36, 0, 0);
+		bool allIssued = true;
+		for (int i = 0; i < static_cast<int>(StateCall::Count); i++)
+		{
+			allIssued = allIssued && counting.Calls[i] == (i == static_cast<int>(StateCall::Constants) ? 0u : 1u);
+		}
+		failures += Check(allIssued, "the first binds do not all reach the context");
+
+		// The same state again, only the draw goes through
+		CountingContext before = counting;
+		BindAll(cache);
+		cache.DrawIndexed(36, 0, 0);
+		failures += Check(OnlyReached(counting, before, StateCall::Draw), "repeated binds are not dropped");
+		failures += Check(cache.CurrentFrame().Elided[static_cast<int>(StateCall::VertexBuffer)] == 1
+			&& cache.CurrentFrame().TotalElided() == 5 && cache.CurrentFrame().TotalIssued() == 7, "the cache statistics do not count the dropped binds");
+
+		// Every field of a binding counts
+		before = counting;
+		cache.SetVertexBuffer(0, vertexBuffer, 48, 0);
+		failures += Check(OnlyReached(counting, before, StateCall::VertexBuffer) && counting.LastStride == 48, "a changed vertex stride is not issued");
+		before = counting;
+		cache.SetVertexBuffer(0, vertexBuffer, 48, 96);
+		failures += Check(OnlyReached(counting, before, StateCall::VertexBuffer) && counting.LastOffset == 96, "a changed vertex offset is not issued");
+		before = counting;
+		cache.SetVertexBuffer(1, vertexBuffer, 48, 96);
+		failures += Check(OnlyReached(counting, before, StateCall::VertexBuffer), "the same buffer in another slot is not issued");
+		before = counting;
+		cache.SetVertexBuffer(0, vertexBuffer, 48, 96);
+		cache.SetVertexBuffer(1, vertexBuffer, 48, 96);
+		failures += Check(NothingReached(counting, before), "slots are not cached separately");
+		before = counting;
+		cache.SetIndexBuffer(indexBuffer, IndexFormat::UInt16, 0);
+		failures += Check(OnlyReached(counting, before, StateCall::IndexBuffer) && counting.LastFormat == IndexFormat::UInt16, "a changed index format is not issued");
+		before = counting;
+		cache.SetIndexBuffer(indexBuffer, IndexFormat::UInt16, 64);
+		failures += Check(OnlyReached(counting, before, StateCall::IndexBuffer), "a changed index offset is not issued");
+		before = counting;
+		cache.SetPrimitiveTopology(PrimitiveTopology::TriangleStrip);
+		failures += Check(OnlyReached(counting, before, StateCall::PrimitiveTopology), "a changed topology is not issued");
+		before = counting;
+		cache.SetInputLayout(FakeObject<RenderInputLayout>(7));
+		failures += Check(OnlyReached(counting, before, StateCall::InputLayout), "a changed input layout is not issued");
+
+		// Applying the pass uploads the effect constants, so it follows every change
+		before = counting;
+		cache.ApplyPass(pass);
+		failures += Check(NothingReached(counting, before), "the bound pass is applied again");
+		Float4x4 worldViewProj = MatrixTranslation(1.0f, 2.0f, 3.0f);
+		cache.SetConstants(constant, &worldViewProj, sizeof(worldViewProj));
+		before = counting;
+		cache.ApplyPass(pass);
+		failures += Check(OnlyReached(counting, before, StateCall::Pass), "the pass is not applied again after SetConstants");
+		before = counting;
+		cache.ApplyPass(pass);
+		failures += Check(NothingReached(counting, before), "the pass is applied twice after one SetConstants");
+		before = counting;
+		cache.ApplyPass(otherPass);
+		failures += Check(OnlyReached(counting, before, StateCall::Pass), "a different pass is not applied");
+
+		// After Invalidate the same state reaches the context again
+		cache.Invalidate();
+		before = counting;
+		cache.SetInputLayout(FakeObject<RenderInputLayout>(7));
+		cache.SetPrimitiveTopology(PrimitiveTopology::TriangleStrip);
+		cache.SetVertexBuffer(0, vertexBuffer, 48, 96);
+		cache.SetVertexBuffer(1, vertexBuffer, 48, 96);
+		cache.SetIndexBuffer(indexBuffer, IndexFormat::UInt16, 64);
+		cache.ApplyPass(otherPass);
+		bool reissued = counting.Reached(StateCall::InputLayout) == before.Reached(StateCall::InputLayout) + 1
+			&& counting.Reached(StateCall::PrimitiveTopology) == before.Reached(StateCall::PrimitiveTopology) + 1
+			&& counting.Reached(StateCall::VertexBuffer) == before.Reached(StateCall::VertexBuffer) + 2
+			&& counting.Reached(StateCall::IndexBuffer) == before.Reached(StateCall::IndexBuffer) + 1
+			&& counting.Reached(StateCall::Pass) == before.Reached(StateCall::Pass) + 1;
+		failures += Check(reissued, "state bound before Invalidate is not issued again");
+
+		// Statistics move to LastFrame
+		uint32_t issued = cache.CurrentFrame().TotalIssued();
+		cache.BeginFrame();
+		failures += Check(cache.LastFrame().TotalIssued() == issued && cache.CurrentFrame().TotalIssued() == 0, "BeginFrame does not start new statistics");
+
+		printf("State cache: repeated binds are dropped, changes, constants and Invalidate are issued\n");
+		return failures;
+	}
+
+	const uint32_t benchmarkDraws = 200000;
+
+	// A scene's draw loop: each draw binds its state, sets its matrix and
+	// applies the pass. With 'changing' the vertex buffer offset and the pass
+	// alternate every draw, so only the layout, topology and index buffer are
+	// dropped.
+	void SubmitDraws(IDeviceContext& context, bool changing)
+	{
+		Float4x4 worldViewProj = MatrixTranslation(1.0f, 2.0f, 3.0f);
+		for (uint32_t i = 0; i < benchmarkDraws; i++)
+		{
+			bool odd = changing && (i & 1) != 0;
+			context.SetInputLayout(layout);
+			context.SetPrimitiveTopology(PrimitiveTopology::TriangleList);
+			context.SetVertexBuffer(0, vertexBuffer, 32, odd ? 3200 : 0);
+			context.SetIndexBuffer(indexBuffer, IndexFormat::UInt32, 0);
+			worldViewProj.m[3][0] = static_cast<float>(i);
+			context.SetConstants(constant, &worldViewProj, sizeof(worldViewProj));
+			context.ApplyPass(odd ? otherPass : pass);
+			context.DrawIndexed(36, 0, 0);
+		}
+	}
+
+	// Best of five runs in ns per draw, and the calls that reached 'target'
+	double TimeSubmission(bool cached, bool changing, uint64_t& calls)
+	{
+		double best = 0.0;
+		for (int run = 0; run < 5; run++)
+		{
+			NullDeviceContext target;
+			StateCachedContext cache(target);
+			IDeviceContext& context = cached ? static_cast<IDeviceContext&>(cache) : target;
+
+			auto start = std::chrono::steady_clock::now();
+			SubmitDraws(context, changing);
+			double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / benchmarkDraws;
+			best = run == 0 ? ns : std::min(best, ns);
+			calls = target.CallCount;
+		}
+		return best;
+	}
+
+	void Benchmark()
+	{
+		const char* names[] = { "same state", "changing state" };
+		// The cache pays off once a dropped call costs the real context more
+		// than the time the cache adds per dropped call
+		printf("State cache on the null context, %u draws of 7 calls:\n", benchmarkDraws);
+		for (int changing = 0; changing < 2; changing++)
+		{
+			uint64_t directCalls = 0;
+			uint64_t cachedCalls = 0;
+			double direct = TimeSubmission(false, changing != 0, directCalls);
+			double cached = TimeSubmission(true, changing != 0, cachedCalls);
+			double dropped = static_cast<double>(directCalls - cachedCalls) / benchmarkDraws;
+			printf("  %-15s direct %6.1f ns/draw %4.1f calls/draw   cached %6.1f ns/draw %4.1f calls/draw   %5.1f ns added per dropped call\n", names[changing]
+				, direct, static_cast<double>(directCalls) / benchmarkDraws, cached, static_cast<double>(cachedCalls) / benchmarkDraws
+				, (cached - direct) / dropped);
+		}
+	}
+}
+
+uint32_t RunStateCacheCheck()
+{
+	uint32_t failures = CheckElision();
+	Benchmark();
+
+	if (failures > 0)
+	{
+		printf("%u state cache checks failed\n", failures);
+	}
+	return failures;
+}
@@ -0,0 +1,15 @@
+#ifndef STATECACHECHECK_H
+#define STATECACHECHECK_H
+
+#include <cstdint>
+
+// Puts a StateCachedContext in front of a context that counts every call
+// and checks that repeated binds are dropped, that a changed buffer,
+// stride, offset, format, layout or topology is issued, that a pass is
+// applied again after constants change, and that everything is issued
+// again after Invalidate. Then times submission with and without the
+// cache on the null context, with the same state bound for every draw and
+// with state that changes every draw. Returns the number of failed checks.
+uint32_t RunStateCacheCheck();
+
+#endif // STATECACHECHECK_H
@@ -0,0 +1,133 @@
+#include "StaticGeometryBenchmark.h"
+#include "MeshGenerator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+	const uint32_t benchmarkRuns = 2000;
+
+	constexpr StaticGeometry::StaticMesh<8, 36> bakedCube = StaticGeometry::MakeCornerBox(2.0f, 2.0f, 2.0f);
+	constexpr StaticGeometry::StaticMesh<5, 18> bakedPyramid = StaticGeometry::MakePyramid(2.0f, 2.0f);
+	constexpr StaticGeometry::StaticMesh<401, 2280> bakedSphere = StaticGeometry::MakeSphere<20, 20>(0.5f);
+
+	// Read at runtime so the generators below cannot be folded to constants
+	volatile float boxSize = 2.0f;
+	volatile float sphereRadius = 0.5f;
+
+	uint32_t Check(bool passed, const char* what)
+	{
+		if (!passed)
+		{
+			printf("Failed: %s\n", what);
+			return 1;
+		}
+		return 0;
+	}
+
+	struct Timing
+	{
+		double FirstMicroseconds;
+		double BestMicroseconds;
+	};
+
+	template<typename Function>
+	Timing Measure(Function function)
+	{
+		Timing timing = { 0.0, 1e30 };
+		for (uint32_t run = 0; run < benchmarkRuns; run++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			function();
+			auto end = std::chrono::steady_clock::now();
+			double us = std::chrono::duration<double, std::micro>(end - start).count();
+			if (run == 0)
+			{
+				timing.FirstMicroseconds = us;
+			}
+			timing.BestMicroseconds = std::min(timing.BestMicroseconds, us);
+		}
+		return timing;
+	}
+
+	void PrintTiming(const char* name, const Timing& timing)
+	{
+		printf("  %-34s first %8.2f us  best %8.2f us\n", name, timing.FirstMicroseconds, timing.BestMicroseconds);
+	}
+
+	// What a scene gets from a baked mesh when it wants it in a MeshData
+	template<size_t VertexCount, size_t IndexCount>
+	void CopyMesh(const StaticGeometry::StaticMesh<VertexCount, IndexCount>& mesh, MeshGenerator::MeshData& meshData)
+	{
+		meshData.Vertices.assign(mesh.Vertices.begin(), mesh.Vertices.end());
+		meshData.Indices.assign(mesh.Indices.begin(), mesh.Indices.end());
+	}
+
+	// Largest position difference, or infinity if the sizes or indices differ
+	template<size_t VertexCount, size_t IndexCount>
+	float MeshDifference(const StaticGeometry::StaticMesh<VertexCount, IndexCount>& mesh, const MeshGenerator::MeshData& meshData)
+	{
+		if (meshData.Vertices.size() != VertexCount || meshData.Indices.size() != IndexCount
+			|| !std::equal(mesh.Indices.begin(), mesh.Indices.end(), meshData.Indices.begin()))
+		{
+			return INFINITY;
+		}
+		float difference = 0.0f;
+		for (size_t i = 0; i < VertexCount; i++)
+		{
+			const Float3& a = mesh.Vertices[i].Position;
+			const Float3& b = meshData.Vertices[i].Position;
+			difference = std::max(difference, std::max(std::fabs(a.x - b.x), std::max(std::fabs(a.y - b.y), std::fabs(a.z - b.z))));
+		}
+		return difference;
+	}
+}
+
+uint32_t RunStaticGeometryBenchmark()
+{
+	uint32_t failures = 0;
+	MeshGenerator::MeshData meshData;
+
+	printf("Box demo cube and pyramid, %zu and %zu vertices:\n", bakedCube.Vertices.size(), bakedPyramid.Vertices.size());
+	PrintTiming("StaticGeometry at runtime", Measure([&]()
+	{
+		CopyMesh(StaticGeometry::MakeCornerBox(boxSize, boxSize, boxSize), meshData);
+		CopyMesh(StaticGeometry::MakePyramid(boxSize, boxSize), meshData);
+	}));
+	PrintTiming("baked, copied", Measure([&]()
+	{
+		CopyMesh(bakedCube, meshData);
+		CopyMesh(bakedPyramid, meshData);
+	}));
+	CopyMesh(StaticGeometry::MakeCornerBox(boxSize, boxSize, boxSize), meshData);
+	failures += Check(MeshDifference(bakedCube, meshData) == 0.0f, "the baked cube differs from the runtime one");
+	CopyMesh(StaticGeometry::MakePyramid(boxSize, boxSize), meshData);
+	failures += Check(MeshDifference(bakedPyramid, meshData) == 0.0f, "the baked pyramid differs from the runtime one");
+
+	printf("Shapes demo 20x20 sphere, %zu vertices:\n", bakedSphere.Vertices.size());
+	PrintTiming("MeshGenerator::CreateSphere", Measure([&]()
+	{
+		MeshGenerator::CreateSphere(sphereRadius, 20, 20, meshData);
+	}));
+	failures += Check(MeshDifference(bakedSphere, meshData) < 1e-5f, "the baked sphere differs from MeshGenerator's");
+	PrintTiming("StaticGeometry at runtime", Measure([&]()
+	{
+		CopyMesh(StaticGeometry::MakeSphere<20, 20>(sphereRadius), meshData);
+	}));
+	failures += Check(MeshDifference(bakedSphere, meshData) < 1e-6f, "the baked sphere differs from the runtime one");
+	PrintTiming("baked, copied", Measure([&]()
+	{
+		CopyMesh(bakedSphere, meshData);
+	}));
+	printf("Baked meshes are in the executable's read-only data, a scene that uploads\n"
+		"them from there pays no startup time at all.\n");
+
+	if (failures > 0)
+	{
+		printf("%u static geometry checks failed\n", failures);
+	}
+	return failures;
+}
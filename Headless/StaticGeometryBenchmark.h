@@ -0,0 +1,15 @@
+#ifndef STATICGEOMETRYBENCHMARK_H
+#define STATICGEOMETRYBENCHMARK_H
+
+#include <cstdint>
+
+// Compares the startup cost of generating meshes with baking them with
+// StaticGeometry: the box demo's cube and pyramid, which it bakes, and the
+// 20x20 sphere the shapes demo generates with MeshGenerator. Each is
+// generated at runtime by the constexpr functions, the sphere also by
+// MeshGenerator, and timed against copying the baked arrays. Prints the
+// first call, which startup pays, and the best of many. Checks that the
+// runtime and baked meshes agree. Returns the number of failed checks.
+uint32_t RunStaticGeometryBenchmark();
+
+#endif // STATICGEOMETRYBENCHMARK_H
@@ -0,0 +1,101 @@
+#include "StreamBenchmark.h"
+#include "MeshGenerator.h"
+#include "VertexStreams.h"
+
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+	struct AttributeVertex
+	{
+		Float3 Position;
+		Float3 Normal;
+		Float3 Tangent;
+		Float2 TexC;
+		Float4 Color;
+	};
+
+	uint32_t Check(bool passed, const char* what)
+	{
+		if (!passed)
+		{
+			printf("Failed: %s\n", what);
+			return 1;
+		}
+		return 0;
+	}
+}
+
+template<> struct VertexFormat<AttributeVertex>
+{
+	static constexpr std::array<VertexElement, 5> Elements =
+	{{
+		VERTEX_ELEMENT(AttributeVertex, Position, "POSITION"),
+		VERTEX_ELEMENT(AttributeVertex, Normal, "NORMAL"),
+		VERTEX_ELEMENT(AttributeVertex, Tangent, "TANGENT"),
+		VERTEX_ELEMENT(AttributeVertex, TexC, "TEXCOORD"),
+		VERTEX_ELEMENT(AttributeVertex, Color, "COLOR")
+	}};
+};
+
+static_assert(VertexFormatIsTight<AttributeVertex>(), "AttributeVertex has padding");
+
+uint32_t RunStreamBenchmark()
+{
+	const uint32_t gridSize = 1000;
+	MeshGenerator::MeshData grid;
+	MeshGenerator::CreateGrid(200.0f, 200.0f, gridSize, gridSize, grid);
+	std::vector<AttributeVertex> vertices(grid.Vertices.size());
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		const StaticGeometry::MeshVertex& source = grid.Vertices[i];
+		vertices[i].Position = source.Position;
+		vertices[i].Normal = source.Normal;
+		vertices[i].Tangent = source.TangentU;
+		vertices[i].TexC = source.TexC;
+		vertices[i].Color = Float4(source.TexC.x, source.TexC.y, 1.0f, 1.0f);
+	}
+	uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+
+	// Looking down at part of the grid, as a camera in the hills scene would
+	Float4x4 view = MatrixLookAtLH(Float3(0.0f, 60.0f, -120.0f), Float3(0.0f, 0.0f, 0.0f), Float3(0.0f, 1.0f, 0.0f));
+	Float4x4 viewProj = MatrixMultiply(view, MatrixPerspectiveFovLH(0.25f * StaticGeometry::Pi, 16.0f / 9.0f, 1.0f, 1000.0f));
+
+	printf("%u vertices of %u bytes, position pass in each layout, bytes fetched in whole cache lines:\n", vertexCount, VertexStride<AttributeVertex>());
+	printf("%-24s %14s %14s %10s %10s %8s\n", "layout", "stream bytes", "bytes fetched", "ms/pass", "GB/s", "speedup");
+	VertexStreamSet interleaved = BuildVertexStreams(vertices.data(), vertexCount, StreamLayout::Interleaved);
+	const StreamLayout layouts[] = { StreamLayout::Interleaved, StreamLayout::Split, StreamLayout::PositionAndAttributes };
+	uint32_t failures = 0;
+	double interleavedMs = 0.0;
+	uint32_t interleavedInside = 0;
+	for (StreamLayout layout : layouts)
+	{
+		VertexStreamSet streams = ConvertVertexStreams(interleaved, layout);
+		// One pass first so every layout starts with the position stream out of the caches alike
+		RunPositionOnlyPass(streams, &viewProj.m[0][0], 1);
+		PositionPassStats stats = RunPositionOnlyPass(streams, &viewProj.m[0][0], 10);
+		const VertexStream& positions = streams.Streams[streams.Elements[streams.FindElement("POSITION")].Stream];
+
+		if (layout == StreamLayout::Interleaved)
+		{
+			interleavedMs = stats.MillisecondsPerPass;
+			interleavedInside = stats.VerticesInside;
+		}
+		printf("%-24s %14zu %14llu %10.3f %10.2f %7.2fx\n", StreamLayoutName(layout), positions.Data.size()
+			, static_cast<unsigned long long>(stats.BytesFetched), stats.MillisecondsPerPass
+			, stats.MillisecondsPerPass > 0.0 ? stats.BytesFetched / (stats.MillisecondsPerPass * 1e6) : 0.0
+			, stats.MillisecondsPerPass > 0.0 ? interleavedMs / stats.MillisecondsPerPass : 0.0);
+
+		failures += Check(stats.VerticesInside == interleavedInside, "the layouts see different vertices");
+		failures += Check(layout == StreamLayout::Interleaved || stats.BytesFetched <= stats.BytesUseful + 64
+			, "a position stream touches more than the positions");
+	}
+	failures += Check(interleavedInside > 0 && interleavedInside < vertexCount, "the camera sees none or all of the grid");
+
+	if (failures > 0)
+	{
+		printf("%u stream layout checks failed\n", failures);
+	}
+	return failures;
+}
@@ -0,0 +1,14 @@
+#ifndef STREAMBENCHMARK_H
+#define STREAMBENCHMARK_H
+
+#include <cstdint>
+
+// Runs a position only pass, as a depth prepass or culling would, over a
+// grid of a million vertices with position, normal, tangent, texture
+// coordinates and color in every stream layout. The mesh is far larger
+// than the caches, so the times show the memory traffic of each layout.
+// Checks that every layout sees the same vertices. Returns the number of
+// failed checks.
+uint32_t RunStreamBenchmark();
+
+#endif // STREAMBENCHMARK_H
@@ -0,0 +1,219 @@
+#include "TangentCheck.h"
+#include "TangentGenerator.h"
+#include "JobSystem.h"
+#include "SkullModel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	uint32_t Check(bool passed, const char* what)
+	{
+		if (!passed)
+		{
+			printf("Failed: %s\n", what);
+			return 1;
+		}
+		return 0;
+	}
+
+	TangentInput MeshInput(const MeshGenerator::MeshData& mesh)
+	{
+		const StaticGeometry::MeshVertex& first = mesh.Vertices[0];
+		uint32_t stride = sizeof(StaticGeometry::MeshVertex);
+		TangentInput input = { &first.Position, stride, &first.Normal, stride, &first.TexC, stride
+			, static_cast<uint32_t>(mesh.Vertices.size()), mesh.Indices.data(), static_cast<uint32_t>(mesh.Indices.size()) };
+		return input;
+	}
+
+	// Share of the vertices whose tangent is within about 8 degrees of TangentU
+	float Agreement(const MeshGenerator::MeshData& mesh, const TangentFrames& frames)
+	{
+		uint32_t agreeing = 0;
+		for (size_t i = 0; i < mesh.Vertices.size(); i++)
+		{
+			const Float4& t = frames.Tangents[i];
+			agreeing += Dot(Float3(t.x, t.y, t.z), mesh.Vertices[i].TangentU) > 0.99f ? 1 : 0;
+		}
+		return static_cast<float>(agreeing) / mesh.Vertices.size();
+	}
+
+	uint32_t CheckGeneratedMeshes()
+	{
+		uint32_t failures = 0;
+		TangentFrames frames;
+
+		MeshGenerator::MeshData grid;
+		MeshGenerator::CreateGrid(10.0f, 10.0f, 20, 30, grid);
+		GenerateTangents(MeshInput(grid), frames);
+		bool exact = frames.SplitVertices == 0 && frames.DegenerateTriangles == 0;
+		for (size_t i = 0; i < grid.Vertices.size(); i++)
+		{
+			const Float4& t = frames.Tangents[i];
+			exact = exact && std::fabs(t.x - 1.0f) < 1e-6f && std::fabs(t.y) < 1e-6f && std::fabs(t.z) < 1e-6f && t.w == 1.0f;
+		}
+		failures += Check(exact && frames.Indices == grid.Indices, "the grid's tangents are not +x with w = 1");
+
+		// The poles have a single vertex for many texture coordinates, their TangentU is arbitrary
+		MeshGenerator::MeshData sphere;
+		MeshGenerator::CreateSphere(2.0f, 40, 30, sphere);
+		GenerateTangents(MeshInput(sphere), frames);
+		float sphereAgreement = Agreement(sphere, frames);
+		MeshGenerator::MeshData cylinder;
+		MeshGenerator::CreateCylinder(1.0f, 0.5f, 3.0f, 40, 10, cylinder);
+		GenerateTangents(MeshInput(cylinder), frames);
+		float cylinderAgreement = Agreement(cylinder, frames);
+		printf("Tangents agreeing with TangentU: sphere %.1f%%, cylinder %.1f%%\n", sphereAgreement * 100.0f, cylinderAgreement * 100.0f);
+		failures += Check(sphereAgreement > 0.99f && cylinderAgreement > 0.99f, "the sphere's or cylinder's tangents differ from TangentU");
+
+		// The MeshData version keeps an unmirrored mesh as it is
+		MeshGenerator::MeshData replaced = sphere;
+		uint32_t splits = GenerateTangents(replaced);
+		failures += Check(splits == 0 && replaced.Vertices.size() == sphere.Vertices.size() && replaced.Indices == sphere.Indices, "the sphere's vertices are split");
+		return failures;
+	}
+
+	uint32_t CheckMirrored()
+	{
+		uint32_t failures = 0;
+
+		// The left half of the grid mirrors the right one around the middle column
+		const uint32_t rows = 8;
+		const uint32_t columns = 9;
+		MeshGenerator::MeshData grid;
+		MeshGenerator::CreateGrid(8.0f, 7.0f, rows, columns, grid);
+		for (size_t i = 0; i < grid.Vertices.size(); i++)
+		{
+			Float2& texC = grid.Vertices[i].TexC;
+			texC.x = std::fabs(texC.x - 0.5f) * 2.0f;
+		}
+
+		TangentFrames frames;
+		GenerateTangents(MeshInput(grid), frames);
+		failures += Check(frames.SplitVertices == rows, "the middle column is not split once per row");
+
+		bool right = true;
+		for (size_t corner = 0; corner < frames.Indices.size(); corner++)
+		{
+			uint32_t triangle = static_cast<uint32_t>(corner / 3);
+			const uint32_t* source = &grid.Indices[triangle * 3];
+			float centerX = 0.0f;
+			for (uint32_t i = 0; i < 3; i++)
+			{
+				centerX += grid.Vertices[source[i]].Position.x / 3.0f;
+			}
+
+			// Left of the middle dP/du is -x, so the bitangent -z is -cross(N, T)
+			const Float4& t = frames.Tangents[frames.Indices[corner]];
+			Float4 expected = centerX < 0.0f ? Float4(-1.0f, 0.0f, 0.0f, -1.0f) : Float4(1.0f, 0.0f, 0.0f, 1.0f);
+			right = right && std::fabs(t.x - expected.x) < 1e-5f && t.w == expected.w
+				&& frames.SourceVertices[frames.Indices[corner]] == grid.Indices[corner];
+		}
+		failures += Check(right, "the mirrored half does not use its own tangents");
+
+		MeshGenerator::MeshData split = grid;
+		uint32_t splits = GenerateTangents(split);
+		failures += Check(splits == rows && split.Vertices.size() == grid.Vertices.size() + rows, "MeshData is not split");
+
+		// Zero texture area adds nothing, the vertices only get a perpendicular tangent
+		MeshGenerator::MeshData flat = grid;
+		for (size_t i = 0; i < flat.Vertices.size(); i++)
+		{
+			flat.Vertices[i].TexC = Float2(0.25f, 0.25f);
+		}
+		GenerateTangents(MeshInput(flat), frames);
+		bool perpendicular = frames.DegenerateTriangles == flat.Indices.size() / 3 && frames.SplitVertices == 0;
+		for (size_t i = 0; i < frames.Tangents.size(); i++)
+		{
+			const Float4& t = frames.Tangents[i];
+			perpendicular = perpendicular && std::fabs(t.y) < 1e-6f && std::fabs(t.x * t.x + t.z * t.z - 1.0f) < 1e-5f;
+		}
+		failures += Check(perpendicular, "degenerate texture coordinates do not give perpendicular tangents");
+		return failures;
+	}
+
+	bool SameFrames(const TangentFrames& a, const TangentFrames& b)
+	{
+		return a.Tangents.size() == b.Tangents.size()
+			&& memcmp(a.Tangents.data(), b.Tangents.data(), a.Tangents.size() * sizeof(Float4)) == 0
+			&& a.Indices == b.Indices
+			&& a.SourceVertices == b.SourceVertices
+			&& a.DegenerateTriangles == b.DegenerateTriangles;
+	}
+
+	double Milliseconds(const TangentInput& input, JobSystem* jobs, TangentFrames& frames)
+	{
+		// Best of a few, the first also wakes the workers
+		double best = 0.0;
+		for (int run = 0; run < 5; run++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			GenerateTangents(input, frames, jobs);
+			double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			best = run == 0 ? ms : std::min(best, ms);
+		}
+		return best;
+	}
+
+	uint32_t CheckThreads(const TangentInput& input, const char* name, uint32_t maxThreads)
+	{
+		uint32_t failures = 0;
+		uint32_t triangles = input.IndexCount / 3;
+		TangentFrames serial;
+		double serialMs = Milliseconds(input, nullptr, serial);
+		printf("%s: %u vertices, %u triangles, %u split vertices, %u degenerate triangles\n", name, input.VertexCount, triangles, serial.SplitVertices, serial.DegenerateTriangles);
+		printf("%-8s %10s %14s %8s\n", "threads", "ms", "M triangles/s", "speedup");
+		printf("%-8s %10.3f %14.2f %7.2fx\n", "none", serialMs, triangles / serialMs / 1000.0, 1.0);
+
+		for (uint32_t threads = 1; threads <= maxThreads; threads *= 2)
+		{
+			JobSystem jobs(threads);
+			TangentFrames frames;
+			double ms = Milliseconds(input, &jobs, frames);
+			printf("%-8u %10.3f %14.2f %7.2fx\n", threads, ms, triangles / ms / 1000.0, serialMs / ms);
+			failures += Check(SameFrames(serial, frames), "the result depends on the thread count");
+
+			if (threads < maxThreads && threads * 2 > maxThreads)
+			{
+				threads = maxThreads / 2;
+			}
+		}
+		return failures;
+	}
+}
+
+uint32_t RunTangentCheck(const std::string& skullModel, uint32_t maxThreads)
+{
+	uint32_t failures = CheckGeneratedMeshes();
+	failures += CheckMirrored();
+
+	SkullModel skull;
+	if (LoadSkullModel(skullModel, skull))
+	{
+		// The seam of the spherical mapping mirrors a few triangles
+		std::vector<Float2> texCoords;
+		ComputeSphericalTexCoords(skull.Positions, texCoords);
+		TangentInput input = { skull.Positions.data(), sizeof(Float3), skull.Normals.data(), sizeof(Float3), texCoords.data(), sizeof(Float2)
+			, static_cast<uint32_t>(skull.Positions.size()), skull.Indices.data(), static_cast<uint32_t>(skull.Indices.size()) };
+		failures += CheckThreads(input, "Skull", maxThreads);
+	}
+	else
+	{
+		printf("Could not load %s, using a sphere\n", skullModel.c_str());
+	}
+
+	MeshGenerator::MeshData sphere;
+	MeshGenerator::CreateSphere(5.0f, 500, 500, sphere);
+	failures += CheckThreads(MeshInput(sphere), "Sphere", maxThreads);
+
+	if (failures > 0)
+	{
+		printf("%u tangent checks failed\n", failures);
+	}
+	return failures;
+}
@@ -0,0 +1,15 @@
+#ifndef TANGENTCHECK_H
+#define TANGENTCHECK_H
+
+#include <cstdint>
+#include <string>
+
+// Checks GenerateTangents against the analytic tangents of the generated
+// grid, sphere and cylinder and the vertex splitting of mirrored texture
+// coordinates. On the skull model with spherical texture coordinates and
+// on a large sphere, checks that 1 to maxThreads threads give identical
+// results and prints the triangles per second. Returns the number of failed
+// checks.
+uint32_t RunTangentCheck(const std::string& skullModel, uint32_t maxThreads);
+
+#endif // TANGENTCHECK_H
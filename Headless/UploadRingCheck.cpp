@@ -0,0 +1,223 @@
+#include "UploadRingCheck.h"
+#include "NullRenderDevice.h"
+#include "UploadRing.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+	// A GPU that finishes frames when told to, or when waited for
+	class ManualFence : public IFrameFence
+	{
+	public:
+		ManualFence() : Signaled(0), Completed(0), Waits(0) {}
+
+		void Signal(uint64_t frame) { Signaled = frame; }
+		uint64_t CompletedFrame() { return Completed; }
+		void Wait(uint64_t frame)
+		{
+			Waits++;
+			Completed = frame > Completed ? frame : Completed;
+		}
+
+		uint64_t Signaled;
+		uint64_t Completed;
+		uint32_t Waits;
+	};
+
+	uint32_t Check(bool passed, const char* what)
+	{
+		if (!passed)
+		{
+			printf("Failed: %s\n", what);
+			return 1;
+		}
+		return 0;
+	}
+
+	uint32_t CheckBasics()
+	{
+		uint32_t failures = 0;
+		NullRenderDevice device;
+		ManualFence fence;
+		{
+			UploadRing ring(device, fence, BufferBinding::Vertex, 100, 3);
+
+			UploadAllocation a = ring.Allocate(10);
+			UploadAllocation b = ring.Allocate(16, 16);
+			UploadAllocation c = ring.Allocate(28, 28);
+			failures += Check(a.Offset == 0 && b.Offset == 16 && c.Offset == 56, "allocations are not aligned");
+			failures += Check(device.MapCount == 1 && device.DiscardCount == 1, "the first map is not a single Discard");
+			memset(c.Data, 0xab, 28);
+			failures += Check(NullRenderDevice::ToBuffer(ring.Buffer())->Data[56 + 27] == 0xab, "the data does not reach the buffer");
+			ring.EndFrame();
+			failures += Check(fence.Signaled == 1 && ring.Stats().FrameBytes == 84 && ring.Stats().PaddingBytes == 30, "the frame is not accounted");
+
+			// Frame 1 is still in flight, this frame appends after it
+			UploadAllocation d = ring.Allocate(10);
+			failures += Check(d.Offset == 84 && device.MapCount == 2 && device.DiscardCount == 1, "the second frame does not append with NoOverwrite");
+			// and wraps to the start, which frame 1 holds until the wait
+			UploadAllocation e = ring.Allocate(20);
+			failures += Check(e.Offset == 0 && fence.Waits == 1 && ring.Stats().Stalls == 1 && ring.Stats().Wraps == 1, "the wrap does not wait for frame 1");
+			ring.EndFrame();
+
+			// Even with frame 2 finished the current frame has no room left
+			UploadAllocation f = ring.Allocate(60);
+			UploadAllocation g = ring.Allocate(30);
+			failures += Check(f.Offset == 20 && g.Data == nullptr && ring.Stats().Stalls == 2 && ring.Stats().Overflows == 1, "the current frame does not overflow into itself");
+			ring.EndFrame();
+
+			// Everything finished, the next frame starts over with a Discard
+			fence.Completed = fence.Signaled;
+			UploadAllocation h = ring.Allocate(40);
+			failures += Check(h.Offset == 0 && device.DiscardCount == 2 && ring.FramesInFlight() == 0, "an empty ring does not start over");
+			ring.EndFrame();
+
+			UploadAllocation i = ring.Allocate(101);
+			failures += Check(i.Data == nullptr && ring.Stats().Overflows == 2, "an allocation larger than the ring does not overflow");
+			ring.EndFrame();
+
+			// More frames than may be in flight wait at EndFrame
+			uint32_t stalls = ring.Stats().Stalls;
+			for (uint32_t frame = 0; frame < 4; frame++)
+			{
+				ring.Allocate(10);
+				ring.EndFrame();
+			}
+			failures += Check(ring.Stats().Stalls == stalls + 2 && ring.FramesInFlight() == 3, "frames in flight are not limited");
+		}
+		failures += Check(device.BufferCount == 0, "the ring's buffer leaked");
+		return failures;
+	}
+
+	struct LiveRange
+	{
+		uint64_t Frame;
+		uint32_t Offset;
+		uint32_t Size;
+	};
+
+	// Random sizes and alignments with the GPU 0 to 3 frames behind
+	uint32_t CheckRandomFrames()
+	{
+		uint32_t failures = 0;
+		NullRenderDevice device;
+		ManualFence fence;
+		std::mt19937 random(7);
+		const uint32_t capacity = 64 * 1024;
+		const uint32_t alignments[] = { 1, 4, 16, 28, 256 };
+		{
+			UploadRing ring(device, fence, BufferBinding::Vertex, capacity, 3);
+			const uint8_t* buffer = NullRenderDevice::ToBuffer(ring.Buffer())->Data.data();
+			std::vector<LiveRange> live;
+			uint32_t overlaps = 0;
+			uint32_t misaligned = 0;
+			uint32_t corrupted = 0;
+
+			for (uint64_t frame = 1; frame <= 20000; frame++)
+			{
+				uint32_t count = random() % 8;
+				for (uint32_t i = 0; i < count; i++)
+				{
+					uint32_t size = 1 + random() % 8192;
+					uint32_t alignment = alignments[random() % 5];
+					UploadAllocation allocation = ring.Allocate(size, alignment);
+					if (allocation.Data == nullptr)
+					{
+						continue;
+					}
+					misaligned += allocation.Offset % alignment != 0 || allocation.Offset + size > capacity ? 1 : 0;
+
+					// Ranges the GPU may still read
+					for (size_t j = 0; j < live.size(); j++)
+					{
+						const LiveRange& other = live[j];
+						bool inFlight = other.Frame == frame || other.Frame > fence.Completed;
+						if (inFlight && allocation.Offset < other.Offset + other.Size && other.Offset < allocation.Offset + size)
+						{
+							overlaps++;
+						}
+					}
+					memset(allocation.Data, static_cast<int>(frame & 0xff), size);
+					LiveRange range = { frame, allocation.Offset, size };
+					live.push_back(range);
+				}
+				ring.EndFrame();
+
+				// What the GPU reads of frames in flight is still theirs
+				for (size_t j = 0; j < live.size(); j++)
+				{
+					if (live[j].Frame > fence.Completed)
+					{
+						corrupted += buffer[live[j].Offset] != (live[j].Frame & 0xff) || buffer[live[j].Offset + live[j].Size - 1] != (live[j].Frame & 0xff) ? 1 : 0;
+					}
+				}
+
+				uint64_t lag = random() % 4;
+				if (fence.Signaled > lag && fence.Signaled - lag > fence.Completed)
+				{
+					fence.Completed = fence.Signaled - lag;
+				}
+				size_t kept = 0;
+				for (size_t j = 0; j < live.size(); j++)
+				{
+					if (live[j].Frame > fence.Completed)
+					{
+						live[kept++] = live[j];
+					}
+				}
+				live.resize(kept);
+			}
+
+			failures += Check(overlaps == 0, "an allocation overlaps a frame in flight");
+			failures += Check(misaligned == 0, "an allocation is misaligned or past the end");
+			failures += Check(corrupted == 0, "data of a frame in flight was overwritten");
+			failures += Check(ring.Stats().Wraps > 0 && ring.Stats().Stalls > 0, "the random frames neither wrap nor stall");
+			printf("%llu random frames: %s, %llu allocations\n"
+				, static_cast<unsigned long long>(ring.Stats().Frames)
+				, UploadRingSummary(ring.Stats()).c_str()
+				, static_cast<unsigned long long>(ring.Stats().Allocations));
+		}
+		return failures;
+	}
+
+	// Small allocations as a frame of instance data would make
+	void Benchmark()
+	{
+		NullRenderDevice device;
+		NullFrameFence fence;
+		UploadRing ring(device, fence, BufferBinding::Vertex, 4 * 1024 * 1024, 3);
+		const uint32_t frames = 1000;
+		const uint32_t perFrame = 1000;
+		auto start = std::chrono::steady_clock::now();
+		for (uint32_t frame = 0; frame < frames; frame++)
+		{
+			for (uint32_t i = 0; i < perFrame; i++)
+			{
+				UploadAllocation allocation = ring.Allocate(64, 16);
+				allocation.Data[0] = static_cast<uint8_t>(i);
+			}
+			ring.Unmap();
+			ring.EndFrame();
+		}
+		double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (frames * perFrame);
+		printf("Allocate 64 B: %.1f ns, %s\n", ns, UploadRingSummary(ring.Stats()).c_str());
+	}
+}
+
+uint32_t RunUploadRingCheck()
+{
+	uint32_t failures = CheckBasics();
+	failures += CheckRandomFrames();
+	Benchmark();
+
+	if (failures > 0)
+	{
+		printf("%u upload ring checks failed\n", failures);
+	}
+	return failures;
+}
@@ -0,0 +1,13 @@
+#ifndef UPLOADRINGCHECK_H
+#define UPLOADRINGCHECK_H
+
+#include <cstdint>
+
+// Drives an UploadRing on the null device with a fence the check completes
+// by hand: alignment, Discard and NoOverwrite maps, wrap-around, stalls,
+// overflows and, over many random frames, that no allocation overlaps data
+// of a frame still in flight. Times Allocate. Returns the number of failed
+// checks.
+uint32_t RunUploadRingCheck();
+
+#endif // UPLOADRINGCHECK_H